@@ -297,6 +297,7 @@ clixon_stats_get_db(clicon_handle h,
  * @param[in]     xpath   XPath selection, may be used to filter early
  * @param[in]     nsc     XML Namespace context for xpath
  * @param[in]     content config/state or both
+ * @param[in]     depth   Nr of levels of state data to keep: -1 is all
  * @param[in,out] xret    Existing XML tree, merge x into this
  * @retval       -1       Error (fatal)
  * @retval        0       Statedata callback failed (clicon_err called)
@@ -307,6 +308,7 @@ client_statedata(clicon_handle h,
 		 char         *xpath,
 		 cvec         *nsc,
 		 netconf_content content,
+		 int32_t       depth,
 		 cxobj       **xret)
 {
     int        retval = -1;
@@ -368,7 +370,7 @@ client_statedata(clicon_handle h,
 	if (ret == 0)
 	    goto fail;
     }
-    if ((ret = clixon_plugin_statedata_all(h, yspec, nsc, xpath, xret)) < 0)
+    if ((ret = clixon_plugin_statedata_all(h, yspec, nsc, xpath, depth, xret)) < 0)
 	goto done;
     if (ret == 0)
 	goto fail;
@@ -383,6 +385,196 @@ client_statedata(clicon_handle h,
     goto done;
 }
 
+/*! Get with-defaults mode of a get or get-config request
+ *
+ * The mode is given by the <with-defaults> parameter of RFC 6243, as in:
+ *   <get><with-defaults xmlns="urn:ietf:params:xml:ns:yang:ietf-netconf-with-defaults">trim</with-defaults></get>
+ * @param[in]  xe      Request: <rpc><xn></rpc> 
+ * @param[out] wdef    With-defaults mode, report-all if not given
+ * @param[out] cbret   Return xml tree, eg <rpc-error.. if retval == 0
+ * @retval     1       OK
+ * @retval     0       Invalid value, error in cbret
+ * @retval    -1       Error
+ */
+static int
+client_get_withdefaults(cxobj             *xe,
+			withdefaults_type *wdef,
+			cbuf              *cbret)
+{
+    int    retval = -1;
+    cxobj *xc;
+    char  *ns;
+    char  *mode;
+    int    ret;
+
+    *wdef = WITHDEFAULTS_REPORT_ALL;
+    xc = NULL;
+    while ((xc = xml_child_each(xe, xc, CX_ELMNT)) != NULL) {
+	if (strcmp(xml_name(xc), "with-defaults") != 0)
+	    continue;
+	ns = NULL;
+	if (xml2ns(xc, xml_prefix(xc), &ns) < 0)
+	    goto done;
+	if (ns == NULL || strcmp(ns, NETCONF_WITH_DEFAULTS_NAMESPACE) != 0)
+	    continue;
+	/* report-all-tagged is a valid mode but not supported */
+	if ((mode = xml_body(xc)) == NULL ||
+	    (ret = withdefaults_str2int(mode)) < 0){
+	    if (netconf_invalid_value(cbret, "application", "Unsupported with-defaults mode") < 0)
+		goto done;
+	    goto fail;
+	}
+	*wdef = ret;
+	break;
+    }
+    retval = 1;
+ done:
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Stream a large reply to client in chunks while it is serialized
+ *
+ * Send the reply buffer as a reply chunk when it has grown beyond the chunk size, so that
+ * the backend does not need the whole reply as text. The rest is sent as last chunk by
+ * from_client_msg.
+ * @param[in]  cb    Reply buffer, reset if sent
+ * @param[in]  arg   Client entry
+ * @see xml2cbuf_flush_fn
+ * @see send_msg_reply_chunk
+ */
+static int
+client_reply_flush(cbuf *cb,
+		   void *arg)
+{
+    struct client_entry *ce = (struct client_entry *)arg;
+
+    if (ce == NULL || cbuf_len(cb) < CLIXON_REPLY_CHUNK_SIZE)
+	return 0;
+    if (send_msg_reply_chunk(ce->ce_s, cbuf_get(cb), cbuf_len(cb)) < 0)
+	return -1;
+    cbuf_reset(cb);
+    ce->ce_chunks++;
+    return 0;
+}
+
+/* Filter of default values reported in get replies, see client_get_default */
+struct client_defaults {
+    cxobj        **cd_xvec;  /* Sorted xpath matches, or NULL if all of the tree matches */
+    size_t         cd_xlen;  /* Length of cd_xvec */
+    nacm_read_ctx *cd_nacm;  /* NACM read access of default values, or NULL */
+};
+
+/*! Order xml nodes by address, for bsearch of xpath matches
+ */
+static int
+client_xvec_cmp(const void *a,
+		const void *b)
+{
+    uintptr_t x1 = (uintptr_t)*(cxobj **)a;
+    uintptr_t x2 = (uintptr_t)*(cxobj **)b;
+
+    return x1 < x2 ? -1 : x1 > x2;
+}
+
+/*! Check if a default value that is not in the reply tree is to be reported
+ *
+ * Default values are reported only within the subtrees matching the xpath of the request,
+ * not in their ancestors, and only if NACM gives read access to them.
+ * This is a filter function for clicon_xml2cbuf_wdef.
+ * @param[in]  x    XML parent of default leaf
+ * @param[in]  y    Yang leaf with default value
+ * @param[in]  arg  struct client_defaults
+ * @retval     1    Report default value
+ * @retval     0    Do not report
+ * @retval    -1    Error
+ * @note The xpath matches are compared by address only, they may have been removed by NACM
+ */
+static int
+client_get_default(cxobj     *x,
+		   yang_stmt *y,
+		   void      *arg)
+{
+    struct client_defaults *cd = (struct client_defaults *)arg;
+    cxobj                  *xa;
+
+    if (cd->cd_xvec){
+	for (xa = x; xa != NULL; xa = xml_parent(xa))
+	    if (bsearch(&xa, cd->cd_xvec, cd->cd_xlen, sizeof(cxobj *), client_xvec_cmp) != NULL)
+		break;
+	if (xa == NULL)
+	    return 0;
+    }
+    if (cd->cd_nacm)
+	return nacm_datanode_read_default(x, y, cd->cd_nacm);
+    return 1;
+}
+
+/*! Retrieve configuration directly from a read-only datastore snapshot
+ *
+ * The xpath matches are marked in the snapshot and printed without copying the tree.
+ * Not applicable with NACM, since NACM read access prunes the tree.
+ * @param[in]  h       Clicon handle
+ * @param[in]  nsc     XML namespace context for xpath
+ * @param[in]  db      Datastore, eg "running"
+ * @param[in]  xpath   XPath filter, or NULL
+ * @param[in]  depth   Nr of levels to print, -1 is all
+ * @param[in]  wdef    With-defaults mode
+ * @param[in]  ce      Client entry, for streaming reply in chunks
+ * @param[out] cbret   Return xml tree, eg <rpc-reply>..., <rpc-error.. 
+ * @retval     0       OK
+ * @retval    -1       Error
+ * @see client_get_config_only
+ */
+static int
+client_get_config_snapshot(clicon_handle        h,
+			   cvec                *nsc,
+			   char                *db,
+			   char                *xpath,
+			   int32_t              depth,
+			   withdefaults_type    wdef,
+			   struct client_entry *ce,
+			   cbuf                *cbret)
+{
+    int             retval = -1;
+    xmldb_snapshot *xs = NULL;
+    cxobj          *xt;
+    cxobj         **xvec = NULL;
+    size_t          xlen;
+    int             i;
+
+    if (xmldb_snapshot_get(h, db, &xs) < 0) {
+	if (netconf_operation_failed(cbret, "application", "read registry")< 0)
+	    goto done;
+	goto ok;
+    }
+    xt = xmldb_snapshot_xml(xs);
+    if (xpath_vec(xt, nsc, "%s", &xvec, &xlen, xpath?xpath:"/") < 0)
+	goto done;
+    for (i=0; i<xlen; i++){
+	xml_flag_set(xvec[i], XML_FLAG_MARK);
+	xml_apply_ancestor(xvec[i], (xml_applyfn_t*)xml_flag_set, (void*)XML_FLAG_SUBMARK);
+    }
+    cprintf(cbret, "<rpc-reply>");
+    if (clicon_xml2cbuf_marked(cbret, xt, "data", depth>0?depth+1:depth, wdef,
+			       client_reply_flush, ce) < 0)
+	goto done;
+    cprintf(cbret, "</rpc-reply>");
+ ok:
+    retval = 0;
+ done:
+    /* reset marks in the shared tree, the snapshot is released also on error */
+    if (xml_flag_epoch_next() < 0)
+	retval = -1;
+    if (xvec)
+	free(xvec);
+    if (xs)
+	xmldb_snapshot_release(h, xs);
+    return retval;
+}
+
 /*! Retrieve all or part of a specified configuration.
  * 
  * Function reused from both from_client_get() and from_client_get_config
@@ -392,58 +584,74 @@ client_statedata(clicon_handle h,
  * @param[in]  username
  * @param[in]  content
  * @param[in]  depth
+ * @param[in]  wdef    With-defaults mode
+ * @param[in]  ce      Client entry, for streaming reply in chunks
  * @param[out] cbret   Return xml tree, eg <rpc-reply>..., <rpc-error.. 
  * @retval     0       OK
  * @retval    -1       Error
  * @see from_client_get
  */
 static int
-client_get_config_only(clicon_handle h,
-		       cvec         *nsc,
-		       yang_stmt    *yspec,
-		       char         *db,
-		       char         *xpath,
-		       char         *username,
-		       int32_t       depth,
-		       cbuf         *cbret)
+client_get_config_only(clicon_handle        h,
+		       cvec                *nsc,
+		       yang_stmt           *yspec,
+		       char                *db,
+		       char                *xpath,
+		       char                *username,
+		       int32_t              depth,
+		       withdefaults_type    wdef,
+		       struct client_entry *ce,
+		       cbuf                *cbret)
 {
     int     retval = -1;
     cxobj  *xret = NULL;
     cxobj  *xnacm = NULL;
     cxobj **xvec = NULL;
     size_t  xlen;    
+    struct client_defaults cd = {0,};
 
+    /* Without NACM, print the xpath matches directly from a datastore snapshot */
+    if ((xnacm = clicon_nacm_cache(h)) == NULL)
+	return client_get_config_snapshot(h, nsc, db, xpath, depth, wdef, ce, cbret);
     /* Note xret can be pruned by nacm below (and change name),
      * so zero-copy cant be used
      * Also, must use external namespace context here due to <filter stmt
+     * Default values are not added to the tree, they are reported when printing
      */
-    if (xmldb_get0(h, db, nsc, xpath, 1, &xret, NULL) < 0) {
+    if (xmldb_get_nodefaults(h, db, nsc, xpath, depth, &xret) < 0) {
 	if (netconf_operation_failed(cbret, "application", "read registry")< 0)
 	    goto done;
 	goto ok;
     }
     /* Pre-NACM access step */
-    xnacm = clicon_nacm_cache(h);
-    if (xnacm != NULL){ /* Do NACM validation */
-	if (xpath_vec(xret, nsc, "%s", &xvec, &xlen, xpath?xpath:"/") < 0)
-	    goto done;
-	/* NACM datanode/module read validation */
-	if (nacm_datanode_read(h, xret, xvec, xlen, username, xnacm) < 0) 
-	    goto done;
-    }
+    if (xpath_vec(xret, nsc, "%s", &xvec, &xlen, xpath?xpath:"/") < 0)
+	goto done;
+    /* Default values are reported within the xpath matches only */
+    if (xvec && !(xlen == 1 && xvec[0] == xret)){
+	qsort(xvec, xlen, sizeof(cxobj *), client_xvec_cmp);
+	cd.cd_xvec = xvec;
+	cd.cd_xlen = xlen;
+    }
+    /* NACM datanode/module read validation. Keep the rules to check read access of 
+     * default values when printing, a denied leaf must not be reported with its default */
+    if (nacm_datanode_read0(h, xret, xvec, xlen, username, xnacm, &cd.cd_nacm) < 0) 
+	goto done;
     cprintf(cbret, "<rpc-reply>");
     if (xret==NULL)
 	cprintf(cbret, "<data/>");
     else{
 	if (xml_name_set(xret, "data") < 0)
 	    goto done;
-	if (clicon_xml2cbuf(cbret, xret, 0, 0, depth>0?depth+1:depth) < 0)
+	if (clicon_xml2cbuf_wdef(cbret, xret, 0, 0, depth>0?depth+1:depth, wdef,
+				 client_reply_flush, ce, client_get_default, &cd) < 0)
 	    goto done;
     }
     cprintf(cbret, "</rpc-reply>");
  ok:
     retval = 0;
  done:
+    if (cd.cd_nacm)
+	nacm_read_ctx_free(cd.cd_nacm);
     if (xvec)
 	free(xvec);
     if (xret)
@@ -470,6 +678,7 @@ from_client_get_config(clicon_handle h,
 		       void         *regarg)
 {
     int        retval = -1;
+    struct client_entry *ce = (struct client_entry *)arg;
     char      *db;
     cxobj     *xfilter;
     char      *xpath = NULL;
@@ -482,6 +691,7 @@ from_client_get_config(clicon_handle h,
     char      *attr;
     char      *xpath0;
     cvec      *nsc1 = NULL;
+    withdefaults_type wdef;
     
     username = clicon_username_get(h);
     if ((yspec =  clicon_dbspec_yang(h)) == NULL){
@@ -532,7 +742,11 @@ from_client_get_config(clicon_handle h,
 	    goto ok;
 	}
     }
-    if ((ret = client_get_config_only(h, nsc, yspec, db, xpath, username, -1, cbret)) < 0)
+    if ((ret = client_get_withdefaults(xe, &wdef, cbret)) < 0)
+	goto done;
+    if (ret == 0)
+	goto ok;
+    if ((ret = client_get_config_only(h, nsc, yspec, db, xpath, username, -1, wdef, ce, cbret)) < 0)
 	goto done;
  ok:
     retval = 0;
@@ -968,6 +1182,7 @@ from_client_get(clicon_handle h,
 		void         *regarg)
 {
     int             retval = -1;
+    struct client_entry *ce = (struct client_entry *)arg;
     cxobj          *xfilter;
     char           *xpath = NULL;
     cxobj          *xret = NULL;
@@ -983,6 +1198,8 @@ from_client_get(clicon_handle h,
     int             i;
     cxobj          *xerr = NULL;
     int             ret;
+    withdefaults_type wdef;
+    struct client_defaults cd = {0,};
     
     clicon_debug(1, "%s", __FUNCTION__);
     username = clicon_username_get(h);
@@ -1025,25 +1242,33 @@ from_client_get(clicon_handle h,
 	    goto ok;
 	}
     }
+    /* RFC 6243 with-defaults */
+    if ((ret = client_get_withdefaults(xe, &wdef, cbret)) < 0)
+	goto done;
+    if (ret == 0)
+	goto ok;
     if (content == CONTENT_CONFIG){ /* config only, no state */
-	if (client_get_config_only(h, nsc, yspec, "running", xpath, username, depth, cbret) < 0)
+	if (client_get_config_only(h, nsc, yspec, "running", xpath, username, depth, wdef, ce, cbret) < 0)
 	    goto done;
 	goto ok;
     }
+    /* Default values are config, dont report them with state only */
+    if (content == CONTENT_NONCONFIG)
+	wdef = WITHDEFAULTS_EXPLICIT;
     /* If not only-state, then read running config 
      * Note xret can be pruned by nacm below and change name and
      * merged with state data, so zero-copy cant be used
      * Also, must use external namespace context here due to <filter> stmt
      */
     if (clicon_option_bool(h, "CLICON_VALIDATE_STATE_XML")){
-	if (xmldb_get0(h, "running", nsc, NULL, 1, &xret, NULL) < 0) {
+	if (xmldb_get_nodefaults(h, "running", nsc, NULL, -1, &xret) < 0) {
 	    if (netconf_operation_failed(cbret, "application", "read registry")< 0)
 		goto done;
 	    goto ok;
 	}
     }
     else{
-	if (xmldb_get0(h, "running", nsc, xpath, 1, &xret, NULL) < 0) {
+	if (xmldb_get_nodefaults(h, "running", nsc, xpath, depth, &xret) < 0) {
 	    if (netconf_operation_failed(cbret, "application", "read registry")< 0)
 		goto done;
 	    goto ok;
@@ -1053,7 +1278,9 @@ from_client_get(clicon_handle h,
      * get state data from plugins as defined by plugin_statedata(), if any 
      */
     clicon_err_reset();
-    if ((ret = client_statedata(h, xpath?xpath:"/", nsc, content, &xret)) < 0)
+    if ((ret = client_statedata(h, xpath?xpath:"/", nsc, content,
+				clicon_option_bool(h, "CLICON_VALIDATE_STATE_XML")?-1:depth,
+				&xret)) < 0)
 	goto done;
     if (ret == 0){ /* Error from callback (error in xret) */
 	if (clicon_xml2cbuf(cbret, xret, 0, 0, -1) < 0)
@@ -1064,12 +1291,17 @@ from_client_get(clicon_handle h,
 	/* Check XML  by validating it. return internal error with error cause 
 	 * Primarily intended for user-supplied state-data.
 	 * The whole config tree must be present in case the state data references config data
+	 * Validation needs default values in the tree, remove them afterwards.
 	 */
+	if (xml_default_recurse(xret) < 0)
+	    goto done;
 	if ((ret = xml_yang_validate_all_top(h, xret, &xerr)) < 0) 
 	    goto done;
 	if (ret > 0 &&
 	    (ret = xml_yang_validate_add(h, xret, &xerr)) < 0)
 	    goto done;
+	if (xml_tree_prune_flagged(xret, XML_FLAG_DEFAULT, 1) < 0)
+	    goto done;
 	if (ret == 0){
 	    if (clicon_debug_get())
 		clicon_log_xml(LOG_DEBUG, xret, "VALIDATE_STATE");
@@ -1091,7 +1323,7 @@ from_client_get(clicon_handle h,
 	    goto done;
 	if (xml_tree_prune_flagged_sub(xret, XML_FLAG_MARK, 1, NULL) < 0)
 	    goto done;
-	if (xml_apply(xret, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset, (void*)XML_FLAG_MARK) < 0)
+	if (xml_flag_epoch_next() < 0)
 	    goto done;
     }
     /* Code complex to filter out anything that is outside of xpath 
@@ -1108,26 +1340,27 @@ from_client_get(clicon_handle h,
 	for (i=0; i<xlen; i++)
 	    xml_flag_set(xvec[i], XML_FLAG_MARK);
     }
-    if (xvec){
-	free(xvec);
-	xvec = NULL;
-    }
-
     /* Remove everything that is not marked */
-    if (!xml_flag(xret, XML_FLAG_MARK))
+    if (!xml_flag(xret, XML_FLAG_MARK)){
+	/* Default values of ancestors of matching nodes should not be reported, the
+	 * matching nodes are kept by the pruning */
+	if (xvec){
+	    qsort(xvec, xlen, sizeof(cxobj *), client_xvec_cmp);
+	    cd.cd_xvec = xvec;
+	    cd.cd_xlen = xlen;
+	}
 	if (xml_tree_prune_flagged_sub(xret, XML_FLAG_MARK, 1, NULL) < 0)
 	    goto done;
+    }
     /* reset flag */
-    if (xml_apply(xret, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset, (void*)XML_FLAG_MARK) < 0)
+    if (xml_flag_epoch_next() < 0)
 	goto done;
 
     /* Pre-NACM access step */
     xnacm = clicon_nacm_cache(h);
     if (xnacm != NULL){ /* Do NACM validation */
-	if (xpath_vec(xret, nsc, "%s", &xvec, &xlen, xpath?xpath:"/") < 0)
-	    goto done;
-	/* NACM datanode/module read validation */
-	if (nacm_datanode_read(h, xret, xvec, xlen, username, xnacm) < 0) 
+	/* NACM datanode/module read validation, see client_get_config_only */
+	if (nacm_datanode_read0(h, xret, xvec, xlen, username, xnacm, &cd.cd_nacm) < 0) 
 	    goto done;
     }
     cprintf(cbret, "<rpc-reply>");     /* OK */
@@ -1137,7 +1370,8 @@ from_client_get(clicon_handle h,
 	if (xml_name_set(xret, "data") < 0)
 	    goto done;
 	/* Top level is data, so add 1 to depth if significant */
-	if (clicon_xml2cbuf(cbret, xret, 0, 0, depth>0?depth+1:depth) < 0)
+	if (clicon_xml2cbuf_wdef(cbret, xret, 0, 0, depth>0?depth+1:depth, wdef,
+				 client_reply_flush, ce, client_get_default, &cd) < 0)
 	    goto done;
     }
     cprintf(cbret, "</rpc-reply>");
@@ -1145,6 +1379,8 @@ from_client_get(clicon_handle h,
     retval = 0;
  done:
     clicon_debug(1, "%s retval:%d", __FUNCTION__, retval);
+    if (cd.cd_nacm)
+	nacm_read_ctx_free(cd.cd_nacm);
     if (xerr)
 	xml_free(xerr);
     if (xpath)
@@ -1599,6 +1835,7 @@ from_client_msg(clicon_handle        h,
     
     clicon_debug(1, "%s", __FUNCTION__);
     yspec = clicon_dbspec_yang(h); 
+    ce->ce_chunks = 0;
     /* Return netconf message. Should be filled in by the dispatch(sub) functions 
      * as wither rpc-error or by positive response.
      */
@@ -1676,6 +1913,15 @@ from_client_msg(clicon_handle        h,
 	}
 	clicon_err_reset();
 	if ((ret = rpc_callback_call(h, xe, cbret, ce)) < 0){
+	    if (ce->ce_chunks){
+		/* Part of the reply has already been sent and an rpc-error can not be
+		 * appended to it: close the session so the client does not take the
+		 * partial reply as complete */
+		clicon_log(LOG_NOTICE, "%s Error in rpc_callback_call:%s after %d reply chunks, closing session",
+			   __FUNCTION__, xml_name(xe), ce->ce_chunks);
+		backend_client_rm(h, ce);
+		goto ok;
+	    }
 	    if (netconf_operation_failed(cbret, "application", clicon_err_reason)< 0)
 		goto done;
 	    clicon_log(LOG_NOTICE, "%s Error in rpc_callback_call:%s", __FUNCTION__, xml_name(xe));
@@ -1694,12 +1940,13 @@ from_client_msg(clicon_handle        h,
 	}
     } /* while */
  reply:
-    if (cbuf_len(cbret) == 0)
+    if (cbuf_len(cbret) == 0 && ce->ce_chunks == 0)
 	if (netconf_operation_failed(cbret, "application", clicon_errno?clicon_err_reason:"unknown")< 0)
 	    goto done;
     clicon_debug(1, "%s cbret:%s", __FUNCTION__, cbuf_get(cbret));
     /* XXX problem here is that cbret has not been parsed so may contain 
        parse errors */
+    /* If reply has been streamed in chunks, this is the last chunk */
     if (send_msg_reply(ce->ce_s, cbuf_get(cbret), cbuf_len(cbret)+1) < 0){
 	switch (errno){
 	case EPIPE:
@@ -1717,7 +1964,7 @@ from_client_msg(clicon_handle        h,
 	    goto done;
 	}
     }
-    // ok:
+  ok:
     retval = 0;
   done:  
     clicon_debug(1, "%s retval:%d", __FUNCTION__, retval);
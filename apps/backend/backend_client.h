@@ -50,6 +50,7 @@ struct client_entry{
     int                   ce_stat_in; /* Nr of received msgs from client */
     int                   ce_stat_out;/* Nr of sent msgs to client */
     int                   ce_id;      /* Session id */
+    int                   ce_chunks;  /* Nr of reply chunks sent of current msg */
     char                 *ce_username;/* Translated from peer user cred */
     clicon_handle         ce_handle;  /* clicon config handle (all clients have same?) */
 };
@@ -189,12 +189,9 @@ startup_common(clicon_handle       h,
 	if ((msdiff = modstate_diff_new()) == NULL)
 	    goto done;
     clicon_debug(1, "Reading startup config from %s", db);
-    if (xmldb_get0(h, db, NULL, "/", 0, &xt, msdiff) < 0)
+    if (xmldb_get0(h, db, NULL, "/", 0, 1, &xt, msdiff) < 0)
 	goto done;
     clicon_debug(1, "Reading startup config done");
-    /* Clear flags xpath for get */
-    xml_apply0(xt, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset,
-	       (void*)(XML_FLAG_MARK|XML_FLAG_CHANGE));
     /* Here xt is old syntax */
     /* General purpose datastore upgrade */
     if (clixon_plugin_datastore_upgrade_all(h, db, xt, msdiff) < 0)
@@ -426,12 +423,8 @@ from_validate_common(clicon_handle       h,
 	goto done;
     }	
     /* This is the state we are going to */
-    if (xmldb_get0(h, candidate, NULL, "/", 0, &td->td_target, NULL) < 0)
+    if (xmldb_get0(h, candidate, NULL, "/", 0, 1, &td->td_target, NULL) < 0)
 	goto done;
-
-    /* Clear flags xpath for get */
-    xml_apply0(td->td_target, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset,
-	       (void*)(XML_FLAG_MARK|XML_FLAG_CHANGE));
     /* Validate the target state. It is not completely clear this should be done 
      * here. It is being made in generic_validate below. 
      * But xml_diff requires some basic validation, at least check that yang-specs
@@ -444,11 +437,8 @@ from_validate_common(clicon_handle       h,
 
     /* 2. Parse xml trees 
      * This is the state we are going from */
-    if (xmldb_get0(h, "running", NULL, "/", 0, &td->td_src, NULL) < 0)
+    if (xmldb_get0(h, "running", NULL, "/", 0, 1, &td->td_src, NULL) < 0)
 	goto done;
-    /* Clear flags xpath for get */
-    xml_apply0(td->td_src, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset,
-	       (void*)(XML_FLAG_MARK|XML_FLAG_CHANGE));
     /* 3. Compute differences */
     if (xml_diff(yspec, 
 		 td->td_src,
@@ -851,7 +841,7 @@ from_client_restart_one(clicon_handle h,
     if ((td = transaction_new()) == NULL)
 	goto done;
     /* This is the state we are going to */
-    if (xmldb_get0(h, "running", NULL, "/", 0, &td->td_target, NULL) < 0)
+    if (xmldb_get0(h, "running", NULL, "/", 0, 1, &td->td_target, NULL) < 0)
 	goto done;
     if ((ret = xml_yang_validate_all_top(h, td->td_target, &xerr)) < 0)
 	goto done;
@@ -861,7 +851,7 @@ from_client_restart_one(clicon_handle h,
 	goto fail;
     }
     /* This is the state we are going from */
-    if (xmldb_get0(h, db, NULL, "/", 0, &td->td_src, NULL) < 0)
+    if (xmldb_get0(h, db, NULL, "/", 0, 1, &td->td_src, NULL) < 0)
 	goto done;
 
     /* 3. Compute differences */
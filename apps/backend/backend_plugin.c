@@ -212,6 +212,7 @@ clixon_plugin_statedata_one(clixon_plugin  *cp,
  * @param[in]     yspec   Yang spec
  * @param[in]     nsc     Namespace context
  * @param[in]     xpath   String with XPATH syntax. or NULL for all
+ * @param[in]     depth   Nr of levels below top to keep, -1 is all
  * @param[in,out] xtop    State XML tree is merged with existing tree.
  * @retval       -1       Error
  * @retval        0       Statedata callback failed (xret set with netconf-error)
@@ -223,6 +224,7 @@ clixon_plugin_statedata_all(clicon_handle    h,
 			    yang_stmt       *yspec,
 			    cvec            *nsc,
 			    char            *xpath,
+			    int32_t          depth,
 			    cxobj          **xret)
 {
     int             retval = -1;
@@ -231,6 +233,9 @@ clixon_plugin_statedata_all(clicon_handle    h,
     clixon_plugin  *cp = NULL;
     cbuf           *cberr = NULL; 
     cxobj          *xerr = NULL;
+    cxobj         **xvec = NULL;
+    size_t          xlen = 0;
+    int             i;
     
     clicon_debug(1, "%s", __FUNCTION__);
     while ((cp = clixon_plugin_each(h, cp)) != NULL) {
@@ -275,6 +280,25 @@ clixon_plugin_statedata_all(clicon_handle    h,
 	    xerr = NULL;
 	    goto fail;
 	}
+	/* Nodes below requested depth are not sorted, defaulted or merged 
+	 * Mark xpath matches so that they are kept for the xpath filtering of the reply */
+	if (depth >= 0){
+	    if (xpath && xpath_vec(x, nsc, "%s", &xvec, &xlen, xpath) < 0)
+		goto done;
+	    for (i=0; i<xlen; i++){
+		xml_flag_set(xvec[i], XML_FLAG_MARK);
+		xml_apply_ancestor(xvec[i], (xml_applyfn_t*)xml_flag_set, (void*)XML_FLAG_SUBMARK);
+	    }
+	    if (xvec){
+		free(xvec);
+		xvec = NULL;
+	    }
+	    xlen = 0;
+	    if (xml_tree_prune_depth(x, depth) < 0)
+		goto done;
+	    if (xml_flag_epoch_next() < 0)
+		goto done;
+	}
 	if (xml_sort_recurse(x) < 0)
 	    goto done;
 	if (xml_default_recurse(x) < 0)
@@ -296,6 +320,8 @@ clixon_plugin_statedata_all(clicon_handle    h,
 	cbuf_free(cberr);
     if (x)
 	xml_free(x);
+    if (xvec)
+	free(xvec);
     return retval;
  fail:
     retval = 0;
@@ -78,6 +78,21 @@
 /*! Ignore errors on packet errors: continue */
 static int ignore_packet_errors = 1;
 
+/* End-of-message trailer of netconf 1.0 framing */
+#define NETCONF_EOM "]]>]]>"
+
+/*! Incremental XML parser of current incoming message, created on first input */
+static clixon_xml_push *input_xp = NULL;
+
+/*! Parse error of current incoming message, input is discarded until end-of-message */
+static char *input_parse_err = NULL;
+
+/*! State of end-of-message detection, see detect_endtag */
+static int input_eom_state = 0;
+
+/*! Number of end-of-message chars matched at end of previous input but not pushed */
+static int input_eom_held = 0;
+
 static int
 netconf_hello(cxobj *xn)
 {
@@ -106,16 +121,13 @@ netconf_hello_dispatch(cxobj *xn)
 
 /*! Process incoming packet 
  * @param[in]   h    Clicon handle
- * @param[in]   cb   Packet buffer
+ * @param[in]   xreq Parsed packet
  */
 static int
 netconf_input_packet(clicon_handle h, 
-		     cbuf         *cb)
+		     cxobj        *xreq)
 {
     int        retval = -1;
-    char      *str;
-    char      *str0;
-    cxobj     *xreq = NULL; /* Request (in) */
     int        isrpc = 0;   /* either hello or rpc */
     cbuf      *cbret = NULL;
     cxobj     *xret = NULL; /* Return (out) */
@@ -127,26 +139,15 @@ netconf_input_packet(clicon_handle h,
     cxobj     *xa2;
 
     clicon_debug(1, "%s", __FUNCTION__);
-    clicon_debug(2, "%s: \"%s\"", __FUNCTION__, cbuf_get(cb));
+    if (clicon_debug_get() > 1){
+	clicon_debug(2, "%s:", __FUNCTION__);
+	clicon_xml2file(stderr, xreq, 0, 0);
+    }
     if ((cbret = cbuf_new()) == NULL){
 	clicon_err(LOG_ERR, errno, "cbuf_new");
 	goto done;
     }
     yspec = clicon_dbspec_yang(h);
-    if ((str0 = strdup(cbuf_get(cb))) == NULL){
-	clicon_log(LOG_ERR, "%s: strdup: %s", __FUNCTION__, strerror(errno));
-	return -1;
-    }
-    str = str0;
-    /* Parse incoming XML message */
-    if (clixon_xml_parse_string(str, YB_MODULE, yspec, &xreq, NULL) < 0){ 
-	free(str0);
-	if (netconf_operation_failed(cbret, "rpc", clicon_err_reason)< 0)
-	    goto done;
-	netconf_output_encap(1, cbret, "rpc-error");
-	goto done;
-    }
-    free(str0);
     if ((xrpc=xpath_first(xreq, NULL, "//rpc")) != NULL){
         isrpc++;
 	if ((ret = xml_bind_yang_rpc(xrpc, yspec, &xret)) < 0)
@@ -207,8 +208,6 @@ netconf_input_packet(clicon_handle h,
  ok:
     retval = 0;
   done:
-    if (xreq)
-	xml_free(xreq);
     if (xret)
 	xml_free(xret);
     if (cbret)
@@ -216,12 +215,87 @@ netconf_input_packet(clicon_handle h,
     return retval;
 }
 
+/*! Push input of incoming message to incremental XML parser
+ * The XML tree of the message is built as input arrives. After a parse error, the rest of
+ * the message is discarded.
+ * @param[in]   h    Clicon handle
+ * @param[in]   buf  Input, not NUL-terminated
+ * @param[in]   len  Length of input
+ */
+static int
+netconf_input_push(clicon_handle h,
+		   const char   *buf,
+		   size_t        len)
+{
+    if (input_parse_err != NULL)
+	return 0;
+    if (input_xp == NULL &&
+	(input_xp = clixon_xml_push_new(YB_MODULE, clicon_dbspec_yang(h))) == NULL)
+	return -1;
+    if (len && clixon_xml_push_data(input_xp, buf, len) < 0){
+	if ((input_parse_err = strdup(clicon_err_reason)) == NULL){
+	    clicon_err(OE_UNIX, errno, "strdup");
+	    return -1;
+	}
+	clixon_xml_push_free(input_xp);
+	input_xp = NULL;
+    }
+    return 0;
+}
+
+/*! End-of-message of incoming message: process parsed message or report parse error
+ * @param[in]   h    Clicon handle
+ */
+static int
+netconf_input_eom(clicon_handle h)
+{
+    int    retval = -1;
+    cxobj *xreq = NULL; /* Request (in) */
+    cbuf  *cbret = NULL;
+
+    if (netconf_input_push(h, NULL, 0) < 0)
+	goto done;
+    if (input_parse_err == NULL &&
+	clixon_xml_push_end(input_xp, &xreq, NULL) < 0 &&
+	(input_parse_err = strdup(clicon_err_reason)) == NULL){
+	clicon_err(OE_UNIX, errno, "strdup");
+	goto done;
+    }
+    if (input_parse_err != NULL){
+	if ((cbret = cbuf_new()) == NULL){
+	    clicon_err(OE_UNIX, errno, "cbuf_new");
+	    goto done;
+	}
+	if (netconf_operation_failed(cbret, "rpc", input_parse_err)< 0)
+	    goto done;
+	netconf_output_encap(1, cbret, "rpc-error");
+	goto done;
+    }
+    retval = netconf_input_packet(h, xreq);
+ done:
+    if (input_xp){
+	clixon_xml_push_free(input_xp);
+	input_xp = NULL;
+    }
+    if (input_parse_err){
+	free(input_parse_err);
+	input_parse_err = NULL;
+    }
+    if (xreq)
+	xml_free(xreq);
+    if (cbret)
+	cbuf_free(cbret);
+    return retval;
+}
+
 /*! Get netconf message: detect end-of-msg 
  * @param[in]   s    Socket where input arrived. read from this.
  * @param[in]   arg  Clicon handle.
  * This routine continuously reads until no more data on s. There could
  * be risk of starvation, but the netconf client does little else than
  * read data so I do not see a danger of true starvation here.
+ * Input is pushed to an incremental XML parser as it is read, except chars that may be
+ * the start of an end-of-message trailer. A message may span several callbacks.
  */
 static int
 netconf_input_cb(int   s, 
@@ -229,17 +303,14 @@ netconf_input_cb(int   s,
 {
     int           retval = -1;
     clicon_handle h = arg;
-    unsigned char buf[BUFSIZ];
+    char          buf[BUFSIZ];
     int           i;
+    int           j;
     int           len;
-    cbuf         *cb=NULL;
-    int           xml_state = 0;
+    int           eom;
+    int           p0;           /* Start of input not pushed */
     int           poll;
 
-    if ((cb = cbuf_new()) == NULL){
-	clicon_err(OE_XML, errno, "cbuf_new");
-	return retval;
-    }
     memset(buf, 0, sizeof(buf));
     while (1){
 	if ((len = read(s, buf, sizeof(buf))) < 0){
@@ -256,24 +327,42 @@ netconf_input_cb(int   s,
 	    retval = 0;
 	    goto done;
 	}
+	/* Skip NULL chars (eg from terminals) */
+	for (i=j=0; i<len; i++)
+	    if (buf[i] != 0)
+		buf[j++] = buf[i];
+	len = j;
+	p0 = 0;
 	for (i=0; i<len; i++){
-	    if (buf[i] == 0)
-		continue; /* Skip NULL chars (eg from terminals) */
-	    cprintf(cb, "%c", buf[i]);
-	    if (detect_endtag("]]>]]>",
-			      buf[i],
-			      &xml_state)) {
-		/* OK, we have an xml string from a client */
-		/* Remove trailer */
-		*(((char*)cbuf_get(cb)) + cbuf_len(cb) - strlen("]]>]]>")) = '\0';
-		if (netconf_input_packet(h, cb) < 0 &&
+	    eom = detect_endtag(NETCONF_EOM, buf[i], &input_eom_state);
+	    if (eom){
+		/* OK, we have an xml string from a client
+		 * Push input before the trailer, which may start in previous input */
+		j = i + 1 - (strlen(NETCONF_EOM) - input_eom_held);
+		input_eom_held = 0;
+		if (j > p0 && netconf_input_push(h, buf + p0, j - p0) < 0)
+		    goto done;
+		p0 = i + 1;
+		if (netconf_input_eom(h) < 0 &&
 		    !ignore_packet_errors) // default is to ignore errors
 		    goto done; 
 		if (cc_closed)
 		    break;
-		cbuf_reset(cb);
+	    }
+	    else if (input_eom_held && input_eom_state <= i){
+		/* Chars held from previous input were not a trailer */
+		if (netconf_input_push(h, NETCONF_EOM, input_eom_held) < 0)
+		    goto done;
+		input_eom_held = 0;
 	    }
 	}
+	if (cc_closed)
+	    break;
+	/* Hold chars that may start a trailer, push the rest */
+	j = len - (input_eom_state - input_eom_held);
+	if (j > p0 && netconf_input_push(h, buf + p0, j - p0) < 0)
+	    goto done;
+	input_eom_held = input_eom_state;
 	/* poll==1 if more, poll==0 if none */
 	if ((poll = clixon_event_poll(s)) < 0)
 	    goto done;
@@ -282,8 +371,6 @@ netconf_input_cb(int   s,
     } /* while */
     retval = 0;
   done:
-    if (cb)
-	cbuf_free(cb);
     if (cc_closed) 
 	retval = -1;
     return retval;
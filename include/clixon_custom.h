@@ -66,20 +66,64 @@
  */
 #define IDENTITYREF_KLUDGE
 
-/*! Optimize special list key searches in XPATH finds
- * Identify xpaths that search for exactly a list key, eg: "y[k=3]" and then call
- * binary search. This only works if "y" has proper yang binding and is sorted by system
+/*! Optimize list key searches in XPATH finds
+ * Identify list steps whose predicates have equalities on list keys or explicit indexes, 
+ * eg: "y[k=3]" or "y[k2='b' and k1=3 and x>2]", and then call binary search.
+ * This only works if "y" has proper yang binding and is sorted by system
  */
 #define XPATH_LIST_OPTIMIZE
 
 /*! Add explicit search indexes, so that binary search can be made for non-key list indexes
  * This also applies if there are multiple keys and you want to search on only the second for 
  * example.
+ * Also, large ordered-by user lists are given a key index when searched, so that they
+ * can be binary searched although their elements are in user order.
  * There may be some cases where the index vector is not updated, need to verify before 
  * enabling this completely.
  */
 #define XML_EXPLICIT_INDEX
 
+/*! Maintain a summary of the names of the descendants of each XML element
+ * Each element has a bitmask of hashed names of its descendants, updated as nodes are
+ * added. XPath descendant searches, eg "//interface", skip subtrees whose summary 
+ * does not contain the name.
+ */
+#define XML_DESCENDANT_INDEX
+
+/*! Compile in a hand-written XML scanner as alternative to the flex/bison parser
+ * The scanner creates the same XML tree but scans the input in place, which is
+ * considerably faster on large files. 
+ * It is not used by default, enable it at runtime with the CLICON_XML_PARSE_FAST option
+ * or clixon_xml_parse_fast_set(1)
+ */
+#define XML_PARSE_FAST
+
+/*! Compile in a hand-written JSON scanner as alternative to the flex/bison parser
+ * The scanner translates module names to namespaces, binds yang and decodes identityrefs
+ * while parsing, instead of in separate passes over the tree.
+ * It is not used by default, enable it at runtime with the CLICON_JSON_PARSE_FAST option
+ * or clixon_json_parse_fast_set(1)
+ */
+#define JSON_PARSE_FAST
+
+/*! Compile in stamping of XML datastore files as sorted, so they are not sorted again when read
+ * If the CLICON_XMLDB_SORTED_STAMP option is set (default off), an XML datastore is written
+ * preceded by a comment with a checksum of the module-set-id and the names and revisions of
+ * the loaded yang modules. If a stamped file is read with the same yang modules, each node is
+ * only checked to be in order with its preceding sibling while parsing, instead of verifying
+ * all children of each node after parsing.
+ * If a node is out of order, eg in a file edited by hand, the rest of the input is sorted.
+ */
+#define XMLDB_SORTED_STAMP
+
+/*! Compare list elements using a cached binary encoding of their keys
+ * The key values of a list element are encoded once, when the element is first compared,
+ * so that memcmp of two encodings orders as the key values. Sorting and binary search
+ * of keyed lists then avoids looking up key leafs and comparing their typed values.
+ * Lists with key types that cannot be encoded, eg ip addresses, are compared as before.
+ */
+#define XML_KEY_BLOB
+
 /*! Treat <config> and <data> specially in a xmldb datastore.
  * config/data is treated as a "neutral" tag that does not have a yang spec.
  * In particular when binding xml to yang, if <config> is encountered as top-of-tree, do not
@@ -100,3 +144,10 @@
  * clixon-4.4
  */
 #define STATE_ORDERED_BY_SYSTEM
+
+/*! Size of reply chunks when the backend streams large replies to clients
+ * Replies are serialized and sent in chunks of (approximately) this size, so that a large
+ * get does not need the whole reply as one text buffer in the backend.
+ * @see CLICON_MSG_CHUNK
+ */
+#define CLIXON_REPLY_CHUNK_SIZE 65536
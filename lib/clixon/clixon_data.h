@@ -48,8 +48,10 @@
  */
 /* Struct per database in hash */
 typedef struct {
-    uint32_t  de_id;  /* session id */
-    cxobj    *de_xml; /* cache */
+    uint32_t               de_id;       /* session id */
+    cxobj                 *de_xml;      /* cache */
+    struct xmldb_snapshot *de_snapshot; /* Read-only view sharing de_xml, if any */
+    int                    de_multi;    /* All per-module files written, see CLICON_XMLDB_MULTI */
 } db_elmnt;
 
 /*
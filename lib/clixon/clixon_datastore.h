@@ -38,12 +38,20 @@
 #ifndef _CLIXON_DATASTORE_H
 #define _CLIXON_DATASTORE_H
 
+/*
+ * Types
+ */
+/* Read-only reference counted view of a datastore, opaque */
+typedef struct xmldb_snapshot xmldb_snapshot;
+
 /*
  * Prototypes
  * API
  */
 /* Internal functions */
 int xmldb_db2file(clicon_handle h, const char *db, char **filename);
+int xmldb_db2subdir(clicon_handle h, const char *db, char **dirname);
+int xmldb_multi_rm(clicon_handle h, const char *db);
 
 /* API */
 int xmldb_validate_db(const char *db);
@@ -53,10 +61,18 @@ int xmldb_disconnect(clicon_handle h);
 int xmldb_get(clicon_handle h, const char *db, cvec *nsc, char *xpath, cxobj **xtop);
 int xmldb_get0(clicon_handle h, const char *db,
 	       cvec *nsc, const char *xpath,
-	       int copy, cxobj **xtop, modstate_diff_t *msd); 
+	       int copy, int defaults, cxobj **xtop, modstate_diff_t *msd); 
+int xmldb_get_nodefaults(clicon_handle h, const char *db, cvec *nsc,
+			 const char *xpath, int32_t depth, cxobj **xret);
 int xmldb_get0_clear(clicon_handle h, cxobj *x);
 int xmldb_get0_free(clicon_handle h, cxobj **xp);
+int xmldb_snapshot_get(clicon_handle h, const char *db, xmldb_snapshot **xsp);
+cxobj *xmldb_snapshot_xml(xmldb_snapshot *xs);
+int xmldb_snapshot_release(clicon_handle h, xmldb_snapshot *xs);
 int xmldb_put(clicon_handle h, const char *db, enum operation_type op, cxobj *xt, char *username, cbuf *cbret); /* in clixon_datastore_write.[ch] */
+FILE *xmldb_fopen(clicon_handle h, const char *filename); /* in clixon_datastore_write.[ch] */
+int xmldb_fclose(FILE *f, const char *filename, int ok); /* in clixon_datastore_write.[ch] */
+int xmldb_dump(clicon_handle h, FILE *f, const char *format, cxobj *xt); /* in clixon_datastore_write.[ch] */
 int xmldb_copy(clicon_handle h, const char *from, const char *to);
 int xmldb_lock(clicon_handle h, const char *db, uint32_t id);
 int xmldb_unlock(clicon_handle h, const char *db);
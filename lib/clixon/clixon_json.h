@@ -43,6 +43,7 @@
 /*
  * Prototypes
  */
+int json2xml_decode_node(cxobj *x, cxobj **xerr);
 int json2xml_decode(cxobj *x, cxobj **xerr);
 int xml2json_cbuf(cbuf *cb, cxobj *x, int pretty);
 int xml2json_cbuf_vec(cbuf *cb, cxobj **vec, size_t veclen, int pretty);
@@ -50,6 +51,7 @@ int xml2json(FILE *f, cxobj *x, int pretty);
 int xml2json_cb(FILE *f, cxobj *x, int pretty, clicon_output_cb *fn);
 int json_print(FILE *f, cxobj *x);
 int xml2json_vec(FILE *f, cxobj **vec, size_t veclen, int pretty);
+int clixon_json_parse_fast_set(int enable);
 int clixon_json_parse_string(char *str, yang_bind yb, yang_stmt *yspec, cxobj **xt, cxobj **xret);
 int clixon_json_parse_file(int fd, yang_bind yb, yang_stmt *yspec, cxobj **xt, cxobj **xret);
 
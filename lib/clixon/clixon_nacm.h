@@ -53,12 +53,19 @@ enum nacm_access{
     NACM_EXEC
 };
 
+/* NACM read access of default values not in the XML tree, @see nacm_datanode_read0 */
+typedef struct nacm_read_ctx nacm_read_ctx;
+
 /*
  * Prototypes
  */
 int nacm_rpc(char *rpc, char *module, char *username, cxobj *xnacm, cbuf *cbret);
 int nacm_datanode_read(clicon_handle h, cxobj *xt, cxobj **xvec, size_t xlen, char *username,
 		       cxobj *nacm_xtree);
+int nacm_datanode_read0(clicon_handle h, cxobj *xt, cxobj **xvec, size_t xlen, char *username,
+			cxobj *nacm_xtree, nacm_read_ctx **nrp);
+int nacm_datanode_read_default(cxobj *x, yang_stmt *y, void *arg);
+int nacm_read_ctx_free(nacm_read_ctx *nr);
 int nacm_datanode_write(clicon_handle h, cxobj *xr, cxobj *xt,
 			enum nacm_access access,
 			char *username, cxobj *xnacm, cbuf *cbret);
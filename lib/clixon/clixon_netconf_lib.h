@@ -40,6 +40,12 @@
 #ifndef _CLIXON_NETCONF_LIB_H
 #define _CLIXON_NETCONF_LIB_H
 
+/*
+ * Constants
+ */
+/* With-defaults parameter of get and get-config, RFC 6243 */
+#define NETCONF_WITH_DEFAULTS_NAMESPACE "urn:ietf:params:xml:ns:yang:ietf-netconf-with-defaults"
+
 /*
  * Types
  */
@@ -105,6 +111,8 @@ char *netconf_db_find(cxobj *xn, char *name);
 int netconf_err2cb(cxobj *xerr, cbuf *cberr);
 const netconf_content netconf_content_str2int(char *str);
 const char *netconf_content_int2str(netconf_content nr);
+const int withdefaults_str2int(char *str);
+const char *withdefaults_int2str(withdefaults_type nr);
 int netconf_hello_server(clicon_handle h, cbuf *cb, uint32_t session_id);
 int netconf_hello_req(clicon_handle h, cbuf *cb);
 int clixon_netconf_error_fn(const char *fn, const int line, cxobj *xerr, const char *fmt, const char *arg);
@@ -51,6 +51,16 @@ enum format_enum{
     FORMAT_NETCONF
 };
 
+/* Flag in op_len of a reply chunk: more chunks follow, the last chunk is a regular message.
+ * The length of a chunk is given by the other bits, and the body is not null-terminated.
+ */
+#define CLICON_MSG_CHUNK 0x80000000
+
+/* Maximum length of a message including header, also of a reply assembled from chunks,
+ * since the length must fit in op_len without the chunk flag.
+ */
+#define CLICON_MSG_LEN_MAX (~CLICON_MSG_CHUNK & 0xffffffff)
+
 /* Protocol message header */
 struct clicon_msg {
     uint32_t    op_len;     /* length of message. network byte order. */
@@ -97,6 +107,8 @@ int send_msg_notify_xml(clicon_handle h, int s, cxobj *xev);
 
 int send_msg_reply(int s, char *data, uint32_t datalen);
 
+int send_msg_reply_chunk(int s, char *data, uint32_t datalen);
+
 int detect_endtag(char *tag, char  ch, int  *state);
 
 #endif  /* _CLIXON_PROTO_H_ */
@@ -99,6 +99,7 @@ int uri_percent_encode(char **encp, const char *str, ...);
 int xml_chardata_encode(char **escp, const char *fmt, ...);
 #endif
 int xml_chardata_cbuf_append(cbuf *cb, char *str);
+const char *clixon_memchr4(const char *s, size_t len, char c1, char c2, char c3, char c4);
 int uri_percent_decode(char *enc, char **str);
 const char *clicon_int2str(const map_str2int *mstab, int i);
 int clicon_str2int(const map_str2int *mstab, char *str);
@@ -70,6 +70,16 @@ enum operation_type{ /* edit-config operation */
     OP_NONE
 };
 
+#ifdef XML_KEY_BLOB
+/* State of cached binary key of list element, see xml_key_get */
+enum xml_key_state{
+    XK_NONE = 0, /* Not encoded */
+    XK_ALL,      /* All keys are encoded */
+    XK_MISSING,  /* All keys are encoded, some key leafs are missing */
+    XK_NO,       /* Cannot be encoded, compare key values */
+};
+#endif
+
 /* Netconf insert type (see RFC7950 Sec 7.8.6) */
 enum insert_type{ /* edit-config insert */
     INS_FIRST, 
@@ -78,6 +88,16 @@ enum insert_type{ /* edit-config insert */
     INS_AFTER,  
 };
 
+/* With-defaults retrieval modes, see RFC 6243 Sec 3 
+ * Default leafs are resolved from YANG when serializing, @see clicon_xml2cbuf_wdef
+ */
+enum withdefaults_type{ 
+    WITHDEFAULTS_REPORT_ALL, /* Report all data nodes including default values */
+    WITHDEFAULTS_TRIM,       /* Do not report leafs set to their default value */
+    WITHDEFAULTS_EXPLICIT,   /* Report data nodes in tree only */
+};
+typedef enum withdefaults_type withdefaults_type;
+
 /* XML object types */
 enum cxobj_type {CX_ERROR=-1, 
 		 CX_ELMNT, 
@@ -141,12 +161,18 @@ typedef struct clixon_xml_vec clixon_xvec; /* struct defined in clicon_xml_vec.c
 /*
  * xml_flag() flags:
  */
-#define XML_FLAG_MARK   0x01  /* Marker for dynamic algorithms, eg expand */
+#define XML_FLAG_MARK   0x01  /* Marker for dynamic algorithms, eg expand (transient) */
 #define XML_FLAG_ADD    0x02  /* Node is added (commits) or parent added rec*/
 #define XML_FLAG_DEL    0x04  /* Node is deleted (commits) or parent deleted rec */
 #define XML_FLAG_CHANGE 0x08  /* Node is changed (commits) or child changed rec */
-#define XML_FLAG_NONE   0x10  /* Node is added as NONE */
+#define XML_FLAG_NONE   0x10  /* Node is added as NONE (transient) */
 #define XML_FLAG_DEFAULT 0x20 /* Added as default value @see xml_default */
+#define XML_FLAG_SUBMARK 0x40 /* A descendant is marked, eg xpath match (transient) */
+
+/* Transient flags are only valid in the mark epoch they were set in, 
+ * @see xml_flag_epoch_next
+ */
+#define XML_FLAG_TRANSIENT (XML_FLAG_MARK|XML_FLAG_NONE|XML_FLAG_SUBMARK)
 
 /*
  * Prototypes
@@ -154,6 +180,7 @@ typedef struct clixon_xml_vec clixon_xvec; /* struct defined in clicon_xml_vec.c
 char     *xml_type2str(enum cxobj_type type);
 int       xml_stats_global(uint64_t *nr);
 int       xml_stats(cxobj *xt, uint64_t *nrp, size_t *szp);
+int       xml_descendant_maybe(cxobj *xn, const char *name);
 char     *xml_name(cxobj *xn);
 int       xml_name_set(cxobj *xn, char *name);
 char     *xml_prefix(cxobj *xn);
@@ -172,6 +199,7 @@ int       xml_parent_set(cxobj *xn, cxobj *parent);
 uint16_t  xml_flag(cxobj *xn, uint16_t flag);
 int       xml_flag_set(cxobj *xn, uint16_t flag);
 int       xml_flag_reset(cxobj *xn, uint16_t flag);
+int       xml_flag_epoch_next(void);
 
 char     *xml_value(cxobj *xn);
 int       xml_value_set(cxobj *xn, char *val);
@@ -188,6 +216,7 @@ int       xml_child_order(cxobj *xn, cxobj *xc);
 cxobj    *xml_child_each(cxobj *xparent, cxobj *xprev,  enum cxobj_type type);
 
 int       xml_child_insert_pos(cxobj *x, cxobj *xc, int i);
+int       xml_child_share(cxobj *xp, cxobj *xc);
 int       xml_childvec_set(cxobj *x, int len);
 cxobj   **xml_childvec_get(cxobj *x);
 cxobj    *xml_new(char *name, cxobj *xn_parent, enum cxobj_type type);
@@ -196,8 +225,13 @@ yang_stmt *xml_spec(cxobj *x);
 int       xml_spec_set(cxobj *x, yang_stmt *spec);
 cg_var   *xml_cv(cxobj *x);
 int       xml_cv_set(cxobj *x, cg_var *cv);
+#ifdef XML_KEY_BLOB
+enum xml_key_state xml_key_get(cxobj *x, uint8_t **key, size_t *len);
+int       xml_key_set(cxobj *x, enum xml_key_state state, uint8_t *key, size_t len);
+#endif
 cxobj    *xml_find(cxobj *xn_parent, char *name);
 int       xml_addsub(cxobj *xp, cxobj *xc);
+int       xml_addsub_children(cxobj *xp, cxobj *xfrom);
 cxobj    *xml_wrap_all(cxobj *xp, char *tag);
 cxobj    *xml_wrap(cxobj *xc, char *tag);
 int       xml_purge(cxobj *xc);
@@ -246,8 +280,11 @@ int       clicon_log_xml(int level, cxobj *x, const char *format, ...);
 int       xml_search_index_p(cxobj *x);
 
 int       xml_search_vector_get(cxobj *x, char *name, clixon_xvec **xvec);
+int       xml_search_keyvec_get(cxobj *xp, yang_stmt *y, clixon_xvec **xvec);
+int       xml_search_keyvec_add(cxobj *xp, yang_stmt *y, clixon_xvec **xvec);
 int       xml_search_child_insert(cxobj *xp, cxobj *x);
 int       xml_search_child_rm(cxobj *xp, cxobj *x);
+int       xml_search_index_update(cxobj *xc, int add);
 cxobj    *xml_child_index_each(cxobj *xparent, char *name, cxobj *xprev, enum cxobj_type type);
 
 
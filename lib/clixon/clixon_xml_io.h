@@ -40,6 +40,18 @@
 #ifndef _CLIXON_XML_IO_H_
 #define _CLIXON_XML_IO_H_
 
+/*
+ * Types
+ */
+/* Flush function for streamed serialization, may consume and reset the cbuf */
+typedef int (xml2cbuf_flush_fn)(cbuf *cb, void *arg);
+/* Filter of virtual default leafs: return 1 to print default leaf y in XML parent x, 
+ * 0 to skip it, -1 on error */
+typedef int (xml2cbuf_default_fn)(cxobj *x, yang_stmt *y, void *arg);
+
+/* Incremental XML parser, input is pushed in chunks, see clixon_xml_push_new */
+typedef struct clixon_xml_push clixon_xml_push;
+
 /*
  * Prototypes
  */
@@ -47,12 +59,24 @@ int clicon_xml2file_cb(FILE *f, cxobj *x, int level, int prettyprint, clicon_out
 int clicon_xml2file(FILE *f, cxobj *x, int level, int prettyprint);
 int xml_print(FILE *f, cxobj *xn);
 int clicon_xml2cbuf(cbuf *cb, cxobj *x, int level, int prettyprint, int32_t depth);
+int clicon_xml2cbuf_wdef(cbuf *cb, cxobj *x, int level, int prettyprint, int32_t depth,
+			 withdefaults_type wdef, xml2cbuf_flush_fn *fn, void *arg,
+			 xml2cbuf_default_fn *dfn, void *darg);
+int clicon_xml2cbuf_marked(cbuf *cb, cxobj *xt, const char *name, int32_t depth,
+			   withdefaults_type wdef, xml2cbuf_flush_fn *fn, void *arg);
 char *clicon_xml2str(cxobj *x);
 int xmltree2cbuf(cbuf *cb, cxobj *x, int level);
 
+int clixon_xml_parse_fast_set(int enable);
+int clixon_xml_parse_sorted_set(int sorted);
 int clixon_xml_parse_file(int fd, yang_bind yb, yang_stmt *yspec, char *endtag, cxobj **xt, cxobj **xerr);
 int clixon_xml_parse_string(const char *str, yang_bind yb, yang_stmt *yspec, cxobj **xt, cxobj **xerr);
 
+clixon_xml_push *clixon_xml_push_new(yang_bind yb, yang_stmt *yspec);
+int clixon_xml_push_data(clixon_xml_push *xp, const char *buf, size_t len);
+int clixon_xml_push_end(clixon_xml_push *xp, cxobj **xt, cxobj **xerr);
+int clixon_xml_push_free(clixon_xml_push *xp);
+
 #if defined(__GNUC__) && __GNUC__ >= 3
 int clixon_xml_parse_va(yang_bind yb, yang_stmt *yspec, cxobj **xt, cxobj **xerr, 
 			const char *format, ...)  __attribute__ ((format (printf, 5, 6)));
@@ -44,15 +44,21 @@
 int xml_cmp(cxobj *x1, cxobj *x2, int same, int skip1, char *expl);
 int xml_sort(cxobj *x0);
 int xml_sort_recurse(cxobj *xn);
+int xml_sort_node(cxobj *x);
 int xml_insert(cxobj *xp, cxobj *xc, enum insert_type ins, char *key_val, cvec *nsckey);
+int xml_insert_vec(cxobj *xp, clixon_xvec *xv);
 int xml_sort_verify(cxobj *x, void *arg);
+int xml_sort_verify_prev(cxobj *x);
 #ifdef XML_EXPLICIT_INDEX
 int xml_search_indexvar_binary_pos(cxobj *xp, char *indexvar, clixon_xvec *xvec,
 				   int low, int upper, int max, int *eq);
 #endif
 int match_base_child(cxobj *x0, cxobj *x1c, yang_stmt *yc, cxobj **x0cp);
+int match_base_child_sorted(cxobj *x0, cxobj *x1c, yang_stmt *yc, int *cursor,
+			    cxobj **x1prev, cxobj **x0cp);
 int clixon_xml_find_index(cxobj *xp, yang_stmt *yp, char *ns, char *name,
 			  cvec *cvk, clixon_xvec *xvec);
 int clixon_xml_find_pos(cxobj *xp, yang_stmt *yc, uint32_t pos, clixon_xvec *xvec);
+int xml_child_range_yang(cxobj *xp, yang_stmt *yc, int *first, int *len);
 
 #endif /* _CLIXON_XML_SORT_H */
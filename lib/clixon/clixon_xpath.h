@@ -115,6 +115,8 @@ struct xpath_tree{
     struct xpath_tree *xs_c0;     /* child 0 */
     struct xpath_tree *xs_c1;     /* child 1 */
     int                xs_match; /* meta: match this node */
+    yang_stmt         *xs_yparent; /* meta: step, yang of last context node */
+    yang_stmt         *xs_ychild;  /* meta: step, yang of children selected from it */
 };
 typedef struct xpath_tree xpath_tree;
 
@@ -128,6 +130,8 @@ int   xpath_tree_print(FILE *f, xpath_tree *xs);
 int   xpath_tree2cbuf(xpath_tree *xs, cbuf *xpathcb);
 int   xpath_tree_eq(xpath_tree *xt1, xpath_tree *xt2, xpath_tree ***vec, size_t *len);
 xpath_tree *xpath_tree_traverse(xpath_tree *xt, ...);
+xpath_tree *xpath_tree_unwrap(xpath_tree *xs);
+int   xpath_tree_positional(xpath_tree *xs);
 int   xpath_tree_free(xpath_tree *xs);
 int   xpath_parse(const char *xpath, xpath_tree **xptree);
 int   xpath_vec_ctx(cxobj *xcur, cvec *nsc, const char *xpath, int localonly, xp_ctx  **xrp);
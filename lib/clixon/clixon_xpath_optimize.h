@@ -39,7 +39,7 @@
 #define _CLIXON_XPATH_OPTIMIZE_H
 
 
-int  xpath_list_optimize_stats(int *hits);
+int  xpath_list_optimize_stats(int *hits, int *indexhits, int *misses);
 int  xpath_list_optimize_set(int enable); 
 void xpath_optimize_exit(void);
 int  xpath_optimize_check(xpath_tree *xs, cxobj *xv, cxobj ***xvec0, int *xlen0);
@@ -55,6 +55,11 @@
 #ifdef XML_EXPLICIT_INDEX
 #define YANG_FLAG_INDEX 0x02  /* This yang node under list is (extra) index. --> you can access
 			       * list elements using this index with binary search */
+#define YANG_FLAG_INDEX_LIST 0x04 /* This yang list has (extra) index children */
+#endif
+#ifdef XML_KEY_BLOB
+#define YANG_FLAG_KEY_BLOB_DONE 0x08 /* YANG_FLAG_KEY_BLOB of this yang list is set */
+#define YANG_FLAG_KEY_BLOB 0x10 /* All keys of this yang list can be encoded, see xml_cmp */
 #endif
 
 /*
@@ -156,6 +161,8 @@ struct xml;
 
 typedef struct yang_stmt yang_stmt; /* Defined in clixon_yang_internal */
 
+typedef struct yang_json_cache yang_json_cache; /* Defined in clixon_json.c */
+
 /*! Yang apply function worker
  * @param[in]  yn   yang node
  * @param[in]  arg  Argument
@@ -200,6 +207,8 @@ int        yang_cvec_set(yang_stmt *ys, cvec *cvv);
 uint16_t   yang_flag_get(yang_stmt *ys, uint16_t flag);
 int        yang_flag_set(yang_stmt *ys, uint16_t flag);
 int        yang_flag_reset(yang_stmt *ys, uint16_t flag);
+yang_json_cache *yang_json_cache_get(yang_stmt *ys);
+int        yang_json_cache_set(yang_stmt *ys, yang_json_cache *yj);
 
 /* Other functions */
 yang_stmt *yspec_new(void);
@@ -118,6 +118,142 @@ xmldb_db2file(clicon_handle  h,
     return retval;
 }
 
+/*! Translate from symbolic database name to per-module file directory
+ * @param[in]   h        Clicon handle
+ * @param[in]   db       Symbolic database name, eg "candidate", "running"
+ * @param[out]  dirname  Directory name. Unallocate after use with free()
+ * @retval      0        OK
+ * @retval     -1        Error
+ * @see CLICON_XMLDB_MULTI  where each top-level module is stored in a file in this dir
+ */
+int
+xmldb_db2subdir(clicon_handle  h, 
+		const char    *db,
+		char         **dirname)
+{
+    int   retval = -1;
+    cbuf *cb = NULL;
+    char *dir;
+
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_XML, errno, "cbuf_new");
+	goto done;
+    }
+    if ((dir = clicon_xmldb_dir(h)) == NULL){
+	clicon_err(OE_XML, errno, "dbdir not set");
+	goto done;
+    }
+    cprintf(cb, "%s/%s.d", dir, db);
+    if ((*dirname = strdup4(cbuf_get(cb))) == NULL){
+	clicon_err(OE_UNIX, errno, "strdup");
+	goto done;
+    }
+    retval = 0;
+ done:
+    if (cb)
+	cbuf_free(cb);
+    return retval;
+}
+
+/*! Remove all per-module files of a database
+ * @param[in]   h        Clicon handle
+ * @param[in]   db       Symbolic database name, eg "candidate", "running"
+ * @retval      0        OK
+ * @retval     -1        Error
+ * @see CLICON_XMLDB_MULTI
+ */
+int
+xmldb_multi_rm(clicon_handle  h, 
+	       const char    *db)
+{
+    int            retval = -1;
+    char          *dir = NULL;
+    struct dirent *dp = NULL;
+    int            ndp;
+    int            i;
+    char           filename[MAXPATHLEN];
+
+    if (xmldb_db2subdir(h, db, &dir) < 0)
+	goto done;
+    if ((ndp = clicon_file_dirent(dir, &dp, NULL, S_IFREG)) < 0)
+	goto done;
+    for (i = 0; i < ndp; i++){
+	snprintf(filename, MAXPATHLEN-1, "%s/%s", dir, dp[i].d_name);
+	if (unlink(filename) < 0 && errno != ENOENT){
+	    clicon_err(OE_UNIX, errno, "unlink(%s)", filename);
+	    goto done;
+	}
+    }
+    retval = 0;
+ done:
+    if (dp)
+	free(dp);
+    if (dir)
+	free(dir);
+    return retval;
+}
+
+/*! Copy all per-module files of a database to another database
+ * @param[in]  h     Clicon handle
+ * @param[in]  from  Source database
+ * @param[in]  to    Destination database
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+xmldb_multi_copy(clicon_handle h, 
+		 const char   *from, 
+		 const char   *to)
+{
+    int            retval = -1;
+    char          *fromdir = NULL;
+    char          *todir = NULL;
+    struct dirent *dp = NULL;
+    int            ndp;
+    int            i;
+    struct stat    st;
+    char           fromfile[MAXPATHLEN];
+    char           tofile[MAXPATHLEN];
+
+    if (xmldb_multi_rm(h, to) < 0)
+	goto done;
+    if (xmldb_db2subdir(h, from, &fromdir) < 0)
+	goto done;
+    if (xmldb_db2subdir(h, to, &todir) < 0)
+	goto done;
+    if ((ndp = clicon_file_dirent(fromdir, &dp, NULL, S_IFREG)) < 0)
+	goto done;
+    if (ndp == 0){
+	retval = 0;
+	goto done;
+    }
+    if (stat(todir, &st) < 0){
+	if (errno != ENOENT){
+	    clicon_err(OE_UNIX, errno, "stat(%s)", todir);
+	    goto done;
+	}
+	if (mkdir(todir, S_IRWXU|S_IRGRP|S_IXGRP|S_IROTH|S_IXOTH) < 0){
+	    clicon_err(OE_UNIX, errno, "mkdir(%s)", todir);
+	    goto done;
+	}
+    }
+    for (i = 0; i < ndp; i++){
+	snprintf(fromfile, MAXPATHLEN-1, "%s/%s", fromdir, dp[i].d_name);
+	snprintf(tofile, MAXPATHLEN-1, "%s/%s", todir, dp[i].d_name);
+	if (clicon_file_copy(fromfile, tofile) < 0)
+	    goto done;
+    }
+    retval = 0;
+ done:
+    if (dp)
+	free(dp);
+    if (fromdir)
+	free(fromdir);
+    if (todir)
+	free(todir);
+    return retval;
+}
+
 /*! Ensure database name is correct
  * @param[in]   db    Name of database 
  * @retval  0   OK
@@ -162,13 +298,17 @@ xmldb_disconnect(clicon_handle h)
     
     if (clicon_hash_keys(clicon_db_elmnt(h), &keys, &klen) < 0)
 	goto done;
-    for(i = 0; i < klen; i++) 
+    for(i = 0; i < klen; i++) {
+	/* Outstanding snapshots keep their trees */
+	if (xmldb_snapshot_detach(h, keys[i], 0) < 0)
+	    goto done;
 	if ((de = clicon_hash_value(clicon_db_elmnt(h), keys[i], NULL)) != NULL){
 	    if (de->de_xml){
 		xml_free(de->de_xml);
 		de->de_xml = NULL;
 	    }
 	}
+    }
     retval = 0;
  done:
     if (keys)
@@ -200,6 +340,9 @@ xmldb_copy(clicon_handle h,
     /* XXX lock */
     if (clicon_datastore_cache(h) != DATASTORE_NOCACHE){
 	/* Copy in-memory cache */
+	/* 0. Snapshots of "to" keep the old tree */
+	if (xmldb_snapshot_detach(h, to, 0) < 0)
+	    goto done;
 	/* 1. "to" xml tree in x1 */
 	if ((de1 = clicon_db_elmnt_get(h, from)) != NULL)
 	    x1 = de1->de_xml;
@@ -231,6 +374,8 @@ xmldb_copy(clicon_handle h,
 	if (de2)
 	    de0 = *de2;
 	de0.de_xml = x2; /* The new tree */
+	/* The per-module files are copied below */
+	de0.de_multi = de1 ? de1->de_multi : 0;
 	clicon_db_elmnt_set(h, to, &de0);
     }
     /* Copy the files themselves (above only in-memory cache) */
@@ -240,6 +385,9 @@ xmldb_copy(clicon_handle h,
 	goto done;
     if (clicon_file_copy(fromfile, tofile) < 0)
 	goto done;
+    if (clicon_option_bool(h, "CLICON_XMLDB_MULTI") &&
+	xmldb_multi_copy(h, from, to) < 0)
+	goto done;
     retval = 0;
  done:
     if (fromfile)
@@ -383,6 +531,9 @@ xmldb_clear(clicon_handle h,
     db_elmnt *de = NULL;
     
     if (clicon_datastore_cache(h) != DATASTORE_NOCACHE){
+	/* Snapshots keep the tree, and free it when released */
+	if (xmldb_snapshot_detach(h, db, 0) < 0)
+	    return -1;
 	if ((de = clicon_db_elmnt_get(h, db)) != NULL){
 	    if ((xt = de->de_xml) != NULL){
 		xml_free(xt);
@@ -406,6 +557,7 @@ xmldb_delete(clicon_handle h,
     int                 retval = -1;
     char               *filename = NULL;
     struct stat         sb;
+    db_elmnt           *de;
     
     if (xmldb_clear(h, db) < 0)
 	goto done;
@@ -416,6 +568,12 @@ xmldb_delete(clicon_handle h,
 	    clicon_err(OE_DB, errno, "truncate %s", filename);
 	    goto done;
 	}
+    if (clicon_option_bool(h, "CLICON_XMLDB_MULTI")){
+	if (xmldb_multi_rm(h, db) < 0)
+	    goto done;
+	if ((de = clicon_db_elmnt_get(h, db)) != NULL)
+	    de->de_multi = 0;
+    }
     retval = 0;
  done:
     if (filename)
@@ -440,6 +598,8 @@ xmldb_create(clicon_handle h,
     cxobj              *xt = NULL;
 
     if (clicon_datastore_cache(h) != DATASTORE_NOCACHE){ 
+	if (xmldb_snapshot_detach(h, db, 0) < 0)
+	    goto done;
 	if ((de = clicon_db_elmnt_get(h, db)) != NULL){
 	    if ((xt = de->de_xml) != NULL){
 		xml_free(xt);
@@ -0,0 +1,662 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+
+  Copyright (C) 2009-2016 Olof Hagsand and Benny Holmgren
+  Copyright (C) 2017-2019 Olof Hagsand
+  Copyright (C) 2020 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2,
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+
+ * Compact binary datastore format
+ *
+ * A binary datastore file is a header followed by the XML tree in pre-order. Element
+ * names are not stored per node, but as ids in a symbol table defined inline the first
+ * time a symbol is used. A symbol is an element name and prefix under a parent symbol,
+ * with the namespace of its yang statement, which is resolved to yang once per symbol
+ * when loading instead of binding every node.
+ *
+ * File layout (integers are LEB128 varints unless noted):
+ *   header:  "CLXB" <version:1 byte> <stamp:4 bytes little-endian>
+ *   element: 'E' <symbol id> [<parent symbol id + 1> <prefix> <name> <namespace>] 
+ *            <nr of children> <children>
+ *            The bracketed symbol definition follows iff symbol id is a new id
+ *   attr:    'A' <prefix> <name> <value>
+ *   body:    'B' <value>
+ *   string:  <len + 1> <len bytes> NUL, where 0 is a NULL string
+ * Strings are NUL-terminated in the file so that they can be used directly from the
+ * memory-mapped file. The stamp is a checksum of the yang modules the tree was sorted
+ * with, if it matches when loaded the order of each node is only checked with its
+ * preceding sibling, and the tree is sorted only if a node is out of order.
+ * @see xmldb_modules_sum
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include "clixon_err.h"
+#include "clixon_queue.h"
+#include "clixon_hash.h"
+#include "clixon_handle.h"
+#include "clixon_yang.h"
+#include "clixon_xml.h"
+#include "clixon_yang_module.h"
+#include "clixon_xml_sort.h"
+#include "clixon_xml_bind.h"
+#include "clixon_datastore_binary.h"
+
+/*
+ * Constants
+ */
+#define XMLDB_BINARY_MAGIC   "CLXB"
+#define XMLDB_BINARY_VERSION 1
+#define XMLDB_BINARY_HDRLEN  9
+
+/* Max nesting of elements when loading */
+#define XMLDB_BINARY_MAXDEPTH 10000
+
+/*
+ * Types
+ */
+/*! Symbol when writing, strings point into the XML tree */
+struct bin_wsym {
+    uint32_t   bw_parent;  /* Parent symbol id + 1, 0 if top-level */
+    yang_stmt *bw_ys;      /* Yang statement, or NULL if not bound */
+    char      *bw_prefix;  /* Element prefix, or NULL */
+    char      *bw_name;    /* Element name */
+};
+
+/*! Binary datastore writer */
+struct bin_writer {
+    FILE            *bw_f;     /* Output file */
+    struct bin_wsym *bw_syms;  /* Symbol table, indexed by id */
+    uint32_t         bw_nsyms; /* Nr of symbols */
+    uint32_t         bw_max;   /* Allocated symbols */
+    uint32_t        *bw_hash;  /* Open hash of symbol id + 1, 0 is empty */
+    uint32_t         bw_hsize; /* Hash size, power of 2 */
+};
+
+/*! Symbol when loading, strings point into the mapped file */
+struct bin_rsym {
+    yang_stmt *br_ys;      /* Resolved yang statement, or NULL */
+    char      *br_prefix;  /* Element prefix, or NULL */
+    char      *br_name;    /* Element name */
+};
+
+/*! Binary datastore loader */
+struct bin_reader {
+    char            *br_p;          /* Current position */
+    char            *br_end;        /* End of mapped file */
+    yang_stmt       *br_yspec;      /* Yang spec */
+    struct bin_rsym *br_syms;       /* Symbol table, indexed by id */
+    uint32_t         br_nsyms;      /* Nr of symbols */
+    uint32_t         br_max;        /* Allocated symbols */
+    int              br_depth;      /* Current element nesting */
+    int              br_unresolved; /* Bound symbols not found in yang spec */
+    int              br_sorted;     /* Stamp matches: check order of each node only */
+    int              br_unsorted;   /* A node is out of order, tree needs to be sorted */
+};
+
+/*! Write unsigned integer as LEB128 varint
+ */
+static inline void
+bin_put_varint(FILE    *f,
+	       uint64_t v)
+{
+    while (v >= 0x80){
+	putc((int)(v & 0x7f) | 0x80, f);
+	v >>= 7;
+    }
+    putc((int)v, f);
+}
+
+/*! Write string, or NULL
+ */
+static void
+bin_put_str(FILE *f,
+	    char *s)
+{
+    size_t len;
+
+    if (s == NULL){
+	putc(0, f);
+	return;
+    }
+    len = strlen(s);
+    bin_put_varint(f, len + 1);
+    fwrite(s, 1, len + 1, f); /* Including NUL */
+}
+
+/*! Hash of symbol key
+ */
+static uint32_t
+bin_sym_hash(uint32_t   parent,
+	     yang_stmt *ys,
+	     char      *prefix,
+	     char      *name)
+{
+    uint32_t h = 2166136261U;
+    char    *s;
+
+    h = (h ^ parent) * 16777619;
+    h = (h ^ (uint32_t)(uintptr_t)ys) * 16777619;
+    for (s = name; *s; s++)
+	h = (h ^ (unsigned char)*s) * 16777619;
+    if (prefix)
+	for (s = prefix; *s; s++)
+	    h = (h ^ (unsigned char)*s) * 16777619;
+    return h;
+}
+
+/*! Double the symbol hash and rehash all symbols
+ */
+static int
+bin_sym_rehash(struct bin_writer *bw)
+{
+    uint32_t         hsize = bw->bw_hsize ? bw->bw_hsize * 2 : 256;
+    uint32_t        *hash;
+    struct bin_wsym *sym;
+    uint32_t         i;
+    uint32_t         j;
+
+    if ((hash = calloc(hsize, sizeof(*hash))) == NULL){
+	clicon_err(OE_UNIX, errno, "calloc");
+	return -1;
+    }
+    for (i=0; i<bw->bw_nsyms; i++){
+	sym = &bw->bw_syms[i];
+	j = bin_sym_hash(sym->bw_parent, sym->bw_ys, sym->bw_prefix, sym->bw_name) & (hsize-1);
+	while (hash[j])
+	    j = (j+1) & (hsize-1);
+	hash[j] = i+1;
+    }
+    if (bw->bw_hash)
+	free(bw->bw_hash);
+    bw->bw_hash = hash;
+    bw->bw_hsize = hsize;
+    return 0;
+}
+
+/*! Find symbol of an element, or add it
+ * @param[in]  bw     Binary writer
+ * @param[in]  parent Parent symbol id + 1, 0 if top-level
+ * @param[in]  x      XML element
+ * @param[out] id     Symbol id
+ * @retval     1      Symbol found
+ * @retval     0      New symbol added, needs to be defined in the file
+ * @retval    -1      Error
+ */
+static int
+bin_sym_get(struct bin_writer *bw,
+	    uint32_t           parent,
+	    cxobj             *x,
+	    uint32_t          *id)
+{
+    yang_stmt       *ys = xml_spec(x);
+    char            *prefix = xml_prefix(x);
+    char            *name = xml_name(x);
+    struct bin_wsym *sym;
+    uint32_t         j;
+
+    if (2*(bw->bw_nsyms+1) > bw->bw_hsize && bin_sym_rehash(bw) < 0)
+	return -1;
+    j = bin_sym_hash(parent, ys, prefix, name) & (bw->bw_hsize-1);
+    while (bw->bw_hash[j]){
+	sym = &bw->bw_syms[bw->bw_hash[j]-1];
+	if (sym->bw_parent == parent &&
+	    sym->bw_ys == ys &&
+	    strcmp(sym->bw_name, name) == 0 &&
+	    (prefix == NULL ? sym->bw_prefix == NULL :
+	     (sym->bw_prefix != NULL && strcmp(sym->bw_prefix, prefix) == 0))){
+	    *id = bw->bw_hash[j]-1;
+	    return 1;
+	}
+	j = (j+1) & (bw->bw_hsize-1);
+    }
+    if (bw->bw_nsyms == bw->bw_max){
+	bw->bw_max = bw->bw_max ? bw->bw_max * 2 : 64;
+	if ((sym = realloc(bw->bw_syms, bw->bw_max*sizeof(*sym))) == NULL){
+	    clicon_err(OE_UNIX, errno, "realloc");
+	    return -1;
+	}
+	bw->bw_syms = sym;
+    }
+    sym = &bw->bw_syms[bw->bw_nsyms];
+    sym->bw_parent = parent;
+    sym->bw_ys = ys;
+    sym->bw_prefix = prefix;
+    sym->bw_name = name;
+    *id = bw->bw_nsyms++;
+    bw->bw_hash[j] = *id + 1;
+    return 0;
+}
+
+/*! Write XML node and its children in binary format
+ * @param[in]  bw     Binary writer
+ * @param[in]  parent Symbol id + 1 of parent element, 0 if top-level
+ * @param[in]  x      XML node
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+bin_write_node(struct bin_writer *bw,
+	       uint32_t           parent,
+	       cxobj             *x)
+{
+    FILE      *f = bw->bw_f;
+    cxobj     *xc;
+    uint32_t   id;
+    yang_stmt *ys;
+    int        ret;
+
+    switch (xml_type(x)){
+    case CX_ELMNT:
+	if ((ret = bin_sym_get(bw, parent, x, &id)) < 0)
+	    return -1;
+	putc('E', f);
+	bin_put_varint(f, id);
+	if (ret == 0){ /* Define new symbol */
+	    bin_put_varint(f, parent);
+	    bin_put_str(f, xml_prefix(x));
+	    bin_put_str(f, xml_name(x));
+	    ys = xml_spec(x);
+	    bin_put_str(f, ys ? yang_find_mynamespace(ys) : NULL);
+	}
+	bin_put_varint(f, xml_child_nr(x));
+	xc = NULL;
+	while ((xc = xml_child_each(x, xc, -1)) != NULL)
+	    if (bin_write_node(bw, id+1, xc) < 0)
+		return -1;
+	break;
+    case CX_ATTR:
+	putc('A', f);
+	bin_put_str(f, xml_prefix(x));
+	bin_put_str(f, xml_name(x));
+	bin_put_str(f, xml_value(x));
+	break;
+    case CX_BODY:
+	putc('B', f);
+	bin_put_str(f, xml_value(x));
+	break;
+    default:
+	break;
+    }
+    return 0;
+}
+
+/*! Write XML tree to file in binary datastore format
+ * @param[in]  f      Output file
+ * @param[in]  stamp  Checksum of yang modules xt is sorted with
+ * @param[in]  xt     XML tree, written including the top node
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see xmldb_binary_read
+ */
+int
+xmldb_binary_write(FILE    *f,
+		   uint32_t stamp,
+		   cxobj   *xt)
+{
+    int               retval = -1;
+    struct bin_writer bw = {0,};
+    int               i;
+
+    bw.bw_f = f;
+    fwrite(XMLDB_BINARY_MAGIC, 1, strlen(XMLDB_BINARY_MAGIC), f);
+    putc(XMLDB_BINARY_VERSION, f);
+    for (i=0; i<4; i++)
+	putc((stamp >> (8*i)) & 0xff, f);
+    if (bin_write_node(&bw, 0, xt) < 0)
+	goto done;
+    if (fflush(f) != 0 || ferror(f)){
+	clicon_err(OE_UNIX, errno, "fwrite");
+	goto done;
+    }
+    retval = 0;
+ done:
+    if (bw.bw_syms)
+	free(bw.bw_syms);
+    if (bw.bw_hash)
+	free(bw.bw_hash);
+    return retval;
+}
+
+/*! Report a truncated or malformed binary datastore
+ */
+static int
+bin_read_err(struct bin_reader *br,
+	     const char        *reason)
+{
+    clicon_err(OE_XML, 0, "binary datastore: %s", reason);
+    return -1;
+}
+
+/*! Read LEB128 varint
+ */
+static int
+bin_get_varint(struct bin_reader *br,
+	       uint64_t          *v)
+{
+    uint64_t u = 0;
+    int      shift = 0;
+    unsigned char c;
+
+    do {
+	if (br->br_p >= br->br_end || shift > 63)
+	    return bin_read_err(br, "truncated integer");
+	c = *br->br_p++;
+	u |= (uint64_t)(c & 0x7f) << shift;
+	shift += 7;
+    } while (c & 0x80);
+    *v = u;
+    return 0;
+}
+
+/*! Read string, pointing into the mapped file
+ */
+static int
+bin_get_str(struct bin_reader *br,
+	    char             **s)
+{
+    uint64_t len;
+
+    if (bin_get_varint(br, &len) < 0)
+	return -1;
+    if (len == 0){
+	*s = NULL;
+	return 0;
+    }
+    if (len > (uint64_t)(br->br_end - br->br_p) || br->br_p[len-1] != '\0')
+	return bin_read_err(br, "truncated string");
+    *s = br->br_p;
+    br->br_p += len;
+    return 0;
+}
+
+/*! Read symbol definition and resolve its yang statement
+ * @param[in]  br     Binary reader
+ * @retval     0      OK, symbol added
+ * @retval    -1      Error
+ * Bound symbols are looked up by name in the parent yang statement, or in the module of
+ * their namespace if the parent is not bound. A bound symbol that can not be resolved
+ * this way is left unbound and the whole tree is bound after loading.
+ */
+static int
+bin_sym_define(struct bin_reader *br)
+{
+    struct bin_rsym *sym;
+    uint64_t         parent;
+    char            *ns;
+    char            *myns;
+    yang_stmt       *yp = NULL;
+    yang_stmt       *ymod;
+    yang_stmt       *ys = NULL;
+
+    if (br->br_nsyms == br->br_max){
+	br->br_max = br->br_max ? br->br_max * 2 : 64;
+	if ((sym = realloc(br->br_syms, br->br_max*sizeof(*sym))) == NULL){
+	    clicon_err(OE_UNIX, errno, "realloc");
+	    return -1;
+	}
+	br->br_syms = sym;
+    }
+    sym = &br->br_syms[br->br_nsyms];
+    if (bin_get_varint(br, &parent) < 0 ||
+	bin_get_str(br, &sym->br_prefix) < 0 ||
+	bin_get_str(br, &sym->br_name) < 0 ||
+	bin_get_str(br, &ns) < 0)
+	return -1;
+    if (parent > br->br_nsyms || sym->br_name == NULL)
+	return bin_read_err(br, "invalid symbol");
+    if (parent)
+	yp = br->br_syms[parent-1].br_ys;
+    if (ns != NULL){
+	if (yp != NULL){
+	    if ((ys = yang_find_datanode(yp, sym->br_name)) != NULL &&
+		((myns = yang_find_mynamespace(ys)) == NULL || strcmp(myns, ns) != 0))
+		ys = NULL;
+	}
+	else if ((ymod = yang_find_module_by_namespace(br->br_yspec, ns)) != NULL)
+	    ys = yang_find_schemanode(ymod, sym->br_name);
+	if (ys == NULL)
+	    br->br_unresolved++;
+    }
+    sym->br_ys = ys;
+    br->br_nsyms++;
+    return 0;
+}
+
+/*! Load XML node and its children from binary datastore
+ * @param[in]  br     Binary reader
+ * @param[in]  xp     Parent XML node
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+bin_read_node(struct bin_reader *br,
+	      cxobj             *xp)
+{
+    cxobj           *x;
+    struct bin_rsym *sym;
+    uint64_t         id;
+    uint64_t         nr;
+    uint64_t         i;
+    char            *prefix;
+    char            *name;
+    char            *value;
+    int              ret;
+
+    if (br->br_p >= br->br_end)
+	return bin_read_err(br, "truncated node");
+    switch (*br->br_p++){
+    case 'E':
+	if (bin_get_varint(br, &id) < 0)
+	    return -1;
+	if (id == br->br_nsyms){
+	    if (bin_sym_define(br) < 0)
+		return -1;
+	}
+	else if (id > br->br_nsyms)
+	    return bin_read_err(br, "invalid symbol id");
+	sym = &br->br_syms[id];
+	if ((x = xml_new(sym->br_name, xp, CX_ELMNT)) == NULL)
+	    return -1;
+	if (sym->br_prefix && xml_prefix_set(x, sym->br_prefix) < 0)
+	    return -1;
+	if (sym->br_ys)
+	    xml_spec_set(x, sym->br_ys);
+	if (bin_get_varint(br, &nr) < 0)
+	    return -1;
+	if (++br->br_depth > XMLDB_BINARY_MAXDEPTH)
+	    return bin_read_err(br, "too deep nesting");
+	for (i=0; i<nr; i++)
+	    if (bin_read_node(br, x) < 0)
+		return -1;
+	br->br_depth--;
+	if (xml_bind_yang_close(x) < 0)
+	    return -1;
+	if (br->br_sorted && !br->br_unsorted){
+	    if ((ret = xml_sort_verify_prev(x)) < 0)
+		return -1;
+	    if (ret == 0)
+		br->br_unsorted = 1;
+	}
+	break;
+    case 'A':
+	if (bin_get_str(br, &prefix) < 0 ||
+	    bin_get_str(br, &name) < 0 ||
+	    bin_get_str(br, &value) < 0)
+	    return -1;
+	if (name == NULL)
+	    return bin_read_err(br, "invalid attribute");
+	if ((x = xml_new(name, xp, CX_ATTR)) == NULL)
+	    return -1;
+	if (prefix && xml_prefix_set(x, prefix) < 0)
+	    return -1;
+	if (value && xml_value_set(x, value) < 0)
+	    return -1;
+	break;
+    case 'B':
+	if (bin_get_str(br, &value) < 0)
+	    return -1;
+	if ((x = xml_new("body", xp, CX_BODY)) == NULL)
+	    return -1;
+	if (value && xml_value_set(x, value) < 0)
+	    return -1;
+	break;
+    default:
+	return bin_read_err(br, "invalid node type");
+    }
+    return 0;
+}
+
+/*! Load XML tree from buffer in binary datastore format
+ *
+ * The tree is created with element names and yang bindings taken from the symbol
+ * table of the buffer.
+ * @param[in]  buf    Binary datastore, strings are used directly from it while loading
+ * @param[in]  len    Length of buf
+ * @param[in]  yspec  Yang spec
+ * @param[in]  stamp  Checksum of current yang modules, sort tree if it was written with other
+ * @param[out] xtop   XML tree with a "top" node as parent of the written tree. Free with xml_free
+ * @retval     0      OK
+ * @retval    -1      Error
+ * An empty buffer results in an empty "top" node.
+ * @see xmldb_binary_write
+ * @see xmldb_binary_read  Load from file
+ */
+int
+xmldb_binary_parse(char      *buf,
+		   size_t     len,
+		   yang_stmt *yspec,
+		   uint32_t   stamp,
+		   cxobj    **xtop)
+{
+    int               retval = -1;
+    struct bin_reader br = {0,};
+    cxobj            *xt = NULL;
+    cxobj            *x;
+    uint32_t          s = 0;
+    int               i;
+
+    if ((xt = xml_new("top", NULL, CX_ELMNT)) == NULL)
+	goto done;
+    if (len == 0)
+	goto ok;
+    if (len < XMLDB_BINARY_HDRLEN){
+	bin_read_err(&br, "truncated header");
+	goto done;
+    }
+    if (memcmp(buf, XMLDB_BINARY_MAGIC, strlen(XMLDB_BINARY_MAGIC)) != 0 ||
+	buf[4] != XMLDB_BINARY_VERSION){
+	bin_read_err(&br, "bad magic or version");
+	goto done;
+    }
+    for (i=0; i<4; i++)
+	s |= (uint32_t)(unsigned char)buf[5+i] << (8*i);
+    br.br_p = buf + XMLDB_BINARY_HDRLEN;
+    br.br_end = buf + len;
+    br.br_yspec = yspec;
+    br.br_sorted = (s == stamp);
+    while (br.br_p < br.br_end)
+	if (bin_read_node(&br, xt) < 0)
+	    goto done;
+    if (br.br_unresolved){
+	/* Some bound symbols not found by name: bind from scratch */
+	x = NULL;
+	while ((x = xml_child_each(xt, x, CX_ELMNT)) != NULL)
+	    if (xml_bind_yang(x, YB_MODULE, yspec, NULL) < 0)
+		goto done;
+    }
+    if ((s != stamp || br.br_unresolved || br.br_unsorted) && xml_sort_recurse(xt) < 0)
+	goto done;
+ ok:
+    *xtop = xt;
+    xt = NULL;
+    retval = 0;
+ done:
+    if (br.br_syms)
+	free(br.br_syms);
+    if (xt)
+	xml_free(xt);
+    return retval;
+}
+
+/*! Load XML tree from file in binary datastore format
+ *
+ * The file is memory-mapped and loaded with xmldb_binary_parse
+ * @param[in]  fd     File descriptor of binary datastore file
+ * @param[in]  yspec  Yang spec
+ * @param[in]  stamp  Checksum of current yang modules, sort tree if it was written with other
+ * @param[out] xtop   XML tree with a "top" node as parent of the written tree. Free with xml_free
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see xmldb_binary_write
+ */
+int
+xmldb_binary_read(int        fd,
+		  yang_stmt *yspec,
+		  uint32_t   stamp,
+		  cxobj    **xtop)
+{
+    int         retval = -1;
+    struct stat st;
+    char       *buf = MAP_FAILED;
+
+    if (fstat(fd, &st) < 0){
+	clicon_err(OE_UNIX, errno, "fstat");
+	goto done;
+    }
+    if (st.st_size == 0)
+	return xmldb_binary_parse(NULL, 0, yspec, stamp, xtop);
+    if ((buf = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0)) == MAP_FAILED){
+	clicon_err(OE_UNIX, errno, "mmap");
+	goto done;
+    }
+    retval = xmldb_binary_parse(buf, st.st_size, yspec, stamp, xtop);
+ done:
+    if (buf != MAP_FAILED)
+	munmap(buf, st.st_size);
+    return retval;
+}
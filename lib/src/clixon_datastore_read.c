@@ -51,6 +51,9 @@
 #include <assert.h>
 #include <syslog.h>       
 #include <fcntl.h>
+#ifdef HAVE_LIBZ
+#include <zlib.h>
+#endif
 
 /* cligen */
 #include <cligen/cligen.h>
@@ -80,9 +83,26 @@
 
 #include "clixon_datastore.h"
 #include "clixon_datastore_read.h"
+#include "clixon_datastore_binary.h"
 
 #define handle(xh) (assert(text_handle_check(xh)==0),(struct text_handle *)(xh))
 
+/* Read-only reference counted view of a datastore
+ * As long as the snapshot is registered in the cache (de_snapshot), it shares the cached tree.
+ * Before top-level nodes of the cache tree are modified, the snapshot gets its own top node
+ * with copies of those nodes, while other top-level nodes remain shared (xs_shared).
+ * Before the cache tree is freed, the snapshot takes ownership of the shared nodes.
+ * @see xmldb_snapshot_get
+ * @see xmldb_snapshot_cow
+ */
+struct xmldb_snapshot {
+    char   *xs_db;       /* Name of datastore, eg "running" */
+    cxobj  *xs_xml;      /* Read-only XML tree */
+    cxobj  *xs_shared;   /* Cache tree whose top-level nodes are shared by xs_xml, or NULL */
+    int     xs_refcount; /* Nr of references, free at zero */
+    int     xs_owner;    /* Top node is not shared with cache, free tree with snapshot */
+};
+
 /*! Ensure that xt only has a single sub-element and that is "config" 
  */
 static int
@@ -197,22 +217,109 @@ xml_copy_bottom_recurse(cxobj  *x0t,
     return retval;
 }
 
+/*! Copy xml tree x0 to x1 down to a given depth
+ * @param[in]  x0     Source XML tree
+ * @param[in]  x1     Destination XML tree (must exist)
+ * @param[in]  depth  Nr of levels to copy, including x0: -1 is all
+ * Keys of list entries and leaf bodies are copied also at the last level
+ * @see xml_copy
+ * @see xml_tree_prune_depth
+ */
+static int
+xml_copy_depth(cxobj  *x0, 
+	       cxobj  *x1,
+	       int32_t depth)
+{
+    int        retval = -1;
+    cxobj     *x;
+    cxobj     *xcopy;
+    yang_stmt *y;
+
+    if (depth < 0)
+	return xml_copy(x0, x1);
+    if (xml_copy_one(x0, x1) < 0)
+	goto done;
+    y = xml_spec(x0);
+    x = NULL;
+    while ((x = xml_child_each(x0, x, -1)) != NULL) {
+	if (xml_type(x) == CX_ELMNT && depth <= 1 &&
+	    (y == NULL || yang_keyword_get(y) != Y_LIST ||
+	     yang_key_match(y, xml_name(x)) != 1))
+	    continue;
+	if ((xcopy = xml_new(xml_name(x), x1, xml_type(x))) == NULL)
+	    goto done;
+	if (xml_copy_depth(x, xcopy, xml_type(x)==CX_ELMNT?depth-1:-1) < 0)
+	    goto done;
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Copy an xml node with its leafs and leaf-lists only
+ * Used for xpath matches below depth, so that the xpath can be evaluated again on the
+ * copy if its predicates refer to leafs of the match
+ * @param[in]  x0     Source XML node
+ * @param[in]  x1     Destination XML node (must exist)
+ * @see xml_copy_depth
+ */
+static int
+xml_copy_leafs(cxobj *x0, 
+	       cxobj *x1)
+{
+    int        retval = -1;
+    cxobj     *x;
+    cxobj     *xcopy;
+    yang_stmt *y;
+
+    if (xml_copy_one(x0, x1) < 0)
+	goto done;
+    x = NULL;
+    while ((x = xml_child_each(x0, x, -1)) != NULL) {
+	if (xml_type(x) == CX_ELMNT &&
+	    ((y = xml_spec(x)) == NULL ||
+	     (yang_keyword_get(y) != Y_LEAF && yang_keyword_get(y) != Y_LEAF_LIST)))
+	    continue;
+	if ((xcopy = xml_new(xml_name(x), x1, xml_type(x))) == NULL)
+	    goto done;
+	if (xml_copy(x, xcopy) < 0)
+	    goto done;
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Copy x0 and its ancestors (with list keys) up to x0t into x1t
+ * @param[in]  x0t    Top of source tree
+ * @param[in]  x0     Source node to copy with its sub-tree
+ * @param[in]  x1t    Top of destination tree
+ * @param[in]  depth  Nr of levels below x0t to copy: -1 is all
+ * If x0 is at or below depth, it is copied with its leafs only. The caller evaluates the
+ * xpath again on the copy, which needs the matched nodes and their leafs.
+ */
 static int
 xml_copy_from_bottom(cxobj  *x0t, 
 		     cxobj  *x0,
-		     cxobj  *x1t)
+		     cxobj  *x1t,
+		     int32_t depth)
 {
     int        retval = -1;
     cxobj     *x1p    = NULL;
     cxobj     *x0p    = NULL;
     cxobj     *x1     = NULL;
     yang_stmt *y      = NULL;
+    cxobj     *xa;
     
     if (x0 == x0t)
 	goto ok;
     x0p = xml_parent(x0);
     if (xml_copy_bottom_recurse(x0t, x0p, x1t, &x1p) < 0)
 	return -1;
+    if (depth >= 0){ /* Remaining levels at x0 */
+	for (xa = x0p; xa != x0t && xa != NULL; xa = xml_parent(xa))
+	    depth--;
+    }
     y = xml_spec(x0);
     /* Look if it exists */
     if (match_base_child(x1p, x0, y, &x1) < 0)
@@ -220,7 +327,11 @@ xml_copy_from_bottom(cxobj  *x0t,
     if (x1 == NULL){ /* If not, create it and copy complete tree */
 	if ((x1 = xml_new(xml_name(x0), x1p, CX_ELMNT)) == NULL)
 	    goto done;
-	if (xml_copy(x0, x1) < 0)
+	if (depth >= 0 && depth <= 1){ /* x0 is at or below depth */
+	    if (xml_copy_leafs(x0, x1) < 0)
+		goto done;
+	}
+	else if (xml_copy_depth(x0, x1, depth) < 0)
 	    goto done;
     }
  ok:
@@ -230,18 +341,22 @@ xml_copy_from_bottom(cxobj  *x0t,
 }
 
 /*! Given XML tree x0 with marked nodes, copy marked nodes to new tree x1
- * Two marks are used: XML_FLAG_MARK and XML_FLAG_CHANGE
+ * Two marks are used: XML_FLAG_MARK and XML_FLAG_SUBMARK
  *
  * The algorithm works as following:
- * (1) Copy individual nodes marked with XML_FLAG_CHANGE 
+ * (1) Copy individual nodes marked with XML_FLAG_SUBMARK 
  * until nodes marked with XML_FLAG_MARK are reached, where 
  * (2) the complete subtree of that node is copied. 
  * (3) Special case: key nodes in lists are copied if any node in list is marked
+ * @param[in]  x0     Source XML tree
+ * @param[in]  x1     Destination XML tree (must exist)
+ * @param[in]  depth  Nr of levels to copy, including x0: -1 is all
  *  @note you may want to check:!yang_config(ys)
  */
 static int
-xml_copy_marked(cxobj *x0, 
-		cxobj *x1)
+xml_copy_marked(cxobj  *x0, 
+		cxobj  *x1,
+		int32_t depth)
 {
     int        retval = -1;
     int        mark;
@@ -277,7 +392,7 @@ xml_copy_marked(cxobj *x0,
     mark = 0;
     x = NULL;
     while ((x = xml_child_each(x0, x, CX_ELMNT)) != NULL) {
-	if (xml_flag(x, XML_FLAG_MARK|XML_FLAG_CHANGE)){
+	if (xml_flag(x, XML_FLAG_MARK|XML_FLAG_SUBMARK)){
 	    mark++;
 	    break;
 	}
@@ -286,18 +401,23 @@ xml_copy_marked(cxobj *x0,
     while ((x = xml_child_each(x0, x, CX_ELMNT)) != NULL) {
 	name = xml_name(x);
 	if (xml_flag(x, XML_FLAG_MARK)){
-	    /* (2) the complete subtree of that node is copied. */
+	    /* (2) the complete subtree of that node is copied. 
+	     * Below depth only its leafs, so that the xpath can be evaluated on the copy */
 	    if ((xcopy = xml_new(name, x1, CX_ELMNT)) == NULL)
 		goto done;
-	    if (xml_copy(x, xcopy) < 0) 
+	    if (depth >= 0 && depth <= 2){
+		if (xml_copy_leafs(x, xcopy) < 0)
+		    goto done;
+	    }
+	    else if (xml_copy_depth(x, xcopy, depth<0?-1:depth-1) < 0) 
 		goto done;
 	    continue; 
 	}
-	if (xml_flag(x, XML_FLAG_CHANGE)){
-	    /*  Copy individual nodes marked with XML_FLAG_CHANGE */
+	else if (xml_flag(x, XML_FLAG_SUBMARK)){
+	    /*  Copy individual nodes marked with XML_FLAG_SUBMARK, also below depth */
 	    if ((xcopy = xml_new(name, x1, CX_ELMNT)) == NULL)
 		goto done;
-	    if (xml_copy_marked(x, xcopy) < 0) /*  */
+	    if (xml_copy_marked(x, xcopy, depth<0?-1:(depth>1?depth-1:1)) < 0)
 		goto done;
 	}
 	/* (3) Special case: key nodes in lists are copied if any 
@@ -442,6 +562,421 @@ text_read_modstate(clicon_handle       h,
     return retval;
 }
 
+/*! Add string to FNV-1a checksum
+ */
+static uint32_t
+xmldb_stamp_sum(uint32_t    sum,
+		const char *str)
+{
+    while (*str){
+	sum ^= (unsigned char)*str++;
+	sum *= 16777619;
+    }
+    return sum;
+}
+
+/*! Checksum of the yang modules a datastore file is written with
+ *
+ * The order of a datastore depends on its yang modules. The checksum is made of the
+ * module-set-id and the name and revision of each loaded module, and does not depend on
+ * the order the modules are loaded.
+ * @param[in]  h     Clicon handle
+ * @param[in]  yspec Top-level yang spec
+ * @retval     sum   Checksum
+ */
+uint32_t
+xmldb_modules_sum(clicon_handle h,
+		  yang_stmt    *yspec)
+{
+    yang_stmt *ymod = NULL;
+    yang_stmt *yrev;
+    char      *id;
+    uint32_t   sum = 0;
+    uint32_t   s;
+
+    if ((id = clicon_option_str(h, "CLICON_MODULE_SET_ID")) != NULL)
+	sum = xmldb_stamp_sum(2166136261U, id);
+    while ((ymod = yn_each(yspec, ymod)) != NULL) {
+	if (yang_keyword_get(ymod) != Y_MODULE &&
+	    yang_keyword_get(ymod) != Y_SUBMODULE)
+	    continue;
+	s = xmldb_stamp_sum(2166136261U, yang_argument_get(ymod));
+	if ((yrev = yang_find(ymod, Y_REVISION, NULL)) != NULL)
+	    s = xmldb_stamp_sum(s, yang_argument_get(yrev));
+	sum += s; /* Independent of module order */
+    }
+    return sum;
+}
+
+#ifdef XMLDB_SORTED_STAMP
+/*! Create stamp of a datastore file written in canonical order
+ *
+ * The stamp is an XML comment with a checksum of the yang modules.
+ * @param[in]  h     Clicon handle
+ * @param[in]  yspec Top-level yang spec
+ * @param[out] cb    Stamp is appended to this buffer
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @see XMLDB_SORTED_STAMP
+ * @see xmldb_modules_sum
+ */
+int
+xmldb_sorted_stamp(clicon_handle h,
+		   yang_stmt    *yspec,
+		   cbuf         *cb)
+{
+    cprintf(cb, "<!-- clixon sorted %08x -->", xmldb_modules_sum(h, yspec));
+    return 0;
+}
+
+/*! Check if a buffer starts with a sorted stamp of the current yang modules
+ *
+ * @param[in]  h     Clicon handle
+ * @param[in]  yspec Top-level yang spec
+ * @param[in]  buf   Start of datastore file
+ * @param[in]  len   Length of buf
+ * @retval     1     Buffer starts with sorted stamp of current yang modules
+ * @retval     0     No stamp, or stamped with other yang modules
+ * @retval    -1     Error
+ */
+static int
+xmldb_sorted_stamp_match(clicon_handle h,
+			 yang_stmt    *yspec,
+			 const char   *buf,
+			 size_t        len)
+{
+    int   retval = -1;
+    cbuf *cb = NULL;
+
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    if (xmldb_sorted_stamp(h, yspec, cb) < 0)
+	goto done;
+    retval = (len >= cbuf_len(cb) && memcmp(buf, cbuf_get(cb), cbuf_len(cb)) == 0);
+ done:
+    if (cb)
+	cbuf_free(cb);
+    return retval;
+}
+
+/*! Check if a datastore file starts with a sorted stamp of the current yang modules
+ *
+ * @param[in]  h     Clicon handle
+ * @param[in]  yspec Top-level yang spec
+ * @param[in]  fd    File descriptor of datastore file, rewound after reading the stamp
+ * @retval     1     File is stamped as sorted with current yang modules
+ * @retval     0     File is not stamped, or stamped with other yang modules
+ * @retval    -1     Error
+ */
+static int
+xmldb_sorted_stamp_check(clicon_handle h,
+			 yang_stmt    *yspec,
+			 int           fd)
+{
+    char    buf[64];
+    ssize_t len;
+
+    if ((len = read(fd, buf, sizeof(buf))) < 0){
+	clicon_err(OE_UNIX, errno, "read");
+	return -1;
+    }
+    if (lseek(fd, 0, SEEK_SET) < 0){
+	clicon_err(OE_UNIX, errno, "lseek");
+	return -1;
+    }
+    return xmldb_sorted_stamp_match(h, yspec, buf, len);
+}
+#endif /* XMLDB_SORTED_STAMP */
+
+/*! Check if a datastore file is compressed
+ * @param[in]  fd    File descriptor of datastore file, file offset is not changed
+ * @retval     1     File starts with gzip magic number
+ * @retval     0     Not compressed
+ * @retval    -1     Error
+ */
+static int
+xmldb_file_compressed(int fd)
+{
+    unsigned char magic[2];
+    ssize_t       len;
+
+    if ((len = pread(fd, magic, sizeof(magic), 0)) < 0){
+	clicon_err(OE_UNIX, errno, "pread");
+	return -1;
+    }
+    return len == sizeof(magic) && magic[0] == 0x1f && magic[1] == 0x8b;
+}
+
+#ifdef HAVE_LIBZ
+/* Size of decompressed chunks of XML datastore files */
+#define XMLDB_ZLIB_BUFLEN 65536
+
+/*! Read XML tree from a compressed datastore file
+ *
+ * The file is decompressed while it is parsed: XML is pushed in chunks to the incremental
+ * XML parser. The JSON and binary loaders need their complete input, which is decompressed
+ * directly into the buffer they load from.
+ * @param[in]  h      Clicon handle
+ * @param[in]  fd     File descriptor of compressed datastore file
+ * @param[in]  format Datastore format
+ * @param[in]  yspec  Top-level yang spec
+ * @param[out] xt     XML tree with top-level "top". Free with xml_free
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see xmldb_fopen  for writing compressed datastore files
+ */
+static int
+xmldb_readfile_zlib(clicon_handle h,
+		    int           fd,
+		    const char   *format,
+		    yang_stmt    *yspec,
+		    cxobj       **xt)
+{
+    int              retval = -1;
+    gzFile           gz = NULL;
+    int              fd2;
+    char            *buf = NULL;
+    char            *buf1;
+    size_t           buflen = XMLDB_ZLIB_BUFLEN;
+    size_t           len = 0;
+    int              n;
+    int              errnum;
+    clixon_xml_push *xp = NULL;
+    int              sorted = 0;
+    int              ret;
+
+    if ((fd2 = dup(fd)) < 0){
+	clicon_err(OE_UNIX, errno, "dup");
+	goto done;
+    }
+    if ((gz = gzdopen(fd2, "rb")) == NULL){
+	clicon_err(OE_UNIX, errno, "gzdopen");
+	close(fd2);
+	goto done;
+    }
+    if ((buf = malloc(buflen)) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto done;
+    }
+    if (strcmp(format, "json")==0 || strcmp(format, "binary")==0){
+	while ((n = gzread(gz, buf+len, buflen-1-len)) > 0){
+	    len += n;
+	    if (len == buflen-1){
+		buflen *= 2;
+		if ((buf1 = realloc(buf, buflen)) == NULL){
+		    clicon_err(OE_UNIX, errno, "realloc");
+		    goto done;
+		}
+		buf = buf1;
+	    }
+	}
+	if (n < 0){
+	    clicon_err(OE_UNIX, 0, "gzread: %s", gzerror(gz, &errnum));
+	    goto done;
+	}
+	buf[len] = '\0';
+	if (strcmp(format, "json")==0){
+	    if (clixon_json_parse_string(buf, YB_MODULE, yspec, xt, NULL) < 0)
+		goto done;
+	}
+	else if (xmldb_binary_parse(buf, len, yspec, xmldb_modules_sum(h, yspec), xt) < 0)
+	    goto done;
+    }
+    else {
+	if ((n = gzread(gz, buf, buflen)) < 0){
+	    clicon_err(OE_UNIX, 0, "gzread: %s", gzerror(gz, &errnum));
+	    goto done;
+	}
+#ifdef XMLDB_SORTED_STAMP
+	/* File written in canonical order by clixon: do not sort */
+	if ((sorted = xmldb_sorted_stamp_match(h, yspec, buf, n)) < 0)
+	    goto done;
+#endif
+	clixon_xml_parse_sorted_set(sorted);
+	ret = -1;
+	if ((xp = clixon_xml_push_new(YB_MODULE, yspec)) != NULL){
+	    while (n > 0){
+		if (clixon_xml_push_data(xp, buf, n) < 0)
+		    break;
+		if ((n = gzread(gz, buf, buflen)) < 0){
+		    clicon_err(OE_UNIX, 0, "gzread: %s", gzerror(gz, &errnum));
+		    break;
+		}
+	    }
+	    if (n == 0)
+		ret = clixon_xml_push_end(xp, xt, NULL);
+	}
+	clixon_xml_parse_sorted_set(0);
+	if (ret < 0)
+	    goto done;
+    }
+    retval = 0;
+ done:
+    if (xp)
+	clixon_xml_push_free(xp);
+    if (buf)
+	free(buf);
+    if (gz)
+	gzclose(gz);
+    return retval;
+}
+#endif /* HAVE_LIBZ */
+
+/*! Parse a single datastore file into an XML tree with top-level "config"
+ * @param[in]  h        Clicon handle
+ * @param[in]  filename Datastore file
+ * @param[in]  format   Datastore format: xml, json or binary
+ * @param[in]  yspec    Top-level yang spec
+ * @param[out] xp       XML tree with top-level "config". Free with xml_free
+ * @retval     0        OK
+ * @retval    -1        Error
+ */
+static int
+xmldb_parsefile(clicon_handle h,
+		const char   *filename,
+		const char   *format,
+		yang_stmt    *yspec,
+		cxobj       **xp)
+{
+    int    retval = -1;
+    cxobj *x0 = NULL;
+    int    fd = -1;
+    int    ret;
+
+    if ((fd = open(filename, O_RDONLY)) < 0) {
+	clicon_err(OE_UNIX, errno, "open(%s)", filename);
+	goto done;
+    }    
+    /* Compressed files are read regardless of CLICON_XMLDB_COMPRESS */
+    if ((ret = xmldb_file_compressed(fd)) < 0)
+	goto done;
+    if (ret){
+#ifdef HAVE_LIBZ
+	if (xmldb_readfile_zlib(h, fd, format, yspec, &x0) < 0)
+	    goto done;
+#else
+	clicon_err(OE_CFG, 0, "%s is compressed but clixon is built without zlib", filename);
+	goto done;
+#endif
+    }
+    else if (strcmp(format, "json")==0){
+	if ((ret = clixon_json_parse_file(fd, YB_MODULE, yspec, &x0, NULL)) < 0) /* XXX: ret == 0*/
+	    goto done;
+    }
+    else if (strcmp(format, "binary")==0){
+	if (xmldb_binary_read(fd, yspec, xmldb_modules_sum(h, yspec), &x0) < 0)
+	    goto done;
+    }
+    else {
+#ifdef XMLDB_SORTED_STAMP
+	/* File written in canonical order by clixon: do not sort */
+	if ((ret = xmldb_sorted_stamp_check(h, yspec, fd)) < 0)
+	    goto done;
+	clixon_xml_parse_sorted_set(ret);
+#endif
+	ret = clixon_xml_parse_file(fd, YB_MODULE, yspec, "</config>", &x0, NULL);
+#ifdef XMLDB_SORTED_STAMP
+	clixon_xml_parse_sorted_set(0);
+#endif
+	if (ret < 0)
+	    goto done;
+    }
+
+    /* Always assert a top-level called "config". 
+       To ensure that, deal with two cases:
+       1. File is empty <top/> -> rename top-level to "config" */
+    if (xml_child_nr(x0) == 0){ 
+	if (xml_name_set(x0, "config") < 0)
+	    goto done;     
+    }
+    /* 2. File is not empty <top><config>...</config></top> -> replace root */
+    else{ 
+	/* There should only be one element and called config */
+	if (singleconfigroot(x0, &x0) < 0)
+	    goto done;
+    }
+    *xp = x0;
+    x0 = NULL;
+    retval = 0;
+ done:
+    if (fd != -1)
+	close(fd);
+    if (x0)
+	xml_free(x0);
+    return retval;
+}
+
+/*! Read per-module datastore files and add their top-level nodes to a tree
+ *
+ * Each file in the <db>.d directory holds the top-level nodes of one yang module.
+ * The nodes of each file are moved to x0 which is sorted once all files are read.
+ * @param[in]  h      Clicon handle
+ * @param[in]  db     Symbolic database name, eg "candidate", "running"
+ * @param[in]  format Datastore format
+ * @param[in]  yspec  Top-level yang spec
+ * @param[in]  x0     XML tree with top-level "config" read from main datastore file
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see CLICON_XMLDB_MULTI
+ * @see xmldb_put_multi  for writing
+ */
+static int
+xmldb_readfile_multi(clicon_handle h,
+		     const char   *db,
+		     const char   *format,
+		     yang_stmt    *yspec,
+		     cxobj        *x0)
+{
+    int            retval = -1;
+    char          *dir = NULL;
+    struct dirent *dp = NULL;
+    int            ndp;
+    int            i;
+    cbuf          *cb = NULL;
+    cxobj         *xs = NULL;
+
+    if (xmldb_db2subdir(h, db, &dir) < 0)
+	goto done;
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_XML, errno, "cbuf_new");
+	goto done;
+    }
+    /* Only module files, not eg temporary files left by a failed write.
+     * Returns 0 if dir does not exist */
+    cprintf(cb, "\\.%s$", format);
+    if ((ndp = clicon_file_dirent(dir, &dp, cbuf_get(cb), S_IFREG)) < 0)
+	goto done;
+    if (ndp == 0){
+	retval = 0;
+	goto done;
+    }
+    for (i = 0; i < ndp; i++){
+	cbuf_reset(cb);
+	cprintf(cb, "%s/%s", dir, dp[i].d_name);
+	if (xmldb_parsefile(h, cbuf_get(cb), format, yspec, &xs) < 0)
+	    goto done;
+	if (xml_addsub_children(x0, xs) < 0)
+	    goto done;
+	xml_free(xs);
+	xs = NULL;
+    }
+    if (xml_sort(x0) < 0)
+	goto done;
+    retval = 0;
+ done:
+    if (xs)
+	xml_free(xs);
+    if (cb)
+	cbuf_free(cb);
+    if (dp)
+	free(dp);
+    if (dir)
+	free(dir);
+    return retval;
+}
+
 /*! Common read function that reads an XML tree from file
  * @param[in]  th    Datastore text handle
  * @param[in]  db    Symbolic database name, eg "candidate", "running"
@@ -459,9 +994,7 @@ xmldb_readfile(clicon_handle      h,
     int    retval = -1;
     cxobj *x0 = NULL;
     char  *dbfile = NULL;
-    int    fd = -1;
     char  *format;
-    int    ret;
     
     if (xmldb_db2file(h, db, &dbfile) < 0)
 	goto done;
@@ -474,30 +1007,12 @@ xmldb_readfile(clicon_handle      h,
 	goto done;
     }
     /* Parse file into internal XML tree from different formats */
-    if ((fd = open(dbfile, O_RDONLY)) < 0) {
-	clicon_err(OE_UNIX, errno, "open(%s)", dbfile);
+    if (xmldb_parsefile(h, dbfile, format, yspec, &x0) < 0)
 	goto done;
-    }    
-    if (strcmp(format, "json")==0){
-	if ((ret = clixon_json_parse_file(fd, YB_MODULE, yspec, &x0, NULL)) < 0) /* XXX: ret == 0*/
-	    goto done;
-    }
-    else if ((clixon_xml_parse_file(fd, YB_MODULE, yspec, "</config>", &x0, NULL)) < 0)
+    /* Top-level nodes of each module in separate files */
+    if (clicon_option_bool(h, "CLICON_XMLDB_MULTI") &&
+	xmldb_readfile_multi(h, db, format, yspec, x0) < 0)
 	goto done;
-
-    /* Always assert a top-level called "config". 
-       To ensure that, deal with two cases:
-       1. File is empty <top/> -> rename top-level to "config" */
-    if (xml_child_nr(x0) == 0){ 
-	if (xml_name_set(x0, "config") < 0)
-	    goto done;     
-    }
-    /* 2. File is not empty <top><config>...</config></top> -> replace root */
-    else{ 
-	/* There should only be one element and called config */
-	if (singleconfigroot(x0, &x0) < 0)
-	    goto done;
-    }
     /* From Clixon 3.10,datastore files may contain module-state defining
      * which modules are used in the file. 
      */
@@ -509,8 +1024,6 @@ xmldb_readfile(clicon_handle      h,
     }
     retval = 0;
  done:
-    if (fd != -1)
-	close(fd);
     if (dbfile)
 	free(dbfile);
     if (x0)
@@ -526,6 +1039,8 @@ xmldb_readfile(clicon_handle      h,
  * @param[in]  db     Name of database to search in (filename including dir path
  * @param[in]  nsc    External XML namespace context, or NULL
  * @param[in]  xpath  String with XPATH syntax. or NULL for all
+ * @param[in]  defaults Add default values to returned tree
+ * @param[in]  depth  Nr of levels below top to return: -1 is all
  * @param[out] xret   Single return XML tree. Free with xml_free()
  * @param[out] msdiff    If set, return modules-state differences
  * @retval     0      OK
@@ -537,6 +1052,8 @@ xmldb_get_nocache(clicon_handle       h,
 		  const char         *db, 
 		  cvec               *nsc,
 		  const char         *xpath,
+		  int                 defaults,
+		  int32_t             depth,
 		  cxobj             **xtop,
 		  modstate_diff_t    *msdiff)
 {
@@ -569,17 +1086,22 @@ xmldb_get_nocache(clicon_handle       h,
 	for (i=0; i<xlen; i++){
 	    x = xvec[i];
 	    xml_flag_set(x, XML_FLAG_MARK);
+	    if (depth >= 0)
+		xml_apply_ancestor(x, (xml_applyfn_t*)xml_flag_set, (void*)XML_FLAG_SUBMARK);
 	}
     /* Remove everything that is not marked */
     if (!xml_flag(xt, XML_FLAG_MARK))
 	if (xml_tree_prune_flagged_sub(xt, XML_FLAG_MARK, 1, NULL) < 0)
 	    goto done;
+    /* Remove everything below depth, except marked nodes needed to evaluate xpath again */
+    if (xml_tree_prune_depth(xt, depth) < 0)
+	goto done;
     /* reset flag */
-    if (xml_apply(xt, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset, (void*)XML_FLAG_MARK) < 0)
+    if (xml_flag_epoch_next() < 0)
 	goto done;
 
     /* Add default values (if not set) */
-    if (xml_default_recurse(xt) < 0)
+    if (defaults && xml_default_recurse(xt) < 0)
     	goto done;
 #if 0 /* debug */
     if (xml_apply0(xt, -1, xml_sort_verify, NULL) < 0)
@@ -610,6 +1132,8 @@ xmldb_get_nocache(clicon_handle       h,
  * @param[in]  db     Name of database to search in (filename including dir path
  * @param[in]  nsc    External XML namespace context, or NULL
  * @param[in]  xpath  String with XPATH syntax. or NULL for all
+ * @param[in]  defaults Add default values to returned tree
+ * @param[in]  depth  Nr of levels below top to copy: -1 is all
  * @param[out] xret   Single return XML tree. Free with xml_free()
  * @param[out] msdiff    If set, return modules-state differences
  * @retval     0      OK
@@ -621,6 +1145,8 @@ xmldb_get_cache(clicon_handle    h,
 		const char      *db, 
 		cvec            *nsc,
 		const char      *xpath,
+		int              defaults,
+		int32_t          depth,
 		cxobj          **xtop,
 		modstate_diff_t *msdiff)
 {
@@ -678,7 +1204,7 @@ xmldb_get_cache(clicon_handle    h,
 	 */
 	for (i=0; i<xlen; i++){
 	    x0 = xvec[i];
-	    if (xml_copy_from_bottom(x0t, x0, x1t) < 0) /* config */
+	    if (xml_copy_from_bottom(x0t, x0, x1t, depth) < 0) /* config */
 		goto done;
 	}
     }
@@ -690,18 +1216,17 @@ xmldb_get_cache(clicon_handle    h,
 	for (i=0; i<xlen; i++){
 	    x0 = xvec[i];
 	    xml_flag_set(x0, XML_FLAG_MARK);
-	    xml_apply_ancestor(x0, (xml_applyfn_t*)xml_flag_set, (void*)XML_FLAG_CHANGE);
+	    xml_apply_ancestor(x0, (xml_applyfn_t*)xml_flag_set, (void*)XML_FLAG_SUBMARK);
 	}
-	if (xml_copy_marked(x0t, x1t) < 0) /* config */
-	    goto done;
-	if (xml_apply(x0t, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset, (void*)(XML_FLAG_MARK|XML_FLAG_CHANGE)) < 0)
+	if (xml_copy_marked(x0t, x1t, depth<0?-1:depth+1) < 0) /* config */
 	    goto done;
-	if (xml_apply(x1t, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset, (void*)(XML_FLAG_MARK|XML_FLAG_CHANGE)) < 0)
+	/* Reset marks in x0t (and x1t) without traversing the trees */
+	if (xml_flag_epoch_next() < 0)
 	    goto done;
     }
     /* x1t is wrong here should be <config><system>.. but is <system>.. */
     /* XXX where should we apply default values once? */
-    if (xml_default_recurse(x1t) < 0)
+    if (defaults && xml_default_recurse(x1t) < 0)
 	goto done;
     /* Copy the matching parts of the (relevant) XML tree.
      * If cache was empty, also update to datastore cache
@@ -725,6 +1250,7 @@ xmldb_get_cache(clicon_handle    h,
  * @param[in]  nsc    External XML namespace context, or NULL
  * @param[in]  xpath  String with XPATH syntax. or NULL for all
  * @param[in]  config If set only configuration data, else also state
+ * @param[in]  defaults If set, add default values to the cache (removed by xmldb_get0_clear)
  * @param[out] xret   Single return XML tree. Free with xml_free()
  * @param[out] msdiff    If set, return modules-state differences
  * @retval     0      OK
@@ -735,6 +1261,7 @@ xmldb_get_zerocopy(clicon_handle    h,
 		   const char      *db, 
 		   cvec            *nsc,
 		   const char      *xpath,
+		   int              defaults,
 		   cxobj          **xtop,
 		   modstate_diff_t *msdiff)
 {
@@ -764,8 +1291,18 @@ xmldb_get_zerocopy(clicon_handle    h,
 	de0.de_xml = x0t;
 	clicon_db_elmnt_set(h, db, &de0);
     } /* x0t == NULL */
-    else
+    else{
+	/* Default values are added to the cache tree below, dont let snapshots see them */
+	if (defaults && de->de_snapshot != NULL){
+	    if (xmldb_snapshot_detach(h, db, 1) < 0)
+		goto done;
+	    if ((de = clicon_db_elmnt_get(h, db)) == NULL){
+		clicon_err(OE_DB, ENOENT, "No cache for %s", db);
+		goto done;
+	    }
+	}
 	x0t = de->de_xml;
+    }
     /* Here xt looks like: <config>...</config> */
     if (xpath_vec(x0t, nsc, "%s", &xvec, &xlen, xpath?xpath:"/") < 0)
 	goto done;
@@ -775,10 +1312,10 @@ xmldb_get_zerocopy(clicon_handle    h,
     for (i=0; i<xlen; i++){
 	x0 = xvec[i];
 	xml_flag_set(x0, XML_FLAG_MARK);
-	xml_apply_ancestor(x0, (xml_applyfn_t*)xml_flag_set, (void*)XML_FLAG_CHANGE);
+	xml_apply_ancestor(x0, (xml_applyfn_t*)xml_flag_set, (void*)XML_FLAG_SUBMARK);
     }
     /* Apply default values (removed in clear function) */
-    if (xml_default_recurse(x0t) < 0)
+    if (defaults && xml_default_recurse(x0t) < 0)
 	goto done;
     if (clicon_debug_get()>1)
     	clicon_xml2file(stderr, x0t, 0, 1);
@@ -813,7 +1350,7 @@ xmldb_get(clicon_handle    h,
 	  char            *xpath,
 	  cxobj          **xret)
 {
-    return xmldb_get0(h, db, nsc, xpath, 1, xret, NULL);
+    return xmldb_get0(h, db, nsc, xpath, 1, 1, xret, NULL);
 }
 
 /*! Zero-copy variant of get content of database
@@ -829,13 +1366,17 @@ xmldb_get(clicon_handle    h,
  * @param[in]  nsc    External XML namespace context, or NULL
  * @param[in]  xpath  String with XPATH syntax. or NULL for all
  * @param[in]  copy   Force copy. Overrides cache_zerocopy -> cache 
+ * @param[in]  defaults If set, add default values to the tree
  * @param[out] xret   Single return XML tree. Free with xml_free()
  * @param[out] msdiff    If set, return modules-state differences (upgrade code)
  * @retval     0      OK
  * @retval     -1     Error
+ * Callers that only evaluate xpaths on explicitly set data, or that print the tree with
+ * clicon_xml2cbuf_wdef, should not set defaults. Callers that access default leafs
+ * directly in the tree, such as transaction and validation callbacks, should set it.
  * @code
  *   cxobj   *xt;
- *   if (xmldb_get0(xh, "running", nsc, "/interface[name="eth"]", 0, &xt, NULL) < 0)
+ *   if (xmldb_get0(xh, "running", nsc, "/interface[name="eth"]", 0, 1, &xt, NULL) < 0)
  *      err;
  *   ...
  *   xmldb_get0_clear(h, xt);   # Clear tree from default values and flags 
@@ -850,6 +1391,7 @@ xmldb_get0(clicon_handle    h,
 	   cvec            *nsc,
 	   const char      *xpath,
 	   int              copy,
+	   int              defaults,
 	   cxobj          **xret,
 	   modstate_diff_t *msdiff)
 {
@@ -861,7 +1403,7 @@ xmldb_get0(clicon_handle    h,
 	 * Add default values in copy
 	 * Copy deleted by xmldb_free
 	 */
-	retval = xmldb_get_nocache(h, db, nsc, xpath, xret, msdiff);
+	retval = xmldb_get_nocache(h, db, nsc, xpath, defaults, -1, xret, msdiff);
 	break;
     case DATASTORE_CACHE_ZEROCOPY:
 	/* Get cache (file if empty) mark xpath match in original tree 
@@ -869,7 +1411,7 @@ xmldb_get0(clicon_handle    h,
 	 * Default values and markings removed in xmldb_clear
 	 */
 	if (!copy){
-	    retval = xmldb_get_zerocopy(h, db, nsc, xpath, xret, msdiff);
+	    retval = xmldb_get_zerocopy(h, db, nsc, xpath, defaults, xret, msdiff);
 	    break;
 	}
 	/* fall through */
@@ -878,12 +1420,49 @@ xmldb_get0(clicon_handle    h,
 	 * Add default values in copy, return copy
 	 * Copy deleted by xmldb_free
 	 */
-	retval = xmldb_get_cache(h, db, nsc, xpath, xret, msdiff);
+	retval = xmldb_get_cache(h, db, nsc, xpath, defaults, -1, xret, msdiff);
 	break;
     }
     return retval;
 }
 
+/*! Get a copy of the content of a datastore without adding default values
+ *
+ * Default values are not added to the returned tree. Instead, they can be resolved from
+ * YANG when the tree is serialized, which saves creating (and namespace-resolving) default
+ * leafs for every get.
+ * Nodes below depth are not copied, except keys of list entries at the last level.
+ * @param[in]  h      Clicon handle
+ * @param[in]  db     Name of datastore, eg "running"
+ * @param[in]  nsc    External XML namespace context, or NULL
+ * @param[in]  xpath  String with XPATH syntax. or NULL for all
+ * @param[in]  depth  Nr of levels below top (<config>) to return: -1 is all
+ * @param[out] xret   Single return XML tree. Free with xml_free()
+ * @retval     0      OK
+ * @retval     -1     Error
+ * @code
+ *   if (xmldb_get_nodefaults(h, "running", nsc, "/interfaces", -1, &xt) < 0)
+ *      err;
+ *   clicon_xml2cbuf_wdef(cb, xt, 0, 0, -1, WITHDEFAULTS_REPORT_ALL, NULL, NULL, NULL, NULL);
+ *   xml_free(xt);
+ * @endcode
+ * @see xmldb_get  which adds default values to the tree
+ * @see clicon_xml2cbuf_wdef
+ */
+int 
+xmldb_get_nodefaults(clicon_handle    h, 
+		     const char      *db, 
+		     cvec            *nsc,
+		     const char      *xpath,
+		     int32_t          depth,
+		     cxobj          **xret)
+{
+    if (clicon_datastore_cache(h) == DATASTORE_NOCACHE)
+	return xmldb_get_nocache(h, db, nsc, xpath, 0, depth, xret, NULL);
+    else
+	return xmldb_get_cache(h, db, nsc, xpath, 0, depth, xret, NULL);
+}
+
 /*! Clear cached xml tree obtained with xmldb_get0, if zerocopy
  *
  * @param[in]  h    Clicon handle
@@ -902,9 +1481,12 @@ xmldb_get0_clear(clicon_handle    h,
     /* clear XML tree of defaults */
     if (xml_tree_prune_flagged(x, XML_FLAG_DEFAULT, 1) < 0)
 	goto done;
-    /* clear mark and change */
+    /* clear transient marks */
+    if (xml_flag_epoch_next() < 0)
+	goto done;
+    /* clear add, del and change (commits) */
     xml_apply0(x, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset,
-	       (void*)(0xff));
+	       (void*)(0xff & ~XML_FLAG_TRANSIENT));
  ok:
     retval = 0;
  done:
@@ -927,3 +1509,352 @@ xmldb_get0_free(clicon_handle    h,
     *xp = NULL;
     return 0;
 }
+
+/*! Get a read-only snapshot of a datastore without copying it
+ *
+ * The snapshot is a view of the (cached) datastore tree as it was when the snapshot was taken.
+ * It stays valid until released, also if the datastore is modified or deleted in between,
+ * since top-level nodes of the cache are copied to the snapshot before they are modified.
+ * Consecutive calls without changes of the datastore return the same snapshot.
+ * Default values are not added.
+ * @param[in]  h    Clicon handle
+ * @param[in]  db   Name of datastore, eg "running"
+ * @param[out] xsp  Snapshot, release with xmldb_snapshot_release
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @code
+ *   xmldb_snapshot *xs = NULL;
+ *   if (xmldb_snapshot_get(h, "running", &xs) < 0)
+ *      err;
+ *   xt = xmldb_snapshot_xml(xs); # Do not modify, but transient flags may be used
+ *   ...
+ *   xmldb_snapshot_release(h, xs);
+ * @endcode
+ * @note The tree must not be modified, except for transient flags, see XML_FLAG_TRANSIENT
+ * @note With DATASTORE_NOCACHE the datastore is read into a tree owned by the snapshot
+ */
+int
+xmldb_snapshot_get(clicon_handle    h,
+		   const char      *db,
+		   xmldb_snapshot **xsp)
+{
+    int             retval = -1;
+    yang_stmt      *yspec;
+    db_elmnt       *de = NULL;
+    db_elmnt        de0 = {0,};
+    cxobj          *xt = NULL;
+    xmldb_snapshot *xs = NULL;
+
+    if ((yspec = clicon_dbspec_yang(h)) == NULL){
+	clicon_err(OE_YANG, ENOENT, "No yang spec");
+	goto done;
+    }
+    if (clicon_datastore_cache(h) != DATASTORE_NOCACHE &&
+	(de = clicon_db_elmnt_get(h, db)) != NULL){
+	if ((xs = de->de_snapshot) != NULL){
+	    if (xs->xs_shared == NULL){ /* Reuse existing snapshot */
+		xs->xs_refcount++;
+		*xsp = xs;
+		goto ok;
+	    }
+	    /* Cache has changed since, only one snapshot can share it */
+	    xs = NULL;
+	    if (xmldb_snapshot_detach(h, db, 1) < 0)
+		goto done;
+	    if ((de = clicon_db_elmnt_get(h, db)) == NULL){
+		clicon_err(OE_DB, ENOENT, "No cache for %s", db);
+		goto done;
+	    }
+	}
+	xt = de->de_xml;
+    }
+    if (xt == NULL && xmldb_readfile(h, db, yspec, &xt, NULL) < 0)
+	goto done;
+    if ((xs = malloc(sizeof(*xs))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto done;
+    }
+    memset(xs, 0, sizeof(*xs));
+    if ((xs->xs_db = strdup(db)) == NULL){
+	clicon_err(OE_UNIX, errno, "strdup");
+	goto done;
+    }
+    xs->xs_xml = xt;
+    xs->xs_refcount = 1;
+    if (clicon_datastore_cache(h) == DATASTORE_NOCACHE)
+	xs->xs_owner = 1;
+    else { /* Register in cache, and populate cache if it was read from file */
+	if (de != NULL)
+	    de0 = *de;
+	de0.de_xml = xt;
+	de0.de_snapshot = xs;
+	clicon_db_elmnt_set(h, db, &de0);
+    }
+    xt = NULL;
+    *xsp = xs;
+    xs = NULL;
+ ok:
+    retval = 0;
+ done:
+    if (xs){
+	if (xs->xs_db)
+	    free(xs->xs_db);
+	free(xs);
+    }
+    if (xt && (de == NULL || xt != de->de_xml))
+	xml_free(xt);
+    return retval;
+}
+
+/*! Get XML tree of snapshot
+ * @param[in]  xs  Snapshot
+ * @retval     xt  Top of read-only XML tree, eg <config>...</config>
+ */
+cxobj *
+xmldb_snapshot_xml(xmldb_snapshot *xs)
+{
+    return xs->xs_xml;
+}
+
+/*! Unlink top-level nodes shared with the cache from the snapshot, before it is freed
+ * @param[in]  xs   Snapshot
+ */
+static void
+xmldb_snapshot_unshare(xmldb_snapshot *xs)
+{
+    cxobj *x;
+    int    i;
+
+    if (xs->xs_shared == NULL)
+	return;
+    for (i=0; i<xml_child_nr(xs->xs_xml); i++){
+	x = xml_child_i(xs->xs_xml, i);
+	if (x && xml_parent(x) != xs->xs_xml)
+	    xml_child_i_set(xs->xs_xml, i, NULL);
+    }
+    xs->xs_shared = NULL;
+}
+
+/*! Make the snapshot own the top-level nodes it shares with the cache
+ * @param[in]  xs    Snapshot
+ * @param[in]  move  1: Move the nodes from the cache tree (to be freed), 0: copy them
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+xmldb_snapshot_own(xmldb_snapshot *xs,
+		   int             move)
+{
+    int    retval = -1;
+    cxobj *xt;
+    cxobj *x;
+    cxobj *xcopy;
+    int    i;
+
+    xt = xs->xs_xml;
+    for (i=0; i<xml_child_nr(xt); i++){
+	x = xml_child_i(xt, i);
+	if (xml_parent(x) == xt)
+	    continue;
+	if (move){
+	    if (xml_rm(x) < 0)
+		goto done;
+	    xml_parent_set(x, xt);
+	}
+	else {
+	    if ((xcopy = xml_dup(x)) == NULL)
+		goto done;
+	    xml_parent_set(xcopy, xt);
+	    xml_child_i_set(xt, i, xcopy);
+	}
+    }
+    xs->xs_shared = NULL;
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Create a top node of a snapshot that shares the top-level nodes of a cache tree
+ * @param[in]  xs    Snapshot sharing the whole cache tree
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+xmldb_snapshot_split(xmldb_snapshot *xs)
+{
+    int    retval = -1;
+    cxobj *x0t;
+    cxobj *xt = NULL;
+    cxobj *x;
+    cxobj *xa;
+
+    x0t = xs->xs_xml;
+    if ((xt = xml_new(xml_name(x0t), NULL, CX_ELMNT)) == NULL)
+	goto done;
+    if (xml_copy_one(x0t, xt) < 0)
+	goto done;
+    x = NULL;
+    while ((x = xml_child_each(x0t, x, -1)) != NULL) {
+	if (xml_type(x) == CX_ELMNT){
+	    if (xml_child_share(xt, x) < 0)
+		goto done;
+	}
+	else { /* Attributes, eg namespace declarations, are copied */
+	    if ((xa = xml_new(xml_name(x), xt, xml_type(x))) == NULL)
+		goto done;
+	    if (xml_copy(x, xa) < 0)
+		goto done;
+	}
+    }
+    xs->xs_xml = xt;
+    xs->xs_shared = x0t;
+    xs->xs_owner = 1;
+    xt = NULL;
+    retval = 0;
+ done:
+    if (xt){
+	xs->xs_xml = xt;
+	xs->xs_shared = x0t;
+	xmldb_snapshot_unshare(xs);
+	xml_free(xt);
+	xs->xs_xml = x0t;
+    }
+    return retval;
+}
+
+/*! Release a snapshot obtained with xmldb_snapshot_get
+ * The snapshot (and its tree if detached from cache) is freed with last reference
+ * @param[in]  h    Clicon handle
+ * @param[in]  xs   Snapshot
+ * @see xmldb_snapshot_get
+ */
+int
+xmldb_snapshot_release(clicon_handle   h,
+		       xmldb_snapshot *xs)
+{
+    db_elmnt *de;
+
+    if (xs == NULL)
+	return 0;
+    if (--xs->xs_refcount > 0)
+	return 0;
+    if ((xs->xs_shared != NULL || !xs->xs_owner) &&
+	(de = clicon_db_elmnt_get(h, xs->xs_db)) != NULL &&
+	de->de_snapshot == xs){
+	de->de_snapshot = NULL;
+	clicon_db_elmnt_set(h, xs->xs_db, de);
+    }
+    if (xs->xs_owner && xs->xs_xml){
+	xmldb_snapshot_unshare(xs);
+	xml_free(xs->xs_xml);
+    }
+    free(xs->xs_db);
+    free(xs);
+    return 0;
+}
+
+/*! Detach snapshot from datastore cache before the cache tree is modified or freed
+ *
+ * The snapshot, if any, takes over the cache tree, or the top-level nodes it shares with the
+ * cache. Thereafter either the cache is a private copy of the tree, or the cache is empty.
+ * @param[in]  h     Clicon handle
+ * @param[in]  db    Name of datastore
+ * @param[in]  copy  1: Cache is given a copy of the tree (to be modified), 0: cache is cleared
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+int
+xmldb_snapshot_detach(clicon_handle h,
+		      const char   *db,
+		      int           copy)
+{
+    int             retval = -1;
+    db_elmnt       *de;
+    db_elmnt        de0;
+    xmldb_snapshot *xs;
+
+    if ((de = clicon_db_elmnt_get(h, db)) == NULL ||
+	(xs = de->de_snapshot) == NULL)
+	goto ok;
+    de0 = *de;
+    de0.de_snapshot = NULL;
+    if (xs->xs_shared != NULL){ /* Only top-level nodes are shared */
+	if (xmldb_snapshot_own(xs, !copy) < 0)
+	    goto done;
+    }
+    else{
+	de0.de_xml = NULL;
+	if (copy && xs->xs_xml &&
+	    (de0.de_xml = xml_dup(xs->xs_xml)) == NULL)
+	    goto done;
+	xs->xs_owner = 1;
+    }
+    clicon_db_elmnt_set(h, db, &de0);
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Copy top-level nodes of datastore cache to its snapshot before they are modified
+ *
+ * Copy-on-write per top-level node: the snapshot, if any, gets its own top node and copies
+ * of the top-level nodes that may be modified, while the other top-level nodes remain shared.
+ * The cache tree can then be modified in place, as long as only top-level nodes selected by
+ * fn are changed, and top-level nodes are added or removed.
+ * @param[in]  h     Clicon handle
+ * @param[in]  db    Name of datastore
+ * @param[in]  fn    Returns 1 if a top-level node of the cache may be modified, 0 if not
+ * @param[in]  arg   Argument to fn
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @see xmldb_snapshot_detach  Detach the whole tree
+ */
+int
+xmldb_snapshot_cow(clicon_handle  h,
+		   const char    *db,
+		   xml_applyfn_t *fn,
+		   void          *arg)
+{
+    int             retval = -1;
+    db_elmnt       *de;
+    xmldb_snapshot *xs;
+    cxobj          *xt;
+    cxobj          *x;
+    cxobj          *xcopy;
+    int             i;
+    int             shared = 0;
+    int             ret;
+
+    if ((de = clicon_db_elmnt_get(h, db)) == NULL ||
+	(xs = de->de_snapshot) == NULL)
+	goto ok;
+    if (xs->xs_shared == NULL &&
+	xmldb_snapshot_split(xs) < 0)
+	goto done;
+    xt = xs->xs_xml;
+    for (i=0; i<xml_child_nr(xt); i++){
+	x = xml_child_i(xt, i);
+	if (xml_parent(x) == xt) /* Already copied */
+	    continue;
+	if ((ret = fn(x, arg)) < 0)
+	    goto done;
+	if (ret == 0){
+	    shared++;
+	    continue;
+	}
+	if ((xcopy = xml_dup(x)) == NULL)
+	    goto done;
+	xml_parent_set(xcopy, xt);
+	xml_child_i_set(xt, i, xcopy);
+    }
+    if (shared == 0){ /* Fully detached */
+	xs->xs_shared = NULL;
+	de->de_snapshot = NULL;
+	clicon_db_elmnt_set(h, db, de);
+    }
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
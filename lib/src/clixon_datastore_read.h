@@ -40,5 +40,11 @@
  * Prototypes
  */
 int xmldb_readfile(clicon_handle h, const char *db, yang_stmt *yspec, cxobj **xp, modstate_diff_t *msd);
+int xmldb_snapshot_detach(clicon_handle h, const char *db, int copy);
+int xmldb_snapshot_cow(clicon_handle h, const char *db, xml_applyfn_t *fn, void *arg);
+uint32_t xmldb_modules_sum(clicon_handle h, yang_stmt *yspec);
+#ifdef XMLDB_SORTED_STAMP
+int xmldb_sorted_stamp(clicon_handle h, yang_stmt *yspec, cbuf *cb);
+#endif
 
 #endif /* _CLIXON_DATASTORE_READ_H */
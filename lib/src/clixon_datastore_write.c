@@ -38,6 +38,9 @@
 #include "clixon_config.h" /* generated by config & autoconf */
 #endif
 
+#if defined(HAVE_LIBZ) && defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE /* For fopencookie */
+#endif
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
@@ -47,10 +50,14 @@
 #include <stdint.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/param.h>
 #include <unistd.h>
 #include <dirent.h>
 #include <syslog.h>       
 #include <fcntl.h>
+#ifdef HAVE_LIBZ
+#include <zlib.h>
+#endif
 
 /* cligen */
 #include <cligen/cligen.h>
@@ -65,6 +72,7 @@
 #include "clixon_file.h"
 #include "clixon_yang.h"
 #include "clixon_xml.h"
+#include "clixon_xml_vec.h"
 #include "clixon_xml_sort.h"
 #include "clixon_options.h"
 #include "clixon_data.h"
@@ -81,6 +89,7 @@
 #include "clixon_datastore.h"
 #include "clixon_datastore_write.h"
 #include "clixon_datastore_read.h"
+#include "clixon_datastore_binary.h"
 
 /*! Given an attribute name and its expected namespace, find its value
  * 
@@ -207,6 +216,7 @@ check_body_namespace(cxobj     *x0,
  * @param[in]  x0       Base xml tree (can be NULL in add scenarios)
  * @param[in]  y0       Yang spec corresponding to xml-node x0. NULL if x0 is NULL
  * @param[in]  x0p      Parent of x0
+ * @param[in]  x0new    If set, a new x0 is added here instead of inserted in x0p, see xml_insert_vec
  * @param[in]  x1       XML tree which modifies base
  * @param[in]  x1t      Request root node (nacm needs this)
  * @param[in]  op       OP_MERGE, OP_REPLACE, OP_REMOVE, etc 
@@ -228,6 +238,7 @@ static int
 text_modify(clicon_handle       h,
 	    cxobj              *x0,
 	    cxobj              *x0p,
+	    clixon_xvec        *x0new,
 	    cxobj              *x0t,
 	    cxobj              *x1,
 	    cxobj              *x1t,
@@ -256,7 +267,11 @@ text_modify(clicon_handle       h,
     char      *valstr = NULL;
     enum insert_type insert = INS_LAST;
     int        changed = 0; /* Only if x0p's children have changed-> sort necessary */
+    int        added = 0;   /* x0 added to x0new */
     cvec      *nscx1 = NULL;
+    clixon_xvec *x0cnew = NULL; /* New children of x0 */
+    int        cursor;  /* Position in x0 children, see match_base_child_sorted */
+    cxobj     *x1prev;
     
     /* Check for operations embedded in tree according to netconf */
     if ((ret = attr_ns_value(x1,
@@ -417,7 +432,13 @@ text_modify(clicon_handle       h,
 		}
 	    }
 	    if (changed){ 
-		if (xml_insert(x0p, x0, insert, valstr, NULL) < 0) 
+		if (x0new && valstr == NULL &&
+		    yang_find(y0, Y_ORDERED_BY, "user") == NULL){
+		    if (clixon_xvec_append(x0new, x0) < 0)
+			goto done;
+		    added++;
+		}
+		else if (xml_insert(x0p, x0, insert, valstr, NULL) < 0) 
 		    goto done;
 	    }
 	    break;
@@ -568,6 +589,8 @@ text_modify(clicon_handle       h,
 	    }
 	    x1c = NULL; 
 	    i = 0;
+	    cursor = 0;
+	    x1prev = NULL;
 	    while ((x1c = xml_child_each(x1, x1c, CX_ELMNT)) != NULL) {
 		x1cname = xml_name(x1c);
 		/* Get yang spec of the child by child matching */
@@ -599,27 +622,31 @@ text_modify(clicon_handle       h,
 		}
 		/* See if there is a corresponding node in the base tree */
 		x0c = NULL;
-		if (match_base_child(x0, x1c, yc, &x0c) < 0)
+		if (match_base_child_sorted(x0, x1c, yc, &cursor, &x1prev, &x0c) < 0)
 		    goto done;
 		if (x0c && (yc != xml_spec(x0c))){
 		    /* There is a match but is should be replaced (choice)*/
 		    if (xml_purge(x0c) < 0)
 			goto done;
 		    x0c = NULL;
+		    cursor = -1; /* x0 children changed */
 		}
 		x0vec[i++] = x0c; /* != NULL if x0c is matching x1c */
 	    }
 	    /* Second pass: Loop through children of the x1 modification tree again
 	     * Now potentially modify x0:s children 
 	     * Here x0vec contains one-to-one matching nodes of x1:s children.
+	     * New children are collected in x0cnew and inserted together after the loop
 	     */
+	    if (i > 1 && (x0cnew = clixon_xvec_new()) == NULL)
+		goto done;
 	    x1c = NULL;
 	    i = 0;
 	    while ((x1c = xml_child_each(x1, x1c, CX_ELMNT)) != NULL) {
 		x1cname = xml_name(x1c);
 		x0c = x0vec[i++];
 		yc = yang_find_datanode(y0, x1cname);
-		if ((ret = text_modify(h, x0c, x0, x0t, x1c, x1t,
+		if ((ret = text_modify(h, x0c, x0, x0cnew, x0t, x1c, x1t,
 				       yc, op,
 				       username, xnacm, permit, cbret)) < 0)
 		    goto done;
@@ -627,8 +654,21 @@ text_modify(clicon_handle       h,
 		if (ret == 0)
 		    goto fail;
 	    }
+	    if (x0cnew){
+		ret = xml_insert_vec(x0, x0cnew);
+		clixon_xvec_free(x0cnew); /* Nodes may be in x0 also on error */
+		x0cnew = NULL;
+		if (ret < 0)
+		    goto done;
+	    }
 	    if (changed){
-		if (xml_insert(x0p, x0, insert, keystr, nscx1) < 0)
+		if (x0new && keystr == NULL &&
+		    yang_find(y0, Y_ORDERED_BY, "user") == NULL){
+		    if (clixon_xvec_append(x0new, x0) < 0)
+			goto done;
+		    added++;
+		}
+		else if (xml_insert(x0p, x0, insert, keystr, nscx1) < 0)
 		    goto done;
 	    }
 	    break;
@@ -659,10 +699,15 @@ text_modify(clicon_handle       h,
     if (nscx1)
 	xml_nsctx_free(nscx1);
     /* Remove dangling added objects */
-    if (changed && x0 && xml_parent(x0)==NULL)
+    if (changed && !added && x0 && xml_parent(x0)==NULL)
 	xml_purge(x0);
     if (x0vec)
 	free(x0vec);
+    if (x0cnew){ /* Not inserted */
+	for (i=0; i<clixon_xvec_len(x0cnew); i++)
+	    xml_free(clixon_xvec_i(x0cnew, i));
+	clixon_xvec_free(x0cnew);
+    }
     return retval;
  fail: /* cbret set */
     retval = 0;
@@ -805,7 +850,7 @@ text_modify_top(clicon_handle       h,
 		goto done;
 	    x0c = NULL;
 	}
-	if ((ret = text_modify(h, x0c, x0, x0t, x1c, x1t,
+	if ((ret = text_modify(h, x0c, x0, NULL, x0t, x1c, x1t,
 			       yc, op,
 			       username, xnacm, permit, cbret)) < 0)
 	    goto done;
@@ -822,6 +867,26 @@ text_modify_top(clicon_handle       h,
     goto done;
 } /* text_modify_top */
 
+/*! Check if an XML node is a container without presence and no children (except attrs)
+ * @param[in]   x       XML tree node
+ * @param[in]   arg     Not used
+ * @retval      1       Container to be removed
+ * @retval      0       Not
+ * @see xml_container_presence
+ */
+static int
+xml_container_empty(cxobj  *x, 
+		    void   *arg)
+{
+    yang_stmt *y;  /* yang node */
+
+    if ((y = (yang_stmt*)xml_spec(x)) == NULL)
+	return 0;
+    return yang_keyword_get(y) == Y_CONTAINER && 
+	xml_child_nr_notype(x, CX_ATTR)==0 &&
+	yang_find(y, Y_PRESENCE, NULL) == NULL;
+}
+
 /*! For containers without presence and no children(except attrs), remove
  * @param[in]   x       XML tree node
  * See section 7.5.1 in rfc6020bis-02.txt:
@@ -841,21 +906,616 @@ text_modify_top(clicon_handle       h,
 static int
 xml_container_presence(cxobj  *x, 
 		       void   *arg)
+{
+    /* Mark node that is: container, have no children, dont have presence */
+    if (xml_container_empty(x, arg))
+	xml_flag_set(x, XML_FLAG_MARK); /* Mark, remove later */
+    return 0;
+}
+
+/* Suffix of temporary file a datastore file is written to, see xmldb_fopen */
+#define XMLDB_TMP_SUFFIX ".tmp"
+
+#ifdef HAVE_LIBZ
+/*! Write function of compressed datastore file stream, see fopencookie(3) and funopen(3)
+ */
+#ifdef __linux__
+static ssize_t
+xmldb_zlib_write(void       *cookie,
+		 const char *buf,
+		 size_t      len)
+#else /* BSD, macOS */
+static int
+xmldb_zlib_write(void       *cookie,
+		 const char *buf,
+		 int         len)
+#endif
+{
+    int n;
+
+    if (len == 0)
+	return 0;
+    if ((n = gzwrite((gzFile)cookie, buf, len)) <= 0)
+	return -1;
+    return n;
+}
+
+/*! Close function of compressed datastore file stream, see fopencookie(3) and funopen(3)
+ */
+static int
+xmldb_zlib_close(void *cookie)
+{
+    return gzclose((gzFile)cookie) == Z_OK ? 0 : -1;
+}
+
+/*! Open a compressed datastore file stream on a file descriptor
+ * @param[in]  fd    File descriptor, closed when the stream is closed
+ * @retval     f     File stream
+ * @retval     NULL  Error
+ */
+static FILE *
+xmldb_zlib_fdopen(int fd)
+{
+    FILE  *f = NULL;
+    gzFile gz;
+#ifdef __linux__
+    cookie_io_functions_t io = {NULL, xmldb_zlib_write, NULL, xmldb_zlib_close};
+#endif
+
+    if ((gz = gzdopen(fd, "wb")) == NULL){
+	clicon_err(OE_UNIX, errno, "gzdopen");
+	close(fd);
+	return NULL;
+    }
+#ifdef __linux__
+    if ((f = fopencookie(gz, "w", io)) == NULL){
+	clicon_err(OE_UNIX, errno, "fopencookie");
+	gzclose(gz);
+    }
+#else /* BSD, macOS */
+    if ((f = funopen(gz, NULL, xmldb_zlib_write, NULL, xmldb_zlib_close)) == NULL){
+	clicon_err(OE_UNIX, errno, "funopen");
+	gzclose(gz);
+    }
+#endif
+    return f;
+}
+#endif /* HAVE_LIBZ */
+
+/*! Temporary file a datastore file is written to, see xmldb_fopen
+ * @param[in]  filename Datastore file
+ * @param[out] tmpname  Buffer of MAXPATHLEN for name of temporary file
+ * @retval     0        OK
+ * @retval    -1        Error
+ */
+static int
+xmldb_tmpfile(const char *filename,
+	      char       *tmpname)
+{
+    if (snprintf(tmpname, MAXPATHLEN, "%s%s", filename, XMLDB_TMP_SUFFIX) >= MAXPATHLEN){
+	clicon_err(OE_CFG, ENAMETOOLONG, "%s", filename);
+	return -1;
+    }
+    return 0;
+}
+
+/*! Create the temporary file of a datastore file, with the mode and owner of the latter
+ *
+ * The temporary file replaces the datastore file on close, so the datastore file keeps its
+ * mode and owner. A new datastore file is created as with fopen(3).
+ * @param[in]  filename Datastore file
+ * @param[in]  tmpname  Temporary file
+ * @retval     fd       File descriptor of temporary file, opened for writing
+ * @retval    -1        Error
+ */
+static int
+xmldb_tmpfile_open(const char *filename,
+		   const char *tmpname)
+{
+    int         fd;
+    struct stat st;
+    struct stat st0;
+
+    if ((fd = open(tmpname, O_WRONLY|O_CREAT|O_TRUNC,
+		   S_IRUSR|S_IWUSR|S_IRGRP|S_IWGRP|S_IROTH|S_IWOTH)) < 0){
+	clicon_err(OE_CFG, errno, "Creating file %s", tmpname);
+	return -1;
+    }
+    if (stat(filename, &st0) < 0){
+	if (errno == ENOENT) /* New datastore file */
+	    return fd;
+	clicon_err(OE_UNIX, errno, "stat(%s)", filename);
+	goto fail;
+    }
+    if (fstat(fd, &st) < 0){
+	clicon_err(OE_UNIX, errno, "fstat(%s)", tmpname);
+	goto fail;
+    }
+    if ((st.st_uid != st0.st_uid || st.st_gid != st0.st_gid) &&
+	fchown(fd, st0.st_uid, st0.st_gid) < 0){
+	clicon_err(OE_UNIX, errno, "fchown(%s)", tmpname);
+	goto fail;
+    }
+    /* After chown, which may clear setuid/setgid bits */
+    if (fchmod(fd, st0.st_mode & 07777) < 0){
+	clicon_err(OE_UNIX, errno, "fchmod(%s)", tmpname);
+	goto fail;
+    }
+    return fd;
+ fail:
+    close(fd);
+    unlink(tmpname);
+    return -1;
+}
+
+/*! Open a datastore file for writing, compressed if so configured
+ *
+ * The file is written to a temporary file which replaces the datastore file only when
+ * closed with xmldb_fclose, so that a failed write leaves the datastore file intact.
+ * The temporary file is given the mode and owner of the datastore file.
+ * If CLICON_XMLDB_COMPRESS is zlib, the file is a stream that compresses in gzip format
+ * as it is written, without buffering the uncompressed file.
+ * @param[in]  h        Clicon handle
+ * @param[in]  filename Datastore file
+ * @retval     f        File stream, close with xmldb_fclose
+ * @retval     NULL     Error
+ * @see xmldb_dump
+ */
+FILE *
+xmldb_fopen(clicon_handle h,
+	    const char   *filename)
+{
+    FILE  *f = NULL;
+    char  *compress;
+    char   tmpname[MAXPATHLEN];
+    int    fd;
+
+    if (xmldb_tmpfile(filename, tmpname) < 0)
+	return NULL;
+    compress = clicon_option_str(h, "CLICON_XMLDB_COMPRESS");
+    if (compress == NULL || strcmp(compress, "none") == 0){
+	if ((fd = xmldb_tmpfile_open(filename, tmpname)) < 0)
+	    return NULL;
+	if ((f = fdopen(fd, "w")) == NULL){
+	    clicon_err(OE_UNIX, errno, "fdopen");
+	    close(fd);
+	}
+    }
+    else if (strcmp(compress, "zlib") == 0){
+#ifdef HAVE_LIBZ
+	if ((fd = xmldb_tmpfile_open(filename, tmpname)) < 0)
+	    return NULL;
+	f = xmldb_zlib_fdopen(fd);
+#else
+	clicon_err(OE_CFG, 0, "CLICON_XMLDB_COMPRESS is zlib but clixon is built without zlib");
+#endif
+    }
+    else
+	clicon_err(OE_CFG, EINVAL, "Unknown CLICON_XMLDB_COMPRESS: %s", compress);
+    if (f == NULL)
+	unlink(tmpname);
+    return f;
+}
+
+/*! Close a datastore file opened with xmldb_fopen
+ *
+ * If the file was written without error, it replaces the datastore file, otherwise it is
+ * removed. Write errors of a compressed file may only be seen when it is closed, when the
+ * compressed stream is flushed.
+ * @param[in]  f        File stream, from xmldb_fopen
+ * @param[in]  filename Datastore file, as given to xmldb_fopen
+ * @param[in]  ok       Writing succeeded. If 0, the datastore file is left as is
+ * @retval     0        OK, datastore file is replaced
+ * @retval    -1        Error, or ok is 0
+ */
+int
+xmldb_fclose(FILE       *f,
+	     const char *filename,
+	     int         ok)
+{
+    int  retval = -1;
+    char tmpname[MAXPATHLEN];
+
+    if (xmldb_tmpfile(filename, tmpname) < 0){
+	fclose(f);
+	goto done;
+    }
+    if (ok && ferror(f)){
+	clicon_err(OE_UNIX, errno, "Writing file %s", tmpname);
+	ok = 0;
+    }
+    if (fclose(f) != 0 && ok){
+	clicon_err(OE_UNIX, errno, "Closing file %s", tmpname);
+	ok = 0;
+    }
+    if (ok && rename(tmpname, filename) < 0){
+	clicon_err(OE_UNIX, errno, "rename(%s, %s)", tmpname, filename);
+	ok = 0;
+    }
+    if (!ok){
+	unlink(tmpname);
+	goto done;
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Write XML tree to a datastore file in a given format
+ *
+ * @param[in]  h      Clicon handle
+ * @param[in]  f      Output file
+ * @param[in]  format Datastore format: "xml", "json" or "binary"
+ * @param[in]  xt     XML tree with top-level "config", in canonical order
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see xmldb_readfile  for the corresponding read function
+ */
+int
+xmldb_dump(clicon_handle h,
+	   FILE         *f,
+	   const char   *format,
+	   cxobj        *xt)
 {
     int        retval = -1;
-    yang_stmt *y;  /* yang node */
+    yang_stmt *yspec;
+    cbuf      *cb = NULL;
+
+    if ((yspec = clicon_dbspec_yang(h)) == NULL){
+	clicon_err(OE_YANG, ENOENT, "No yang spec");
+	goto done;
+    }
+    if (strcmp(format,"json")==0){
+	if (xml2json(f, xt, clicon_option_bool(h, "CLICON_XMLDB_PRETTY")) < 0)
+	    goto done;
+    }
+    else if (strcmp(format,"binary")==0){
+	if (xmldb_binary_write(f, xmldb_modules_sum(h, yspec), xt) < 0)
+	    goto done;
+    }
+    else {
+#ifdef XMLDB_SORTED_STAMP
+	/* xt is in canonical order, stamp it so that it is not sorted when read */
+	if (clicon_option_bool(h, "CLICON_XMLDB_SORTED_STAMP")){
+	    if ((cb = cbuf_new()) == NULL){
+		clicon_err(OE_UNIX, errno, "cbuf_new");
+		goto done;
+	    }
+	    if (xmldb_sorted_stamp(h, yspec, cb) < 0)
+		goto done;
+	    fprintf(f, "%s\n", cbuf_get(cb));
+	}
+#endif
+	if (clicon_xml2file(f, xt, 0, clicon_option_bool(h, "CLICON_XMLDB_PRETTY")) < 0)
+	    goto done;
+    }
+    retval = 0;
+ done:
+    if (cb)
+	cbuf_free(cb);
+    return retval;
+}
+
+/*! Get the yang module name of a top-level datastore node
+ * @param[in]  xc     Top-level XML node of datastore
+ * @retval     name   Name of (real) module of xc
+ * @retval     NULL   Not bound to yang
+ */
+static char *
+xmldb_multi_module(cxobj *xc)
+{
+    yang_stmt *ymod;
+
+    if ((ymod = ys_real_module(xml_spec(xc))) == NULL)
+	return NULL;
+    return yang_argument_get(ymod);
+}
 
-    if ((y = (yang_stmt*)xml_spec(x)) == NULL){
+/*! Get modules whose top-level nodes may be changed by a modification tree
+ *
+ * Only the top-level nodes of x1 are examined, the modules of their subtrees (augments)
+ * are stored with the top-level node.
+ * @param[in]  yspec  Top-level yang spec
+ * @param[in]  x1     Modification tree with top-level "config"
+ * @param[in]  op     Top-level operation
+ * @param[out] dirty  Module names as cvec names. NULL if all modules may change. Free
+ *                    with cvec_free
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+xmldb_multi_dirty(yang_stmt          *yspec,
+		  cxobj              *x1,
+		  enum operation_type op,
+		  cvec              **dirty)
+{
+    int        retval = -1;
+    cvec      *cvv = NULL;
+    cxobj     *x1c;
+    yang_stmt *ymod;
+    char      *name;
+
+    *dirty = NULL;
+    /* Top-level operations may affect all modules */
+    if (x1 == NULL ||
+	xml_child_nr_type(x1, CX_ELMNT) == 0 ||
+	op == OP_REPLACE || op == OP_DELETE || op == OP_REMOVE ||
+	xml_find_type(x1, NULL, "operation", CX_ATTR) != NULL){
 	retval = 0;
 	goto done;
     }
-    /* Mark node that is: container, have no children, dont have presence */
-    if (yang_keyword_get(y) == Y_CONTAINER && 
-	xml_child_nr_notype(x, CX_ATTR)==0 &&
-	yang_find(y, Y_PRESENCE, NULL) == NULL)
-	xml_flag_set(x, XML_FLAG_MARK); /* Mark, remove later */
+    if ((cvv = cvec_new(0)) == NULL){
+	clicon_err(OE_UNIX, errno, "cvec_new");
+	goto done;
+    }
+    x1c = NULL;
+    while ((x1c = xml_child_each(x1, x1c, CX_ELMNT)) != NULL) {
+	if (ys_module_by_xml(yspec, x1c, &ymod) < 0)
+	    goto done;
+	if (ymod == NULL) /* Not a module node: in main file which is always written */
+	    continue;
+	name = yang_argument_get(ymod);
+	if (cvec_find(cvv, name) == NULL &&
+	    cvec_add_string(cvv, name, name) < 0){
+	    clicon_err(OE_UNIX, errno, "cvec_add_string");
+	    goto done;
+	}
+    }
+    *dirty = cvv;
+    cvv = NULL;
+    retval = 0;
+ done:
+    if (cvv)
+	cvec_free(cvv);
+    return retval;
+}
+
+/*! Check if a top-level node of a datastore may be changed by xmldb_put
+ * Used to keep unchanged top-level nodes shared with snapshots
+ * @param[in]  xc     Top-level XML node of datastore
+ * @param[in]  arg    Modification tree with top-level "config", NULL if all may change
+ * @retval     1      xc may be changed
+ * @retval     0      xc is not changed
+ * @retval    -1      Error
+ * @see xmldb_snapshot_cow
+ */
+static int
+xmldb_put_touched(cxobj *xc,
+		  void  *arg)
+{
+    cxobj     *x1 = (cxobj *)arg;
+    cxobj     *x1c;
+    yang_stmt *y;
+
+    if (x1 == NULL || (y = xml_spec(xc)) == NULL)
+	return 1;
+    x1c = NULL;
+    while ((x1c = xml_child_each(x1, x1c, CX_ELMNT)) != NULL)
+	if (xml_spec(x1c) == NULL || xml_spec(x1c) == y)
+	    return 1;
+    /* Empty non-presence containers are removed also in unchanged sub-trees */
+    return xml_apply0(xc, CX_ELMNT, xml_container_empty, NULL);
+}
+
+/*! Write one datastore file with copies of selected top-level nodes
+ * @param[in]  h        Clicon handle
+ * @param[in]  filename Datastore file
+ * @param[in]  format   Datastore format
+ * @param[in]  x0       Datastore XML tree with top-level "config"
+ * @param[in]  module   Write top-level nodes of this module, or if NULL, non-module nodes
+ * @param[in]  xmodst   Module-state node in x0 to write in non-module file, or NULL
+ * @retval     0        OK
+ * @retval    -1        Error
+ * If there are no module nodes, the file is removed.
+ */
+static int
+xmldb_multi_dump(clicon_handle h,
+		 const char   *filename,
+		 const char   *format,
+		 cxobj        *x0,
+		 const char   *module,
+		 cxobj        *xmodst)
+{
+    int    retval = -1;
+    cxobj *xt = NULL;
+    cxobj *xc;
+    cxobj *xd;
+    char  *name;
+    FILE  *f = NULL;
+    int    ret;
+
+    if ((xt = xml_new("config", NULL, CX_ELMNT)) == NULL)
+	goto done;
+    xc = NULL;
+    while ((xc = xml_child_each(x0, xc, CX_ELMNT)) != NULL) {
+	name = (xc == xmodst) ? NULL : xmldb_multi_module(xc);
+	if (module == NULL ? name != NULL : (name == NULL || strcmp(name, module) != 0))
+	    continue;
+	if ((xd = xml_dup(xc)) == NULL)
+	    goto done;
+	if (xml_addsub(xt, xd) < 0)
+	    goto done;
+    }
+    if (module && xml_child_nr_type(xt, CX_ELMNT) == 0){
+	if (unlink(filename) < 0 && errno != ENOENT){
+	    clicon_err(OE_UNIX, errno, "unlink(%s)", filename);
+	    goto done;
+	}
+	retval = 0;
+	goto done;
+    }
+    if ((f = xmldb_fopen(h, filename)) == NULL)
+	goto done;
+    if (xmldb_dump(h, f, format, xt) < 0)
+	goto done;
+    ret = xmldb_fclose(f, filename, 1);
+    f = NULL;
+    if (ret < 0)
+	goto done;
+    retval = 0;
+ done:
+    if (f)
+	xmldb_fclose(f, filename, 0);
+    if (xt)
+	xml_free(xt);
+    return retval;
+}
+
+/*! Check if a module of a top-level datastore node has no per-module file
+ * @param[in]  dir    Directory of per-module files
+ * @param[in]  format Datastore format
+ * @param[in]  x0     Datastore XML tree with top-level "config"
+ * @param[in]  xmodst Module-state node in x0, or NULL
+ * @param[in]  dirty  Module names that are written anyway
+ * @retval     1      A module file is missing
+ * @retval     0      All module files exist
+ * @retval    -1      Error
+ */
+static int
+xmldb_multi_missing(const char *dir,
+		    const char *format,
+		    cxobj      *x0,
+		    cxobj      *xmodst,
+		    cvec       *dirty)
+{
+    int         retval = -1;
+    cxobj      *xc;
+    char       *name;
+    cbuf       *cb = NULL;
+    struct stat st;
+
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_XML, errno, "cbuf_new");
+	goto done;
+    }
+    xc = NULL;
+    while ((xc = xml_child_each(x0, xc, CX_ELMNT)) != NULL) {
+	if (xc == xmodst || (name = xmldb_multi_module(xc)) == NULL)
+	    continue;
+	if (cvec_find(dirty, name) != NULL)
+	    continue;
+	cbuf_reset(cb);
+	cprintf(cb, "%s/%s.%s", dir, name, format);
+	if (stat(cbuf_get(cb), &st) < 0){
+	    if (errno != ENOENT){
+		clicon_err(OE_UNIX, errno, "stat(%s)", cbuf_get(cb));
+		goto done;
+	    }
+	    retval = 1;
+	    goto done;
+	}
+    }
     retval = 0;
  done:
+    if (cb)
+	cbuf_free(cb);
+    return retval;
+}
+
+/*! Write datastore as one file per top-level module and a main file
+ *
+ * The main datastore file contains module-state and non-module top-level nodes, and is
+ * always written. Of the per-module files in the <db>.d directory, only those of the
+ * modules in the dirty set are written, unless the set of per-module files is not known
+ * to be complete. Then all are written, eg if the main file was written without
+ * CLICON_XMLDB_MULTI and holds top-level nodes of modules, or if a module file is missing.
+ * The main file is written last, so that it keeps such nodes until they are written to
+ * their module files.
+ * @param[in]  h        Clicon handle
+ * @param[in]  db       Symbolic database name, eg "candidate", "running"
+ * @param[in]  dbfile   Main datastore file
+ * @param[in]  format   Datastore format
+ * @param[in]  x0       Datastore XML tree with top-level "config"
+ * @param[in]  xmodst   Module-state node in x0, or NULL
+ * @param[in]  dirty    Module names to write, or NULL for all
+ * @param[in]  complete All module files have been written before, ie only dirty need be
+ * @retval     0        OK
+ * @retval    -1        Error
+ * @see CLICON_XMLDB_MULTI
+ * @see xmldb_readfile_multi  for reading
+ */
+static int
+xmldb_put_multi(clicon_handle h,
+		const char   *db,
+		const char   *dbfile,
+		const char   *format,
+		cxobj        *x0,
+		cxobj        *xmodst,
+		cvec         *dirty,
+		int           complete)
+{
+    int         retval = -1;
+    char       *dir = NULL;
+    cvec       *all = NULL;
+    cg_var     *cv;
+    cxobj      *xc;
+    char       *name;
+    cbuf       *cb = NULL;
+    struct stat st;
+    int         ret;
+
+    if (xmldb_db2subdir(h, db, &dir) < 0)
+	goto done;
+    if (stat(dir, &st) < 0){
+	if (errno != ENOENT){
+	    clicon_err(OE_UNIX, errno, "stat(%s)", dir);
+	    goto done;
+	}
+	if (mkdir(dir, S_IRWXU|S_IRGRP|S_IXGRP|S_IROTH|S_IXOTH) < 0){
+	    clicon_err(OE_UNIX, errno, "mkdir(%s)", dir);
+	    goto done;
+	}
+	dirty = NULL; /* New dir: write all */
+    }
+    if (!complete)
+	dirty = NULL;
+    else if (dirty != NULL){
+	if ((ret = xmldb_multi_missing(dir, format, x0, xmodst, dirty)) < 0)
+	    goto done;
+	if (ret == 1)
+	    dirty = NULL;
+    }
+    if (dirty == NULL){
+	/* Remove all module files and write modules present in x0 */
+	if (xmldb_multi_rm(h, db) < 0)
+	    goto done;
+	if ((all = cvec_new(0)) == NULL){
+	    clicon_err(OE_UNIX, errno, "cvec_new");
+	    goto done;
+	}
+	xc = NULL;
+	while ((xc = xml_child_each(x0, xc, CX_ELMNT)) != NULL) {
+	    if (xc == xmodst || (name = xmldb_multi_module(xc)) == NULL)
+		continue;
+	    if (cvec_find(all, name) == NULL &&
+		cvec_add_string(all, name, name) < 0){
+		clicon_err(OE_UNIX, errno, "cvec_add_string");
+		goto done;
+	    }
+	}
+	dirty = all;
+    }
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_XML, errno, "cbuf_new");
+	goto done;
+    }
+    cv = NULL;
+    while ((cv = cvec_each(dirty, cv)) != NULL) {
+	cbuf_reset(cb);
+	cprintf(cb, "%s/%s.%s", dir, cv_name_get(cv), format);
+	if (xmldb_multi_dump(h, cbuf_get(cb), format, x0, cv_name_get(cv), NULL) < 0)
+	    goto done;
+    }
+    if (xmldb_multi_dump(h, dbfile, format, x0, NULL, xmodst) < 0)
+	goto done;
+    retval = 0;
+ done:
+    if (cb)
+	cbuf_free(cb);
+    if (all)
+	cvec_free(all);
+    if (dir)
+	free(dir);
     return retval;
 }
 
@@ -906,6 +1566,9 @@ xmldb_put(clicon_handle       h,
     char               *format;
     cvec               *nsc = NULL; /* nacm namespace context */
     int                 firsttime = 0;
+    int                 multi;
+    int                 complete;
+    cvec               *dirty = NULL;
 
     if (cbret == NULL){
 	clicon_err(OE_XML, EINVAL, "cbret is NULL");
@@ -920,6 +1583,12 @@ xmldb_put(clicon_handle       h,
 		   xml_name(x1));
 	goto done;
     }
+    /* Modules whose top-level nodes may change, NULL if all (top-level operation) */
+    if (xmldb_multi_dirty(yspec, x1, op, &dirty) < 0)
+	goto done;
+    /* Snapshots of the cache keep copies of the top-level nodes that may change */
+    if (xmldb_snapshot_cow(h, db, xmldb_put_touched, dirty?x1:NULL) < 0)
+	goto done;
     if ((de = clicon_db_elmnt_get(h, db)) != NULL){
 	if (clicon_datastore_cache(h) != DATASTORE_NOCACHE)
 	    x0 = de->de_xml; 
@@ -945,6 +1614,8 @@ xmldb_put(clicon_handle       h,
     xnacm = clicon_nacm_cache(h);
     permit = (xnacm==NULL);
 
+    /* Modules to write if each module is in a separate file */
+    multi = clicon_option_bool(h, "CLICON_XMLDB_MULTI");
     /* Here assume if xnacm is set and !permit do NACM */
     /* 
      * Modify base tree x with modification x1. This is where the
@@ -965,8 +1636,8 @@ xmldb_put(clicon_handle       h,
     /* Remove NONE nodes if all subs recursively are also NONE */
     if (xml_tree_prune_flagged_sub(x0, XML_FLAG_NONE, 0, NULL) <0)
 	goto done;
-    if (xml_apply(x0, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset, 
-		  (void*)(XML_FLAG_NONE|XML_FLAG_MARK)) < 0)
+    /* Reset NONE and MARK flags */
+    if (xml_flag_epoch_next() < 0)
 	goto done;
     /* Mark non-presence containers that do not have children */
     if (xml_apply(x0, CX_ELMNT, (xml_applyfn_t*)xml_container_presence, NULL) < 0)
@@ -974,6 +1645,8 @@ xmldb_put(clicon_handle       h,
     /* Remove (prune) nodes that are marked (non-presence containers w/o children) */
     if (xml_tree_prune_flagged(x0, XML_FLAG_MARK, 1) < 0)
 	goto done;
+    if (xml_flag_epoch_next() < 0)
+	goto done;
 #if 0 /* debug */
     if (xml_apply0(x0, -1, xml_sort_verify, NULL) < 0)
 	clicon_log(LOG_NOTICE, "%s: verify failed #3", __FUNCTION__);
@@ -1008,16 +1681,27 @@ xmldb_put(clicon_handle       h,
 	clicon_err(OE_CFG, ENOENT, "No CLICON_XMLDB_FORMAT");
 	goto done;
     }
-    if ((f = fopen(dbfile, "w")) == NULL){
-	clicon_err(OE_CFG, errno, "Creating file %s", dbfile);
-	goto done;
-    } 
-    if (strcmp(format,"json")==0){
-	if (xml2json(f, x0, clicon_option_bool(h, "CLICON_XMLDB_PRETTY")) < 0)
+    if (multi){
+	/* Per-module files are known to be complete only if written by this process and
+	 * the datastore is cached, otherwise the files may have been changed */
+	complete = clicon_datastore_cache(h) != DATASTORE_NOCACHE &&
+	    (de = clicon_db_elmnt_get(h, db)) != NULL && de->de_multi;
+	if (xmldb_put_multi(h, db, dbfile, format, x0, xmodst, dirty, complete) < 0)
+	    goto done;
+	if (clicon_datastore_cache(h) != DATASTORE_NOCACHE &&
+	    (de = clicon_db_elmnt_get(h, db)) != NULL)
+	    de->de_multi = 1;
+    }
+    else {
+	if ((f = xmldb_fopen(h, dbfile)) == NULL)
+	    goto done;
+	if (xmldb_dump(h, f, format, x0) < 0)
+	    goto done;
+	ret = xmldb_fclose(f, dbfile, 1);
+	f = NULL;
+	if (ret < 0)
 	    goto done;
     }
-    else if (clicon_xml2file(f, x0, 0, clicon_option_bool(h, "CLICON_XMLDB_PRETTY")) < 0)
-	goto done;
     /* Remove modules state after writing to file
      */
     if (xmodst && xml_purge(xmodst) < 0)
@@ -1025,9 +1709,11 @@ xmldb_put(clicon_handle       h,
     retval = 1;
  done:
     if (f != NULL)
-	fclose(f);
+	xmldb_fclose(f, dbfile, 0);
     if (nsc)
 	xml_nsctx_free(nsc);
+    if (dirty)
+	cvec_free(dirty);
     if (dbfile)
 	free(dbfile);
     if (cb)
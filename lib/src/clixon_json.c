@@ -74,6 +74,7 @@
 #include "clixon_netconf_lib.h"
 #include "clixon_json.h"
 #include "clixon_json_parse.h"
+#include "clixon_json_scan.h"
 
 #define JSON_INDENT 2 /* maybe we should set this programmatically? */
 
@@ -88,6 +89,10 @@
 /* Name of xml top object created by xml parse functions */
 #define JSON_TOP_SYMBOL "top"
 
+#ifdef JSON_PARSE_FAST
+static int _json_parse_fast = 0;
+#endif
+
 enum array_element_type{
     NO_ARRAY=0,
     FIRST_ARRAY,  /* [a, */
@@ -97,6 +102,27 @@ enum array_element_type{
     BODY_ARRAY
 };
 
+/*! JSON encoding of leaf and leaf-list values, given by yang type
+ * @see xml2json_encode_leafs
+ */
+enum json_leaf_enc{
+    JSON_ENC_STRING=0,    /* Quoted string */
+    JSON_ENC_IDENTITYREF, /* Quoted identity, qualified with module name if other module */
+    JSON_ENC_NUMBER,      /* Unquoted: integers, decimal64 and boolean */
+    JSON_ENC_EMPTY,       /* YANG empty type: [null] */
+    JSON_ENC_VOID,        /* Other void types: "" */
+    JSON_ENC_OTHER        /* Quoted, or {} if no value */
+};
+
+/*! JSON encoding metadata of a yang data node, cached on the yang node
+ * Computed once per node instead of for every XML node when translating to JSON
+ * @see json_yang_cache
+ */
+struct yang_json_cache{
+    char              *yj_modname; /* Name of (real) module, qualifies JSON member names */
+    enum json_leaf_enc yj_enc;     /* Encoding of value if leaf or leaf-list */
+};
+
 enum childtype{
     NULL_CHILD=0, /* eg <a/> no children. Translated to null if in 
 		   * array or leaf terminal, and to {} if proper object, ie container.
@@ -179,6 +205,28 @@ arraytype2str(enum array_element_type lt)
     return "";
 }
 
+/*! Check if sibling x2 is in the same array as element x: same name and namespace
+ * If both are bound to yang, the yang specs are compared instead
+ */
+static int
+array_eq(cxobj *x,
+	 cxobj *x2)
+{
+    yang_stmt *ys;
+    char      *nsx; /* namespace of x */
+    char      *ns2;
+
+    if (x2 == NULL || xml_type(x2) != CX_ELMNT)
+	return 0;
+    if ((ys = xml_spec(x)) != NULL && xml_spec(x2) != NULL)
+	return ys == xml_spec(x2);
+    if (strcmp(xml_name(x), xml_name(x2)) != 0)
+	return 0;
+    nsx = xml_find_type_value(x, NULL, "xmlns", CX_ATTR);
+    ns2 = xml_find_type_value(x2, NULL, "xmlns", CX_ATTR);
+    return (!nsx && !ns2) || (nsx && ns2 && strcmp(nsx, ns2) == 0);
+}
+
 /*! Check typeof x in array
  * Some complexity when x is in different namespaces
  */
@@ -191,31 +239,14 @@ array_eval(cxobj *xprev,
     int                     eqprev=0;
     int                     eqnext=0;
     yang_stmt              *ys;
-    char                   *nsx; /* namespace of x */
-    char                   *ns2;
 
-    nsx = xml_find_type_value(x, NULL, "xmlns", CX_ATTR);
     if (xml_type(x) != CX_ELMNT){
 	array=BODY_ARRAY;
 	goto done;
     }
     ys = xml_spec(x);
-    if (xnext && 
-	xml_type(xnext)==CX_ELMNT &&
-	strcmp(xml_name(x), xml_name(xnext))==0){
-        ns2 = xml_find_type_value(xnext, NULL, "xmlns", CX_ATTR);
-	if ((!nsx && !ns2)
-	    || (nsx && ns2 && strcmp(nsx,ns2)==0))
-	    eqnext++;
-    }
-    if (xprev &&
-	xml_type(xprev)==CX_ELMNT &&
-	strcmp(xml_name(x),xml_name(xprev))==0){
-	ns2 = xml_find_type_value(xprev, NULL, "xmlns", CX_ATTR);
-	if ((!nsx && !ns2)
-	    || (nsx && ns2 && strcmp(nsx,ns2)==0))
-	    eqprev++;
-    }
+    eqnext = array_eq(x, xnext);
+    eqprev = array_eq(x, xprev);
     if (eqprev && eqnext)
 	array = MIDDLE_ARRAY;
     else if (eqprev)
@@ -238,46 +269,127 @@ static int
 json_str_escape_cdata(cbuf *cb,
 		      char *str)
 {
-    int   retval = -1;
-    int   i;
+    char *p = str;
+    char *end = str + strlen(str);
+    char *q;
     int   esc = 0; /* cdata escape */
 
-    for (i=0;i<strlen(str);i++)
-	switch (str[i]){
-	case '\n':
-	    cprintf(cb, "\\n");
-	    break;
-	case '\"':
-	    cprintf(cb, "\\\"");
+    while (1){
+	/* Append run of characters that need no escaping, see clixon_memchr4 */
+	q = (char*)clixon_memchr4(p, end - p, '\n', '"', '\\', esc?']':'<');
+	cbuf_append_buf(cb, p, q - p);
+	if (q == end)
 	    break;
+	p = q + 1;
+	switch (*q){
+	case '\n':
+	case '"':
 	case '\\':
-	    cprintf(cb, "\\\\");
+	    cbuf_append(cb, '\\');
+	    cbuf_append(cb, *q == '\n' ? 'n' : *q);
 	    break;
 	case '<':
-	    if (!esc &&
-		strncmp(&str[i], "<![CDATA[", strlen("<![CDATA[")) == 0){
+	    if (strncmp(q, "<![CDATA[", strlen("<![CDATA[")) == 0){
 		esc=1;
-		i += strlen("<![CDATA[")-1;
+		p = q + strlen("<![CDATA[");
 	    }
 	    else
-		cprintf(cb, "%c", str[i]);
+		cbuf_append(cb, *q);
 	    break;
 	case ']':
-	    if (esc &&
-		strncmp(&str[i], "]]>", strlen("]]>")) == 0){
+	    if (strncmp(q, "]]>", strlen("]]>")) == 0){
 		esc=0;
-		i += strlen("]]>")-1;
+		p = q + strlen("]]>");
 	    }
 	    else
-		cprintf(cb, "%c", str[i]);
+		cbuf_append(cb, *q);
 	    break;
-	default: /* fall thru */
-	    cprintf(cb, "%c", str[i]);
+	}
+    }
+    return 0;
+}
+
+/*! Append a quoted and escaped JSON string
+ * @param[out] cb   cbuf   (encoded)
+ * @param[in]  str  string (unencoded)
+ */
+static int
+json_str_quote(cbuf *cb,
+	       char *str)
+{
+    cbuf_append(cb, '"');
+    json_str_escape_cdata(cb, str);
+    cbuf_append(cb, '"');
+    return 0;
+}
+
+/*! Get JSON encoding metadata of a yang data node, compute and cache it on first use
+ * @param[in]  ys    Yang spec of XML element
+ * @retval     yj    JSON encoding metadata
+ * @retval     NULL  Error
+ * @see yang_json_cache_get
+ */
+static yang_json_cache *
+json_yang_cache(yang_stmt *ys)
+{
+    yang_json_cache *yj;
+    yang_stmt       *ymod;
+    yang_stmt       *ytype = NULL;
+    char            *origtype = NULL;
+    char            *restype;
+
+    if ((yj = yang_json_cache_get(ys)) != NULL)
+	return yj;
+    if ((ymod = ys_real_module(ys)) == NULL){
+	clicon_err(OE_YANG, ENOENT, "No module of %s", yang_argument_get(ys));
+	return NULL;
+    }
+    if ((yj = malloc(sizeof(*yj))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	return NULL;
+    }
+    memset(yj, 0, sizeof(*yj));
+    yj->yj_modname = yang_argument_get(ymod);
+    yj->yj_enc = JSON_ENC_STRING;
+    if (yang_keyword_get(ys) == Y_LEAF || yang_keyword_get(ys) == Y_LEAF_LIST){
+	if (yang_type_get(ys, &origtype, &ytype, NULL, NULL, NULL, NULL, NULL) < 0){
+	    free(yj);
+	    return NULL;
+	}
+	restype = ytype?yang_argument_get(ytype):NULL;
+	switch (yang_type2cv(ys)){ 
+	case CGV_STRING:
+	case CGV_REST:
+	    if (restype && strcmp(restype, "identityref")==0)
+		yj->yj_enc = JSON_ENC_IDENTITYREF;
+	    break;
+	case CGV_INT8:
+	case CGV_INT16:
+	case CGV_INT32:
+	case CGV_INT64:
+	case CGV_UINT8:
+	case CGV_UINT16:
+	case CGV_UINT32:
+	case CGV_UINT64:
+	case CGV_DEC64:
+	case CGV_BOOL:
+	    yj->yj_enc = JSON_ENC_NUMBER;
+	    break;
+	case CGV_VOID:
+	    if (restype && strcmp(restype, "empty")==0)
+		yj->yj_enc = JSON_ENC_EMPTY;
+	    else
+		yj->yj_enc = JSON_ENC_VOID;
+	    break;
+	default:
+	    yj->yj_enc = JSON_ENC_OTHER;
 	    break;
 	}
-    retval = 0;
-    // done:
-    return retval;
+	if (origtype)
+	    free(origtype);
+    }
+    yang_json_cache_set(ys, yj);
+    return yj;
 }
 
 /*! Decode types from JSON to XML identityrefs
@@ -392,6 +504,32 @@ json2xml_decode_identityref(cxobj     *x,
     goto done;
 }
 
+/*! Decode leaf/leaf_list type of a single XML node from JSON to XML, not its children
+ *
+ * @param[in]     x     XML node. Must be yang populated. After json parsing
+ * @param[out]    xerr  Reason for invalid tree returned as netconf err msg or NULL
+ * @retval        1     OK 
+ * @retval        0     Invalid, wrt namespace.  xerr set
+ * @retval       -1     Error
+ * @see json2xml_decode  For a whole tree
+ */
+int
+json2xml_decode_node(cxobj     *x,
+		     cxobj    **xerr)
+{
+    yang_stmt       *y;
+    yang_json_cache *yj;
+    
+    if ((y = xml_spec(x)) == NULL ||
+	(yang_keyword_get(y) != Y_LEAF && yang_keyword_get(y) != Y_LEAF_LIST))
+	return 1;
+    if ((yj = json_yang_cache(y)) == NULL)
+	return -1;
+    if (yj->yj_enc == JSON_ENC_IDENTITYREF)
+	return json2xml_decode_identityref(x, y, xerr);
+    return 1;
+}
+
 /*! Decode leaf/leaf_list types from JSON to XML after parsing and yang
  *
  * Assume an xml tree where prefix:name have been split into "module":"name"
@@ -410,30 +548,13 @@ json2xml_decode(cxobj     *x,
 		cxobj    **xerr)
 {
     int           retval = -1;
-    yang_stmt    *y;
-    enum rfc_6020 keyword;
     cxobj        *xc;
     int           ret;
-    yang_stmt    *ytype;
 
-    if ((y = xml_spec(x)) != NULL){
-	keyword = yang_keyword_get(y);
-	if (keyword == Y_LEAF || keyword == Y_LEAF_LIST){
-	    if (yang_type_get(y, NULL, &ytype, NULL, NULL, NULL, NULL, NULL) < 0)
-		goto done;
-
-	    if (ytype){
-		if (strcmp(yang_argument_get(ytype), "identityref")==0){
-		    if ((ret = json2xml_decode_identityref(x, y, xerr)) < 0)
-			goto done;
-		    if (ret == 0)
-			goto fail;
-		}
-		else if (strcmp(yang_argument_get(ytype), "empty")==0)
-		    ; /* dont need to do anything */
-	    }
-	}
-    }
+    if ((ret = json2xml_decode_node(x, xerr)) < 0)
+	goto done;
+    if (ret == 0)
+	goto fail;
     xc = NULL;
     while ((xc = xml_child_each(x, xc, CX_ELMNT)) != NULL){
 	if ((ret = json2xml_decode(xc, xerr)) < 0)
@@ -517,6 +638,7 @@ xml2json_encode_identityref(cxobj     *xb,
  * @param[in]     x   XML body
  * @param[in]     ys  Yang spec of parent
  * @param[out]    cb0  Encoded string
+ * @see json_yang_cache  Encoding is given by the resolved yang type
  */
 static int
 xml2json_encode_leafs(cxobj     *xb,
@@ -524,98 +646,60 @@ xml2json_encode_leafs(cxobj     *xb,
 		      yang_stmt *yp,
 		      cbuf      *cb0)
 {
-    int           retval = -1;
-    enum rfc_6020 keyword;
-    yang_stmt    *ytype;
-    char         *restype;  /* resolved type */
-    char         *origtype=NULL;   /* original type */
-    char         *body;
-    enum cv_type  cvtype;
-    int           quote = 1; /* Quote value w string: "val" */
-    cbuf         *cb = NULL; /* the variable itself */
+    int              retval = -1;
+    char            *body;
+    yang_json_cache *yj;
+    cbuf            *cb = NULL; /* identityref */
 
-    if ((cb = cbuf_new()) ==NULL){
-	clicon_err(OE_XML, errno, "cbuf_new");
-	goto done;
-    }
     body = xb?xml_value(xb):NULL;
     if (yp == NULL){
-	cprintf(cb, "%s", body?body:"null"); 
+	json_str_quote(cb0, body?body:"null");
 	goto ok; /* unknown */
     }
-    keyword = yang_keyword_get(yp);
-    switch (keyword){
-    case Y_LEAF:
-    case Y_LEAF_LIST:
-	if (yang_type_get(yp, &origtype, &ytype, NULL, NULL, NULL, NULL, NULL) < 0)
-	    goto done;
-	restype = ytype?yang_argument_get(ytype):NULL;
-	cvtype = yang_type2cv(yp);
-	switch (cvtype){ 
-	case CGV_STRING:
-	case CGV_REST:
-	    if (body==NULL)
-		; /* empty: "" */
-	    else if (ytype){
-		if (strcmp(restype, "identityref")==0){
-		    if (xml2json_encode_identityref(xb, body, yp, cb) < 0)
-			goto done;
-		}
-		else
-		    cprintf(cb, "%s", body);
-	    }
-	    else
-		cprintf(cb, "%s", body);
-	    break;
-	case CGV_INT8:
-	case CGV_INT16:
-	case CGV_INT32:
-	case CGV_INT64:
-	case CGV_UINT8:
-	case CGV_UINT16:
-	case CGV_UINT32:
-	case CGV_UINT64:
-	case CGV_DEC64:
-	case CGV_BOOL:
-	    cprintf(cb, "%s", body);
-	    quote = 0;
-	    break;
-	case CGV_VOID:
-	    /* special case YANG empty type */
-	    if (body == NULL && strcmp(restype, "empty")==0){
-		quote = 0;
-		cprintf(cb, "[null]");
-	    }
+    if (yang_keyword_get(yp) != Y_LEAF && yang_keyword_get(yp) != Y_LEAF_LIST){
+	json_str_quote(cb0, body?body:"(null)");
+	goto ok;
+    }
+    if ((yj = json_yang_cache(yp)) == NULL)
+	goto done;
+    switch (yj->yj_enc){
+    case JSON_ENC_STRING:
+	json_str_quote(cb0, body?body:"");
+	break;
+    case JSON_ENC_IDENTITYREF:
+	if (body == NULL){
+	    json_str_quote(cb0, "");
 	    break;
-	default:
-	    if (body)
-		cprintf(cb, "%s", body);
-	    else
-		cprintf(cb, "{}"); /* dont know */
 	}
+	if ((cb = cbuf_new()) ==NULL){
+	    clicon_err(OE_XML, errno, "cbuf_new");
+	    goto done;
+	}
+	if (xml2json_encode_identityref(xb, body, yp, cb) < 0)
+	    goto done;
+	json_str_quote(cb0, cbuf_get(cb));
 	break;
-    default:
-	cprintf(cb, "%s", body);
+    case JSON_ENC_NUMBER:
+	cbuf_append_str(cb0, body?body:"(null)");
+	break;
+    case JSON_ENC_EMPTY:
+	if (body == NULL)
+	    cbuf_append_str(cb0, "[null]");
+	else
+	    json_str_quote(cb0, "");
+	break;
+    case JSON_ENC_VOID:
+	json_str_quote(cb0, "");
+	break;
+    case JSON_ENC_OTHER:
+	json_str_quote(cb0, body?body:"{}");
 	break;
     }
  ok:
-    /* write into original cb0
-     * includign quoting and encoding 
-     */
-    if (quote){
-	cprintf(cb0, "\"");
-	json_str_escape_cdata(cb0, cbuf_get(cb));
-    }
-    else
-	cprintf(cb0, "%s", cbuf_get(cb));
-    if (quote)
-	cprintf(cb0, "\"");
     retval = 0;
  done:
     if (cb)
 	cbuf_free(cb);
-    if (origtype)
-	free(origtype);
     return retval;
 }
 
@@ -662,6 +746,31 @@ nullchild(cbuf      *cb,
     return retval;
 }
 
+/*! Append JSON object member name, qualified with module name if set
+ * @param[out]   cb        Cligen text buffer
+ * @param[in]    x         XML element
+ * @param[in]    modname   Module name, or NULL if same as parent
+ * @param[in]    level     Indentation level
+ * @param[in]    pretty    Pretty-print output
+ */
+static void
+json_member(cbuf  *cb,
+	    cxobj *x,
+	    char  *modname,
+	    int    level,
+	    int    pretty)
+{
+    if (pretty)
+	cprintf(cb, "%*s", level*JSON_INDENT, "");
+    cbuf_append(cb, '"');
+    if (modname){
+	cbuf_append_str(cb, modname);
+	cbuf_append(cb, ':');
+    }
+    cbuf_append_str(cb, xml_name(x));
+    cbuf_append_str(cb, pretty?"\": ":"\":");
+}
+
 /*! Do the actual work of translating XML to JSON 
  * @param[out]   cb        Cligen text buffer containing json on exit
  * @param[in]    x         XML tree structure containing XML to translate
@@ -716,14 +825,15 @@ xml2json1_cbuf(cbuf                   *cb,
     enum childtype   childt;
     enum array_element_type xc_arraytype;
     yang_stmt       *ys;
-    yang_stmt       *ymod; /* yang module */
     int              commas;
     char            *modname = NULL;
+    yang_json_cache *yj;
 
     if ((ys = xml_spec(x)) != NULL){
-	ymod = ys_real_module(ys);
-	modname = yang_argument_get(ymod);
-	if (modname0 && strcmp(modname, modname0) == 0)
+	if ((yj = json_yang_cache(ys)) == NULL)
+	    goto done;
+	modname = yj->yj_modname;
+	if (modname0 && (modname == modname0 || strcmp(modname, modname0) == 0))
 	    modname=NULL;
 	else
 	    modname0 = modname; /* modname0 is ancestor ns passed to child */
@@ -740,12 +850,8 @@ xml2json1_cbuf(cbuf                   *cb,
 	    goto done;
 	break;
     case NO_ARRAY:
-	if (!flat){
-	    cprintf(cb, "%*s\"", pretty?(level*JSON_INDENT):0, "");
-	    if (modname) 
-		cprintf(cb, "%s:", modname);
-	    cprintf(cb, "%s\":%s", xml_name(x), pretty?" ":"");
-	}
+	if (!flat)
+	    json_member(cb, x, modname, level, pretty);
 	switch (childt){
 	case NULL_CHILD:
 	    if (nullchild(cb, x, ys) < 0)
@@ -762,10 +868,7 @@ xml2json1_cbuf(cbuf                   *cb,
 	break;
     case FIRST_ARRAY:
     case SINGLE_ARRAY:
-	cprintf(cb, "%*s\"", pretty?(level*JSON_INDENT):0, "");
-	if (modname)
-	    cprintf(cb, "%s:", modname);
-	cprintf(cb, "%s\":%s", xml_name(x), pretty?" ":"");
+	json_member(cb, x, modname, level, pretty);
 	level++;
 	cprintf(cb, "[%s%*s", 
 		pretty?"\n":"",
@@ -825,7 +928,9 @@ xml2json1_cbuf(cbuf                   *cb,
 			   level+1, pretty, 0, modname0) < 0)
 	    goto done;
 	if (commas > 0) {
-	    cprintf(cb, ",%s", pretty?"\n":"");
+	    cbuf_append(cb, ',');
+	    if (pretty)
+		cbuf_append(cb, '\n');
 	    --commas;
 	}
     }
@@ -1175,6 +1280,21 @@ json_xmlns_translate(yang_stmt *yspec,
     goto done;
 }
 
+/*! Enable or disable the hand-written JSON scanner
+ * If disabled, the flex/bison JSON parser is used. 
+ * @param[in]  enable  0: use flex/bison parser, 1: use fast scanner (if compiled in)
+ * @see JSON_PARSE_FAST
+ * @see clixon_xml_parse_fast_set
+ */
+int
+clixon_json_parse_fast_set(int enable)
+{
+#ifdef JSON_PARSE_FAST
+    _json_parse_fast = enable;
+#endif
+    return 0;
+}
+
 /*! Parse a string containing JSON and return an XML tree
  *
  * Parsing using yacc according to JSON syntax. Names with <prefix>:<id>
@@ -1207,8 +1327,24 @@ _json_parse(char      *str,
     cbuf            *cberr = NULL;
     int              i;
     int              failed = 0; /* yang assignment */
+#ifdef JSON_PARSE_FAST
+    char            *str1 = NULL;
+#endif
     
     clicon_debug(1, "%s %d %s", __FUNCTION__, yb, str);
+#ifdef JSON_PARSE_FAST
+    /* Namespaces, yang and identityrefs are translated by the scanner in the same pass */
+    if (_json_parse_fast){
+	if ((str1 = strdup(str)) == NULL){
+	    clicon_err(OE_XML, errno, "strdup");
+	    return -1;
+	}
+	retval = clixon_json_scan(str1, yb, yspec, xt, xerr);
+	free(str1);
+	clicon_debug(1, "%s retval:%d", __FUNCTION__, retval);
+	return retval;
+    }
+#endif
     jy.jy_parse_string = str;
     jy.jy_linenum = 1;
     jy.jy_current = xt;
@@ -1397,7 +1533,6 @@ clixon_json_parse_file(int        fd,
     int       jsonbuflen = BUFLEN; /* start size */
     int       oldjsonbuflen;
     char     *ptr;
-    char      ch;
     int       len = 0;
     
     if (xt==NULL){
@@ -1411,12 +1546,11 @@ clixon_json_parse_file(int        fd,
     memset(jsonbuf, 0, jsonbuflen);
     ptr = jsonbuf;
     while (1){
-	if ((ret = read(fd, &ch, 1)) < 0){
+	if ((ret = read(fd, jsonbuf+len, jsonbuflen-1-len)) < 0){
 	    clicon_err(OE_XML, errno, "read");
-	    break;
+	    goto done;
 	}
-	if (ret != 0)
-	    jsonbuf[len++] = ch;
+	len += ret;
 	if (ret == 0){
 	    if (*xt == NULL)
 		if ((*xt = xml_new(JSON_TOP_SYMBOL, NULL, CX_ELMNT)) == NULL)
@@ -217,8 +217,13 @@ json_current_clone(clixon_json_yacc *jy)
     }
     xn = jy->jy_current;
     json_current_pop(jy);
-    if (jy->jy_current) 
-	json_current_new(jy, xml_name(xn));
+    if (jy->jy_current){
+	if (json_current_new(jy, xml_name(xn)) < 0)
+	    return -1;
+	/* Same module name as previous element */
+	if (xml_prefix(xn) && xml_prefix_set(jy->jy_current, xml_prefix(xn)) < 0)
+	    return -1;
+    }
     return 0;
 }
 
@@ -0,0 +1,756 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+
+  Copyright (C) 2009-2016 Olof Hagsand and Benny Holmgren
+  Copyright (C) 2017-2019 Olof Hagsand
+  Copyright (C) 2020 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2,
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * Hand-written JSON scanner, alternative to the flex/bison JSON parser
+ * Builds the same XML tree as the generated parser followed by namespace translation,
+ * yang binding, identityref decoding and sorting in _json_parse, but in a single pass:
+ *  - A member name "module:name" is split and the module is resolved directly to its
+ *    namespace when the member is created, see json_xmlns_translate
+ *  - An element is bound to yang when it is created, ie when its parent is bound, see
+ *    xml_bind_yang_node
+ *  - When the value of an element is complete, an identityref value is decoded and the
+ *    children of the element are sorted
+ * Strings are decoded in place in the input buffer, which is therefore expected to be a
+ * private copy. As in the generated parser, the escapes \b \f \n \r \t and \uXXXX are
+ * decoded, the latter to UTF-8, and other escaped characters are kept as is.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include "clixon_err.h"
+#include "clixon_string.h"
+#include "clixon_queue.h"
+#include "clixon_hash.h"
+#include "clixon_handle.h"
+#include "clixon_options.h"
+#include "clixon_yang.h"
+#include "clixon_xml.h"
+#include "clixon_yang_module.h"
+#include "clixon_xml_sort.h"
+#include "clixon_xml_bind.h"
+#include "clixon_xml_map.h"
+#include "clixon_netconf_lib.h"
+#include "clixon_json.h"
+#include "clixon_json_scan.h"
+
+/*
+ * Constants
+ */
+#define JSON_WHITESPACE(c) ((c)==' ' || (c)=='\t' || (c)=='\n' || (c)=='\r')
+
+/* Max nesting of objects and arrays, as the stack depth of the generated parser */
+#define JSON_SCAN_MAXDEPTH 10000
+
+/*
+ * Types
+ */
+/*! JSON scanner state */
+struct json_scan {
+    char       *js_buf;    /* Start of (mutable) input buffer */
+    char       *js_p;      /* Current scan position */
+    char       *js_end;    /* End of input, points to terminating NUL */
+    int         js_depth;  /* Nesting of objects and arrays */
+    cxobj      *js_xt;     /* Top of XML parse tree */
+    yang_bind   js_yb;     /* How to bind yang to top-level elements */
+    yang_stmt  *js_yspec;  /* Yang spec */
+    cxobj     **js_xerr;   /* Reason for invalid tree */
+    int         js_failed; /* Tree is invalid: no more namespace checks or yang binding */
+};
+typedef struct json_scan json_scan;
+
+static int json_scan_value(json_scan *js, cxobj **xp);
+
+/*! Report a scan error at current position
+ * @param[in]  js     JSON scanner state
+ * @param[in]  reason Error reason
+ * @retval    -1      Always, with clicon_err called
+ * @note line number is computed here instead of being maintained while scanning
+ */
+static int
+json_scan_err(json_scan  *js,
+	      const char *reason)
+{
+    int   linenum = 1;
+    char *p;
+
+    for (p = js->js_buf; p < js->js_p; p++)
+	if (*p == '\n')
+	    linenum++;
+    clicon_err(OE_XML, XMLPARSE_ERRNO, "json_parse: line %d: %s at or before: '%.1s'",
+	       linenum, reason, js->js_p);
+    return -1;
+}
+
+/*! Skip whitespace */
+static inline void
+json_scan_ws(json_scan *js)
+{
+    while (JSON_WHITESPACE(*js->js_p))
+	js->js_p++;
+}
+
+/*! Decode four hex digits of a \uXXXX escape
+ * @param[in]  p     First hex digit
+ * @retval     u     Code unit
+ * @retval    -1     Not four hex digits
+ */
+static int
+json_unicode_hex4(const char *p)
+{
+    int u = 0;
+    int i;
+    
+    for (i=0; i<4; i++){
+	u <<= 4;
+	if (p[i] >= '0' && p[i] <= '9')
+	    u |= p[i] - '0';
+	else if (p[i] >= 'a' && p[i] <= 'f')
+	    u |= p[i] - 'a' + 10;
+	else if (p[i] >= 'A' && p[i] <= 'F')
+	    u |= p[i] - 'A' + 10;
+	else
+	    return -1;
+    }
+    return u;
+}
+
+/*! Decode a \uXXXX escape, or a surrogate pair of two, to UTF-8
+ * @param[in]  p     First hex digit after \u
+ * @param[out] w     Output, room for at least four characters
+ * @param[out] len   Number of UTF-8 characters written to w
+ * @retval     n     Number of input characters decoded from p, 4 or 10 for a pair
+ * @retval    -1     Not four hex digits
+ */
+int
+json_unicode_utf8(const char *p,
+		  char       *w,
+		  int        *len)
+{
+    char *w0 = w;
+    int   u;
+    int   u2;
+    int   n = 4;
+
+    if ((u = json_unicode_hex4(p)) < 0)
+	return -1;
+    if (u >= 0xD800 && u < 0xDC00 && p[4] == '\\' && p[5] == 'u' &&
+	(u2 = json_unicode_hex4(p + 6)) >= 0xDC00 && u2 < 0xE000){
+	u = 0x10000 + ((u - 0xD800) << 10) + (u2 - 0xDC00);
+	n = 10;
+    }
+    if (u < 0x80)
+	*w++ = u;
+    else if (u < 0x800){
+	*w++ = 0xC0 | (u >> 6);
+	*w++ = 0x80 | (u & 0x3F);
+    }
+    else if (u < 0x10000){
+	*w++ = 0xE0 | (u >> 12);
+	*w++ = 0x80 | ((u >> 6) & 0x3F);
+	*w++ = 0x80 | (u & 0x3F);
+    }
+    else{
+	*w++ = 0xF0 | (u >> 18);
+	*w++ = 0x80 | ((u >> 12) & 0x3F);
+	*w++ = 0x80 | ((u >> 6) & 0x3F);
+	*w++ = 0x80 | (u & 0x3F);
+    }
+    *len = w - w0;
+    return n;
+}
+
+/*! Decode one or two \uXXXX escapes matched by the generated scanner
+ * @param[in]  s     Escapes without the first backslash, eg "u00e5" or "ud83d\\ude00"
+ * @retval     str   Malloced UTF-8 string, free with free()
+ * @retval     NULL  Error
+ * @see clixon_json_parse.l
+ */
+char *
+json_unicode_strdup(const char *s)
+{
+    char *str;
+    int   n;
+    int   len;
+    int   i = 0;
+
+    if ((str = malloc(9)) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	return NULL;
+    }
+    while (*s == 'u'){
+	if ((n = json_unicode_utf8(s + 1, str + i, &len)) < 0){
+	    clicon_err(OE_XML, EINVAL, "json_parse: invalid unicode escape");
+	    free(str);
+	    return NULL;
+	}
+	i += len;
+	s += 1 + n;
+	if (*s == '\\')
+	    s++;
+    }
+    str[i] = '\0';
+    return str;
+}
+
+/*! Scan a quoted string and decode it in place
+ * @param[in]  js    JSON scanner state, current position at '"'
+ * @param[out] str   NUL-terminated decoded string in the input buffer
+ * @retval     0     OK, current position after closing '"'
+ * @retval    -1     Error
+ */
+static int
+json_scan_string(json_scan *js,
+		 char     **str)
+{
+    char *s;
+    char *p;
+    char *w;
+    int   n;
+    int   len;
+
+    s = p = ++js->js_p;
+    /* Fast path: no escapes */
+    p = (char*)clixon_memchr4(p, js->js_end - p, '"', '\\', '"', '\\');
+    w = p;
+    js->js_p = p;
+    while (*js->js_p != '"'){
+	switch (*js->js_p){
+	case '\0':
+	    return json_scan_err(js, "unterminated string");
+	case '\\':
+	    js->js_p++;
+	    switch (*js->js_p){
+	    case '\0':
+		return json_scan_err(js, "unterminated string");
+	    case 'b':
+		*w++ = '\b';
+		break;
+	    case 'f':
+		*w++ = '\f';
+		break;
+	    case 'n':
+		*w++ = '\n';
+		break;
+	    case 'r':
+		*w++ = '\r';
+		break;
+	    case 't':
+		*w++ = '\t';
+		break;
+	    case 'u': /* Output is shorter than the escape */
+		if ((n = json_unicode_utf8(js->js_p + 1, w, &len)) < 0)
+		    return json_scan_err(js, "invalid unicode escape");
+		w += len;
+		js->js_p += n; /* At last char of escape */
+		break;
+	    default: /* '"', '\\', '/' and others as the generated parser */
+		*w++ = *js->js_p;
+		break;
+	    }
+	    break;
+	default:
+	    *w++ = *js->js_p;
+	    break;
+	}
+	js->js_p++;
+    }
+    *w = '\0'; /* May overwrite closing '"' */
+    js->js_p++;
+    *str = s;
+    return 0;
+}
+
+/*! Add a body to an XML element
+ * @param[in]  x     XML element
+ * @param[in]  val   NUL-terminated value, or NULL for JSON null
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+json_scan_body(cxobj *x,
+	       char  *val)
+{
+    cxobj *xb;
+
+    if ((xb = xml_new("body", x, CX_BODY)) == NULL)
+	return -1;
+    if (val && xml_value_set(xb, val) < 0)
+	return -1;
+    return 0;
+}
+
+/*! Scan a number and add it as body, the number text is kept as is
+ * @param[in]  js    JSON scanner state
+ * @param[in]  x     XML element
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+json_scan_number(json_scan *js,
+		 cxobj     *x)
+{
+    char *p = js->js_p;
+    char *q;
+    int   digits = 0;
+    char  c;
+    int   retval;
+
+    if (*p == '-')
+	p++;
+    for (; *p >= '0' && *p <= '9'; p++)
+	digits++;
+    if (*p == '.')
+	for (p++; *p >= '0' && *p <= '9'; p++)
+	    digits++;
+    if (digits == 0)
+	return json_scan_err(js, "syntax error");
+    if (*p == 'e' || *p == 'E'){
+	q = p + 1;
+	if (*q == '+' || *q == '-')
+	    q++;
+	if (*q >= '0' && *q <= '9'){
+	    for (; *q >= '0' && *q <= '9'; q++);
+	    p = q;
+	}
+    }
+    /* Terminate in place, a number is always followed by a delimiter or end */
+    c = *p;
+    *p = '\0';
+    retval = json_scan_body(x, js->js_p);
+    *p = c;
+    js->js_p = p;
+    return retval;
+}
+
+/*! Find a bound node with same name to use as role model for yang binding
+ *
+ * The corresponding child of the parent's previous sibling, eg in the previous entry of
+ * a list, as in xml_bind_yang0_opt. Only if neither has a namespace attribute.
+ * @param[in]  xp  Parent, last child of its parent
+ * @param[in]  x   New XML element, unqualified
+ * @retval     xs  Role model
+ * @retval     NULL None found
+ */
+static cxobj *
+json_scan_sibling(cxobj *xp,
+		  cxobj *x)
+{
+    cxobj *xs;
+    cxobj *xpp;
+    cxobj *xps;
+    int    n;
+
+    if ((xpp = xml_parent(xp)) != NULL &&
+	(n = xml_child_nr(xpp)) > 1 &&
+	(xps = xml_child_i(xpp, n-2)) != NULL &&
+	xml_type(xps) == CX_ELMNT &&
+	xml_spec(xps) == xml_spec(xp) &&
+	(xs = xml_find_type(xps, NULL, xml_name(x), CX_ELMNT)) != NULL &&
+	xml_spec(xs) != NULL &&
+	xml_child_nr_type(xs, CX_ATTR) == 0)
+	return xs;
+    return NULL;
+}
+
+/*! Translate module name of a new XML element to namespace and bind it to yang
+ *
+ * The namespace translation follows json_xmlns_translate, and the binding follows
+ * xml_bind_yang0 etc, depending on the parent:
+ * - top-level: according to yb, as in _json_parse
+ * - config/data (YB_MODULE) or rpc (YB_RPC) on top-level: from modules and rpcs respectively
+ * - otherwise: from parent yang spec, if the parent is bound
+ * @param[in]  js       JSON scanner state
+ * @param[in]  xp       Parent
+ * @param[in]  x        New XML element
+ * @param[in]  xsibling Previous element of same array, or NULL
+ * @retval     0        OK, or tree invalid and js_failed set
+ * @retval    -1        Error
+ */
+static int
+json_scan_bind(json_scan *js,
+	       cxobj     *xp,
+	       cxobj     *x,
+	       cxobj     *xsibling)
+{
+    int        retval = -1;
+    char      *modname;
+    char      *name;
+    yang_stmt *ymod;
+    yang_bind  yb;
+    cbuf      *cberr = NULL;
+    int        ret;
+
+    name = xml_name(x);
+    modname = xml_prefix(x); /* prefix is here module name */
+    /* RFC 7951 Section 4: A namespace-qualified member name MUST be used for all 
+     * members of a top-level JSON object 
+     */
+    if (xp == js->js_xt && js->js_yspec && modname == NULL){
+	if ((cberr = cbuf_new()) == NULL){
+	    clicon_err(OE_UNIX, errno, "cbuf_new");
+	    goto done;
+	}
+	cprintf(cberr, "Top-level JSON object %s is not qualified with namespace which is a MUST according to RFC 7951", name);
+	if (js->js_xerr &&
+	    netconf_malformed_message_xml(js->js_xerr, cbuf_get(cberr)) < 0)
+	    goto done;
+	goto fail;
+    }
+    if (modname){
+	if ((ymod = yang_find_module_by_name(js->js_yspec, modname)) == NULL){
+	    if (js->js_xerr &&
+		netconf_unknown_namespace_xml(js->js_xerr, "application",
+					      modname,
+					      "No yang module found corresponding to prefix") < 0)
+		goto done;
+	    goto fail;
+	}
+	if (xml_namespace_change(x, yang_find_mynamespace(ymod), NULL) < 0)
+	    goto done;
+    }
+    if (js->js_yb == YB_NONE)
+	goto ok;
+    if (xp == js->js_xt){
+	switch (js->js_yb){
+	case YB_MODULE:
+#ifdef XMLDB_CONFIG_HACK
+	    if (strcmp(name, "config") == 0 || strcmp(name, "data") == 0)
+		goto ok; /* Children bound from modules */
+#endif
+	    yb = YB_MODULE;
+	    break;
+	case YB_RPC: /* see xml_bind_yang_rpc */
+	    if (strcmp(name, "rpc") == 0 ||
+		strcmp(name, "hello") == 0 ||
+		strcmp(name, "notification") == 0)
+		goto ok;
+	    if (js->js_xerr &&
+		netconf_unknown_element_xml(js->js_xerr, "protocol", name, "Unrecognized netconf operation") < 0)
+		goto done;
+	    goto fail;
+	default:
+	    yb = YB_PARENT;
+	    break;
+	}
+    }
+    else if (xml_spec(xp) != NULL){
+	yb = YB_PARENT;
+	if (xsibling == NULL && modname == NULL)
+	    xsibling = json_scan_sibling(xp, x);
+    }
+    else if (xml_parent(xp) != js->js_xt)
+	goto ok; /* Parent not bound */
+    else if (js->js_yb == YB_RPC && strcmp(xml_name(xp), "rpc") == 0)
+	yb = YB_RPC;
+#ifdef XMLDB_CONFIG_HACK
+    else if (js->js_yb == YB_MODULE &&
+	     (strcmp(xml_name(xp), "config") == 0 || strcmp(xml_name(xp), "data") == 0))
+	yb = YB_MODULE;
+#endif
+    else
+	goto ok; /* Parent not bound */
+    if ((ret = xml_bind_yang_node(x, yb, js->js_yspec, xsibling, js->js_xerr)) < 0)
+	goto done;
+    if (ret == 0)
+	goto fail;
+ ok:
+    retval = 0;
+ done:
+    if (cberr)
+	cbuf_free(cberr);
+    return retval;
+ fail:
+    js->js_failed++;
+    goto ok;
+}
+
+/*! Create a new XML element for a JSON member (or array element) and bind it
+ * @param[in]  js       JSON scanner state
+ * @param[in]  xp       Parent
+ * @param[in]  prefix   Module name, or NULL
+ * @param[in]  name     Name
+ * @param[in]  xsibling Previous element of same array, or NULL
+ * @retval     x        New XML element
+ * @retval     NULL     Error
+ */
+static cxobj *
+json_scan_elem(json_scan *js,
+	       cxobj     *xp,
+	       char      *prefix,
+	       char      *name,
+	       cxobj     *xsibling)
+{
+    cxobj *x;
+
+    if ((x = xml_new(name, xp, CX_ELMNT)) == NULL)
+	return NULL;
+    if (prefix && xml_prefix_set(x, prefix) < 0)
+	return NULL;
+    if (!js->js_failed && json_scan_bind(js, xp, x, xsibling) < 0)
+	return NULL;
+    return x;
+}
+
+/*! The value of an XML element is complete: complete yang binding, decode and sort
+ * @param[in]  js    JSON scanner state
+ * @param[in]  x     XML element
+ * @retval     0     OK, or tree invalid and js_failed set
+ * @retval    -1     Error
+ */
+static int
+json_scan_close(json_scan *js,
+		cxobj     *x)
+{
+    int ret;
+
+    if (js->js_yb == YB_NONE)
+	return 0;
+    if (xml_bind_yang_close(x) < 0)
+	return -1;
+    /* Translate prefix of identityref value to XML namespace prefix */
+    if (!js->js_failed && xml_spec(x) != NULL){
+	if ((ret = json2xml_decode_node(x, js->js_xerr)) < 0)
+	    return -1;
+	if (ret == 0)
+	    js->js_failed++;
+    }
+    if (xml_sort_node(x) < 0)
+	return -1;
+    return 0;
+}
+
+/*! Scan a JSON object, its members are added as children
+ * @param[in]  js    JSON scanner state, current position at '{'
+ * @param[in]  xp    XML element of object
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+json_scan_object(json_scan *js,
+		 cxobj     *xp)
+{
+    cxobj *x;
+    char  *name;
+    char  *id;
+
+    js->js_p++;
+    json_scan_ws(js);
+    if (*js->js_p == '}'){
+	js->js_p++;
+	return 0;
+    }
+    while (1){
+	json_scan_ws(js);
+	if (*js->js_p != '"')
+	    return json_scan_err(js, "syntax error");
+	if (json_scan_string(js, &name) < 0)
+	    return -1;
+	json_scan_ws(js);
+	if (*js->js_p != ':')
+	    return json_scan_err(js, "syntax error");
+	js->js_p++;
+	/* Split name into module:name (RFC7951) */
+	if ((id = strchr(name, ':')) != NULL)
+	    *id++ = '\0';
+	if ((x = json_scan_elem(js, xp, id?name:NULL, id?id:name, NULL)) == NULL)
+	    return -1;
+	if (json_scan_value(js, &x) < 0)
+	    return -1;
+	if (json_scan_close(js, x) < 0)
+	    return -1;
+	json_scan_ws(js);
+	if (*js->js_p == '}'){
+	    js->js_p++;
+	    break;
+	}
+	if (*js->js_p != ',')
+	    return json_scan_err(js, "syntax error");
+	js->js_p++;
+    }
+    return 0;
+}
+
+/*! Scan a JSON array, each value is a new XML element with the same name
+ * @param[in]     js    JSON scanner state, current position at '['
+ * @param[in,out] xp    XML element of first value, last element on return
+ * @retval        0     OK
+ * @retval       -1     Error
+ */
+static int
+json_scan_array(json_scan *js,
+		cxobj    **xp)
+{
+    cxobj *x = *xp;
+    cxobj *xprev;
+
+    js->js_p++;
+    json_scan_ws(js);
+    if (*js->js_p == ']'){
+	js->js_p++;
+	return 0;
+    }
+    while (1){
+	if (json_scan_value(js, &x) < 0)
+	    return -1;
+	json_scan_ws(js);
+	if (*js->js_p == ']'){
+	    js->js_p++;
+	    break;
+	}
+	if (*js->js_p != ',')
+	    return json_scan_err(js, "syntax error");
+	js->js_p++;
+	if (x != js->js_xt){ /* Values of top-level array are all bodies of top */
+	    xprev = x;
+	    if (json_scan_close(js, xprev) < 0)
+		return -1;
+	    if ((x = json_scan_elem(js, xml_parent(xprev), xml_prefix(xprev), xml_name(xprev),
+				    xml_spec(xprev)?xprev:NULL)) == NULL)
+		return -1;
+	}
+    }
+    *xp = x;
+    return 0;
+}
+
+/*! Scan a JSON value into an XML element
+ * @param[in]     js    JSON scanner state
+ * @param[in,out] xp    XML element, last element of array on return
+ * @retval        0     OK
+ * @retval       -1     Error
+ */
+static int
+json_scan_value(json_scan *js,
+		cxobj    **xp)
+{
+    int   retval = -1;
+    char *str;
+
+    json_scan_ws(js);
+    if (++js->js_depth > JSON_SCAN_MAXDEPTH){
+	json_scan_err(js, "memory exhausted");
+	goto done;
+    }
+    switch (*js->js_p){
+    case '{':
+	retval = json_scan_object(js, *xp);
+	break;
+    case '[':
+	retval = json_scan_array(js, xp);
+	break;
+    case '"':
+	if (json_scan_string(js, &str) < 0)
+	    goto done;
+	retval = json_scan_body(*xp, str);
+	break;
+    case 't':
+    case 'f':
+    case 'n':
+	if (strncmp(js->js_p, "true", 4) == 0){
+	    js->js_p += 4;
+	    retval = json_scan_body(*xp, "true");
+	}
+	else if (strncmp(js->js_p, "false", 5) == 0){
+	    js->js_p += 5;
+	    retval = json_scan_body(*xp, "false");
+	}
+	else if (strncmp(js->js_p, "null", 4) == 0){
+	    js->js_p += 4;
+	    retval = json_scan_body(*xp, NULL);
+	}
+	else
+	    json_scan_err(js, "syntax error");
+	break;
+    default:
+	retval = json_scan_number(js, *xp);
+	break;
+    }
+ done:
+    js->js_depth--;
+    return retval;
+}
+
+/*! Scan JSON string into an XML tree, translate namespaces and bind yang
+ *
+ * @param[in]  str   NUL-terminated JSON string. Modified during scanning.
+ * @param[in]  yb    How to bind yang to XML top-level when parsing
+ * @param[in]  yspec Yang specification, mandatory to make module->xmlns translation
+ * @param[in]  xt    Top of XML parse tree, new top-level elements are added as children
+ * @param[out] xerr  Reason for invalid tree returned as netconf err msg 
+ * @retval     1     OK and valid
+ * @retval     0     Invalid wrt namespace or yang, xerr set
+ * @retval    -1     Error with clicon_err called, eg parse error
+ * @note The tree created is the same as the flex/bison parser followed by namespace
+ *       translation, yang binding, identityref decoding and sorting in _json_parse, 
+ *       including escapes and array elements, see file header.
+ * @see clixon_json_parseparse
+ */
+int
+clixon_json_scan(char       *str,
+		 yang_bind   yb,
+		 yang_stmt  *yspec,
+		 cxobj      *xt,
+		 cxobj     **xerr)
+{
+    json_scan js = {0,};
+    cxobj    *x = xt;
+
+    js.js_buf = str;
+    js.js_p = str;
+    js.js_end = str + strlen(str);
+    js.js_xt = xt;
+    js.js_yb = yb;
+    js.js_yspec = yspec;
+    js.js_xerr = xerr;
+    if (json_scan_value(&js, &x) < 0)
+	return -1;
+    json_scan_ws(&js);
+    if (*js.js_p != '\0')
+	return json_scan_err(&js, "syntax error");
+    if (yb != YB_NONE && xml_sort_node(xt) < 0)
+	return -1;
+    return js.js_failed ? 0 : 1;
+}
@@ -315,9 +315,20 @@ struct prepvec{
     qelem_t       pv_q;
     cxobj        *pv_xrule;
     clixon_xvec  *pv_xpathvec;
+    clixon_xvec  *pv_parentvec; /* Parents of leaf of path, for default values not in tree */
+    yang_stmt    *pv_yleaf;     /* Yang of leaf of path, if pv_parentvec */
 };
 typedef struct prepvec prepvec;
 
+/* NACM read access of default values that are not in the XML tree
+ * @see nacm_datanode_read0
+ */
+struct nacm_read_ctx{
+    prepvec      *nr_pv_list;   /* Rules of the user's groups */
+    int           nr_permit;    /* read-default is permit */
+    int           nr_denyall;   /* No user: no read access at all */
+};
+
 /*! Delete all Upgrade callbacks
  */
 int
@@ -329,6 +340,8 @@ prepvec_free(prepvec *pv_list)
 	DELQ(pv, pv_list, prepvec *);
 	if (pv->pv_xpathvec)
 	    clixon_xvec_free(pv->pv_xpathvec);
+	if (pv->pv_parentvec)
+	    clixon_xvec_free(pv->pv_parentvec);
 	free(pv);
     }
     return 0;
@@ -352,12 +365,77 @@ prepvec_add(prepvec  **pv_listp,
     return pv;
 }
 
+/*! Find the parents of the leaf that a rule path refers to
+ *
+ * A leaf with a default value that is not in the XML tree is not found by the path of
+ * a rule, but its parent is. Save the parent instances and the yang of the leaf, so that
+ * NACM read access of the default value can be checked without adding it to the tree.
+ * @param[in]  xt     XML root tree
+ * @param[in]  yspec  Yang spec
+ * @param[in]  path   Canonical path of the rule
+ * @param[in]  pv     Prepared rule
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see nacm_datanode_read_default
+ */
+static int
+nacm_datanode_prepare_leaf(cxobj     *xt,
+			   yang_stmt *yspec,
+			   char      *path,
+			   prepvec   *pv)
+{
+    int        retval = -1;
+    char      *p;
+    char      *name;
+    cxobj    **xvec = NULL;
+    int        xlen = 0;
+    int        i;
+    yang_stmt *y;
+    int        ret;
+
+    /* The last step of the path is a leaf name, without predicates */
+    if (strlen(path) == 0 || path[strlen(path)-1] == ']' ||
+	(p = strrchr(path, '/')) == NULL || p == path)
+	goto ok;
+    if ((name = strchr(p+1, ':')) != NULL)
+	name++;
+    else
+	name = p+1;
+    *p = '\0';
+    ret = clixon_xml_find_instance_id(xt, yspec, &xvec, &xlen, "%s", path);
+    *p = '/';
+    if (ret < 0)
+	goto done;
+    if (ret == 0)
+	goto ok;
+    for (i=0; i<xlen; i++){
+	if ((y = xml_spec(xvec[i])) == NULL ||
+	    (y = yang_find_datanode(y, name)) == NULL ||
+	    yang_keyword_get(y) != Y_LEAF)
+	    continue;
+	if (pv->pv_parentvec == NULL &&
+	    (pv->pv_parentvec = clixon_xvec_new()) == NULL)
+	    goto done;
+	if (clixon_xvec_append(pv->pv_parentvec, xvec[i]) < 0)
+	    goto done;
+	pv->pv_yleaf = y;
+    }
+ ok:
+    retval = 0;
+ done:
+    if (xvec)
+	free(xvec);
+    return retval;
+}
+
 /*! Prepare datastructures before running through XML tree
  * Save rules in a "cache"
  * These rules match:
  *  - user/group
  *  - have read access-op, etc
  * Also make instance-id lookups on top object for each rule. Assume at most one result
+ * If leaf is set, also save the parents of a leaf that a path refers to, 
+ * see nacm_datanode_prepare_leaf
  */
 static int
 nacm_datanode_prepare(clicon_handle     h,
@@ -368,6 +446,7 @@ nacm_datanode_prepare(clicon_handle     h,
 		      cxobj           **rlistvec,
 		      size_t            rlistlen,
 		      cvec             *nsc,
+		      int               leaf,
 		      prepvec         **pv_listp)
 {
     int        retval = -1;
@@ -471,6 +550,9 @@ nacm_datanode_prepare(clicon_handle     h,
 		    if (clixon_xvec_append(pv->pv_xpathvec, xvec[k]) < 0)
 			goto done;
 		}
+		if (leaf &&
+		    nacm_datanode_prepare_leaf(xt, yspec, path, pv) < 0)
+		    goto done;
 		if (xvec){
 		    free(xvec);
 		    xvec = NULL;
@@ -713,7 +795,7 @@ nacm_datanode_write(clicon_handle    h,
 	goto done;
     /* First run through rules and cache rules as well as lookup objects in xt. 
      */
-    if (nacm_datanode_prepare(h, xt, access, gvec, glen, rlistvec, rlistlen, nsc, &pv_list) < 0)
+    if (nacm_datanode_prepare(h, xt, access, gvec, glen, rlistvec, rlistlen, nsc, 0, &pv_list) < 0)
 	goto done;
     /* Then recursivelyy traverse all requested nodes */
     if ((ret = nacm_datanode_write_recurse(h, xreq, pv_list,
@@ -966,6 +1048,7 @@ nacm_datanode_read_recurse(clicon_handle h,
  * @see RFC8341 3.4.5.  Data Node Access Validation
  * @see nacm_datanode_write
  * @see nacm_rpc
+ * @see nacm_datanode_read0  which also checks default values not in the tree
  */
 int
 nacm_datanode_read(clicon_handle h,
@@ -974,6 +1057,41 @@ nacm_datanode_read(clicon_handle h,
 		   size_t        xrlen,    
 		   char         *username,
 		   cxobj        *xnacm)
+{
+    return nacm_datanode_read0(h, xt, xrvec, xrlen, username, xnacm, NULL);
+}
+
+/*! Make nacm datanode read access validation, and keep rules for default values
+ *
+ * As nacm_datanode_read, but if nrp is given, return the prepared rules, so that read 
+ * access of default values that are not in the tree can be checked when they are 
+ * printed, see nacm_datanode_read_default. 
+ * @param[in]  h        Clicon handle
+ * @param[in]  xt       XML root tree with "config" label 
+ * @param[in]  xrvec    Vector of requested nodes (sub-part of xt)
+ * @param[in]  xrlen    Length of requsted node vector
+ * @param[in]  username 
+ * @param[in]  xnacm    NACM xml tree
+ * @param[out] nrp      Read access context of default values, or NULL. Free with nacm_read_ctx_free
+ * @retval -1  Error
+ * @retval  0  OK
+ * @code
+ *   if (nacm_datanode_read0(h, xt, xvec, xlen, username, xnacm, &nr) < 0)
+ *      err;
+ *   clicon_xml2cbuf_wdef(cb, xt, 0, 0, -1, WITHDEFAULTS_REPORT_ALL, NULL, NULL,
+ *                        nacm_datanode_read_default, nr);
+ *   nacm_read_ctx_free(nr);
+ * @endcode
+ * @note The context refers to nodes in xt, do not modify xt until it is freed
+ */
+int
+nacm_datanode_read0(clicon_handle   h,
+		    cxobj          *xt,
+		    cxobj         **xrvec,
+		    size_t          xrlen,    
+		    char           *username,
+		    cxobj          *xnacm,
+		    nacm_read_ctx **nrp)
 {
     int             retval = -1;
     cxobj         **gvec = NULL; /* groups */
@@ -984,7 +1102,15 @@ nacm_datanode_read(clicon_handle h,
     char           *read_default = NULL;
     cvec           *nsc = NULL;
     prepvec        *pv_list = NULL;
+    nacm_read_ctx  *nr = NULL;
     
+    if (nrp){
+	if ((nr = malloc(sizeof(*nr))) == NULL){
+	    clicon_err(OE_UNIX, errno, "malloc");
+	    goto done;
+	}
+	memset(nr, 0, sizeof(*nr));
+    }
     /* Create namespace context for with nacm namespace as default */
     if ((nsc = xml_nsctx_init(NULL, NACM_NS)) == NULL)
 	goto done;
@@ -1014,7 +1140,8 @@ nacm_datanode_read(clicon_handle h,
     /* First run through rules and cache rules as well as lookup objects in xt. 
      * DANGER: objects could be stale if they are removed?
      */
-    if (nacm_datanode_prepare(h, xt, NACM_READ, gvec, glen, rlistvec, rlistlen, nsc, &pv_list) < 0)
+    if (nacm_datanode_prepare(h, xt, NACM_READ, gvec, glen, rlistvec, rlistlen, nsc,
+			      nr != NULL, &pv_list) < 0)
 	goto done;
     /* Then recursivelyy traverse all nodes */
     if (nacm_datanode_read_recurse(h, xt, pv_list, clicon_dbspec_yang(h)) < 0)
@@ -1028,9 +1155,13 @@ nacm_datanode_read(clicon_handle h,
 	    goto done;
 #endif
     /* reset flag */
-    if (xml_apply(xt, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset, (void*)XML_FLAG_MARK) < 0)
+    if (xml_flag_epoch_next() < 0)
 	goto done;
-
+    if (nr){
+	nr->nr_permit = strcmp(read_default, "permit") == 0;
+	nr->nr_pv_list = pv_list;
+	pv_list = NULL;
+    }
     goto ok;
     /* 8.   At this point, no matching rule was found in any rule-list
        entry. */
@@ -1044,10 +1175,18 @@ nacm_datanode_read(clicon_handle h,
     for (i=0; i<xrlen; i++)     /* Loop through requested nodes, safe since vector not children */
 	if (xml_purge(xrvec[i]) < 0)
 	    goto done;
+    if (nr)
+	nr->nr_denyall = 1;
  ok:
+    if (nrp){
+	*nrp = nr;
+	nr = NULL;
+    }
     retval = 0;
  done:
     clicon_debug(1, "%s retval:%d", __FUNCTION__, retval);
+    if (nr)
+	nacm_read_ctx_free(nr);
     if (pv_list)
 	prepvec_free(pv_list);
     if (nsc)
@@ -1060,6 +1199,90 @@ nacm_datanode_read(clicon_handle h,
 }
 
 
+/*! Check NACM read access of a default value that is not in the XML tree
+ *
+ * A virtual default leaf is matched by the rules as if it was in the tree: by the module
+ * of the leaf, by a path that refers to its parent or an ancestor, or by a path that refers
+ * to the leaf itself, see nacm_datanode_prepare_leaf. The first matching rule applies,
+ * otherwise read-default.
+ * This is a filter function for clicon_xml2cbuf_wdef.
+ * @param[in]  x    XML parent of the default leaf, after nacm_datanode_read0
+ * @param[in]  y    Yang leaf with default value
+ * @param[in]  arg  Read access context, nacm_read_ctx from nacm_datanode_read0
+ * @retval     1    Read access, the default value may be reported
+ * @retval     0    No read access
+ * @retval    -1    Error
+ * @see nacm_data_read_xrule_xml  for the corresponding check of XML nodes
+ */
+int
+nacm_datanode_read_default(cxobj     *x,
+			   yang_stmt *y,
+			   void      *arg)
+{
+    nacm_read_ctx *nr = (nacm_read_ctx *)arg;
+    prepvec       *pv;
+    yang_stmt     *ymod;
+    char          *module_pattern;
+    char          *ns;
+    char          *action;
+    cxobj         *xp;
+    int            match;
+    int            i;
+
+    if (nr->nr_denyall)
+	return 0;
+    if ((pv = nr->nr_pv_list) != NULL){
+	do {
+	    match = 0;
+	    if ((module_pattern = xml_find_body(pv->pv_xrule, "module-name")) == NULL)
+		goto next;
+	    /* 6a) The rule's "module-name" leaf is "*" or equals the name of the module */
+	    if (strcmp(module_pattern, "*") != 0){
+		if ((ns = yang_find_mynamespace(y)) == NULL ||
+		    (ymod = yang_find_module_by_namespace(ys_spec(y), ns)) == NULL ||
+		    strcmp(yang_argument_get(ymod), module_pattern) != 0)
+		    goto next;
+	    }
+	    /* 6b) No path, or the path matches the leaf or an ancestor */
+	    if (xml_find_type(pv->pv_xrule, NULL, "path", CX_ELMNT) == NULL)
+		match++;
+	    for (i=0; !match && i<clixon_xvec_len(pv->pv_xpathvec); i++){
+		xp = clixon_xvec_i(pv->pv_xpathvec, i);
+		if (x == xp || xml_isancestor(x, xp))
+		    match++;
+	    }
+	    if (pv->pv_yleaf == y)
+		for (i=0; !match && i<clixon_xvec_len(pv->pv_parentvec); i++)
+		    if (x == clixon_xvec_i(pv->pv_parentvec, i))
+			match++;
+	    if (match){ /* First match applies, see nacm_data_read_action */
+		if ((action = xml_find_body(pv->pv_xrule, "action")) != NULL){
+		    if (strcmp(action, "deny") == 0)
+			return 0;
+		    if (strcmp(action, "permit") == 0)
+			return 1;
+		}
+		break;
+	    }
+	next:
+	    pv = NEXTQ(prepvec *, pv);
+	} while (pv && pv != nr->nr_pv_list);
+    }
+    return nr->nr_permit;
+}
+
+/*! Free read access context of default values
+ * @param[in]  nr   Context from nacm_datanode_read0
+ */
+int
+nacm_read_ctx_free(nacm_read_ctx *nr)
+{
+    if (nr->nr_pv_list)
+	prepvec_free(nr->nr_pv_list);
+    free(nr);
+    return 0;
+}
+
 /*---------------------------------------------------------------
  * NACM pre-procesing
  */
@@ -1166,7 +1389,7 @@ nacm_access_pre(clicon_handle  h,
 		goto done;
     }
     else if (strcmp(mode, "internal")==0){
-	if (xmldb_get0(h, "running", nsc, "nacm", 1, &xnacm0, NULL) < 0)
+	if (xmldb_get0(h, "running", nsc, "nacm", 1, 1, &xnacm0, NULL) < 0)
 	    goto done;
     }
     else{
@@ -1305,6 +1305,9 @@ netconf_module_load(clicon_handle h)
     /* Load yang spec */
     if (yang_spec_parse_module(h, "ietf-netconf", NULL, yspec)< 0)
 	goto done;
+    /* RFC 6243 with-defaults parameter of get and get-config */
+    if (yang_spec_parse_module(h, "ietf-netconf-with-defaults", NULL, yspec)< 0)
+	goto done;
     if (clicon_option_bool(h, "CLICON_STREAM_DISCOVERY_RFC5277"))
 	if (yang_spec_parse_module(h, "clixon-rfc5277", NULL, yspec)< 0)
 	    goto done;
@@ -1405,6 +1408,33 @@ netconf_content_int2str(netconf_content nr)
     return clicon_int2str(netconf_content_map, nr);
 }
 
+/* See RFC 6243 Sec 3
+ * @see withdefaults_str2int
+ */
+static const map_str2int withdefaults_map[] = {
+    {"report-all",     WITHDEFAULTS_REPORT_ALL},
+    {"trim",           WITHDEFAULTS_TRIM},
+    {"explicit",       WITHDEFAULTS_EXPLICIT},
+    {NULL,             -1}
+};
+
+/*! Translate with-defaults parameter string to mode
+ * @param[in]  str   With-defaults string, eg "trim"
+ * @retval     mode  With-defaults mode
+ * @retval     -1    Not supported, eg "report-all-tagged"
+ */
+const int
+withdefaults_str2int(char *str)
+{
+    return clicon_str2int(withdefaults_map, str);
+}
+
+const char *
+withdefaults_int2str(withdefaults_type nr)
+{
+    return clicon_int2str(withdefaults_map, nr);
+}
+
 /*! Create Netconf server hello. Single cap and defer individual to querying modules
 
  * @param[in]  h           Clicon handle
@@ -1441,6 +1471,7 @@ netconf_content_int2str(netconf_content nr)
  *   urn:ietf:params:netconf:capability:startup:1.0 (8.7)
  *   urn:ietf:params:netconf:capability:xpath:1.0 (8.9)
  *   urn:ietf:params:netconf:capability:notification:1.0 (RFC5277)
+ *   urn:ietf:params:netconf:capability:with-defaults:1.0 (RFC6243)
  *
  * @note the hello message is created bythe netconf application, not the 
  *  backend, and backend may implement more modules - please consider if using
@@ -1476,6 +1507,7 @@ netconf_hello_server(clicon_handle h,
     cprintf(cb, "<capability>urn:ietf:params:netconf:capability:startup:1.0</capability>");
     cprintf(cb, "<capability>urn:ietf:params:netconf:capability:xpath:1.0</capability>");
     cprintf(cb, "<capability>urn:ietf:params:netconf:capability:notification:1.0</capability>");
+    cprintf(cb, "<capability>urn:ietf:params:netconf:capability:with-defaults:1.0?basic-mode=report-all&amp;also-supported=trim,explicit</capability>");
     cprintf(cb, "</capabilities>");
     if (session_id) 
 	cprintf(cb, "<session-id>%lu</session-id>", (long unsigned int)session_id);
@@ -76,6 +76,7 @@
 #include "clixon_netconf_lib.h"
 #include "clixon_xml_nsctx.h"
 #include "clixon_xml_io.h"
+#include "clixon_json.h"
 #include "clixon_validate.h"
 #include "clixon_xml_map.h"
 
@@ -433,7 +434,9 @@ clicon_options_main(clicon_handle h)
     /* Set clixon_conf pointer to handle */
     if (clicon_conf_xml_set(h, xconfig) < 0)
 	goto done;
-
+    /* XML parse functions have no handle */
+    clixon_xml_parse_fast_set(clicon_option_bool(h, "CLICON_XML_PARSE_FAST"));
+    clixon_json_parse_fast_set(clicon_option_bool(h, "CLICON_JSON_PARSE_FAST"));
     retval = 0;
  done:
     return retval;
@@ -139,15 +139,25 @@ clicon_msg_encode(uint32_t      id,
 		  const char   *format, ...)
 {
     va_list            args;
+    int                ret;
     uint32_t           xmllen;
     uint32_t           len;
     struct clicon_msg *msg = NULL;
     int                hdrlen = sizeof(*msg);
 
     va_start(args, format);
-    xmllen = vsnprintf(NULL, 0, format, args) + 1;
+    ret = vsnprintf(NULL, 0, format, args);
     va_end(args);
-
+    if (ret < 0){
+	clicon_err(OE_PROTO, errno, "vsnprintf");
+	return NULL;
+    }
+    xmllen = ret + 1;
+    if (xmllen > CLICON_MSG_LEN_MAX - hdrlen){
+	clicon_err(OE_PROTO, EMSGSIZE, "Message length %u exceeds maximum %u",
+		   xmllen, CLICON_MSG_LEN_MAX - hdrlen);
+	return NULL;
+    }
     len = hdrlen + xmllen;
     if ((msg = (struct clicon_msg *)malloc(len)) == NULL){
 	clicon_err(OE_PROTO, errno, "malloc");
@@ -298,7 +308,7 @@ msg_dump(struct clicon_msg *msg)
     
     memset(buf2, 0, sizeof(buf2));
     snprintf(buf2, sizeof(buf2), "%s:", __FUNCTION__);
-    for (i=0; i<ntohl(msg->op_len); i++){
+    for (i=0; i<(ntohl(msg->op_len)&~CLICON_MSG_CHUNK); i++){
 	snprintf(buf, sizeof(buf), "%s%02x", buf2, ((char*)msg)[i]&0xff);
 	if ((i+1)%32==0){
 	    clicon_debug(2, "%s", buf);
@@ -322,17 +332,20 @@ int
 clicon_msg_send(int                s, 
 		struct clicon_msg *msg)
 { 
-    int retval = -1;
+    int      retval = -1;
+
+    uint32_t len;
 
+    len = ntohl(msg->op_len) & ~CLICON_MSG_CHUNK;
     clicon_debug(2, "%s: send msg len=%d", 
-		 __FUNCTION__, ntohl(msg->op_len));
+		 __FUNCTION__, len);
     if (clicon_debug_get() > 2)
 	msg_dump(msg);
     if (atomicio((ssize_t (*)(int, void *, size_t))write, 
-		 s, msg, ntohl(msg->op_len)) < 0){
+		 s, msg, len) < 0){
 	clicon_err(OE_CFG, errno, "atomicio");
 	clicon_log(LOG_WARNING, "%s: write: %s len:%u msg:%s", __FUNCTION__,
-		   strerror(errno), ntohs(msg->op_len), msg->op_body);
+		   strerror(errno), len, msg->op_body);
 	goto done;
     }
     retval = 0;
@@ -340,38 +353,25 @@ clicon_msg_send(int                s,
     return retval;
 }
 
-/*! Receive a CLICON message
- *
- * XXX: timeout? and signals?
- * There is rudimentary code for turning on signals and handling them 
- * so that they can be interrupted by ^C. But the problem is that this
- * is a library routine and such things should be set up in the cli 
- * application for example: a daemon calling this function will want another 
- * behaviour.
- * Now, ^C will interrupt the whole process, and this may not be what you want.
- *
+/*! Read a message header from socket
  * @param[in]   s      socket (unix or inet) to communicate with backend
- * @param[out]  msg    CLICON msg data reply structure. Free with free()
+ * @param[out]  hdr    Message header
+ * @param[out]  mlen   Message length including header, chunk bit cleared
+ * @param[out]  chunk  Set if message is a chunk and more chunks follow
  * @param[out]  eof    Set if eof encountered
- * Note: caller must ensure that s is closed if eof is set after call.
+ * @see clicon_msg_rcv
  */
-int
-clicon_msg_rcv(int                s,
-	       struct clicon_msg **msg,
-	       int                *eof)
+static int
+clicon_msg_hdr_rcv(int                s,
+		   struct clicon_msg *hdr,
+		   uint32_t          *mlen,
+		   int               *chunk,
+		   int               *eof)
 { 
     int       retval = -1;
-    struct clicon_msg hdr;
     int       hlen;
-    uint32_t  len2;
-    sigfn_t   oldhandler;
-    uint32_t  mlen;
 
-    *eof = 0;
-    if (0)
-	set_signal(SIGINT, atomicio_sig_handler, &oldhandler);
-
-    if ((hlen = atomicio(read, s, &hdr, sizeof(hdr))) < 0){ 
+    if ((hlen = atomicio(read, s, hdr, sizeof(*hdr))) < 0){ 
 	clicon_err(OE_CFG, errno, "atomicio");
 	goto done;
     }
@@ -380,32 +380,147 @@ clicon_msg_rcv(int                s,
 	*eof = 1;
 	goto done;
     }
-    if (hlen != sizeof(hdr)){
+    if (hlen != sizeof(*hdr)){
 	clicon_err(OE_CFG, errno, "header too short (%d)", hlen);
 	goto done;
     }
-    mlen = ntohl(hdr.op_len);
-    clicon_debug(2, "%s: rcv msg len=%d",  
-		 __FUNCTION__, mlen);
-    if ((*msg = (struct clicon_msg *)malloc(mlen)) == NULL){
-	clicon_err(OE_CFG, errno, "malloc");
+    *mlen = ntohl(hdr->op_len);
+    *chunk = (*mlen & CLICON_MSG_CHUNK) != 0;
+    *mlen &= ~CLICON_MSG_CHUNK;
+    clicon_debug(2, "%s: rcv msg len=%d%s",  
+		 __FUNCTION__, *mlen, *chunk?" chunk":"");
+    if (*mlen < sizeof(*hdr)){
+	clicon_err(OE_CFG, EINVAL, "message too short (%u)", *mlen);
 	goto done;
     }
-    memcpy(*msg, &hdr, hlen);
-    if ((len2 = atomicio(read, s, (*msg)->op_body, mlen - sizeof(hdr))) == 0){ 
- 	clicon_err(OE_CFG, errno, "read");
+    retval = 0;
+  done:
+    return retval;
+}
+
+/*! Read a message body from socket
+ * @param[in]   s      socket (unix or inet) to communicate with backend
+ * @param[out]  buf    Buffer of at least len bytes
+ * @param[in]   len    Body length
+ */
+static int
+clicon_msg_body_rcv(int      s,
+		    char    *buf,
+		    uint32_t len)
+{ 
+    int       retval = -1;
+    uint32_t  len2;
+
+    if (len == 0)
+	goto ok;
+    if ((len2 = atomicio(read, s, buf, len)) == 0){ 
+	clicon_err(OE_CFG, errno, "read");
 	goto done;
     }
-    if (len2 != mlen - sizeof(hdr)){
+    if (len2 != len){
 	clicon_err(OE_CFG, errno, "body too short");
 	goto done;
     }
+ ok:
+    retval = 0;
+  done:
+    return retval;
+}
+
+/*! Receive a CLICON message
+ *
+ * XXX: timeout? and signals?
+ * There is rudimentary code for turning on signals and handling them 
+ * so that they can be interrupted by ^C. But the problem is that this
+ * is a library routine and such things should be set up in the cli 
+ * application for example: a daemon calling this function will want another 
+ * behaviour.
+ * Now, ^C will interrupt the whole process, and this may not be what you want.
+ *
+ * A reply streamed in chunks by the backend is assembled into a single message. The
+ * chunk bodies are read directly into the message buffer, which grows geometrically,
+ * so the reply is held only once in memory.
+ * The assembled reply is limited to CLICON_MSG_LEN_MAX bytes. If it is longer, an error is
+ * returned without reading the rest of the reply, and the socket should be closed.
+ * @param[in]   s      socket (unix or inet) to communicate with backend
+ * @param[out]  msg    CLICON msg data reply structure. Free with free()
+ * @param[out]  eof    Set if eof encountered
+ * Note: caller must ensure that s is closed if eof is set after call.
+ * @see send_msg_reply_chunk
+ */
+int
+clicon_msg_rcv(int                s,
+	       struct clicon_msg **msg,
+	       int                *eof)
+{ 
+    int                retval = -1;
+    sigfn_t            oldhandler;
+    struct clicon_msg  hdr;
+    struct clicon_msg *m = NULL;
+    struct clicon_msg *m1;
+    int                chunk = 0;
+    uint32_t           mlen;    /* Length of current message/chunk incl header */
+    size_t             len = 0; /* Length of assembled message incl header */
+    size_t             sz = 0;  /* Allocated size of assembled message */
+
+    *eof = 0;
+    if (0)
+	set_signal(SIGINT, atomicio_sig_handler, &oldhandler);
+    do {
+	if (clicon_msg_hdr_rcv(s, &hdr, &mlen, &chunk, eof) < 0)
+	    goto done;
+	if (*eof){
+	    if (m != NULL){
+		clicon_err(OE_PROTO, ESHUTDOWN, "Unexpected close in chunked reply");
+		goto done;
+	    }
+	    goto ok;
+	}
+	/* The assembled message must fit in op_len */
+	if (len + mlen - sizeof(hdr) > CLICON_MSG_LEN_MAX){
+	    clicon_err(OE_PROTO, EMSGSIZE, "Reply exceeds maximum message length %u",
+		       CLICON_MSG_LEN_MAX);
+	    goto done;
+	}
+	if (m == NULL){ /* First message or chunk, keep its header */
+	    sz = mlen;
+	    if (chunk && sz < CLIXON_REPLY_CHUNK_SIZE)
+		sz = CLIXON_REPLY_CHUNK_SIZE;
+	    if ((m = (struct clicon_msg *)malloc(sz)) == NULL){
+		clicon_err(OE_CFG, errno, "malloc");
+		goto done;
+	    }
+	    memcpy(m, &hdr, sizeof(hdr));
+	    len = sizeof(hdr);
+	}
+	else if (len + mlen - sizeof(hdr) > sz){
+	    while (len + mlen - sizeof(hdr) > sz)
+		sz *= 2;
+	    if (sz > CLICON_MSG_LEN_MAX)
+		sz = CLICON_MSG_LEN_MAX;
+	    if ((m1 = (struct clicon_msg *)realloc(m, sz)) == NULL){
+		clicon_err(OE_CFG, errno, "realloc");
+		goto done;
+	    }
+	    m = m1;
+	}
+	if (clicon_msg_body_rcv(s, (char*)m + len, mlen - sizeof(hdr)) < 0)
+	    goto done;
+	len += mlen - sizeof(hdr);
+    } while (chunk);
+    /* Last chunk is a regular (null-terminated) message */
+    m->op_len = htonl(len);
     if (clicon_debug_get() > 1)
-	msg_dump(*msg);
+	msg_dump(m);
+    *msg = m;
+    m = NULL;
+ ok:
     retval = 0;
   done:
     if (0)
 	set_signal(SIGINT, oldhandler, NULL);
+    if (m)
+	free(m);
     return retval;
 }
 
@@ -573,6 +688,11 @@ send_msg_reply(int      s,
     struct clicon_msg *reply = NULL;
     uint32_t           len;
 
+    if (datalen > CLICON_MSG_LEN_MAX - sizeof(*reply)){
+	clicon_err(OE_PROTO, EMSGSIZE, "Reply length %u exceeds maximum %u",
+		   datalen, (uint32_t)(CLICON_MSG_LEN_MAX - sizeof(*reply)));
+	goto done;
+    }
     len = sizeof(*reply) + datalen;
     if ((reply = (struct clicon_msg *)malloc(len)) == NULL)
 	goto done;
@@ -589,6 +709,46 @@ send_msg_reply(int      s,
     return retval;
 }
 
+/*! Send a chunk of a clicon_msg reply to a clicon rpc request, more chunks follow
+ *
+ * A large reply can be sent as a sequence of chunks, which ends with a regular reply
+ * sent with send_msg_reply. The client assembles the reply in clicon_msg_rcv.
+ * @param[in]  s       Socket to communicate with client
+ * @param[in]  data    Part of reply data, not null-terminated
+ * @param[in]  datalen Length of data
+ * @retval     0       OK
+ * @retval     -1      Error
+ * @see send_msg_reply  to send last chunk
+ */
+int 
+send_msg_reply_chunk(int      s, 
+		     char    *data, 
+		     uint32_t datalen)
+{
+    int               retval = -1;
+    struct clicon_msg hdr = {0,};
+    uint32_t          len;
+
+    if (datalen > CLICON_MSG_LEN_MAX - sizeof(hdr)){
+	clicon_err(OE_PROTO, EMSGSIZE, "Reply chunk length %u exceeds maximum %u",
+		   datalen, (uint32_t)(CLICON_MSG_LEN_MAX - sizeof(hdr)));
+	goto done;
+    }
+    len = sizeof(hdr) + datalen;
+    hdr.op_len = htonl(len | CLICON_MSG_CHUNK);
+    clicon_debug(2, "%s: send chunk len=%d", __FUNCTION__, len);
+    if (atomicio((ssize_t (*)(int, void *, size_t))write, 
+		 s, &hdr, sizeof(hdr)) < 0 ||
+	atomicio((ssize_t (*)(int, void *, size_t))write, 
+		 s, data, datalen) < 0){
+	clicon_err(OE_CFG, errno, "atomicio");
+	goto done;
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*! Send a clicon_msg NOTIFY message asynchronously to client
  *
  * @param[in]  s       Socket to communicate with client
@@ -44,6 +44,11 @@
 #include <stdlib.h>
 #include <errno.h>
 #include <ctype.h>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 #include <cligen/cligen.h>
 
@@ -344,6 +349,72 @@ uri_percent_decode(char  *enc,
     return retval;
 }
 
+/*! Find first occurrence of any of four characters in a buffer
+ *
+ * Used to find the next character that needs encoding (or decoding) so that runs of
+ * characters that need not can be copied in bulk. Scans 32 bytes at a time with AVX2, or
+ * 16 bytes with SSE2, if compiled for it, with a bytewise scan of the remainder.
+ * To search for fewer characters, repeat one of them.
+ * @param[in]  s    Buffer, need not be NUL-terminated
+ * @param[in]  len  Length of buffer
+ * @param[in]  c1   Character to search for
+ * @param[in]  c2   Character to search for
+ * @param[in]  c3   Character to search for
+ * @param[in]  c4   Character to search for
+ * @retval     p    Pointer to first occurrence, or s+len if none
+ * @see xml_chardata_cbuf_append
+ */
+const char *
+clixon_memchr4(const char *s,
+	       size_t      len,
+	       char        c1,
+	       char        c2,
+	       char        c3,
+	       char        c4)
+{
+    const char *end = s + len;
+#if defined(__AVX2__)
+    const __m256i v1 = _mm256_set1_epi8(c1);
+    const __m256i v2 = _mm256_set1_epi8(c2);
+    const __m256i v3 = _mm256_set1_epi8(c3);
+    const __m256i v4 = _mm256_set1_epi8(c4);
+    __m256i       v;
+    unsigned int  m;
+
+    while (end - s >= 32){
+	v = _mm256_loadu_si256((const __m256i *)s);
+	m = _mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, v1),
+								 _mm256_cmpeq_epi8(v, v2)),
+						 _mm256_or_si256(_mm256_cmpeq_epi8(v, v3),
+								 _mm256_cmpeq_epi8(v, v4))));
+	if (m)
+	    return s + __builtin_ctz(m);
+	s += 32;
+    }
+#elif defined(__SSE2__)
+    const __m128i v1 = _mm_set1_epi8(c1);
+    const __m128i v2 = _mm_set1_epi8(c2);
+    const __m128i v3 = _mm_set1_epi8(c3);
+    const __m128i v4 = _mm_set1_epi8(c4);
+    __m128i       v;
+    unsigned int  m;
+
+    while (end - s >= 16){
+	v = _mm_loadu_si128((const __m128i *)s);
+	m = _mm_movemask_epi8(_mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, v1),
+							_mm_cmpeq_epi8(v, v2)),
+					   _mm_or_si128(_mm_cmpeq_epi8(v, v3),
+							_mm_cmpeq_epi8(v, v4))));
+	if (m)
+	    return s + __builtin_ctz(m);
+	s += 16;
+    }
+#endif
+    while (s < end && *s != c1 && *s != c2 && *s != c3 && *s != c4)
+	s++;
+    return s;
+}
+
 /*! Escape characters according to XML definition
  * @param[out]  encp   Encoded malloced output string
  * @param[in]   fmt    Not-encoded input string (stdarg format string)
@@ -377,10 +448,7 @@ xml_chardata_encode(char      **escp,
     char   *str = NULL;  /* Expanded format string w stdarg */
     int     fmtlen;
     char   *esc = NULL;
-    int     l;
-    int     len;
-    int     i, j;
-    int     cdata; /* when set, skip encoding */
+    cbuf   *cb = NULL;
     va_list args;
     
     /* Two steps: (1) read in the complete format string */
@@ -398,92 +466,23 @@ xml_chardata_encode(char      **escp,
     /* Now str is the combined fmt + ... */
 
     /* Step (2) encode and expand str --> enc */
-    /* First compute length (do nothing) */
-    len = 0; cdata = 0;
-    for (i=0; i<strlen(str); i++){
-	if (cdata){
-	    if (strncmp(&str[i], "]]>", strlen("]]>")) == 0)
-		cdata = 0;
-	    len++;
-	}
-	else
-	    switch (str[i]){
-	    case '&':
-		len += strlen("&amp;");
-		break;
-	    case '<':
-		if (strncmp(&str[i], "<![CDATA[", strlen("<![CDATA[")) == 0){
-		    len++;
-		    cdata++;
-		}
-		else
-		    len += strlen("&lt;");
-		break;
-	    case '>':
-		len += strlen("&gt;");
-		break;
-	    default:
-		len++;
-	    }
-    }
-    len++; /* trailing \0 */
-    /* We know length, allocate encoding buffer  */
-    if ((esc = malloc(len)) == NULL){
-	clicon_err(OE_UNIX, errno, "malloc"); 
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
 	goto done;
     }
-    memset(esc, 0, len);
-
-    /* Same code again, but now actually encode into output buffer */
-    j = 0; cdata = 0;
-    for (i=0; i<strlen(str); i++){
-	if (cdata){
-	    if (strncmp(&str[i], "]]>", strlen("]]>")) == 0){
-		cdata = 0;
-		esc[j++] = str[i++];
-		esc[j++] = str[i++];
-	    }
-	    esc[j++] = str[i];
-	}
-	else
-	switch (str[i]){
-	case '&':
-	    if ((l=snprintf(&esc[j], 6, "&amp;")) < 0){
-		clicon_err(OE_UNIX, errno, "snprintf");
-		goto done;
-	    }
-	    j += l;
-	    break;
-	case '<':
-	    if (strncmp(&str[i], "<![CDATA[", strlen("<![CDATA[")) == 0){
-		esc[j++] = str[i];
-		cdata++;
-		break;
-	    }
-	    if ((l=snprintf(&esc[j], 5, "&lt;")) < 0){
-		clicon_err(OE_UNIX, errno, "snprintf");
-		goto done;
-	    }
-	    j += l;
-	    break;
-	case '>':
-	    if ((l=snprintf(&esc[j], 5, "&gt;")) < 0){
-		clicon_err(OE_UNIX, errno, "snprintf");
-		goto done;
-	    }
-	    j += l;
-	    break;
-	default:
-	    esc[j++] = str[i];
-	}
+    if (xml_chardata_cbuf_append(cb, str) < 0)
+	goto done;
+    if ((esc = strdup(cbuf_get(cb))) == NULL){
+	clicon_err(OE_UNIX, errno, "strdup");
+	goto done;
     }
     *escp = esc;
     retval = 0;
  done:
     if (str)
 	free(str);
-    if (retval < 0 && esc)
-	free(esc);
+    if (cb)
+	cbuf_free(cb);
     return retval;
 }
 
@@ -496,32 +495,29 @@ int
 xml_chardata_cbuf_append(cbuf *cb,
 			 char *str)
 {
-    int  retval = -1;
-    int  i;
-    int  cdata; /* when set, skip encoding */
-
-    /* The orignal of this code is in xml_chardata_encode */
-    /* Step: encode and expand str --> enc */
-    /* Same code again, but now actually encode into output buffer */
-    cdata = 0;
-    for (i=0; i<strlen(str); i++){
-	if (cdata){
-	    if (strncmp(&str[i], "]]>", strlen("]]>")) == 0){
-		cdata = 0;
-		cbuf_append(cb, str[i++]);
-		cbuf_append(cb, str[i++]);
-	    }
-	    cbuf_append(cb, str[i]);
-	}
-	else
-	switch (str[i]){
+    char *p = str;
+    char *end = str + strlen(str);
+    char *q;
+
+    while (1){
+	/* Append run of characters that need no encoding */
+	q = (char*)clixon_memchr4(p, end - p, '&', '<', '>', '>');
+	cbuf_append_buf(cb, p, q - p);
+	if (q == end)
+	    break;
+	p = q + 1;
+	switch (*q){
 	case '&':
 	    cbuf_append_str(cb, "&amp;");
 	    break;
 	case '<':
-	    if (strncmp(&str[i], "<![CDATA[", strlen("<![CDATA[")) == 0){
-		cbuf_append(cb, str[i]);
-		cdata++;
+	    if (strncmp(q, "<![CDATA[", strlen("<![CDATA[")) == 0){
+		/* Not encoded up to and including "]]>" (or end) */
+		if ((p = strstr(q + strlen("<![CDATA["), "]]>")) == NULL)
+		    p = end;
+		else
+		    p += strlen("]]>");
+		cbuf_append_buf(cb, q, p - q);
 		break;
 	    }
 	    cbuf_append_str(cb, "&lt;");
@@ -529,16 +525,11 @@ xml_chardata_cbuf_append(cbuf *cb,
 	case '>':
 	    cbuf_append_str(cb, "&gt;");
 	    break;
-	default:
-	    cbuf_append(cb, str[i]);
 	}
     }
-    retval = 0;
-    // done:
-    return retval;
+    return 0;
 }
 
-
 /*! Split a string into a cligen variable vector using 1st and 2nd delimiter 
  * Split a string first into elements delimited by delim1, then into
  * pairs delimited by delim2.
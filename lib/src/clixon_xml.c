@@ -97,8 +97,12 @@
  * Types
  */
 
+#ifdef XML_KEY_BLOB
+static void xml_key_clear(cxobj *xp, cxobj *xc);
+#endif
 #ifdef XML_EXPLICIT_INDEX
 static int xml_search_index_free(cxobj *x);
+static int xml_search_key_changed(cxobj *xl, int added);
 
 /* A search index pair consisting of a name of an (index) variable and a vector of xml children
  * the variable should be a potential child of the XML node
@@ -123,6 +127,7 @@ struct search_index{
     qelem_t      si_q;    /* Queue header */
     char        *si_name; /* Name of index variable (must be (potential) child of xml node at hand */
     clixon_xvec *si_xvec; /* Sorted vector of xml object pointers (should be of YANG type LIST) */
+    yang_stmt   *si_ylist; /* If set, key index of ordered-by user list, si_name is list name */
 };
 #endif
 
@@ -165,6 +170,7 @@ struct xml{
     char             *x_name;       /* name of node */
     char             *x_prefix;     /* namespace localname N, called prefix */
     uint16_t          x_flags;      /* Flags according to XML_FLAG_* */
+    uint64_t          x_epoch;      /* Mark epoch of XML_FLAG_TRANSIENT flags */
     struct xml       *x_up;         /* parent node in hierarchy if any */
     int              _x_vector_i;   /* internal use: xml_child_each */
     int              _x_i;          /* internal use for sorting: 
@@ -182,9 +188,17 @@ struct xml{
     yang_stmt        *x_spec;       /* Pointer to specification, eg yang, 
 				       by reference, dont free */
     cg_var           *x_cv;         /* Cached value as cligen variable (set by xml_cmp) */
+#ifdef XML_KEY_BLOB
+    uint8_t          *x_key;        /* Cached binary key of list element (set by xml_cmp) */
+    size_t            x_keylen;     /* Length of x_key */
+    enum xml_key_state x_keystate;  /* State of x_key */
+#endif
 #ifdef XML_EXPLICIT_INDEX
     struct search_index *x_search_index; /* explicit search index vectors */
 #endif
+#ifdef XML_DESCENDANT_INDEX
+    uint64_t          x_descendant_names; /* Bits of hashed names of descendants */
+#endif
 };
 
 /* Variant of struct xml for use by non-elements to save space
@@ -195,6 +209,7 @@ struct xmlbody{
     char             *xb_name;       /* name of node */
     char             *xb_prefix;     /* namespace localname N, called prefix */
     uint16_t          xb_flags;      /* Flags according to XML_FLAG_* */
+    uint64_t          xb_epoch;      /* Mark epoch of XML_FLAG_TRANSIENT flags */
     struct xml       *xb_up;         /* parent node in hierarchy if any */
     int              _xb_vector_i;   /* internal use: xml_child_each */
     int              _xb_i;          /* internal use for sorting: 
@@ -206,6 +221,15 @@ struct xmlbody{
  * Variables
  */
 
+/* Current mark epoch. Transient flags (XML_FLAG_TRANSIENT) of a node are only valid
+ * if the epoch of the node is equal to this value.
+ * Starts at 1 so that new nodes (epoch 0) have no valid transient flags
+ * 64 bits so that it does not wrap: a node stamped with an old epoch would otherwise
+ * get its stale transient flags back when the counter reaches the same value again
+ * @see xml_flag_epoch_next
+ */
+static uint64_t _xml_epoch = 1;
+
 /* Mapping between xml type <--> string */
 static const map_str2int xsmap[] = {
     {"error",         CX_ERROR}, 
@@ -263,6 +287,9 @@ xml_stats_one(cxobj    *x,
 	    sz += cvec_size(x->x_ns_cache);
 	if (x->x_cv)
 	    sz += cv_size(x->x_cv);
+#ifdef XML_KEY_BLOB
+	sz += x->x_keylen;
+#endif
 #ifdef XML_EXPLICIT_INDEX
 	if (x->x_search_index){
 	    /* XXX: only one */
@@ -368,6 +395,83 @@ xml_stats(cxobj    *xt,
 /*
  * Access functions
  */
+#ifdef XML_DESCENDANT_INDEX
+/*! Bits of a name in a descendant name summary
+ * Two bits of a 64-bit mask given by a FNV-1a hash of the name
+ * @param[in]  name  Name of xml element
+ * @retval     bits  Bitmask
+ */
+static uint64_t
+xml_name_bits(const char *name)
+{
+    uint32_t h = 2166136261U;
+
+    while (*name){
+	h ^= (unsigned char)*name++;
+	h *= 16777619U;
+    }
+    return ((uint64_t)1 << (h & 0x3f)) | ((uint64_t)1 << ((h >> 6) & 0x3f));
+}
+
+/*! Add the names of an element and its descendants to the summaries of xp and its ancestors
+ * @param[in]  xp   Parent (or view) of xn
+ * @param[in]  xn   xml element
+ */
+static void
+xml_descendant_names_add_to(cxobj *xp,
+			    cxobj *xn)
+{
+    uint64_t bits;
+    cxobj   *x;
+
+    bits = xml_name_bits(xn->x_name) | xn->x_descendant_names;
+    for (x = xp; x != NULL; x = x->x_up){
+	if ((x->x_descendant_names & bits) == bits)
+	    break;
+	x->x_descendant_names |= bits;
+    }
+}
+
+/*! Add the names of an element and its descendants to the summaries of its ancestors
+ * Stops at the first ancestor that already has them, since then all its ancestors
+ * have them as well.
+ * @param[in]  xn   xml node
+ * @note Names are not removed when nodes are removed, summaries may have false positives
+ */
+static void
+xml_descendant_names_add(cxobj *xn)
+{
+    if (xml_type(xn) != CX_ELMNT || xn->x_name == NULL)
+	return;
+    xml_descendant_names_add_to(xn->x_up, xn);
+}
+#endif /* XML_DESCENDANT_INDEX */
+
+/*! Check if an xml node may have a descendant element with a given name
+ *
+ * Used to skip subtrees in descendant searches. May give false positives, eg after
+ * descendants are removed, but never false negatives.
+ * @param[in]  xn    xml node
+ * @param[in]  name  Name of descendant element, without prefix
+ * @retval     1     xn may have a descendant element named name
+ * @retval     0     xn has no descendant element named name
+ */
+int
+xml_descendant_maybe(cxobj      *xn,
+		     const char *name)
+{
+#ifdef XML_DESCENDANT_INDEX
+    uint64_t bits;
+
+    if (xml_type(xn) != CX_ELMNT)
+	return 0;
+    bits = xml_name_bits(name);
+    return (xn->x_descendant_names & bits) == bits;
+#else
+    return 1;
+#endif
+}
+
 /*! Get name of xnode
  * @param[in]  xn    xml node
  * @retval     name of xml node
@@ -397,7 +501,16 @@ xml_name_set(cxobj *xn,
 	    clicon_err(OE_XML, errno, "strdup");
 	    return -1;
 	}
+#ifdef XML_DESCENDANT_INDEX
+	if (xn->x_up)
+	    xml_descendant_names_add(xn);
+#endif
     }
+#ifdef XML_KEY_BLOB
+    /* Eg a key leaf of the parent is renamed */
+    if (xn->x_up)
+	xml_key_clear(xn->x_up, xn);
+#endif
     return 0;
 }
 
@@ -578,18 +691,28 @@ xml_parent_set(cxobj *xn,
 	       cxobj *parent)
 {
     xn->x_up = parent;
+#ifdef XML_DESCENDANT_INDEX
+    if (parent)
+	xml_descendant_names_add(xn);
+#endif
     return 0;
 }
 
 /*! Get xml node flags, used for internal algorithms
  * @param[in]  xn    xml node
  * @retval     flag  Flag value(s), see XML_FLAG_*
+ * @note Transient flags set in an earlier mark epoch are not returned
+ * @see xml_flag_epoch_next
  */
 uint16_t
 xml_flag(cxobj   *xn, 
 	 uint16_t flag)
 {
-    return xn->x_flags&flag;
+    uint16_t flags = xn->x_flags;
+
+    if ((flags & XML_FLAG_TRANSIENT) && xn->x_epoch != _xml_epoch)
+	flags &= ~XML_FLAG_TRANSIENT;
+    return flags&flag;
 }
 
 /*! Set xml node flags, used for internal algorithms
@@ -600,6 +723,11 @@ int
 xml_flag_set(cxobj   *xn, 
 	     uint16_t flag)
 {
+    if (flag & XML_FLAG_TRANSIENT && xn->x_epoch != _xml_epoch){
+	/* Transient flags from earlier epochs are stale: clear them first */
+	xn->x_flags &= ~XML_FLAG_TRANSIENT;
+	xn->x_epoch = _xml_epoch;
+    }
     xn->x_flags |= flag;
     return 0;
 }
@@ -616,6 +744,34 @@ xml_flag_reset(cxobj   *xn,
     return 0;
 }
 
+/*! Start a new mark epoch, ie reset transient flags in all XML trees in O(1)
+ *
+ * Instead of traversing a tree with xml_flag_reset to clear marks, transient flags
+ * (XML_FLAG_TRANSIENT) are stamped with the current epoch when set, and considered
+ * unset if the epoch has changed.
+ * @retval     0       OK
+ * @retval    -1       Error, epoch counter exhausted
+ * @note Clears transient flags in ALL trees. A transient flag must therefore not be
+ *       kept across calls that may start a new epoch, such as xmldb_get0 or xmldb_put
+ * @code
+ *    xml_flag_set(x, XML_FLAG_MARK);
+ *    xml_tree_prune_flagged_sub(xt, XML_FLAG_MARK, 1, NULL);
+ *    xml_flag_epoch_next();
+ * @endcode
+ */
+int
+xml_flag_epoch_next(void)
+{
+    if (_xml_epoch == UINT64_MAX){
+	/* Cannot happen in practice. Stamps of existing nodes are not reachable from
+	 * here, so starting over would make stale transient flags valid again */
+	clicon_err(OE_XML, EOVERFLOW, "XML mark epoch wrap-around");
+	return -1;
+    }
+    _xml_epoch++;
+    return 0;
+}
+
 /*! Get value of xnode
  * @param[in]  xn    xml node
  * @retval     value of xml node
@@ -640,6 +796,10 @@ xml_value_set(cxobj *xn,
 {
     int    retval = -1;
     size_t sz;
+    cxobj *xp;
+#ifdef XML_EXPLICIT_INDEX
+    int    index = 0;
+#endif
 
     if (!is_bodyattr(xn))
 	return 0;
@@ -647,6 +807,26 @@ xml_value_set(cxobj *xn,
 	clicon_err(OE_XML, EINVAL, "value is NULL");
 	goto done;
     }
+    if (xml_type(xn) == CX_BODY && (xp = xml_parent(xn)) != NULL){
+#ifdef XML_EXPLICIT_INDEX
+	/* Index is sorted on the value, remove with old value and insert with new */
+	if (xml_search_index_p(xp)){
+	    if (xml_search_child_rm(xml_parent(xp), xp) < 0)
+		goto done;
+	    index++;
+	}
+	if (xml_search_key_changed(xp, 0) < 0)
+	    goto done;
+#endif
+	/* Cached value of parent is stale */
+	if (xp->x_cv){
+	    cv_free(xp->x_cv);
+	    xp->x_cv = NULL;
+	}
+#ifdef XML_KEY_BLOB
+	xml_key_clear(xp, NULL);
+#endif
+    }
     sz = strlen(val)+1;
     if (xn->x_value_cb == NULL){
 	if ((xn->x_value_cb = cbuf_new_alloc(sz)) == NULL){
@@ -657,6 +837,11 @@ xml_value_set(cxobj *xn,
     else
 	cbuf_reset(xn->x_value_cb);
     cbuf_append_str(xn->x_value_cb, val);
+#ifdef XML_EXPLICIT_INDEX
+    if (index &&
+	xml_search_child_insert(xml_parent(xp), xp) < 0)
+	goto done;
+#endif
     retval = 0;
  done:
     return retval;
@@ -674,6 +859,7 @@ xml_value_append(cxobj *xn,
 {
     int    retval = -1;
     size_t sz;
+    cxobj *xp;
 
     if (!is_bodyattr(xn))
 	return 0;
@@ -681,6 +867,16 @@ xml_value_append(cxobj *xn,
 	clicon_err(OE_XML, EINVAL, "value is NULL");
 	goto done;
     }
+    if (xml_type(xn) == CX_BODY && (xp = xml_parent(xn)) != NULL){
+	/* Cached value of parent is stale, as in xml_value_set */
+	if (xp->x_cv){
+	    cv_free(xp->x_cv);
+	    xp->x_cv = NULL;
+	}
+#ifdef XML_KEY_BLOB
+	xml_key_clear(xp, NULL);
+#endif
+    }
     sz = strlen(val)+1;
     if (xn->x_value_cb == NULL){
 	if ((xn->x_value_cb = cbuf_new_alloc(sz)) == NULL){
@@ -958,6 +1154,9 @@ xml_child_append(cxobj *xp,
 	}
     }
     xp->x_childvec[xp->x_childvec_len-1] = xc;
+#ifdef XML_KEY_BLOB
+    xml_key_clear(xp, xc);
+#endif
     return 0;
 }
 
@@ -990,6 +1189,33 @@ xml_child_insert_pos(cxobj *xp,
     size = (xml_child_nr(xp) - i - 1)*sizeof(cxobj *);
     memmove(&xp->x_childvec[i+1], &xp->x_childvec[i], size);
     xp->x_childvec[i] = xc;
+#ifdef XML_KEY_BLOB
+    xml_key_clear(xp, xc);
+#endif
+    return 0;
+}
+
+/*! Append a child to a node without changing the parent of the child
+ *
+ * The child is then shared between xp and its parent. This is used for read-only views
+ * of a tree that share sub-trees with it, such as datastore snapshots.
+ * Ancestor accesses from xc, such as namespace lookups, are made via its real parent.
+ * @param[in]  xp    xml parent node (view)
+ * @param[in]  xc    Child, still owned by its parent
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @note Before xp is freed, the shared children must be unlinked, eg with xml_child_i_set(xp, i, NULL)
+ */
+int
+xml_child_share(cxobj *xp,
+		cxobj *xc)
+{
+    if (xml_child_append(xp, xc) < 0)
+	return -1;
+#ifdef XML_DESCENDANT_INDEX
+    if (xml_type(xc) == CX_ELMNT && xc->x_name != NULL)
+	xml_descendant_names_add_to(xp, xc);
+#endif
     return 0;
 }
 
@@ -1177,6 +1403,75 @@ xml_cv_set(cxobj  *x,
     return 0;
 }
 
+#ifdef XML_KEY_BLOB
+/*! Get cached binary key of list element
+ * @param[in]  x     XML list element
+ * @param[out] key   Binary key, or NULL
+ * @param[out] len   Length of key
+ * @retval     state State of key, XK_NONE if not set
+ * Only accessed as part of sorting in xml_cmp
+ * @see xml_key_cache
+ */
+enum xml_key_state
+xml_key_get(cxobj    *x,
+	    uint8_t **key,
+	    size_t   *len)
+{
+    if (!is_element(x))
+	return XK_NO;
+    *key = x->x_key;
+    *len = x->x_keylen;
+    return x->x_keystate;
+}
+
+/*! Set cached binary key of list element
+ * @param[in]  x     XML list element
+ * @param[in]  state State of key, XK_NONE clears it
+ * @param[in]  key   Binary key, malloced, consumed by the function, or NULL
+ * @param[in]  len   Length of key
+ * @retval     0     OK
+ * Only accessed as part of sorting in xml_cmp
+ * @see xml_key_cache
+ */
+int
+xml_key_set(cxobj             *x,
+	    enum xml_key_state state,
+	    uint8_t           *key,
+	    size_t             len)
+{
+    if (!is_element(x)){
+	if (key)
+	    free(key);
+	return 0;
+    }
+    if (x->x_key)
+	free(x->x_key);
+    x->x_key = key;
+    x->x_keylen = len;
+    x->x_keystate = state;
+    return 0;
+}
+
+/*! Clear cached binary keys that may depend on a changed child
+ * A list element key depends on its children and the bodies of its key leafs
+ * @param[in]  xp    XML node whose children have changed
+ * @param[in]  xc    Child of xp that is added or removed, or NULL
+ */
+static void
+xml_key_clear(cxobj *xp,
+	      cxobj *xc)
+{
+    cxobj *xpp;
+
+    if (xp->x_keystate != XK_NONE)
+	xml_key_set(xp, XK_NONE, NULL, 0);
+    if ((xc == NULL || xml_type(xc) == CX_BODY) &&
+	(xpp = xml_parent(xp)) != NULL &&
+	xpp->x_keystate != XK_NONE)
+	xml_key_set(xpp, XK_NONE, NULL, 0);
+}
+#endif /* XML_KEY_BLOB */
+
 /*! Find an XML node matching name among a parent's children.
  *
  * Get first XML node directly under x_up in the xml hierarchy with
@@ -1261,8 +1556,8 @@ xml_addsub(cxobj *xp,
 	/* clear namespace context cache of child */
 	nscache_clear(xc);
 #ifdef XML_EXPLICIT_INDEX
-    if (xml_search_index_p(xc))
-	    xml_search_child_insert(xp, xc);
+	if (xml_search_index_update(xc, 1) < 0)
+	    goto done;
 #endif
     }
     retval = 0;
@@ -1270,6 +1565,58 @@ xml_addsub(cxobj *xp,
     return retval;
 }
 
+/*! Move all element children of xfrom to xp, appended after existing children of xp
+ *
+ * Same as xml_addsub on each element child, but linear in the number of children
+ * since they are not removed one by one from xfrom.
+ * @param[in] xp    Parent xml node
+ * @param[in] xfrom Xml node whose element children are moved
+ * @retval    0     OK
+ * @retval    -1    Error
+ * @note Children are not sorted, need to call xml_sort on xp
+ * @note Unlike xml_addsub, duplicate default namespaces are not removed from children
+ * @see xml_addsub
+ */
+int
+xml_addsub_children(cxobj *xp,
+		    cxobj *xfrom)
+{
+    int    retval = -1;
+    cxobj *xc;
+    int    i;
+    int    j = 0;
+
+    if (!is_element(xp) || !is_element(xfrom))
+	return 0;
+    for (i=0; i<xfrom->x_childvec_len; i++){
+	xc = xfrom->x_childvec[i];
+	if (xml_type(xc) != CX_ELMNT){ /* Keep in xfrom */
+	    xfrom->x_childvec[j++] = xc;
+	    continue;
+	}
+	if (xml_child_append(xp, xc) < 0){
+	    /* Keep the rest in xfrom */
+	    for (; i<xfrom->x_childvec_len; i++)
+		xfrom->x_childvec[j++] = xfrom->x_childvec[i];
+	    goto done;
+	}
+	xml_parent_set(xc, xp);
+	nscache_clear(xc);
+#ifdef XML_EXPLICIT_INDEX
+	if (xml_search_index_update(xc, 1) < 0){
+	    i++;
+	    for (; i<xfrom->x_childvec_len; i++)
+		xfrom->x_childvec[j++] = xfrom->x_childvec[i];
+	    goto done;
+	}
+#endif
+    }
+    retval = 0;
+ done:
+    xfrom->x_childvec_len = j;
+    return retval;
+}
+
 /*! Wrap a new node between a parent xml node (xp) and all its children
  *  Before:  xp --> xc*
  *  After:   xp --> xw --> xc*
@@ -1380,18 +1727,19 @@ xml_child_rm(cxobj *xp,
 	clicon_err(OE_XML, 0, "Child not found");
 	goto done;
     }
+#ifdef XML_EXPLICIT_INDEX
+    /* Before parent is reset, the index is found via the parent */
+    if (xml_search_index_update(xc, 0) < 0)
+	goto done;
+#endif
+#ifdef XML_KEY_BLOB
+    xml_key_clear(xp, xc);
+#endif
     xml_parent_set(xc, NULL);
     xp->x_childvec[i] = NULL;
     xp->x_childvec_len--;
     if (i<xp->x_childvec_len)
 	memmove(&xp->x_childvec[i], &xp->x_childvec[i+1], (xp->x_childvec_len-i)*sizeof(cxobj*));
-#ifdef XML_EXPLICIT_INDEX
-    if (xml_type(xc) == CX_ELMNT){
-	if (xml_search_index_p(xc))
-	    xml_search_child_rm(xp, xc);
-
-    }
-#endif
     retval = 0;
  done:
     return retval;
@@ -1829,6 +2177,10 @@ xml_free(cxobj *x)
 	    free(x->x_childvec);
 	if (x->x_cv)
 	    cv_free(x->x_cv);
+#ifdef XML_KEY_BLOB
+	if (x->x_key)
+	    free(x->x_key);
+#endif
 	if (x->x_ns_cache)
 	    xml_nsctx_free(x->x_ns_cache);
 #ifdef XML_EXPLICIT_INDEX
@@ -2472,7 +2824,7 @@ xml_search_index_get(cxobj *x,
 
     if ((si = x->x_search_index) != NULL) {
 	do {
-	    if (strcmp(si->si_name, name) == 0){
+	    if (si->si_ylist == NULL && strcmp(si->si_name, name) == 0){
 		goto done;
 		break;
 	    }
@@ -2501,7 +2853,7 @@ xml_search_vector_get(cxobj        *xp,
     *xvec = NULL;
     if ((si = xp->x_search_index) != NULL) {
 	do {
-	    if (strcmp(si->si_name, name) == 0){
+	    if (si->si_ylist == NULL && strcmp(si->si_name, name) == 0){
 		*xvec = si->si_xvec;
 		break;
 	    }
@@ -2511,9 +2863,228 @@ xml_search_vector_get(cxobj        *xp,
     return 0;
 }
 
+/*! Get key index of an ordered-by user list
+ * @param[in]  x     XML parent object
+ * @param[in]  y     Yang spec of list
+ * @retval     si    Key index
+ * @retval     NULL  No key index of list in x
+ */
+static struct search_index *
+xml_search_key_get(cxobj     *x,
+		   yang_stmt *y)
+{
+    struct search_index *si;
+
+    if ((si = x->x_search_index) != NULL) {
+	do {
+	    if (si->si_ylist == y)
+		return si;
+	    si = NEXTQ(struct search_index *, si);
+	} while (si && si != x->x_search_index);
+    }
+    return NULL;
+}
+
+/*! Get key index vector of an ordered-by user list
+ *
+ * The children of an ordered-by user list are in user order and can not be binary searched.
+ * A key index is a vector of the list elements sorted on their keys, which can.
+ * @param[in]  xp    XML parent object
+ * @param[in]  y     Yang spec of list
+ * @param[out] xvec  Key index vector, or NULL if there is none
+ * @retval     0     OK
+ * @see xml_search_keyvec_add
+ */
+int
+xml_search_keyvec_get(cxobj        *xp,
+		      yang_stmt    *y,
+		      clixon_xvec **xvec)
+{
+    struct search_index *si;
+
+    *xvec = NULL;
+    if ((si = xml_search_key_get(xp, y)) != NULL)
+	*xvec = si->si_xvec;
+    return 0;
+}
+
+/*! Add an empty key index vector of an ordered-by user list
+ *
+ * The caller fills the vector with the list elements sorted on their keys. Thereafter
+ * the vector is maintained as elements are added and removed, and the index is
+ * removed if a key of an element changes.
+ * @param[in]  xp    XML parent object
+ * @param[in]  y     Yang spec of list
+ * @param[out] xvec  Key index vector
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @see xml_search_keyvec_get
+ */
+int
+xml_search_keyvec_add(cxobj        *xp,
+		      yang_stmt    *y,
+		      clixon_xvec **xvec)
+{
+    int                  retval = -1;
+    struct search_index *si;
+
+    if ((si = xml_search_key_get(xp, y)) == NULL){
+	if ((si = xml_search_index_add(xp, yang_argument_get(y))) == NULL)
+	    goto done;
+	si->si_ylist = y;
+    }
+    *xvec = si->si_xvec;
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Find position of a list element in a search index vector
+ *
+ * Binary search on the value of the index variable, then the element itself is looked for
+ * among the elements with an equal value, since index values need not be unique.
+ * @param[in]  si    Search index
+ * @param[in]  xp    XML list element
+ * @param[out] posp  Position of xp if found, otherwise where it should be inserted
+ * @retval     1     Found, xp is at position posp
+ * @retval     0     Not found
+ * @retval    -1     Error
+ */
+static int
+xml_search_index_pos(struct search_index *si,
+		     cxobj               *xp,
+		     int                 *posp)
+{
+    clixon_xvec *xv = si->si_xvec;
+    char        *indexvar;
+    int          len;
+    int          pos;
+    int          eq = 0;
+    int          i;
+
+    /* A key index is sorted on the list keys */
+    indexvar = si->si_ylist ? NULL : si->si_name;
+    len = clixon_xvec_len(xv);
+    if ((pos = xml_search_indexvar_binary_pos(xp, indexvar, xv, 0, len, len, &eq)) < 0)
+	return -1;
+    *posp = pos;
+    if (eq){
+	for (i=pos; i>=0 && xml_cmp(xp, clixon_xvec_i(xv, i), 0, 0, indexvar) == 0; i--)
+	    if (clixon_xvec_i(xv, i) == xp){
+		*posp = i;
+		return 1;
+	    }
+	for (i=pos+1; i<len && xml_cmp(xp, clixon_xvec_i(xv, i), 0, 0, indexvar) == 0; i++)
+	    if (clixon_xvec_i(xv, i) == xp){
+		*posp = i;
+		return 1;
+	    }
+    }
+    return 0;
+}
+
+/*! A key leaf of a list element is added, removed or changed: remove key index of list
+ * The key index is built again when it is next searched.
+ * @param[in]  xl    XML leaf
+ * @param[in]  added xl has been added, keep index if the list element is found in it
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+xml_search_key_changed(cxobj *xl,
+		       int    added)
+{
+    int                  retval = -1;
+    cxobj               *xe;
+    cxobj               *xpp;
+    yang_stmt           *ye;
+    struct search_index *si;
+    int                  i;
+    int                  ret;
+
+    if ((xe = xml_parent(xl)) == NULL ||
+	(xpp = xml_parent(xe)) == NULL ||
+	xpp->x_search_index == NULL)
+	goto ok;
+    if ((ye = xml_spec(xe)) == NULL ||
+	(si = xml_search_key_get(xpp, ye)) == NULL)
+	goto ok;
+    if ((ret = yang_key_match(ye, xml_name(xl))) < 0)
+	goto done;
+    if (ret == 0) /* Not a key */
+	goto ok;
+    if (added){
+	/* Index is consistent, eg yang of an existing key leaf is bound */
+	if ((ret = xml_search_index_pos(si, xe, &i)) < 0)
+	    goto done;
+	if (ret == 1)
+	    goto ok;
+    }
+    DELQ(si, xpp->x_search_index, struct search_index *);
+    free(si->si_name);
+    clixon_xvec_free(si->si_xvec);
+    free(si);
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Insert list element in search index, unless it already is in the index
+ * @param[in]  si    Search index
+ * @param[in]  xp    XML list element
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+xml_search_index_insert(struct search_index *si,
+			cxobj               *xp)
+{
+    int i;
+    int ret;
+
+    /* Find element position using binary search and then insert */
+    if ((ret = xml_search_index_pos(si, xp, &i)) < 0)
+	return -1;
+    if (ret == 0 &&
+	clixon_xvec_insert_pos(si->si_xvec, xp, i) < 0)
+	return -1;
+    return 0;
+}
+
+/*! Remove list element from search index
+ * @param[in]  si    Search index
+ * @param[in]  xp    XML list element
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @note If the index value has been changed without updating the index, xp is not found
+ * using binary search and a linear search is made
+ */
+static int
+xml_search_index_remove(struct search_index *si,
+			cxobj               *xp)
+{
+    int i;
+    int ret;
+
+    /* Find element using binary search and then remove */
+    if ((ret = xml_search_index_pos(si, xp, &i)) < 0)
+	return -1;
+    if (ret == 0)
+	for (i=0; i<clixon_xvec_len(si->si_xvec); i++)
+	    if (clixon_xvec_i(si->si_xvec, i) == xp)
+		break;
+    if (i < clixon_xvec_len(si->si_xvec) &&
+	clixon_xvec_i(si->si_xvec, i) == xp)
+	if (clixon_xvec_rm_pos(si->si_xvec, i) < 0)
+	    return -1;
+    return 0;
+}
+
 /*! Insert a new cxobj into search index vector for list for variable "name"
  * @param[in] xp XML parent object (the list element)
  * @param[in] xi XML index object (that should be added)
+ * @note xp is not added if it already is in the index
  */
 int
 xml_search_child_insert(cxobj *xp,
@@ -2523,8 +3094,6 @@ xml_search_child_insert(cxobj *xp,
     char                *indexvar;
     struct search_index *si;
     cxobj               *xpp;
-    int                  i;
-    int                  len;
     
     indexvar = xml_name(xi);
     if ((xpp = xml_parent(xp)) == NULL)
@@ -2535,12 +3104,7 @@ xml_search_child_insert(cxobj *xp,
 	if ((si = xml_search_index_add(xpp, indexvar)) == NULL)
 	    goto done;
     }
-    /* Find element position using binary search and then remove */
-    len = clixon_xvec_len(si->si_xvec);
-    if ((i = xml_search_indexvar_binary_pos(xp, indexvar, si->si_xvec, 0, len, len, NULL)) < 0)
-	goto done;
-    assert(clixon_xvec_i(si->si_xvec, i) != xp);
-    if (clixon_xvec_insert_pos(si->si_xvec, xp, i) < 0)
+    if (xml_search_index_insert(si, xp) < 0)
 	goto done;
  ok:
     retval = 0;
@@ -2559,10 +3123,7 @@ xml_search_child_rm(cxobj *xp,
     int                 retval = -1;
     cxobj              *xpp;
     char               *indexvar;
-    int                 i;
-    int                 len;
     struct search_index *si;
-    int                  eq = 0;
     
     indexvar = xml_name(xi);
     if ((xpp = xml_parent(xp)) == NULL)
@@ -2570,15 +3131,76 @@ xml_search_child_rm(cxobj *xp,
     /* Find base vector in grandparent */
     if ((si = xml_search_index_get(xpp, indexvar)) == NULL)
 	goto ok;
-    
-    /* Find element using binary search and then remove */
-    len = clixon_xvec_len(si->si_xvec);
-    if ((i = xml_search_indexvar_binary_pos(xp, indexvar, si->si_xvec, 0, len, len, &eq)) < 0)
+    if (xml_search_index_remove(si, xp) < 0)
 	goto done;
-	//    if (clixon_xvec_i(si->si_xvec, i) == xp)
-    if (eq)
-	if (clixon_xvec_rm_pos(si->si_xvec, i) < 0)
-	    goto done;		
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Update search indexes when an xml node is added to, or is removed from its parent
+ *
+ * If the node is an index variable, its list element is added to or removed from the
+ * index in the grand-parent. If the node is a list element, it is added to or removed
+ * from the indexes of all its index variables in the parent, and from the key index of
+ * its list in the parent, if any. If the node is a key leaf, the key index of its list
+ * is removed.
+ * @param[in] xc   XML node with parent
+ * @param[in] add  1: xc has been added to its parent, 0: xc is about to be removed
+ * @retval    0    OK
+ * @retval   -1    Error
+ * @see xml_bind_search_index  where indexes are updated when yang is bound
+ */
+int
+xml_search_index_update(cxobj *xc,
+			int    add)
+{
+    int        retval = -1;
+    yang_stmt *y;
+    cxobj     *xi;
+    cxobj     *xp;
+    int        i;
+    struct search_index *si;
+
+    if (xml_type(xc) != CX_ELMNT || (y = xml_spec(xc)) == NULL)
+	goto ok;
+    if (yang_keyword_get(y) == Y_LIST &&
+	(xp = xml_parent(xc)) != NULL &&
+	xp->x_search_index != NULL &&
+	(si = xml_search_key_get(xp, y)) != NULL){
+	if (add){
+	    if (xml_search_index_insert(si, xc) < 0)
+		goto done;
+	}
+	else if (xml_search_index_remove(si, xc) < 0)
+	    goto done;
+    }
+    else if (yang_keyword_get(y) == Y_LEAF &&
+	     xml_search_key_changed(xc, add) < 0)
+	goto done;
+    if (xml_search_index_p(xc)){
+	if (add){
+	    if (xml_search_child_insert(xml_parent(xc), xc) < 0)
+		goto done;
+	}
+	else if (xml_search_child_rm(xml_parent(xc), xc) < 0)
+	    goto done;
+    }
+    else if (yang_keyword_get(y) == Y_LIST &&
+	     yang_flag_get(y, YANG_FLAG_INDEX_LIST) != 0){
+	for (i=0; i<xml_child_nr(xc); i++){
+	    xi = xml_child_i(xc, i);
+	    if (xml_type(xi) != CX_ELMNT || !xml_search_index_p(xi))
+		continue;
+	    if (add){
+		if (xml_search_child_insert(xc, xi) < 0)
+		    goto done;
+	    }
+	    else if (xml_search_child_rm(xc, xi) < 0)
+		goto done;
+	}
+    }
  ok:
     retval = 0;
  done:
@@ -115,6 +115,20 @@ strip_whitespace(cxobj *xt)
     return 0;
 }
 
+#ifdef XML_EXPLICIT_INDEX
+/*! Update explicit search indexes when XML node is bound to yang
+ * Add list element of XML node to explicit search index if node is an index variable,
+ * and list element to key index of ordered-by user list if any.
+ * @param[in]   x      XML node, with yang spec and body
+ * @see xml_search_index_update
+ */
+static int
+xml_bind_search_index(cxobj *x)
+{
+    return xml_search_index_update(x, 1);
+}
+#endif
+
 /*! Associate XML node x with x:s parents yang:s matching child
  *
  * @param[in]   xt     XML tree node
@@ -207,10 +221,6 @@ populate_self_parent(cxobj  *xt,
     }
  set:
     xml_spec_set(xt, y);
-#ifdef XML_EXPLICIT_INDEX
-    if (xml_search_index_p(xt))
-	xml_search_child_insert(xp, xt);
-#endif
     retval = 1;
  done:
     if (cb)
@@ -325,6 +335,84 @@ populate_self_top(cxobj     *xt,
     goto done;
 }
 
+/*! Associate XML node x with the yang spec of the RPC it invokes
+ *
+ * @param[in]   x      XML node, child of <rpc>
+ * @param[in]   yspec  Yang spec
+ * @param[out]  xerr   Reason for failure, or NULL
+ * @retval      1      OK yang assignment made, input statement or rpc if no input
+ * @retval      0      yang assigment not made and xerr set
+ * @retval     -1      Error
+ * @note the input statement is assigned to the rpc level although not 100% intuitive,
+ * since binding of children need to have a parent with yang spec
+ * @see xml_bind_yang_rpc
+ */
+static int
+populate_self_rpc(cxobj     *x, 
+		  yang_stmt *yspec,
+		  cxobj    **xerr)
+{
+    int        retval = -1;
+    yang_stmt *yrpc = NULL;    /* yang node */
+    yang_stmt *ymod=NULL; /* yang module */
+    yang_stmt *yi = NULL; /* input */
+    char      *rpcname; /* RPC name */
+
+    rpcname = xml_name(x);
+    if (ys_module_by_xml(yspec, x, &ymod) < 0)
+	goto done;
+    if (ymod == NULL){
+	if (xerr &&
+	    netconf_unknown_element_xml(xerr, "application", rpcname, "Unrecognized RPC (wrong namespace?)") < 0)
+	    goto done;
+	goto fail;
+    }
+    if ((yrpc = yang_find(ymod, Y_RPC, rpcname)) == NULL){
+	if (xerr &&
+	    netconf_unknown_element_xml(xerr, "application", rpcname, "Unrecognized RPC") < 0)
+	    goto done;
+	goto fail;
+    }
+    xml_spec_set(x, yrpc); /* required for validate */
+    if ((yi = yang_find(yrpc, Y_INPUT, NULL)) != NULL)
+	xml_spec_set(x, yi); 
+    retval = 1;
+ done:
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Unrecognized parameter error of an RPC without input statement
+ *
+ * @param[in]   xc     XML node, child of RPC
+ * @param[out]  xerr   Reason for failure, or NULL
+ * @retval      0      xerr set
+ * @retval     -1      Error
+ */
+static int
+populate_rpc_noinput(cxobj  *xc,
+		     cxobj **xerr)
+{
+    int   retval = -1;
+    cbuf *cb = NULL;
+
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    cprintf(cb, "Unrecognized parameter: %s in rpc: %s", xml_name(xc), xml_name(xml_parent(xc)));
+    if (xerr &&
+	netconf_unknown_element_xml(xerr, "application", xml_name(xc), cbuf_get(cb)) < 0)
+	goto done;
+    retval = 0;
+ done:
+    if (cb)
+	cbuf_free(cb);
+    return retval;
+}
+
 /*! Find yang spec association of tree of XML nodes
  *
  * Populate xt:s children as top-level symbols
@@ -397,6 +485,10 @@ xml_bind_yang0_opt(cxobj     *xt,
     case YB_PARENT:
 	if ((ret = populate_self_parent(xt, xsibling, xerr)) < 0)
 	    goto done;
+#ifdef XML_EXPLICIT_INDEX
+	if (ret == 1 && xml_bind_search_index(xt) < 0)
+	    goto done;
+#endif
 	break;
     default:
 	clicon_err(OE_XML, EINVAL, "Invalid yang binding: %d", yb);
@@ -476,6 +568,10 @@ xml_bind_yang0(cxobj     *xt,
     case YB_PARENT:
 	if ((ret = populate_self_parent(xt, NULL, xerr)) < 0)
 	    goto done;
+#ifdef XML_EXPLICIT_INDEX
+	if (ret == 1 && xml_bind_search_index(xt) < 0)
+	    goto done;
+#endif
 	break;
     case YB_NONE:
 	ret = 1;
@@ -508,6 +604,86 @@ xml_bind_yang0(cxobj     *xt,
     goto done;
 }
 
+/*! Bind yang spec to a single XML node while it is parsed, but not its children
+ *
+ * Used by the XML scanner to bind each element when its start-tag has been parsed, ie
+ * when its parent is bound and its own namespace attributes are known. Its children are
+ * bound in the same way as they are parsed, and the binding is completed by
+ * xml_bind_yang_close() when the end-tag is parsed. The tree is bound as by xml_bind_yang0
+ * in a single pass.
+ * @param[in]   x        XML node
+ * @param[in]   yb       YB_MODULE: bind from top-level modules, YB_PARENT: bind from
+ *                       parent yang spec, YB_RPC: x is an RPC operation, child of <rpc>
+ * @param[in]   yspec    Yang spec (YB_MODULE and YB_RPC)
+ * @param[in]   xsibling Previous node with same name and yang spec to use as role model, or NULL
+ * @param[out]  xerr     Reason for failure, or NULL
+ * @retval      2        OK yang assignment not made: parent is anyxml/anydata, or x is
+ *                       treated as anydata. Children should not be bound
+ * @retval      1        OK yang assignment made
+ * @retval      0        Yang assigment not made and xerr set
+ * @retval     -1        Error
+ * @see xml_bind_yang0   Bind a complete tree
+ */
+int
+xml_bind_yang_node(cxobj     *x,
+		   yang_bind  yb,
+		   yang_stmt *yspec,
+		   cxobj     *xsibling,
+		   cxobj    **xerr)
+{
+    int        retval = -1;
+    cxobj     *xp;
+    yang_stmt *yp;
+
+    switch (yb){
+    case YB_MODULE:
+	retval = populate_self_top(x, yspec, xerr);
+	break;
+    case YB_PARENT:
+	/* RPC without input, report first element only, see xml_bind_yang_rpc */
+	if ((xp = xml_parent(x)) != NULL &&
+	    (yp = xml_spec(xp)) != NULL &&
+	    yang_keyword_get(yp) == Y_RPC){
+	    if (xml_child_i_type(xp, 0, CX_ELMNT) == x)
+		retval = populate_rpc_noinput(x, xerr);
+	    else
+		retval = 2;
+	    break;
+	}
+	retval = populate_self_parent(x, xsibling, xerr);
+	break;
+    case YB_RPC:
+	retval = populate_self_rpc(x, yspec, xerr);
+	break;
+    default:
+	clicon_err(OE_XML, EINVAL, "Invalid yang binding: %d", yb);
+	break;
+    }
+    return retval;
+}
+
+/*! Complete yang binding of an XML node when it has been parsed
+ *
+ * Strip whitespace bodies of containers and lists, and add the node to explicit search
+ * indexes, which requires its body.
+ * @param[in]   x        XML node, bound by xml_bind_yang_node (or not bound)
+ * @retval      0        OK
+ * @retval     -1        Error
+ * @see xml_bind_yang_node
+ */
+int
+xml_bind_yang_close(cxobj *x)
+{
+    if (xml_spec(x) == NULL)
+	return 0;
+    strip_whitespace(x);
+#ifdef XML_EXPLICIT_INDEX
+    if (xml_bind_search_index(x) < 0)
+	return -1;
+#endif
+    return 0;
+}
+
 /*! Find yang spec association of XML node for incoming RPC starting with <rpc>
  * 
  * Incoming RPC has an "input" structure that is not taken care of by xml_bind_yang
@@ -531,16 +707,9 @@ xml_bind_yang_rpc(cxobj     *xrpc,
 		  cxobj    **xerr)
 {
     int        retval = -1;
-    yang_stmt *yrpc = NULL;    /* yang node */
-    yang_stmt *ymod=NULL; /* yang module */
-    yang_stmt *yi = NULL; /* input */
     cxobj     *x;
     int        ret;
     char      *opname;  /* top-level netconf operation */
-    char      *rpcname; /* RPC name */
-    char      *name;
-    cbuf      *cb = NULL;
-    cxobj     *xc;
     
     opname = xml_name(xrpc);
     if ((strcmp(opname, "hello")) == 0) /* Hello: dont bind, dont appear in any yang spec  */
@@ -557,43 +726,19 @@ xml_bind_yang_rpc(cxobj     *xrpc,
     }
     x = NULL;
     while ((x = xml_child_each(xrpc, x, CX_ELMNT)) != NULL) {
-	rpcname = xml_name(x);
-	if (ys_module_by_xml(yspec, x, &ymod) < 0)
+	if ((ret = populate_self_rpc(x, yspec, xerr)) < 0)
 	    goto done;
-	if (ymod == NULL){
-	    if (xerr &&
-		netconf_unknown_element_xml(xerr, "application", rpcname, "Unrecognized RPC (wrong namespace?)") < 0)
-		goto done;
-	    goto fail;
-	}
-	if ((yrpc = yang_find(ymod, Y_RPC, rpcname)) == NULL){
-	    if (xerr &&
-		netconf_unknown_element_xml(xerr, "application", rpcname, "Unrecognized RPC") < 0)
-		goto done;
+	if (ret == 0)
 	    goto fail;
-	}
-	xml_spec_set(x, yrpc); /* required for validate */
-	if ((yi = yang_find(yrpc, Y_INPUT, NULL)) == NULL){
+	if (yang_keyword_get(xml_spec(x)) == Y_RPC){
 	    /* If no yang input spec but RPC has elements, return unknown element */
 	    if (xml_child_nr_type(x, CX_ELMNT) != 0){
-		xc = xml_child_i_type(x, 0, CX_ELMNT); /* Pick first */
-		name = xml_name(xc);
-		if ((cb = cbuf_new()) == NULL){
-		    clicon_err(OE_UNIX, errno, "cbuf_new");
-		    goto done;
-		}
-		cprintf(cb, "Unrecognized parameter: %s in rpc: %s", name, rpcname);
-		if (xerr &&
-		    netconf_unknown_element_xml(xerr, "application", name, cbuf_get(cb)) < 0)
+		if (populate_rpc_noinput(xml_child_i_type(x, 0, CX_ELMNT), xerr) < 0) /* Pick first */
 		    goto done;
 		goto fail;
 	    }
 	}
 	else{
-	    /* xml_bind_yang need to have parent with yang spec for
-	     * recursive population to work. Therefore, assign input yang
-	     * to rpc level although not 100% intuitive */
-	    xml_spec_set(x, yi); 
 	    if ((ret = xml_bind_yang(x, YB_PARENT, NULL, xerr)) < 0)
 		goto done;
 	    if (ret == 0)
@@ -603,8 +748,6 @@ xml_bind_yang_rpc(cxobj     *xrpc,
  ok:
     retval = 1;
  done:
-    if (cb)
-	cbuf_free(cb);
     return retval;
  fail:
     retval = 0;
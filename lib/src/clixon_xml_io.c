@@ -73,6 +73,7 @@
 #include "clixon_xml_sort.h"
 #include "clixon_xml_nsctx.h"
 #include "clixon_xml_parse.h"
+#include "clixon_xml_scan.h"
 #include "clixon_xml_io.h"
 
 /*
@@ -85,6 +86,10 @@
 /* Name of xml top object created by xml parse functions */
 #define XML_TOP_SYMBOL "top" 
 
+#ifdef XML_PARSE_FAST
+static int _xml_parse_fast = 0;
+#endif
+
 
 /*------------------------------------------------------------------------
  * XML printing functions. Output a parse tree to file, string cligen buf
@@ -248,38 +253,376 @@ xml_print(FILE  *f,
     return xml2file_recurse(f, x, 0, 1, fprintf);
 }
 
-/*! Print an XML tree structure to a cligen buffer and encode chars "<>&"
+/*! Check if a yang node is a leaf with a default value that can be reported virtually
+ * @param[in]  y   Yang statement
+ * @retval     1   Config leaf with default value
+ * @retval     0   Not a leaf, or no default value
+ * @see xml_default  which adds the same defaults to a tree
+ */
+static int
+xml_default_leaf(yang_stmt *y)
+{
+    return yang_keyword_get(y) == Y_LEAF &&
+	yang_config(y) &&
+	!cv_flag(yang_cv_get(y), V_UNSET);
+}
+
+/*! Check if a yang node can have child leafs with default values
+ * @param[in]  ys  Yang statement, or NULL
+ * @see xml_default
+ */
+static int
+xml_default_parent(yang_stmt *ys)
+{
+    enum rfc_6020 keyw;
+
+    if (ys == NULL)
+	return 0;
+    keyw = yang_keyword_get(ys);
+    return keyw == Y_CONTAINER || keyw == Y_LIST || keyw == Y_INPUT;
+}
+
+/*! Check if the value of a leaf is equal to its yang default value (for trim mode)
+ * @param[in]  x   XML leaf node
+ * @param[in]  y   Yang leaf with default value
+ * @retval     1   Body is equal to default
+ * @retval     0   Not equal
+ */
+static int
+xml_default_equal(cxobj     *x,
+		  yang_stmt *y)
+{
+    cg_var *cv;
+    char   *body;
+    char    buf[64];
+
+    if ((body = xml_body(x)) == NULL)
+	return 0;
+    cv = yang_cv_get(y);
+    switch (cv_type_get(cv)){
+    case CGV_STRING:
+    case CGV_REST:
+	return strcmp(body, cv_string_get(cv)) == 0;
+    default:
+	if (cv2str(cv, buf, sizeof(buf)) >= sizeof(buf)) /* truncated */
+	    return 0;
+	return strcmp(body, buf) == 0;
+    }
+}
+
+/*! Print a virtual default leaf not present in the XML tree
  *
+ * The leaf is printed with the prefix its namespace is bound to in the XML parent, or
+ * with a default namespace declaration if the namespace is not bound, as xml_default
+ * does when it adds a default leaf to a tree.
+ * @param[in,out] cb          Cligen buffer to write to
+ * @param[in]     x           XML parent
+ * @param[in]     y           Yang leaf with default value
+ * @param[in]     level       Indentation level for prettyprint
+ * @param[in]     prettyprint insert \n and spaces tomake the xml more readable.
+ */
+static int
+xml2cbuf_default(cbuf      *cb,
+		 cxobj     *x,
+		 yang_stmt *y,
+		 int        level,
+		 int        prettyprint)
+{
+    int     retval = -1;
+    cg_var *cv;
+    char   *ns;
+    char   *prefix = NULL;
+    int     ret = 1;
+    
+    if ((ns = yang_find_mynamespace(y)) != NULL &&
+	(ret = xml2prefix(x, ns, &prefix)) < 0)
+	goto done;
+    if (prettyprint)
+	cprintf(cb, "%*s<", level*XML_INDENT, "");
+    else
+	cbuf_append_str(cb, "<");
+    if (prefix){
+	cbuf_append_str(cb, prefix);
+	cbuf_append_str(cb, ":");
+    }
+    cbuf_append_str(cb, yang_argument_get(y));
+    if (ret == 0) /* Namespace not bound in the parent: declare it */
+	cprintf(cb, " xmlns=\"%s\"", ns);
+    cbuf_append_str(cb, ">");
+    cv = yang_cv_get(y);
+    switch (cv_type_get(cv)){
+    case CGV_STRING:
+    case CGV_REST:
+	if (xml_chardata_cbuf_append(cb, cv_string_get(cv)) < 0)
+	    goto done;
+	break;
+    default:
+	cv2cbuf(cv, cb);
+	break;
+    }
+    cbuf_append_str(cb, "</");
+    if (prefix){
+	cbuf_append_str(cb, prefix);
+	cbuf_append_str(cb, ":");
+    }
+    cbuf_append_str(cb, yang_argument_get(y));
+    cbuf_append_str(cb, ">");
+    if (prettyprint)
+	cbuf_append_str(cb, "\n");
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Find the case of a choice whose default values are in effect
+ *
+ * RFC 7950 Sec 7.9.3: Default values of the nodes of a case are in effect if a node of
+ * the case exists in the data tree, or if no case exists and it is the default case.
+ * @param[in]  xt    XML parent of the nodes of the choice
+ * @param[in]  ych   Yang choice statement
+ * @retval     ycase Yang case, or data node if shorthand case
+ * @retval     NULL  No case is in effect
+ */
+static yang_stmt *
+xml_default_case(cxobj     *xt,
+		 yang_stmt *ych)
+{
+    cxobj     *xc;
+    yang_stmt *y;
+    yang_stmt *yp;
+    yang_stmt *ydef;
+    char      *name;
+
+    /* Active case: the child of ych that an existing XML node is an instance of */
+    xc = NULL;
+    while ((xc = xml_child_each(xt, xc, CX_ELMNT)) != NULL) {
+	y = xml_spec(xc);
+	while (y && (yp = yang_parent_get(y)) != ych){
+	    if (yp == NULL ||
+		(yang_keyword_get(yp) != Y_CASE && yang_keyword_get(yp) != Y_CHOICE))
+		y = NULL;
+	    else
+		y = yp;
+	}
+	if (y != NULL)
+	    return y;
+    }
+    /* Default case */
+    if ((ydef = yang_find(ych, Y_DEFAULT, NULL)) == NULL)
+	return NULL;
+    name = yang_argument_get(ydef);
+    y = NULL;
+    while ((y = yn_each(ych, y)) != NULL)
+	if ((yang_keyword_get(y) == Y_CASE || yang_keyword_get(y) == Y_CHOICE ||
+	     yang_datanode(y)) &&
+	    strcmp(yang_argument_get(y), name) == 0)
+	    return y;
+    return NULL;
+}
+
+/*! Check if a virtual default leaf is to be printed
+ * @param[in]  x     XML parent
+ * @param[in]  y     Yang child of (the yang spec of) x, or of a case in effect
+ * @param[in]  dfn   Default filter function, or NULL
+ * @param[in]  darg  Argument to filter function
+ * @retval     1     Config leaf with default value, and accepted by filter
+ * @retval     0     Not a default leaf, or rejected by filter
+ * @retval    -1     Error
+ */
+static int
+xml2cbuf_default_ok(cxobj               *x,
+		    yang_stmt           *y,
+		    xml2cbuf_default_fn *dfn,
+		    void                *darg)
+{
+    if (!xml_default_leaf(y))
+	return 0;
+    if (dfn == NULL)
+	return 1;
+    return dfn(x, y, darg);
+}
+
+/*! Print virtual default leafs of the case in effect of a choice, if not in the XML tree
+ * @param[in,out] cb          Cligen buffer to write to, if NULL only count
+ * @param[in]     x           XML parent
+ * @param[in]     ych         Yang choice, child of yang spec of x or of a case
+ * @param[in]     level       Indentation level for prettyprint
+ * @param[in]     prettyprint insert \n and spaces tomake the xml more readable.
+ * @param[in]     dfn         Default filter function, or NULL
+ * @param[in]     darg        Argument to filter function
+ * @retval        n           Number of default leafs (printed)
+ * @retval       -1           Error
+ * @see xml_default_case
+ */
+static int
+xml2cbuf_choice_defaults(cbuf                *cb,
+			 cxobj               *x,
+			 yang_stmt           *ych,
+			 int                  level,
+			 int                  prettyprint,
+			 xml2cbuf_default_fn *dfn,
+			 void                *darg)
+{
+    int        retval = -1;
+    yang_stmt *ycase;
+    yang_stmt *y;
+    int        n = 0;
+    int        ret;
+
+    if ((ycase = xml_default_case(x, ych)) == NULL)
+	goto ok;
+    /* Iterate the nodes of the case, or the shorthand case node itself */
+    if (yang_keyword_get(ycase) == Y_CASE)
+	y = yn_each(ycase, NULL);
+    else
+	y = ycase;
+    for (; y != NULL; y = yang_keyword_get(ycase)==Y_CASE?yn_each(ycase, y):NULL){
+	if (yang_keyword_get(y) == Y_CHOICE){
+	    if ((ret = xml2cbuf_choice_defaults(cb, x, y, level, prettyprint, dfn, darg)) < 0)
+		goto done;
+	    n += ret;
+	}
+	else if (xml_find(x, yang_argument_get(y)) == NULL){
+	    if ((ret = xml2cbuf_default_ok(x, y, dfn, darg)) < 0)
+		goto done;
+	    if (ret == 0)
+		continue;
+	    if (cb && xml2cbuf_default(cb, x, y, level, prettyprint) < 0)
+		goto done;
+	    n++;
+	}
+    }
+ ok:
+    retval = n;
+ done:
+    return retval;
+}
+
+/*! Print virtual default leafs of ys that appear before yang node yuntil
+ *
+ * The yang children of ys are iterated from (but not including) ycur until yuntil, and
+ * every default leaf found on the way is printed, including those of choices.
+ * @param[in,out] cb          Cligen buffer to write to
+ * @param[in]     x           XML parent
+ * @param[in]     ys          Yang spec of XML parent
+ * @param[in]     ycur        Current position among yang children of ys (NULL: first)
+ * @param[in]     yuntil      Stop at this yang child (NULL: print remaining)
+ * @param[in]     level       Indentation level for prettyprint
+ * @param[in]     prettyprint insert \n and spaces tomake the xml more readable.
+ * @param[in]     dfn         Default filter function, or NULL
+ * @param[in]     darg        Argument to filter function
+ */
+static int
+xml2cbuf_defaults(cbuf                *cb,
+		  cxobj               *x,
+		  yang_stmt           *ys,
+		  yang_stmt           *ycur,
+		  yang_stmt           *yuntil,
+		  int                  level,
+		  int                  prettyprint,
+		  xml2cbuf_default_fn *dfn,
+		  void                *darg)
+{
+    int        retval = -1;
+    yang_stmt *y;
+    int        ret;
+
+    y = ycur;
+    while ((y = yn_each(ys, y)) != NULL && y != yuntil){
+	if (yang_keyword_get(y) == Y_CHOICE){
+	    if (xml2cbuf_choice_defaults(cb, x, y, level, prettyprint, dfn, darg) < 0)
+		goto done;
+	}
+	else {
+	    if ((ret = xml2cbuf_default_ok(x, y, dfn, darg)) < 0)
+		goto done;
+	    if (ret && xml2cbuf_default(cb, x, y, level, prettyprint) < 0)
+		goto done;
+	}
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Find the yang child of ys that an XML child with yang spec yc is an instance of
+ * Skip choice and case nodes.
+ * @param[in]  ys  Yang spec of XML parent
+ * @param[in]  yc  Yang spec of XML child
+ * @retval     y   Yang child of ys, or NULL if yc is not a (schema) descendant of ys
+ */
+static yang_stmt *
+xml_default_ychild(yang_stmt *ys,
+		   yang_stmt *yc)
+{
+    yang_stmt *yp;
+    
+    while (yc && (yp = yang_parent_get(yc)) != ys){
+	if (yp == NULL ||
+	    (yang_keyword_get(yp) != Y_CASE && yang_keyword_get(yp) != Y_CHOICE))
+	    return NULL;
+	yc = yp;
+    }
+    return yc;
+}
+
+/*! Check if yang node ytarget follows ycur among the children of ys
+ * @param[in]  ys       Yang parent
+ * @param[in]  ycur     Current yang child (NULL means before first)
+ * @param[in]  ytarget  Yang child to find
+ */
+static int
+xml_default_ahead(yang_stmt *ys,
+		  yang_stmt *ycur,
+		  yang_stmt *ytarget)
+{
+    yang_stmt *y = ycur;
+    
+    while ((y = yn_each(ys, y)) != NULL)
+	if (y == ytarget)
+	    return 1;
+    return 0;
+}
+
+/*! Print an XML tree to a cligen buffer with RFC 6243 with-defaults handling
+ *
+ * Default values are not stored in the tree but resolved from the YANG spec when
+ * serializing: missing default leafs are printed in yang order in report-all mode.
+ * XML children are assumed to be sorted in yang order, as in datastore trees.
  * @param[in,out] cb          Cligen buffer to write to
  * @param[in]     xn          Clicon xml tree
  * @param[in]     level       Indentation level for prettyprint
  * @param[in]     prettyprint insert \n and spaces tomake the xml more readable.
  * @param[in]     depth       Limit levels of child resources: -1 is all, 0 is none, 1 is node itself
- *
- * @code
- * cbuf *cb;
- * cb = cbuf_new();
- * if (clicon_xml2cbuf(cb, xn, 0, 1, -1) < 0)
- *   goto err;
- * fprintf(stderr, "%s", cbuf_get(cb));
- * cbuf_free(cb);
- * @endcode
- * @see  clicon_xml2file
+ * @param[in]     wdef        With-defaults mode
+ * @param[in]     fn          Flush function called after each child element, or NULL
+ * @param[in]     arg         Argument to flush function
+ * @param[in]     dfn         Filter of virtual default leafs, or NULL
+ * @param[in]     darg        Argument to filter function
  */
-int
-clicon_xml2cbuf(cbuf   *cb, 
-		cxobj  *x, 
-		int     level,
-		int     prettyprint,
-		int32_t depth)
+static int
+xml2cbuf_recurse(cbuf                *cb, 
+		 cxobj               *x, 
+		 int                  level,
+		 int                  prettyprint,
+		 int32_t              depth,
+		 withdefaults_type    wdef,
+		 xml2cbuf_flush_fn   *fn,
+		 void                *arg,
+		 xml2cbuf_default_fn *dfn,
+		 void                *darg)
 {
-    int    retval = -1;
-    cxobj *xc;
-    char  *name;
-    int    hasbody;
-    int    haselement;
-    char  *namespace;
-    char  *val;
+    int        retval = -1;
+    cxobj     *xc;
+    char      *name;
+    int        hasbody;
+    int        haselement;
+    char      *namespace;
+    char      *val;
+    yang_stmt *ys = NULL;
+    yang_stmt *yc;
+    yang_stmt *ycur = NULL;  /* Current yang child of ys when printing defaults */
+    int        defaults = 0; /* Print virtual default children */
     
     if (depth == 0)
 	goto ok;
@@ -310,6 +653,10 @@ clicon_xml2cbuf(cbuf   *cb,
 	    cbuf_append_str(cb, ":");
 	}
 	cbuf_append_str(cb, name);
+	if (wdef != WITHDEFAULTS_EXPLICIT && depth != 1){
+	    ys = xml_spec(x);
+	    defaults = xml_default_parent(ys);
+	}
 	hasbody = 0;
 	haselement = 0;
 	xc = NULL;
@@ -317,7 +664,7 @@ clicon_xml2cbuf(cbuf   *cb,
 	while ((xc = xml_child_each(x, xc, -1)) != NULL) 
 	    switch (xml_type(xc)){
 	    case CX_ATTR:
-		if (clicon_xml2cbuf(cb, xc, level+1, prettyprint, -1) < 0)
+		if (xml2cbuf_recurse(cb, xc, level+1, prettyprint, -1, wdef, NULL, NULL, NULL, NULL) < 0)
 		    goto done;
 		break;
 	    case CX_BODY:
@@ -329,6 +676,20 @@ clicon_xml2cbuf(cbuf   *cb,
 	    default:
 		break;
 	    }
+	/* Only virtual default children, if any */
+	if (haselement == 0 && defaults && wdef == WITHDEFAULTS_REPORT_ALL){
+	    yc = NULL;
+	    while ((yc = yn_each(ys, yc)) != NULL){
+		if (yang_keyword_get(yc) == Y_CHOICE)
+		    haselement = xml2cbuf_choice_defaults(NULL, x, yc, 0, 0, dfn, darg);
+		else
+		    haselement = xml2cbuf_default_ok(x, yc, dfn, darg);
+		if (haselement < 0)
+		    goto done;
+		if (haselement)
+		    break;
+	    }
+	}
 	/* Check for special case <a/> instead of <a></a> */
 	if (hasbody==0 && haselement==0) 
 	    cbuf_append_str(cb, "/>");
@@ -337,10 +698,39 @@ clicon_xml2cbuf(cbuf   *cb,
 	    if (prettyprint && hasbody == 0)
 		cbuf_append_str(cb, "\n");
 	    xc = NULL;
-	    while ((xc = xml_child_each(x, xc, -1)) != NULL) 
-		if (xml_type(xc) != CX_ATTR)
-		    if (clicon_xml2cbuf(cb, xc, level+1, prettyprint, depth-1) < 0)
-			goto done;
+	    while ((xc = xml_child_each(x, xc, -1)) != NULL) {
+		if (xml_type(xc) == CX_ATTR)
+		    continue;
+		if (defaults && xml_type(xc) == CX_ELMNT &&
+		    (yc = xml_default_ychild(ys, xml_spec(xc))) != NULL){
+		    if (wdef == WITHDEFAULTS_TRIM && xml_default_leaf(xml_spec(xc)) &&
+			xml_default_equal(xc, xml_spec(xc)))
+			continue; /* trim: skip leafs with default value */
+		    if (yc != ycur && xml_default_ahead(ys, ycur, yc)){
+			/* report-all: print missing default leafs preceding xc */
+			if (wdef == WITHDEFAULTS_REPORT_ALL){
+			    if (xml2cbuf_defaults(cb, x, ys, ycur, yc, level+1, prettyprint,
+						  dfn, darg) < 0)
+				goto done;
+			    /* and of the case of xc if a choice */
+			    if (yang_keyword_get(yc) == Y_CHOICE &&
+				xml2cbuf_choice_defaults(cb, x, yc, level+1, prettyprint,
+							     dfn, darg) < 0)
+				goto done;
+			}
+			ycur = yc;
+		    }
+		}
+		if (xml2cbuf_recurse(cb, xc, level+1, prettyprint, depth-1, wdef, fn, arg,
+				     dfn, darg) < 0)
+		    goto done;
+		if (fn && fn(cb, arg) < 0)
+		    goto done;
+	    }
+	    /* report-all: print remaining missing default leafs */
+	    if (defaults && wdef == WITHDEFAULTS_REPORT_ALL &&
+		xml2cbuf_defaults(cb, x, ys, ycur, NULL, level+1, prettyprint, dfn, darg) < 0)
+		goto done;
 	    if (prettyprint && hasbody == 0)
 		cprintf(cb, "%*s", level*XML_INDENT, "");
 	    cbuf_append_str(cb, "</");
@@ -363,6 +753,213 @@ clicon_xml2cbuf(cbuf   *cb,
     return retval;
 }
 
+/*! Print an XML tree structure to a cligen buffer and encode chars "<>&"
+ *
+ * @param[in,out] cb          Cligen buffer to write to
+ * @param[in]     xn          Clicon xml tree
+ * @param[in]     level       Indentation level for prettyprint
+ * @param[in]     prettyprint insert \n and spaces tomake the xml more readable.
+ * @param[in]     depth       Limit levels of child resources: -1 is all, 0 is none, 1 is node itself
+ *
+ * @code
+ * cbuf *cb;
+ * cb = cbuf_new();
+ * if (clicon_xml2cbuf(cb, xn, 0, 1, -1) < 0)
+ *   goto err;
+ * fprintf(stderr, "%s", cbuf_get(cb));
+ * cbuf_free(cb);
+ * @endcode
+ * @see  clicon_xml2file
+ * @see  clicon_xml2cbuf_wdef  with default values resolved from YANG
+ */
+int
+clicon_xml2cbuf(cbuf   *cb, 
+		cxobj  *x, 
+		int     level,
+		int     prettyprint,
+		int32_t depth)
+{
+    return xml2cbuf_recurse(cb, x, level, prettyprint, depth, WITHDEFAULTS_EXPLICIT,
+			    NULL, NULL, NULL, NULL);
+}
+
+/*! Print an XML tree to a cligen buffer and report default values as in RFC 6243
+ *
+ * Default leafs need not be added to the tree with xml_default_recurse, instead they are
+ * resolved from the YANG spec while printing.
+ * @param[in,out] cb          Cligen buffer to write to
+ * @param[in]     xn          Clicon xml tree
+ * @param[in]     level       Indentation level for prettyprint
+ * @param[in]     prettyprint insert \n and spaces tomake the xml more readable.
+ * @param[in]     depth       Limit levels of child resources: -1 is all, 0 is none, 1 is node itself
+ * @param[in]     wdef        With-defaults mode: report-all, trim or explicit
+ * @param[in]     fn          Flush function called after each element, or NULL, see below
+ * @param[in]     arg         Argument to flush function
+ * @param[in]     dfn         Filter of virtual default leafs, or NULL to print all
+ * @param[in]     darg        Argument to filter function
+ * If fn is given, the output is streamed: fn is called after every printed element and
+ * may consume (eg send) and reset the cbuf, so that the whole tree is never kept as text.
+ * @note  Only config leafs are reported. XML children should be sorted in yang order.
+ * @see  clicon_xml2cbuf
+ */
+int
+clicon_xml2cbuf_wdef(cbuf                *cb, 
+		     cxobj               *x, 
+		     int                  level,
+		     int                  prettyprint,
+		     int32_t              depth,
+		     withdefaults_type    wdef,
+		     xml2cbuf_flush_fn   *fn,
+		     void                *arg,
+		     xml2cbuf_default_fn *dfn,
+		     void                *darg)
+{
+    return xml2cbuf_recurse(cb, x, level, prettyprint, depth, wdef, fn, arg, dfn, darg);
+}
+
+/*! Check if an XML element is to be printed as part of a marked tree
+ * @param[in]  x     XML element
+ * @param[in]  ys    Yang spec of parent of x, or NULL
+ * @retval     1     Marked, ancestor of marked, or key of a list that is ancestor of marked
+ * @retval     0     Not to be printed
+ */
+static int
+xml2cbuf_marked_child(cxobj     *x,
+		      yang_stmt *ys)
+{
+    if (xml_flag(x, XML_FLAG_MARK|XML_FLAG_SUBMARK))
+	return 1;
+    return ys != NULL && yang_keyword_get(ys) == Y_LIST &&
+	yang_key_match(ys, xml_name(x)) == 1;
+}
+
+/*! Print marked sub-trees of an XML tree with their ancestors, see clicon_xml2cbuf_marked
+ * @param[in,out] cb     Cligen buffer to write to
+ * @param[in]     x      XML element flagged with XML_FLAG_SUBMARK (or list key)
+ * @param[in]     name   Name to print instead of name of x, or NULL
+ * @param[in]     depth  Limit levels of child resources: -1 is all, 0 is none, 1 is node itself
+ * @param[in]     wdef   With-defaults mode of marked sub-trees
+ * @param[in]     fn     Flush function called after each element, or NULL
+ * @param[in]     arg    Argument to flush function
+ */
+static int
+xml2cbuf_marked_recurse(cbuf              *cb, 
+			cxobj             *x,
+			const char        *name,
+			int32_t            depth,
+			withdefaults_type  wdef,
+			xml2cbuf_flush_fn *fn,
+			void              *arg)
+{
+    int        retval = -1;
+    cxobj     *xc;
+    yang_stmt *ys;
+    char      *prefix;
+    int        haschild = 0;
+    
+    if (depth == 0)
+	goto ok;
+    ys = xml_spec(x);
+    if (name == NULL){
+	if (xml_flag(x, XML_FLAG_MARK))
+	    return xml2cbuf_recurse(cb, x, 0, 0, depth, wdef, fn, arg, NULL, NULL);
+	if (!xml_flag(x, XML_FLAG_SUBMARK)) /* key of ancestor list entry */
+	    return xml2cbuf_recurse(cb, x, 0, 0, depth, WITHDEFAULTS_EXPLICIT,
+				    NULL, NULL, NULL, NULL);
+    }
+    cbuf_append_str(cb, "<");
+    if (name == NULL){
+	if ((prefix = xml_prefix(x)) != NULL){
+	    cbuf_append_str(cb, prefix);
+	    cbuf_append_str(cb, ":");
+	}
+	cbuf_append_str(cb, xml_name(x));
+    }
+    else
+	cbuf_append_str(cb, (char*)name);
+    xc = NULL;
+    while ((xc = xml_child_each(x, xc, CX_ATTR)) != NULL)
+	if (xml2cbuf_recurse(cb, xc, 0, 0, -1, WITHDEFAULTS_EXPLICIT, NULL, NULL, NULL, NULL) < 0)
+	    goto done;
+    if (depth != 1){ /* A marked top prints all children */
+	xc = NULL;
+	while ((xc = xml_child_each(x, xc, CX_ELMNT)) != NULL){
+	    if (!xml_flag(x, XML_FLAG_MARK) && !xml2cbuf_marked_child(xc, ys))
+		continue;
+	    if (!haschild){
+		cbuf_append_str(cb, ">");
+		haschild++;
+	    }
+	    if (xml_flag(x, XML_FLAG_MARK)){
+		if (xml2cbuf_recurse(cb, xc, 0, 0, depth-1, wdef, fn, arg, NULL, NULL) < 0)
+		    goto done;
+	    }
+	    else if (xml2cbuf_marked_recurse(cb, xc, NULL, depth-1, wdef, fn, arg) < 0)
+		goto done;
+	    if (fn && fn(cb, arg) < 0)
+		goto done;
+	}
+    }
+    if (!haschild)
+	cbuf_append_str(cb, "/>");
+    else{
+	cbuf_append_str(cb, "</");
+	if (name == NULL){
+	    if ((prefix = xml_prefix(x)) != NULL){
+		cbuf_append_str(cb, prefix);
+		cbuf_append_str(cb, ":");
+	    }
+	    cbuf_append_str(cb, xml_name(x));
+	}
+	else
+	    cbuf_append_str(cb, (char*)name);
+	cbuf_append_str(cb, ">");
+    }
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Print the marked parts of an XML tree without copying or pruning it
+ *
+ * Print the sub-trees flagged with XML_FLAG_MARK (eg matches of an xpath) and their ancestors
+ * flagged with XML_FLAG_SUBMARK, including the keys of ancestor list entries.
+ * This is a read-only visitor that can be used directly on a shared tree, such as a datastore
+ * snapshot, instead of first copying the tree and pruning it.
+ * Default values are reported as defined by wdef in marked sub-trees only, not in ancestors.
+ * @param[in,out] cb     Cligen buffer to write to
+ * @param[in]     xt     Top of XML tree
+ * @param[in]     name   Print top node with this name instead, eg "data", or NULL
+ * @param[in]     depth  Limit levels of child resources: -1 is all, 0 is none, 1 is node itself
+ * @param[in]     wdef   With-defaults mode
+ * @param[in]     fn     Flush function for streaming, or NULL, see clicon_xml2cbuf_wdef
+ * @param[in]     arg    Argument to flush function
+ * @code
+ *   for (i=0; i<xlen; i++){
+ *      xml_flag_set(xvec[i], XML_FLAG_MARK);
+ *      xml_apply_ancestor(xvec[i], (xml_applyfn_t*)xml_flag_set, (void*)XML_FLAG_SUBMARK);
+ *   }
+ *   clicon_xml2cbuf_marked(cb, xt, "data", -1, WITHDEFAULTS_EXPLICIT, NULL, NULL);
+ *   xml_flag_epoch_next(); # clear marks
+ * @endcode
+ * @note Top node is always printed, as an empty element if nothing is marked
+ * @see xml_tree_prune_flagged_sub  which removes all non-marked nodes
+ */
+int
+clicon_xml2cbuf_marked(cbuf              *cb, 
+		       cxobj             *xt,
+		       const char        *name,
+		       int32_t            depth,
+		       withdefaults_type  wdef,
+		       xml2cbuf_flush_fn *fn,
+		       void              *arg)
+{
+    if (name == NULL)
+	name = xml_name(xt);
+    return xml2cbuf_marked_recurse(cb, xt, name, depth, wdef, fn, arg);
+}
+
 /*! Return an xml tree as a pretty-printed malloced string.
  * @param[in]  x    XML tree
  * @retval     str  Malloced pretty-printed string (should be free:d after use)
@@ -429,6 +1026,42 @@ xmltree2cbuf(cbuf  *cb,
 /*--------------------------------------------------------------------
  * XML parsing functions. Create XML parse tree from string and file.
  *--------------------------------------------------------------------*/
+/*! Enable or disable the hand-written XML scanner
+ * If disabled, the flex/bison XML parser is used, which is the default.
+ * Set from the CLICON_XML_PARSE_FAST option, since there is no handle in xml parse functions
+ * @param[in]  enable  0: use flex/bison parser, 1: use fast scanner (if compiled in)
+ * @see XML_PARSE_FAST
+ */
+int
+clixon_xml_parse_fast_set(int enable)
+{
+#ifdef XML_PARSE_FAST
+    _xml_parse_fast = enable;
+#endif
+    return 0;
+}
+
+/*! Input is trusted to be sorted: bind yang and check the order, but sort only if wrong
+ * @see clixon_xml_parse_sorted_set
+ */
+static int _xml_parse_sorted = 0;
+
+/*! Trust (or not) XML input to be sorted in canonical order when parsing
+ *
+ * Used when reading datastore files written by clixon, where the yang binding is the same
+ * as when the file was written. The input is not blindly trusted: the order of each node
+ * is checked with its preceding sibling while scanning, and if a node is out of order, eg
+ * in a file edited by hand, the rest of the input is sorted.
+ * @param[in] sorted  1: only check order while parsing, 0: sort (default)
+ * @retval    0       OK
+ */
+int
+clixon_xml_parse_sorted_set(int sorted)
+{
+    _xml_parse_sorted = sorted;
+    return 0;
+}
+
 /*! Common internal xml parsing function string to parse-tree
  *
  * Given a string containing XML, parse into existing XML tree and return
@@ -473,6 +1106,17 @@ _xml_parse(const char *str,
     xy.xy_xtop = xt;
     xy.xy_xparent = xt;
     xy.xy_yspec = yspec;
+#ifdef XML_PARSE_FAST
+    /* Yang is bound and sorted by the scanner in the same pass */
+    if (_xml_parse_fast){
+	if ((ret = clixon_xml_scan(xy.xy_parse_string, yb, yspec, _xml_parse_sorted, xt, xerr)) < 0)
+	    goto done;
+	if (ret == 0)
+	    goto fail;
+	retval = 1;
+	goto done;
+    }
+#endif
     if (clixon_xml_parsel_init(&xy) < 0)
 	goto done;    
     if (clixon_xml_parseparse(&xy) != 0)  /* yacc returns 1 on error */
@@ -534,13 +1178,15 @@ _xml_parse(const char *str,
     if (failed)
 	goto fail;
     /* Sort the complete tree after parsing. Sorting is not really meaningful if Yang
-       not bound */
+       not bound. Also input trusted to be sorted is verified, only nodes that are out of
+       order are sorted */
     if (yb != YB_NONE)
 	if (xml_sort_recurse(xt) < 0)
 	    goto done;
     retval = 1;
   done:
-    clixon_xml_parsel_exit(&xy);
+    if (xy.xy_lexbuf)
+	clixon_xml_parsel_exit(&xy);
     if (xy.xy_parse_string != NULL)
 	free(xy.xy_parse_string);
     if (xy.xy_xvec)
@@ -770,3 +1416,156 @@ clixon_xml_parse_va(yang_bind   yb,
     return retval;
 }
 
+/*! Incremental XML parser state
+ * @see clixon_xml_push_new
+ */
+struct clixon_xml_push {
+    yang_bind  xp_yb;     /* How to bind yang to XML top-level */
+    yang_stmt *xp_yspec;  /* Yang specification */
+    cxobj     *xp_xt;     /* Top of XML parse tree */
+    cxobj     *xp_xerr;   /* Reason for yang binding failure */
+#ifdef XML_PARSE_FAST
+    xml_scan  *xp_scan;   /* XML scanner, builds tree as input arrives */
+#endif
+    cbuf      *xp_cb;     /* Input buffer for flex/bison parser */
+};
+
+/*! Create an incremental XML parser where input is pushed in chunks as it arrives
+ *
+ * With the fast XML scanner, the XML tree is built and bound to yang while input
+ * arrives, so that parsing overlaps with I/O and complete input is never buffered.
+ * Otherwise input is buffered and parsed when it ends.
+ * @param[in]  yb    How to bind yang to XML top-level when parsing
+ * @param[in]  yspec Yang specification, or NULL
+ * @retval     xp    Incremental XML parser, free with clixon_xml_push_free
+ * @retval     NULL  Error
+ * @code
+ *  clixon_xml_push *xp;
+ *  cxobj           *xt = NULL;
+ *
+ *  if ((xp = clixon_xml_push_new(YB_MODULE, yspec)) == NULL)
+ *    err;
+ *  while ((len = read(s, buf, sizeof(buf))) > 0)
+ *    if (clixon_xml_push_data(xp, buf, len) < 0)
+ *      err;
+ *  if (clixon_xml_push_end(xp, &xt, NULL) < 0)
+ *    err;
+ *  clixon_xml_push_free(xp);
+ * @endcode
+ * @see clixon_xml_parse_string  Parse complete input
+ */
+clixon_xml_push *
+clixon_xml_push_new(yang_bind  yb,
+		    yang_stmt *yspec)
+{
+    clixon_xml_push *xp = NULL;
+
+    if (yb == YB_MODULE && yspec == NULL){
+	clicon_err(OE_XML, EINVAL, "yspec is required if yb == YB_MODULE");
+	goto err;
+    }
+    if ((xp = malloc(sizeof(*xp))) == NULL){
+	clicon_err(OE_XML, errno, "malloc");
+	goto err;
+    }
+    memset(xp, 0, sizeof(*xp));
+    xp->xp_yb = yb;
+    xp->xp_yspec = yspec;
+    if ((xp->xp_xt = xml_new(XML_TOP_SYMBOL, NULL, CX_ELMNT)) == NULL)
+	goto err;
+#ifdef XML_PARSE_FAST
+    if (_xml_parse_fast){
+	if ((xp->xp_scan = clixon_xml_scan_new(yb, yspec, _xml_parse_sorted, xp->xp_xt, &xp->xp_xerr)) == NULL)
+	    goto err;
+	return xp;
+    }
+#endif
+    if ((xp->xp_cb = cbuf_new()) == NULL){
+	clicon_err(OE_XML, errno, "cbuf_new");
+	goto err;
+    }
+    return xp;
+ err:
+    if (xp)
+	clixon_xml_push_free(xp);
+    return NULL;
+}
+
+/*! Push a chunk of XML input to incremental XML parser
+ * @param[in]  xp    Incremental XML parser
+ * @param[in]  buf   Chunk of input, not NUL-terminated. May not contain NUL characters
+ * @param[in]  len   Length of buf
+ * @retval     0     OK
+ * @retval    -1     Error with clicon_err called. Includes parse error
+ */
+int
+clixon_xml_push_data(clixon_xml_push *xp,
+		     const char      *buf,
+		     size_t           len)
+{
+#ifdef XML_PARSE_FAST
+    if (xp->xp_scan)
+	return clixon_xml_scan_push(xp->xp_scan, buf, len);
+#endif
+    if (cbuf_append_buf(xp->xp_cb, (void*)buf, len) < 0){
+	clicon_err(OE_XML, errno, "cbuf_append_buf");
+	return -1;
+    }
+    return 0;
+}
+
+/*! End of XML input to incremental XML parser, get XML tree
+ * @param[in]  xp    Incremental XML parser
+ * @param[out] xt    XML parse tree with top element 'top'. Call xml_free() after use
+ * @param[out] xerr  Reason for failure (yang assignment not made), or NULL
+ * @retval     1     Parse OK and all yang assignment made
+ * @retval     0     Parse OK but yang assigment not made (or only partial) and xerr set
+ * @retval    -1     Error with clicon_err called. Includes parse error
+ * @note The parser cannot be used again after this call, only freed
+ */
+int
+clixon_xml_push_end(clixon_xml_push *xp,
+		    cxobj          **xt,
+		    cxobj          **xerr)
+{
+    int retval = -1;
+    
+#ifdef XML_PARSE_FAST
+    if (xp->xp_scan){
+	if ((retval = clixon_xml_scan_end(xp->xp_scan)) < 0)
+	    goto done;
+    }
+    else
+#endif
+    if ((retval = _xml_parse(cbuf_get(xp->xp_cb), xp->xp_yb, xp->xp_yspec,
+			     xp->xp_xt, &xp->xp_xerr)) < 0)
+	goto done;
+    *xt = xp->xp_xt;
+    xp->xp_xt = NULL;
+    if (xerr){
+	*xerr = xp->xp_xerr;
+	xp->xp_xerr = NULL;
+    }
+ done:
+    return retval;
+}
+
+/*! Free incremental XML parser, and XML tree if not returned by clixon_xml_push_end
+ * @param[in]  xp    Incremental XML parser
+ */
+int
+clixon_xml_push_free(clixon_xml_push *xp)
+{
+#ifdef XML_PARSE_FAST
+    if (xp->xp_scan)
+	clixon_xml_scan_free(xp->xp_scan);
+#endif
+    if (xp->xp_cb)
+	cbuf_free(xp->xp_cb);
+    if (xp->xp_xerr)
+	xml_free(xp->xp_xerr);
+    if (xp->xp_xt)
+	xml_free(xp->xp_xt);
+    free(xp);
+    return 0;
+}
@@ -75,6 +75,7 @@
 #include "clixon_log.h"
 #include "clixon_err.h"
 #include "clixon_netconf_lib.h"
+#include "clixon_xml_vec.h"
 #include "clixon_xml_sort.h"
 #include "clixon_yang_type.h"
 #include "clixon_xml_map.h"
@@ -888,6 +889,69 @@ xml_tree_prune_flagged(cxobj *xt,
     return retval;
 }
 
+/*! Prune all elements below a given depth, except keys of list entries
+ * @param[in]   xt      XML tree
+ * @param[in]   depth   Nr of levels to keep below xt: -1 is all, 0 is none (only xt itself)
+ * Keys of list entries at the last level are kept, so that the entries can be identified
+ * (eg by xpath predicates), as well as bodies of leafs.
+ * Nodes below depth marked with XML_FLAG_MARK, eg xpath matches, are kept with their leafs,
+ * and so are their ancestors marked with XML_FLAG_SUBMARK with their keys. An xpath whose
+ * predicates refer to keys of ancestors or leafs of matched nodes then matches the same
+ * nodes in the pruned tree.
+ * @code
+ *    xml_tree_prune_depth(xt, 1);  # Keep only children of xt
+ * @endcode
+ */
+int
+xml_tree_prune_depth(cxobj  *xt, 
+		     int32_t depth)
+{
+    int        retval = -1;
+    cxobj     *x;
+    cxobj     *xprev;
+    yang_stmt *yt;
+    yang_stmt *y;
+    int        marked;
+
+    if (depth < 0)
+	goto ok;
+    yt = xml_spec(xt);
+    marked = xml_flag(xt, XML_FLAG_MARK);
+    x = NULL;
+    xprev = NULL;
+    while ((x = xml_child_each(xt, x, CX_ELMNT)) != NULL) {
+	if (depth == 0){
+	    if (xml_flag(x, XML_FLAG_MARK|XML_FLAG_SUBMARK)){
+		if (xml_tree_prune_depth(x, 0) < 0)
+		    goto done;
+		xprev = x;
+		continue;
+	    }
+	    if (marked && (y = xml_spec(x)) != NULL &&
+		(yang_keyword_get(y) == Y_LEAF || yang_keyword_get(y) == Y_LEAF_LIST)){
+		xprev = x;
+		continue;
+	    }
+	    if (yt && yang_keyword_get(yt) == Y_LIST &&
+		yang_key_match(yt, xml_name(x)) == 1){
+		xprev = x;
+		continue;
+	    }
+	    if (xml_purge(x) < 0)
+		goto done;
+	    x = xprev;
+	    continue; 
+	}
+	if (xml_tree_prune_depth(x, depth-1) < 0)
+	    goto done;
+	xprev = x;
+    }
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*! Add prefix:namespace pair to xml node, set cache, etc
  * @param[in]  x         XML node whose namespace should change
  * @param[in]  xp        XML node where namespace attribute should be declared (can be same)
@@ -1469,6 +1533,7 @@ assign_namespace_body(cxobj *x0, /* source */
  * @param[in]  x0  Base xml tree (can be NULL in add scenarios)
  * @param[in]  y0  Yang spec corresponding to xml-node x0. NULL if x0 is NULL
  * @param[in]  x0p Parent of x0
+ * @param[in]  x0new If set, a moved x1 is added here instead of inserted in x0p, see xml_insert_vec
  * @param[in]  x1  xml tree which modifies base
  * @param[out] reason If retval=0 a malloced string
  * @retval     1      OK
@@ -1480,6 +1545,7 @@ static int
 xml_merge1(cxobj              *x0,  /* the target */
 	   yang_stmt          *y0,
 	   cxobj              *x0p,
+	   clixon_xvec        *x0new,
 	   cxobj              *x1,  /* the source */
 	   char              **reason)
 {
@@ -1495,6 +1561,9 @@ xml_merge1(cxobj              *x0,  /* the target */
     int        i;
     merge_twophase *twophase = NULL;
     int twophase_len;
+    clixon_xvec *x0cnew = NULL; /* New children of x0 */
+    int        cursor = 0; /* Position in x0 children, see match_base_child_sorted */
+    cxobj     *x1prev = NULL;
     
     assert(x1 && xml_type(x1) == CX_ELMNT);
     assert(y0);
@@ -1512,15 +1581,20 @@ xml_merge1(cxobj              *x0,  /* the target */
             if (xml_addsub(x0p, x1) < 0)
                 goto done;
         }
-        else
+        else if (x0new){
+	    if (clixon_xvec_append(x0new, x1) < 0)
+		goto done;
+	}
+	else
 	    if (xml_insert(x0p, x1, INS_LAST, NULL, NULL) < 0)
 		goto done;
 	cv = NULL;
 	while ((cv = cvec_each(nsc, cv)) != NULL){
 	    px = cv_name_get(cv);
 	    ns = cv_string_get(cv);
-	    /* Check if it exists */
-	    if (xml2prefix(x1, ns, NULL) == 0)
+	    /* Check if it exists, x1 may not yet be inserted in x0p */
+	    if (xml2prefix(x1, ns, NULL) == 0 &&
+		(xml_parent(x1) != NULL || xml2prefix(x0p, ns, NULL) == 0))
 		if (xmlns_set(x1, px, ns) < 0)
 		    goto done;
 	}
@@ -1574,7 +1648,7 @@ xml_merge1(cxobj              *x0,  /* the target */
 	    }
 	    /* See if there is a corresponding node in the base tree */
 	    x0c = NULL;
-	    if (yc && match_base_child(x0, x1c, yc, &x0c) < 0)
+	    if (yc && match_base_child_sorted(x0, x1c, yc, &cursor, &x1prev, &x0c) < 0)
 		goto done;
 	    /* Save x0c, x1c, yc and merge in second wave, so that x1c entries dont "interfer"
 	     * with itself, ie that later searches are among earlier objects already added
@@ -1586,18 +1660,30 @@ xml_merge1(cxobj              *x0,  /* the target */
 	} /* while */
 	twophase_len = i; /* Inital length included non-elements */
 	/* Second run where actual merging is done 
-	 * Loop through children of the modification tree */
+	 * Loop through children of the modification tree
+	 * New children are collected in x0cnew and inserted together after the loop
+	 */
+	if (twophase_len > 1 && (x0cnew = clixon_xvec_new()) == NULL)
+	    goto done;
 	for (i=0; i<twophase_len; i++){
 	    assert(twophase[i].mt_x1c);
 	    if ((ret = xml_merge1(twophase[i].mt_x0c,
 			   twophase[i].mt_yc,
 			   x0,
+			   x0cnew,
 			   twophase[i].mt_x1c,
 				  reason)) < 0)
 		goto done;
 	    if (ret == 0)
 		goto fail;
 	}
+	if (x0cnew){
+	    ret = xml_insert_vec(x0, x0cnew);
+	    clixon_xvec_free(x0cnew); /* Nodes may be in x0 also on error */
+	    x0cnew = NULL;
+	    if (ret < 0)
+		goto done;
+	}
 	if (xml_parent(x0) == NULL &&
 	    xml_insert(x0p, x0, INS_LAST, NULL, NULL) < 0) 
 	    goto done;
@@ -1609,6 +1695,11 @@ xml_merge1(cxobj              *x0,  /* the target */
 	free(twophase);
     if (cbr)
 	cbuf_free(cbr);
+    if (x0cnew){ /* Not inserted */
+	for (i=0; i<clixon_xvec_len(x0cnew); i++)
+	    xml_free(clixon_xvec_i(x0cnew, i));
+	clixon_xvec_free(x0cnew);
+    }
     return retval;
  fail:
     retval = 0;
@@ -1642,6 +1733,9 @@ xml_merge(cxobj     *x0,
     merge_twophase *twophase = NULL;
     int        twophase_len;
     int        ret;
+    clixon_xvec *x0cnew = NULL; /* New children of x0 */
+    int        cursor = 0; /* Position in x0 children, see match_base_child_sorted */
+    cxobj     *x1prev = NULL;
 
     if (x0 == NULL || x1 == NULL){
 	clicon_err(OE_UNIX, EINVAL, "parameters x0 or x1 is NULL");
@@ -1684,7 +1778,7 @@ xml_merge(cxobj     *x0,
 	}
 	x0c = NULL;
 	/* See if there is a corresponding node (x1c) in the base tree (x0) */
-	if (yc && match_base_child(x0, x1c, yc, &x0c) < 0)
+	if (yc && match_base_child_sorted(x0, x1c, yc, &cursor, &x1prev, &x0c) < 0)
 	    goto done;
 	/* Save x0c, x1c, yc and merge in second wave, so that x1c entries don't "interfere"
 	 * with itself, ie that later searches are among earlier objects already added
@@ -1697,23 +1791,38 @@ xml_merge(cxobj     *x0,
     twophase_len = i; /* Inital length included non-elements */
     /* Second run where actual merging is done 
      * Loop through children of the modification tree */
+    if (twophase_len > 1 && (x0cnew = clixon_xvec_new()) == NULL)
+	goto done;
     for (i=0; i<twophase_len; i++){
 	assert(twophase[i].mt_x1c);
 	if ((ret = xml_merge1(twophase[i].mt_x0c,
 			      twophase[i].mt_yc,
 			      x0,
+			      x0cnew,
 			      twophase[i].mt_x1c,
 			      reason)) < 0)
 	    goto done;
 	if (ret == 0)
 	    goto fail;
     }
+    if (x0cnew){
+	ret = xml_insert_vec(x0, x0cnew);
+	clixon_xvec_free(x0cnew); /* Nodes may be in x0 also on error */
+	x0cnew = NULL;
+	if (ret < 0)
+	    goto done;
+    }
     retval = 1; /* OK */
  done:
     if (twophase)
 	free(twophase);
     if (cbr)
 	cbuf_free(cbr);
+    if (x0cnew){ /* Not inserted */
+	for (i=0; i<clixon_xvec_len(x0cnew); i++)
+	    xml_free(clixon_xvec_i(x0cnew, i));
+	clixon_xvec_free(x0cnew);
+    }
     return retval;
  fail:
     retval = 0;
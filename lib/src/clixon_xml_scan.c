@@ -0,0 +1,1121 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+
+  Copyright (C) 2009-2016 Olof Hagsand and Benny Holmgren
+  Copyright (C) 2017-2019 Olof Hagsand
+  Copyright (C) 2020 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2,
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * Hand-written XML scanner, alternative to the flex/bison XML parser
+ * @see https://www.w3.org/TR/2008/REC-xml-20081126
+ *
+ * The scanner builds the same XML tree as the generated parser (clixon_xml_parse.[ly]) but
+ * scans the input buffer in place: names are NUL-terminated temporarily where they are
+ * found and copied once into the new node, character data is entity-decoded and
+ * CR/CRLF-normalized by compacting it within the buffer, and runs of plain character data
+ * are skipped with SIMD where available, see clixon_memchr4.
+ * Therefore the input buffer is modified, and is expected to be a private copy.
+ * Compatible with the generated parser:
+ *  - An element with element children gets no body, pretty-print whitespace and mixed
+ *    content are removed (see xml_parse_bslash)
+ *  - CDATA sections are kept verbatim in the body, including the CDATA markers
+ *  - Attribute values are not entity-decoded
+ *  - Comments and processing instructions are skipped
+ * Character references (&#N; and &#xN;) are decoded to UTF-8.
+ * YANG is bound in the same pass: an element is bound when its start-tag is parsed, and
+ * its children are sorted when its end-tag is parsed. See xml_bind_yang_node.
+ * Input may also be pushed in chunks as it arrives, see clixon_xml_scan_push. Then only
+ * complete items (character data and the tag following it) are scanned, and the rest is
+ * kept in the buffer until more input arrives.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include "clixon_err.h"
+#include "clixon_string.h"
+#include "clixon_queue.h"
+#include "clixon_hash.h"
+#include "clixon_handle.h"
+#include "clixon_yang.h"
+#include "clixon_xml.h"
+#include "clixon_xml_nsctx.h"
+#include "clixon_xml_sort.h"
+#include "clixon_xml_bind.h"
+#include "clixon_netconf_lib.h"
+#include "clixon_xml_scan.h"
+
+/*
+ * Constants
+ */
+#define XML_NAMESTART(c) (((c)>='A' && (c)<='Z') || ((c)>='a' && (c)<='z') || (c)=='_')
+#define XML_NAMECHAR(c)  (XML_NAMESTART(c) || ((c)>='0' && (c)<='9') || (c)=='-' || (c)=='.')
+#define XML_WHITESPACE(c) ((c)==' ' || (c)=='\t' || (c)=='\n' || (c)=='\r')
+
+/*
+ * Types
+ */
+/*! Where xml_scan_complete stopped in an incomplete item */
+enum xs_cstate{
+    XS_TEXT,    /* Character data */
+    XS_COMMENT, /* In comment, look for "-->" */
+    XS_PI,      /* In processing instruction, look for "?>" */
+    XS_CDATA,   /* In CDATA section, look for "]]>" */
+    XS_TAG,     /* In start-tag or end-tag, look for '>' */
+};
+
+/*! XML scanner state */
+struct xml_scan {
+    char       *xs_buf;    /* Start of (mutable) input buffer */
+    char       *xs_p;      /* Current scan position */
+    char       *xs_end;    /* End of input, points to terminating NUL */
+    size_t      xs_buflen; /* Allocated length of xs_buf if pushed, else 0 */
+    int         xs_line;   /* Number of lines scanned and removed from xs_buf */
+    int         xs_begun;  /* XML declaration (if any) is scanned */
+    cxobj      *xs_x;      /* Current element, parent of new nodes */
+    int         xs_haselem;/* Current element has element children */
+    int         xs_nr;     /* Number of top-level elements */
+    int         xs_xmldecl;/* Input starts with XML declaration */
+    cxobj      *xs_xt;     /* Top of XML parse tree */
+    yang_bind   xs_yb;     /* How to bind yang to top-level elements */
+    yang_stmt  *xs_yspec;  /* Yang spec */
+    cxobj     **xs_xerr;   /* Reason for yang binding failure */
+    int         xs_failed; /* Number of failed yang bindings */
+    int         xs_sorted; /* Input is sorted, only check order of each node */
+    size_t      xs_cpos;   /* Offset from xs_p checked by xml_scan_complete */
+    enum xs_cstate xs_cstate; /* State of xml_scan_complete at xs_cpos */
+    char        xs_cquote; /* Quote character of attribute value in XS_TAG */
+};
+
+/*! Predefined entities, @see xml_chardata_encode */
+static const struct {
+    const char *xe_name;
+    size_t      xe_len;
+    char        xe_char;
+} xml_entities[] = {
+    {"amp;",  4, '&'},
+    {"lt;",   3, '<'},
+    {"gt;",   3, '>'},
+    {"apos;", 5, '\''},
+    {"quot;", 5, '"'},
+    {NULL,    0, 0}
+};
+
+/*! Report a scan error at current position
+ * @param[in]  xs     XML scanner state
+ * @param[in]  reason Error reason
+ * @retval    -1      Always, with clicon_err called
+ * @note line number is computed here instead of being maintained while scanning
+ */
+static int
+xml_scan_err(xml_scan   *xs,
+	     const char *reason)
+{
+    int   linenum = 1 + xs->xs_line;
+    char *p;
+
+    for (p = xs->xs_buf; p < xs->xs_p; p++)
+	if (*p == '\n')
+	    linenum++;
+    clicon_err(OE_XML, XMLPARSE_ERRNO, "xml_parse: line %d: %s: at or before: %.1s",
+	       linenum, reason, xs->xs_p);
+    return -1;
+}
+
+/*! Find end of a run of plain character data
+ * @param[in]  p    Start of character data
+ * @param[in]  end  End of input
+ * @retval     q    Pointer to first '<', '&' or '\r' at or after p, or end if none
+ */
+static inline char *
+xml_scan_chardata(char *p,
+		  char *end)
+{
+    return (char*)clixon_memchr4(p, end - p, '<', '&', '\r', '\r');
+}
+
+/*! Skip whitespace at current position */
+static inline void
+xml_scan_ws(xml_scan *xs)
+{
+    while (XML_WHITESPACE(*xs->xs_p))
+	xs->xs_p++;
+}
+
+/*! Length of NCName at p, or 0 if p does not start a name */
+static inline size_t
+xml_scan_ncname(const char *p)
+{
+    const char *p0 = p;
+
+    if (!XML_NAMESTART(*p))
+	return 0;
+    p++;
+    while (XML_NAMECHAR(*p))
+	p++;
+    return p - p0;
+}
+
+/*! Scan qualified name, ie name or prefix:name, at current position
+ * @param[in]  xs     XML scanner state
+ * @param[out] prefix Start of prefix or NULL if unprefixed
+ * @param[out] plen   Length of prefix
+ * @param[out] name   Start of local name
+ * @param[out] nlen   Length of local name
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+xml_scan_qname(xml_scan *xs,
+	       char    **prefix,
+	       size_t   *plen,
+	       char    **name,
+	       size_t   *nlen)
+{
+    char  *p = xs->xs_p;
+    size_t len;
+
+    if ((len = xml_scan_ncname(p)) == 0)
+	return xml_scan_err(xs, "syntax error");
+    if (p[len] == ':'){
+	*prefix = p;
+	*plen = len;
+	p += len + 1;
+	if ((len = xml_scan_ncname(p)) == 0){
+	    xs->xs_p = p;
+	    return xml_scan_err(xs, "syntax error");
+	}
+    }
+    else{
+	*prefix = NULL;
+	*plen = 0;
+    }
+    *name = p;
+    *nlen = len;
+    xs->xs_p = p + len;
+    return 0;
+}
+
+/*! Decode an entity or character reference at current position
+ * @param[in]     xs  XML scanner state, current position at '&'
+ * @param[in,out] wp  Write pointer, decoded characters are written here (never after xs_p)
+ * @retval        0   OK
+ * @retval       -1   Error
+ */
+static int
+xml_scan_entity(xml_scan *xs,
+		char    **wp)
+{
+    char         *p = xs->xs_p + 1;
+    char         *w = *wp;
+    char         *p0;
+    unsigned long c = 0;
+    int           base = 10;
+    int           d;
+    int           i;
+
+    if (*p == '#'){
+	p++;
+	if (*p == 'x'){
+	    base = 16;
+	    p++;
+	}
+	p0 = p;
+	while (c <= 0x10FFFF){
+	    if (*p >= '0' && *p <= '9')
+		d = *p - '0';
+	    else if (*p >= 'a' && *p <= 'f')
+		d = *p - 'a' + 10;
+	    else if (*p >= 'A' && *p <= 'F')
+		d = *p - 'A' + 10;
+	    else
+		break;
+	    if (d >= base)
+		break;
+	    c = c*base + d;
+	    p++;
+	}
+	if (p == p0 || *p != ';' || c == 0 || c > 0x10FFFF)
+	    return xml_scan_err(xs, "invalid character reference");
+	p++;
+	/* Encode as UTF-8, never longer than the reference itself */
+	if (c < 0x80)
+	    *w++ = c;
+	else if (c < 0x800){
+	    *w++ = 0xC0 | (c >> 6);
+	    *w++ = 0x80 | (c & 0x3F);
+	}
+	else if (c < 0x10000){
+	    *w++ = 0xE0 | (c >> 12);
+	    *w++ = 0x80 | ((c >> 6) & 0x3F);
+	    *w++ = 0x80 | (c & 0x3F);
+	}
+	else{
+	    *w++ = 0xF0 | (c >> 18);
+	    *w++ = 0x80 | ((c >> 12) & 0x3F);
+	    *w++ = 0x80 | ((c >> 6) & 0x3F);
+	    *w++ = 0x80 | (c & 0x3F);
+	}
+    }
+    else{
+	for (i=0; xml_entities[i].xe_name; i++)
+	    if (strncmp(p, xml_entities[i].xe_name, xml_entities[i].xe_len) == 0)
+		break;
+	if (xml_entities[i].xe_name == NULL)
+	    return xml_scan_err(xs, "unknown entity");
+	p += xml_entities[i].xe_len;
+	*w++ = xml_entities[i].xe_char;
+    }
+    xs->xs_p = p;
+    *wp = w;
+    return 0;
+}
+
+/*! Scan character data up to the next start-tag, end-tag or end of input
+ *
+ * Entities are decoded and line-ends normalized in place, so that the resulting text is
+ * contiguous at the original start position. CDATA sections are kept verbatim, comments
+ * and processing instructions are skipped.
+ * @param[in]  xs    XML scanner state
+ * @param[out] text  Start of (decoded) character data
+ * @param[out] len   Length of (decoded) character data
+ * @retval     0     OK, current position at '<' of tag or end of input
+ * @retval    -1     Error
+ */
+static int
+xml_scan_text(xml_scan *xs,
+	      char    **text,
+	      size_t   *len)
+{
+    char *p = xs->xs_p;
+    char *w = p;  /* Write pointer of decoded text */
+    char *q;
+
+    *text = p;
+    while (1){
+	q = xml_scan_chardata(p, xs->xs_end);
+	if (w != p)
+	    memmove(w, p, q - p);
+	w += q - p;
+	p = q;
+	if (p == xs->xs_end)
+	    break;
+	if (*p == '\r'){ /* CR LF -> LF, CR -> LF */
+	    *w++ = '\n';
+	    if (*++p == '\n')
+		p++;
+	}
+	else if (*p == '&'){
+	    xs->xs_p = p;
+	    if (xml_scan_entity(xs, &w) < 0)
+		return -1;
+	    p = xs->xs_p;
+	}
+	else if (strncmp(p, "<![CDATA[", 9) == 0){
+	    if ((q = strstr(p + 9, "]]>")) == NULL){
+		xs->xs_p = p;
+		return xml_scan_err(xs, "unterminated CDATA section");
+	    }
+	    q += 3;
+	    if (w != p)
+		memmove(w, p, q - p);
+	    w += q - p;
+	    p = q;
+	}
+	else if (strncmp(p, "<!--", 4) == 0){
+	    if ((q = strstr(p + 4, "-->")) == NULL){
+		xs->xs_p = p;
+		return xml_scan_err(xs, "unterminated comment");
+	    }
+	    p = q + 3;
+	}
+	else if (p[1] == '?'){
+	    if ((q = strstr(p + 2, "?>")) == NULL){
+		xs->xs_p = p;
+		return xml_scan_err(xs, "unterminated processing instruction");
+	    }
+	    p = q + 2;
+	}
+	else
+	    break;
+    }
+    xs->xs_p = p;
+    *len = w - *text;
+    return 0;
+}
+
+/*! Scan pseudo-attribute in XML declaration, eg version="1.0"
+ * @param[in]  xs        XML scanner state
+ * @param[in]  name      Name of pseudo-attribute
+ * @param[in]  mandatory Pseudo-attribute must be present
+ * @param[out] val       Start of value
+ * @param[out] vlen      Length of value
+ * @retval     1         Found
+ * @retval     0         Not present (and not mandatory)
+ * @retval    -1         Error
+ */
+static int
+xml_scan_pseudoattr(xml_scan   *xs,
+		    const char *name,
+		    int         mandatory,
+		    char      **val,
+		    size_t     *vlen)
+{
+    size_t len = strlen(name);
+    char  *p;
+    char  *q;
+
+    xml_scan_ws(xs);
+    p = xs->xs_p;
+    if (strncmp(p, name, len) != 0 || XML_NAMECHAR(p[len])){
+	if (mandatory)
+	    return xml_scan_err(xs, "syntax error");
+	return 0;
+    }
+    xs->xs_p += len;
+    xml_scan_ws(xs);
+    if (*xs->xs_p != '=')
+	return xml_scan_err(xs, "syntax error");
+    xs->xs_p++;
+    xml_scan_ws(xs);
+    p = xs->xs_p;
+    if ((*p != '"' && *p != '\'') ||
+	(q = strchr(p + 1, *p)) == NULL)
+	return xml_scan_err(xs, "syntax error");
+    *val = p + 1;
+    *vlen = q - p - 1;
+    xs->xs_p = q + 1;
+    return 1;
+}
+
+/*! Scan XML declaration, eg <?xml version="1.0" encoding="UTF-8"?>
+ * @param[in]  xs   XML scanner state, current position at "<?xml"
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+xml_scan_xmldecl(xml_scan *xs)
+{
+    char  *val;
+    size_t vlen;
+
+    xs->xs_p += strlen("<?xml");
+    if (xml_scan_pseudoattr(xs, "version", 1, &val, &vlen) < 0)
+	return -1;
+    if (vlen != 3 || strncmp(val, "1.0", 3) != 0){
+	clicon_err(OE_XML, XMLPARSE_ERRNO, "Wrong XML version %.*s expected 1.0", (int)vlen, val);
+	return -1;
+    }
+    if (xml_scan_pseudoattr(xs, "encoding", 0, &val, &vlen) < 0)
+	return -1;
+    if (xml_scan_pseudoattr(xs, "standalone", 0, &val, &vlen) < 0)
+	return -1;
+    xml_scan_ws(xs);
+    if (strncmp(xs->xs_p, "?>", 2) != 0)
+	return xml_scan_err(xs, "syntax error");
+    xs->xs_p += 2;
+    return 0;
+}
+
+/*! Create element or attribute node from name tokens in the scan buffer
+ * @param[in]  xp     Parent
+ * @param[in]  prefix Prefix or NULL
+ * @param[in]  plen   Length of prefix
+ * @param[in]  name   Local name
+ * @param[in]  nlen   Length of local name
+ * @param[in]  type   CX_ELMNT or CX_ATTR. An existing attribute is reused
+ * @retval     x      New (or existing) node
+ * @retval     NULL   Error
+ */
+static cxobj *
+xml_scan_node(cxobj          *xp,
+	      char           *prefix,
+	      size_t          plen,
+	      char           *name,
+	      size_t          nlen,
+	      enum cxobj_type type)
+{
+    cxobj *x = NULL;
+    char   pc = 0;
+    char   nc;
+
+    /* Terminate tokens in place, they are always followed by a delimiter */
+    nc = name[nlen];
+    name[nlen] = '\0';
+    if (prefix){
+	pc = prefix[plen];
+	prefix[plen] = '\0';
+    }
+    if (type == CX_ATTR &&
+	(x = xml_find_type(xp, prefix, name, CX_ATTR)) != NULL)
+	goto done;
+    if ((x = xml_new(name, xp, type)) == NULL)
+	goto done;
+    if (prefix && xml_prefix_set(x, prefix) < 0){
+	x = NULL;
+	goto done;
+    }
+ done:
+    name[nlen] = nc;
+    if (prefix)
+	prefix[plen] = pc;
+    return x;
+}
+
+/*! Set NUL-terminated value from a token in the scan buffer
+ * @param[in]  x      XML node
+ * @param[in]  val    Start of value
+ * @param[in]  vlen   Length of value
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+xml_scan_value(cxobj *x,
+	       char  *val,
+	       size_t vlen)
+{
+    int  retval;
+    char c;
+
+    c = val[vlen];
+    val[vlen] = '\0';
+    retval = xml_value_set(x, val);
+    val[vlen] = c;
+    return retval;
+}
+
+/*! Scan attributes and end of start-tag
+ * @param[in]  xs    XML scanner state, current position after element name
+ * @param[in]  x     Element
+ * @retval     1     Empty-element tag, ie "/>"
+ * @retval     0     Start-tag, ie ">"
+ * @retval    -1     Error
+ */
+static int
+xml_scan_attrs(xml_scan *xs,
+	       cxobj    *x)
+{
+    cxobj *xa;
+    char  *prefix;
+    char  *name;
+    size_t plen;
+    size_t nlen;
+    char  *p;
+    char  *q;
+
+    while (1){
+	xml_scan_ws(xs);
+	p = xs->xs_p;
+	if (*p == '>'){
+	    xs->xs_p++;
+	    return 0;
+	}
+	if (*p == '/' && p[1] == '>'){
+	    xs->xs_p += 2;
+	    return 1;
+	}
+	if (xml_scan_qname(xs, &prefix, &plen, &name, &nlen) < 0)
+	    return -1;
+	xml_scan_ws(xs);
+	if (*xs->xs_p != '=')
+	    return xml_scan_err(xs, "syntax error");
+	xs->xs_p++;
+	xml_scan_ws(xs);
+	p = xs->xs_p;
+	if ((*p != '"' && *p != '\'') ||
+	    (q = memchr(p + 1, *p, xs->xs_end - p - 1)) == NULL)
+	    return xml_scan_err(xs, "syntax error");
+	if ((xa = xml_scan_node(x, prefix, plen, name, nlen, CX_ATTR)) == NULL)
+	    return -1;
+	if (xml_scan_value(xa, p + 1, q - p - 1) < 0)
+	    return -1;
+	xs->xs_p = q + 1;
+    }
+    return 0;
+}
+
+/*! Return 1 if XML nodes have same name and prefix */
+static inline int
+xml_scan_samename(cxobj *x1,
+		  cxobj *x2)
+{
+    return strcmp(xml_name(x1), xml_name(x2)) == 0 &&
+	clicon_strcmp(xml_prefix(x1), xml_prefix(x2)) == 0;
+}
+
+/*! Find a bound node with same name to use as role model for yang binding
+ *
+ * Either the previous sibling, or the corresponding child of the parent's previous
+ * sibling, as in xml_bind_yang0_opt. 
+ * @param[in]  xp  Parent, x is its last child and xp is the last child of its parent
+ * @param[in]  x   New XML element
+ * @retval     xs  Role model
+ * @retval     NULL None found
+ */
+static cxobj *
+xml_scan_sibling(cxobj *xp,
+		 cxobj *x)
+{
+    cxobj *xs;
+    cxobj *xpp;
+    cxobj *xps;
+    int    n;
+
+    if ((n = xml_child_nr(xp)) > 1 &&
+	(xs = xml_child_i(xp, n-2)) != NULL &&
+	xml_type(xs) == CX_ELMNT &&
+	xml_spec(xs) != NULL &&
+	xml_scan_samename(xs, x))
+	return xs;
+    /* Parent has no attributes (they are always first) and has a role model itself */
+    if (xml_type(xml_child_i(xp, 0)) != CX_ATTR &&
+	(xpp = xml_parent(xp)) != NULL &&
+	(n = xml_child_nr(xpp)) > 1 &&
+	(xps = xml_child_i(xpp, n-2)) != NULL &&
+	xml_type(xps) == CX_ELMNT &&
+	xml_spec(xps) == xml_spec(xp) &&
+	xml_scan_samename(xps, xp) &&
+	(xs = xml_find_type(xps, xml_prefix(x), xml_name(x), CX_ELMNT)) != NULL &&
+	xml_spec(xs) != NULL)
+	return xs;
+    return NULL;
+}
+
+/*! Bind yang spec to a new XML element when its start-tag (with attributes) is parsed
+ *
+ * The binding of the element follows xml_bind_yang0 etc, but depends on its parent:
+ * - top-level: according to yb, as in _xml_parse
+ * - config/data (YB_MODULE) or rpc (YB_RPC) on top-level: from modules and rpcs respectively
+ * - otherwise: from parent yang spec, if the parent is bound
+ * Also verify the namespace of a prefixed element, as xml2ns_recurse
+ * @param[in]  xs    XML scanner state
+ * @param[in]  xp    Parent
+ * @param[in]  x     New XML element
+ * @retval     0     OK, or yang binding failed and xs_failed incremented
+ * @retval    -1     Error
+ */
+static int
+xml_scan_bind(xml_scan *xs,
+	      cxobj    *xp,
+	      cxobj    *x)
+{
+    int        retval = -1;
+    char      *prefix;
+    char      *namespace = NULL;
+    char      *name;
+    cxobj     *xsibling = NULL;
+    yang_bind  yb;
+    int        ret;
+
+    if ((prefix = xml_prefix(x)) != NULL){
+	if (xml2ns(x, prefix, &namespace) < 0)
+	    goto done;
+	if (namespace == NULL){
+	    clicon_err(OE_XML, ENOENT, "No namespace associated with %s:%s", prefix, xml_name(x));
+	    goto done;
+	}
+    }
+    if (xs->xs_yb == YB_NONE)
+	goto ok;
+    if (xp == xs->xs_xt){
+	name = xml_name(x);
+	switch (xs->xs_yb){
+	case YB_MODULE:
+#ifdef XMLDB_CONFIG_HACK
+	    if (strcmp(name, "config") == 0 || strcmp(name, "data") == 0)
+		goto ok; /* Children bound from modules */
+#endif
+	    yb = YB_MODULE;
+	    break;
+	case YB_RPC: /* see xml_bind_yang_rpc */
+	    if (strcmp(name, "rpc") == 0 ||
+		strcmp(name, "hello") == 0 ||
+		strcmp(name, "notification") == 0)
+		goto ok;
+	    if (xs->xs_xerr &&
+		netconf_unknown_element_xml(xs->xs_xerr, "protocol", name, "Unrecognized netconf operation") < 0)
+		goto done;
+	    xs->xs_failed++;
+	    goto ok;
+	    break;
+	default:
+	    yb = YB_PARENT;
+	    break;
+	}
+    }
+    else if (xml_spec(xp) != NULL){
+	yb = YB_PARENT;
+	if (xml_child_nr(x) == 0) /* No attributes */
+	    xsibling = xml_scan_sibling(xp, x);
+    }
+    else if (xml_parent(xp) != xs->xs_xt)
+	goto ok; /* Parent not bound */
+    else if (xs->xs_yb == YB_RPC && strcmp(xml_name(xp), "rpc") == 0)
+	yb = YB_RPC;
+#ifdef XMLDB_CONFIG_HACK
+    else if (xs->xs_yb == YB_MODULE &&
+	     (strcmp(xml_name(xp), "config") == 0 || strcmp(xml_name(xp), "data") == 0))
+	yb = YB_MODULE;
+#endif
+    else
+	goto ok; /* Parent not bound */
+    if ((ret = xml_bind_yang_node(x, yb, xs->xs_yspec, xsibling, xs->xs_xerr)) < 0)
+	goto done;
+    if (ret == 0)
+	xs->xs_failed++;
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! An XML element is complete: complete yang binding and sort its children
+ * @param[in]  xs    XML scanner state
+ * @param[in]  x     XML element
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+xml_scan_close(xml_scan *xs,
+	       cxobj    *x)
+{
+    int ret;
+
+    if (xs->xs_yb == YB_NONE)
+	return 0;
+    if (xml_bind_yang_close(x) < 0)
+	return -1;
+    /* Input trusted to be sorted is checked node by node. If out of order, eg a stamped
+     * datastore file edited by hand, verify and sort the rest of the input, including
+     * the still open parent of x */
+    if (xs->xs_sorted){
+	if ((ret = xml_sort_verify_prev(x)) < 0)
+	    return -1;
+	if (ret == 0)
+	    xs->xs_sorted = 0;
+    }
+    if (!xs->xs_sorted && xml_sort_node(x) < 0)
+	return -1;
+    return 0;
+}
+
+/*! Check if the next item, ie character data and the tag following it, is complete
+ *
+ * Used when scanning input pushed in chunks, where the rest of the item may not have
+ * arrived. Comments, CDATA sections and processing instructions are part of the character
+ * data, as in xml_scan_text.
+ * If the item is incomplete, the position and state of the check is saved in xs, and the
+ * next call continues from there, so that each input character is checked only once
+ * also if a large item arrives in many small chunks.
+ * @param[in]  xs    XML scanner state
+ * @retval     1     Next item is complete
+ * @retval     0     Next item is incomplete
+ */
+static int
+xml_scan_complete(xml_scan *xs)
+{
+    char          *p = xs->xs_p + xs->xs_cpos;
+    char          *end = xs->xs_end;
+    enum xs_cstate state = xs->xs_cstate;
+    char           quote = xs->xs_cquote;
+    const char    *term = NULL;
+    size_t         tlen;
+    char          *q;
+
+    while (p < end){
+	switch (state){
+	case XS_TEXT:
+	    if ((q = memchr(p, '<', end - p)) == NULL){
+		p = end;
+		goto incomplete;
+	    }
+	    p = q;
+	    if (end - p < 4)
+		goto incomplete;
+	    if (strncmp(p, "<!--", 4) == 0){
+		state = XS_COMMENT;
+		p += 4;
+	    }
+	    else if (p[1] == '?'){
+		state = XS_PI;
+		p += 2;
+	    }
+	    else if (p[1] == '!' && end - p < 9)
+		goto incomplete;
+	    else if (strncmp(p, "<![CDATA[", 9) == 0){
+		state = XS_CDATA;
+		p += 9;
+	    }
+	    else{
+		state = XS_TAG;
+		p++;
+	    }
+	    break;
+	case XS_COMMENT:
+	case XS_PI:
+	case XS_CDATA:
+	    term = state==XS_COMMENT?"-->":state==XS_PI?"?>":"]]>";
+	    tlen = strlen(term);
+	    if ((q = strstr(p, term)) == NULL){
+		/* Terminator may be split between chunks */
+		if ((size_t)(end - p) >= tlen)
+		    p = end - (tlen - 1);
+		goto incomplete;
+	    }
+	    p = q + tlen;
+	    state = XS_TEXT;
+	    break;
+	case XS_TAG: /* Find closing '>' that is not in an attribute value */
+	    for (; p < end; p++){
+		if (quote){
+		    if (*p == quote)
+			quote = 0;
+		}
+		else if (*p == '"' || *p == '\'')
+		    quote = *p;
+		else if (*p == '>'){
+		    xs->xs_cpos = 0;
+		    xs->xs_cstate = XS_TEXT;
+		    xs->xs_cquote = 0;
+		    return 1;
+		}
+	    }
+	    break;
+	}
+    }
+ incomplete:
+    xs->xs_cpos = p - xs->xs_p;
+    xs->xs_cstate = state;
+    xs->xs_cquote = quote;
+    return 0;
+}
+
+/*! Scan items from current position and build XML tree
+ *
+ * @param[in]  xs    XML scanner state
+ * @param[in]  final All input is in buffer. If not, stop at first incomplete item
+ * @retval     0     OK
+ * @retval    -1     Error with clicon_err called
+ */
+static int
+xml_scan_items(xml_scan *xs,
+	       int       final)
+{
+    int       retval = -1;
+    cxobj    *xt = xs->xs_xt;
+    cxobj    *x = xs->xs_x; /* Current element, parent of new nodes */
+    cxobj    *xc;
+    char     *text;
+    size_t    len;
+    char     *prefix;
+    char     *name;
+    size_t    plen;
+    size_t    nlen;
+    char     *prefix0;
+    char     *name0;
+    size_t    i;
+    int       ret;
+
+    if (!xs->xs_begun){
+	if (!final &&
+	    (xs->xs_end - xs->xs_p < 6 ||
+	     (strncmp(xs->xs_p, "<?xml", 5) == 0 && strstr(xs->xs_p, "?>") == NULL)))
+	    goto ok; /* Wait for more input */
+	if (strncmp(xs->xs_p, "<?xml", 5) == 0 && XML_WHITESPACE(xs->xs_p[5])){
+	    if (xml_scan_xmldecl(xs) < 0)
+		goto done;
+	    xs->xs_xmldecl++;
+	}
+	xs->xs_begun++;
+    }
+    while (final || xml_scan_complete(xs)){
+	if (xml_scan_text(xs, &text, &len) < 0)
+	    goto done;
+	if (x == xt){ /* Only whitespace allowed at top-level */
+	    for (i=0; i<len; i++)
+		if (!XML_WHITESPACE(text[i])){
+		    xs->xs_p = text + i;
+		    xml_scan_err(xs, "syntax error");
+		    goto done;
+		}
+	}
+	if (xs->xs_p == xs->xs_end)
+	    break;
+	/* Current position is at '<' */
+	if (xs->xs_p[1] == '/'){ /* End-tag */
+	    if (x == xt){
+		xml_scan_err(xs, "syntax error");
+		goto done;
+	    }
+	    /* Body only if no element children, see xml_parse_bslash */
+	    if (!xs->xs_haselem && len){
+		if ((xc = xml_new("body", x, CX_BODY)) == NULL)
+		    goto done;
+		if (xml_scan_value(xc, text, len) < 0)
+		    goto done;
+	    }
+	    xs->xs_p += 2;
+	    if (xml_scan_qname(xs, &prefix, &plen, &name, &nlen) < 0)
+		goto done;
+	    prefix0 = xml_prefix(x);
+	    name0 = xml_name(x);
+	    if (strlen(name0) != nlen || strncmp(name0, name, nlen) != 0 ||
+		(prefix0 == NULL) != (prefix == NULL) ||
+		(prefix0 && (strlen(prefix0) != plen || strncmp(prefix0, prefix, plen) != 0))){
+		clicon_err(OE_XML, XMLPARSE_ERRNO, "Sanity check failed: %s%s%s vs %.*s%s%.*s",
+			   prefix0?prefix0:"", prefix0?":":"", name0,
+			   (int)plen, prefix?prefix:"", prefix?":":"", (int)nlen, name);
+		goto done;
+	    }
+	    xml_scan_ws(xs);
+	    if (*xs->xs_p != '>'){
+		xml_scan_err(xs, "syntax error");
+		goto done;
+	    }
+	    xs->xs_p++;
+	    if (xml_scan_close(xs, x) < 0)
+		goto done;
+	    x = xml_parent(x);
+	    xs->xs_haselem = 1;
+	}
+	else { /* Start-tag or empty-element tag */
+	    xs->xs_p++;
+	    xml_scan_ws(xs);
+	    if (xml_scan_qname(xs, &prefix, &plen, &name, &nlen) < 0)
+		goto done;
+	    if ((xc = xml_scan_node(x, prefix, plen, name, nlen, CX_ELMNT)) == NULL)
+		goto done;
+	    if (x == xt)
+		xs->xs_nr++;
+	    if ((ret = xml_scan_attrs(xs, xc)) < 0)
+		goto done;
+	    if (xml_scan_bind(xs, x, xc) < 0)
+		goto done;
+	    if (ret == 0){
+		x = xc;
+		xs->xs_haselem = 0;
+	    }
+	    else{
+		if (xml_scan_close(xs, xc) < 0)
+		    goto done;
+		xs->xs_haselem = 1;
+	    }
+	}
+    }
+ ok:
+    retval = 0;
+ done:
+    xs->xs_x = x;
+    return retval;
+}
+
+/*! All input is scanned: check that the tree is complete and sort top-level
+ * @param[in]  xs    XML scanner state
+ * @retval     1     OK and all yang assignment made
+ * @retval     0     OK but yang assigment not made (or only partial) and xerr set
+ * @retval    -1     Error with clicon_err called
+ */
+static int
+xml_scan_finish(xml_scan *xs)
+{
+    if (xs->xs_x != xs->xs_xt)
+	return xml_scan_err(xs, "premature end of input");
+    if (xs->xs_xmldecl && xs->xs_nr == 0)
+	return xml_scan_err(xs, "syntax error");
+    if (xs->xs_yb != YB_NONE && !xs->xs_sorted && xml_sort_node(xs->xs_xt) < 0)
+	return -1;
+    return xs->xs_failed ? 0 : 1;
+}
+
+/*! Scan XML string into an XML tree and bind yang
+ *
+ * @param[in]  str   NUL-terminated XML string. Modified during scanning.
+ * @param[in]  yb    How to bind yang to XML top-level when parsing
+ * @param[in]  yspec Yang specification (if yb is YB_MODULE or YB_RPC)
+ * @param[in]  sorted Input is trusted to be sorted, only check order node by node
+ * @param[in]  xt    Top of XML parse tree, new top-level elements are added as children
+ * @param[out] xerr  Reason for failure (yang assignment not made)
+ * @retval     1     OK and all yang assignment made
+ * @retval     0     OK but yang assigment not made (or only partial) and xerr set
+ * @retval    -1     Error with clicon_err called
+ * @note The tree created is the same as the flex/bison parser followed by yang binding
+ *       and sorting in _xml_parse, except for some corner cases of malformed XML, see
+ *       file header. 
+ * @note Unlike _xml_parse, children are sorted also if yang binding fails
+ * @see clixon_xml_parseparse
+ */
+int
+clixon_xml_scan(char       *str,
+		yang_bind   yb,
+		yang_stmt  *yspec,
+		int         sorted,
+		cxobj      *xt,
+		cxobj     **xerr)
+{
+    xml_scan  xs = {0,};
+
+    xs.xs_buf = str;
+    xs.xs_p = str;
+    xs.xs_end = str + strlen(str);
+    xs.xs_xt = xt;
+    xs.xs_x = xt;
+    xs.xs_yb = yb;
+    xs.xs_yspec = yspec;
+    xs.xs_xerr = xerr;
+    xs.xs_sorted = sorted;
+    if (xml_scan_items(&xs, 1) < 0)
+	return -1;
+    return xml_scan_finish(&xs);
+}
+
+/*! Create XML scanner for input pushed in chunks
+ *
+ * @param[in]  yb    How to bind yang to XML top-level when parsing
+ * @param[in]  yspec Yang specification (if yb is YB_MODULE or YB_RPC)
+ * @param[in]  sorted Input is trusted to be sorted, only check order node by node
+ * @param[in]  xt    Top of XML parse tree, new top-level elements are added as children
+ * @param[out] xerr  Reason for failure (yang assignment not made)
+ * @retval     xs    XML scanner, free with clixon_xml_scan_free
+ * @retval     NULL  Error
+ * @see clixon_xml_scan_push
+ */
+xml_scan *
+clixon_xml_scan_new(yang_bind   yb,
+		    yang_stmt  *yspec,
+		    int         sorted,
+		    cxobj      *xt,
+		    cxobj     **xerr)
+{
+    xml_scan *xs;
+
+    if ((xs = malloc(sizeof(*xs))) == NULL){
+	clicon_err(OE_XML, errno, "malloc");
+	return NULL;
+    }
+    memset(xs, 0, sizeof(*xs));
+    xs->xs_buflen = BUFSIZ;
+    if ((xs->xs_buf = malloc(xs->xs_buflen)) == NULL){
+	clicon_err(OE_XML, errno, "malloc");
+	free(xs);
+	return NULL;
+    }
+    xs->xs_buf[0] = '\0';
+    xs->xs_p = xs->xs_end = xs->xs_buf;
+    xs->xs_xt = xt;
+    xs->xs_x = xt;
+    xs->xs_yb = yb;
+    xs->xs_yspec = yspec;
+    xs->xs_xerr = xerr;
+    xs->xs_sorted = sorted;
+    return xs;
+}
+
+/*! Push a chunk of input to the XML scanner and scan all complete items
+ *
+ * The XML tree is built as far as the input allows, incomplete input is kept until the
+ * next chunk.
+ * @param[in]  xs    XML scanner
+ * @param[in]  buf   Chunk of input, not NUL-terminated. May not contain NUL characters
+ * @param[in]  len   Length of buf
+ * @retval     0     OK
+ * @retval    -1     Error with clicon_err called, eg parse error
+ */
+int
+clixon_xml_scan_push(xml_scan   *xs,
+		     const char *buf,
+		     size_t      len)
+{
+    size_t n;
+    char  *p;
+
+    n = xs->xs_end - xs->xs_buf;
+    if (n + len + 1 > xs->xs_buflen){
+	while (n + len + 1 > xs->xs_buflen)
+	    xs->xs_buflen *= 2;
+	if ((p = realloc(xs->xs_buf, xs->xs_buflen)) == NULL){
+	    clicon_err(OE_XML, errno, "realloc");
+	    return -1;
+	}
+	xs->xs_buf = p;
+    }
+    memcpy(xs->xs_buf + n, buf, len);
+    xs->xs_buf[n + len] = '\0';
+    xs->xs_p = xs->xs_buf;
+    xs->xs_end = xs->xs_buf + n + len;
+    if (xml_scan_items(xs, 0) < 0)
+	return -1;
+    /* Remove scanned input, if any */
+    if (xs->xs_p > xs->xs_buf){
+	for (p = xs->xs_buf; p < xs->xs_p; p++)
+	    if (*p == '\n')
+		xs->xs_line++;
+	n = xs->xs_end - xs->xs_p;
+	memmove(xs->xs_buf, xs->xs_p, n + 1);
+	xs->xs_p = xs->xs_buf;
+	xs->xs_end = xs->xs_buf + n;
+    }
+    return 0;
+}
+
+/*! No more input: scan the rest and check that the XML tree is complete
+ * @param[in]  xs    XML scanner
+ * @retval     1     OK and all yang assignment made
+ * @retval     0     OK but yang assigment not made (or only partial) and xerr set
+ * @retval    -1     Error with clicon_err called
+ */
+int
+clixon_xml_scan_end(xml_scan *xs)
+{
+    if (xml_scan_items(xs, 1) < 0)
+	return -1;
+    return xml_scan_finish(xs);
+}
+
+/*! Free XML scanner, but not the XML tree
+ * @param[in]  xs    XML scanner
+ */
+int
+clixon_xml_scan_free(xml_scan *xs)
+{
+    if (xs->xs_buf)
+	free(xs->xs_buf);
+    free(xs);
+    return 0;
+}
@@ -73,6 +73,13 @@
 #include "clixon_xml_vec.h"
 #include "clixon_xml_sort.h"
 
+#ifdef XML_EXPLICIT_INDEX
+/* Ordered-by user lists with fewer elements than this are searched linearly, 
+ * larger lists using a key index, see xml_search_userorder
+ */
+#define XML_USERORDER_INDEX_MIN 32
+#endif
+
 /*! Get xml body value as cligen variable
  * @param[in]  x   XML node (body and leaf/leaf-list)
  * @param[out] cvp Pointer to cligen variable containing value of x body
@@ -157,6 +164,214 @@ xml_cv_cache_clear(cxobj *xt)
     return retval;
 }
 
+#ifdef XML_KEY_BLOB
+/* Tag preceding each key of a binary key, so that a missing key leaf is less than a key
+ * leaf without body, which is less than any value, as when comparing key values */
+#define XML_KEY_TAG_MISSING 0
+#define XML_KEY_TAG_NOBODY  1
+#define XML_KEY_TAG_VALUE   2
+
+/*! Check if the keys of a yang list can be encoded, and cache the result in the list
+ *
+ * The binary keys of the elements of a list are either all compared with memcmp or not at
+ * all, so that the order of a list is never a mix of memcmp and cv_cmp.
+ * The types of the keys are found as in xml_cv_cache
+ * @param[in]  y     Yang list
+ * @retval     1     All keys are integers, decimal64, booleans or strings, see xml_key_encode
+ * @retval     0     Some key has another type, eg a union
+ */
+static int
+xml_key_blob_list(yang_stmt *y)
+{
+    cvec        *cvk;
+    cg_var      *cvi;
+    yang_stmt   *yk;
+    yang_stmt   *yrestype;
+    enum cv_type cvtype;
+    int          options = 0;
+    uint8_t      fraction = 0;
+    int          blob = 1;
+
+    if (yang_flag_get(y, YANG_FLAG_KEY_BLOB_DONE))
+	return yang_flag_get(y, YANG_FLAG_KEY_BLOB) != 0;
+    cvk = yang_cvec_get(y); /* Use Y_LIST cache, see ys_populate_list() */
+    cvi = NULL;
+    while (blob && (cvi = cvec_each(cvk, cvi)) != NULL) {
+	yrestype = NULL;
+	if ((yk = yang_find(y, Y_LEAF, cv_string_get(cvi))) == NULL ||
+	    yang_type_get(yk, NULL, &yrestype, &options, NULL, NULL, NULL, &fraction) < 0 ||
+	    yrestype == NULL){
+	    blob = 0;
+	    break;
+	}
+	yang2cv_type(yang_argument_get(yrestype), &cvtype);
+	switch (cvtype){
+	case CGV_INT8:
+	case CGV_INT16:
+	case CGV_INT32:
+	case CGV_INT64:
+	case CGV_DEC64:
+	case CGV_UINT8:
+	case CGV_UINT16:
+	case CGV_UINT32:
+	case CGV_UINT64:
+	case CGV_BOOL:
+	case CGV_STRING:
+	    break;
+	default:
+	    blob = 0;
+	    break;
+	}
+    }
+    if (blob)
+	yang_flag_set(y, YANG_FLAG_KEY_BLOB);
+    yang_flag_set(y, YANG_FLAG_KEY_BLOB_DONE);
+    return blob;
+}
+
+/*! Encode a key value in an order-preserving binary form
+ * Two encodings of values of the same type compare with memcmp as the values with cv_cmp:
+ * integers are 8 bytes big-endian, signed integers and decimal64 with the sign bit inverted,
+ * booleans are 1 byte and strings include the terminating zero.
+ * @param[in]  cv    Key value
+ * @param[out] buf   Encoded value, or NULL to get the length only
+ * @retval     n     Length of encoded value
+ * @retval    -1     Type cannot be encoded
+ */
+static int
+xml_key_encode(cg_var  *cv,
+	       uint8_t *buf)
+{
+    int      n = 8;
+    uint64_t u;
+    char    *str;
+    int      i;
+
+    switch (cv_type_get(cv)){
+    case CGV_INT8:
+	u = (uint64_t)(int64_t)cv_int8_get(cv) ^ 0x8000000000000000ULL;
+	break;
+    case CGV_INT16:
+	u = (uint64_t)(int64_t)cv_int16_get(cv) ^ 0x8000000000000000ULL;
+	break;
+    case CGV_INT32:
+	u = (uint64_t)(int64_t)cv_int32_get(cv) ^ 0x8000000000000000ULL;
+	break;
+    case CGV_INT64:
+	u = (uint64_t)cv_int64_get(cv) ^ 0x8000000000000000ULL;
+	break;
+    case CGV_DEC64:
+	u = (uint64_t)cv_dec64_i_get(cv) ^ 0x8000000000000000ULL;
+	break;
+    case CGV_UINT8:
+	u = cv_uint8_get(cv);
+	break;
+    case CGV_UINT16:
+	u = cv_uint16_get(cv);
+	break;
+    case CGV_UINT32:
+	u = cv_uint32_get(cv);
+	break;
+    case CGV_UINT64:
+	u = cv_uint64_get(cv);
+	break;
+    case CGV_BOOL:
+	n = 1;
+	u = cv_bool_get(cv)?1:0;
+	break;
+    case CGV_STRING:
+	if ((str = cv_string_get(cv)) == NULL)
+	    return -1;
+	n = strlen(str) + 1;
+	if (buf)
+	    memcpy(buf, str, n);
+	return n;
+    default:
+	return -1;
+    }
+    if (buf)
+	for (i=0; i<n; i++)
+	    buf[i] = (u >> (8*(n-1-i))) & 0xff;
+    return n;
+}
+
+/*! Get binary key of list element, encode and cache it if not already done
+ *
+ * The key is the encoded key values in key order, each preceded by a tag, see
+ * xml_key_encode. Only for lists where xml_key_blob_list is true.
+ * @param[in]  x     XML list element
+ * @param[in]  y     Yang spec of x
+ * @param[out] key   Binary key
+ * @param[out] len   Length of key
+ * @retval     XK_ALL     All keys are encoded
+ * @retval     XK_MISSING All keys are encoded, some key leafs are missing
+ * @retval     XK_NO      Cannot be encoded, ie a key value is invalid
+ * @note The cached values of the key leafs are cleared, the key is used instead
+ */
+static enum xml_key_state
+xml_key_cache(cxobj     *x,
+	      yang_stmt *y,
+	      uint8_t  **key,
+	      size_t    *len)
+{
+    enum xml_key_state state;
+    cvec              *cvk;
+    cg_var            *cvi;
+    cg_var            *cv;
+    cxobj             *xb;
+    uint8_t           *buf = NULL;
+    size_t             sz = 0;
+    int                n;
+
+    if ((state = xml_key_get(x, key, len)) != XK_NONE)
+	return state;
+    state = XK_ALL;
+    cvk = yang_cvec_get(y); /* Use Y_LIST cache, see ys_populate_list() */
+    /* First get length, then encode */
+    cvi = NULL;
+    while ((cvi = cvec_each(cvk, cvi)) != NULL) {
+	sz++; /* tag */
+	if ((xb = xml_find(x, cv_string_get(cvi))) == NULL){
+	    state = XK_MISSING;
+	    continue;
+	}
+	if (xml_body(xb) == NULL)
+	    continue;
+	if (xml_cv_cache(xb, &cv) < 0 ||
+	    (n = xml_key_encode(cv, NULL)) < 0){
+	    state = XK_NO;
+	    sz = 0;
+	    goto set;
+	}
+	sz += n;
+    }
+    if (sz && (buf = malloc(sz)) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	state = XK_NO;
+	sz = 0;
+	goto set;
+    }
+    sz = 0;
+    cvi = NULL;
+    while ((cvi = cvec_each(cvk, cvi)) != NULL) {
+	if ((xb = xml_find(x, cv_string_get(cvi))) == NULL)
+	    buf[sz++] = XML_KEY_TAG_MISSING;
+	else if (xml_body(xb) == NULL)
+	    buf[sz++] = XML_KEY_TAG_NOBODY;
+	else{
+	    buf[sz++] = XML_KEY_TAG_VALUE;
+	    if (xml_cv_cache(xb, &cv) < 0) /* Cached above */
+		break;
+	    sz += xml_key_encode(cv, buf + sz);
+	    xml_cv_set(xb, NULL);
+	}
+    }
+ set:
+    xml_key_set(x, state, buf, sz);
+    return xml_key_get(x, key, len);
+}
+#endif /* XML_KEY_BLOB */
+
 /*! Help function to qsort for sorting entries in xml child vector same parent
  * @param[in]  x1    object 1
  * @param[in]  x2    object 2
@@ -221,6 +436,13 @@ xml_cmp(cxobj  *x1,
     cxobj      *x2b;
     enum cxobj_type xt1;
     enum cxobj_type xt2;
+#ifdef XML_KEY_BLOB
+    enum xml_key_state ks1;
+    uint8_t    *k1;
+    uint8_t    *k2;
+    size_t      kl1;
+    size_t      kl2;
+#endif
 
     if (x1==NULL || x2==NULL)
 	goto done; /* shouldnt happen */
@@ -336,6 +558,21 @@ xml_cmp(cxobj  *x1,
 #endif /* XML_EXPLICIT_INDEX */
 	}
 	else {
+#ifdef XML_KEY_BLOB
+	/* Compare binary keys if all keys of the list can be encoded, unless keys missing
+	 * in x1 are skipped (skip1), then key values are compared below as x1 is a search
+	 * template, not a list element */
+	if (xml_key_blob_list(y1) &&
+	    (ks1 = xml_key_cache(x1, y1, &k1, &kl1)) != XK_NO &&
+	    (ks1 == XK_ALL || !skip1) &&
+	    xml_key_cache(x2, y2, &k2, &kl2) != XK_NO){
+	    if (kl1 && kl2)
+		equal = memcmp(k1, k2, kl1<kl2?kl1:kl2);
+	    if (equal == 0)
+		equal = (kl1 > kl2) - (kl1 < kl2);
+	    break;
+	}
+#endif
 	/* Use Y_LIST cache (see struct yang_stmt) */
 	cvk = yang_cvec_get(y1); /* Use Y_LIST cache, see ys_populate_list() */
 	cvi = NULL;
@@ -453,6 +690,53 @@ xml_sort_recurse(cxobj *xn)
     return retval;
 }
 
+/*! Sort children of a single XML node, non-recursive variant of xml_sort_recurse
+ *
+ * Used when a tree is built bottom-up, eg by the XML scanner when an end-tag is parsed:
+ * the children are complete and bound to yang. Value caches created by comparisons are
+ * cleared, ie of children and of list keys.
+ * @param[in] x     XML node
+ * @retval    1     OK, node is not sortable
+ * @retval    0     OK
+ * @retval   -1     Error
+ * @see xml_sort_recurse
+ */
+int
+xml_sort_node(cxobj *x)
+{
+    int        retval = -1;
+    int        ret;
+    cxobj     *xc;
+    yang_stmt *yc;
+
+    if (xml_child_nr(x) < 2)
+	goto ok;
+    if ((ret = xml_sort_verify(x, NULL)) == 1) /* This node is not sortable */
+	goto unsortable;
+    if (ret == -1){ /* not sorted */
+	if ((ret = xml_sort(x)) < 0)
+	    goto done;
+	if (ret == 1)
+	    goto unsortable;
+    }
+    if (xml_cv_cache_clear(x) < 0)
+	goto done;
+    xc = NULL;
+    while ((xc = xml_child_each(x, xc, CX_ELMNT)) != NULL) {
+	if ((yc = xml_spec(xc)) != NULL &&
+	    yang_keyword_get(yc) == Y_LIST &&
+	    xml_cv_cache_clear(xc) < 0)
+	    goto done;
+    }
+ ok:
+    retval = 0;
+ done:
+    return retval;
+ unsortable:
+    retval = 1;
+    goto done;
+}
+
 /*! Special case search for ordered-by user or state data where linear sort is used
  *
  * @param[in]  xp    Parent XML node (go through its childre)
@@ -505,96 +789,130 @@ xml_find_keys_notsorted(cxobj   *xp,
     return retval;
 }
 
-/*! Find more equal objects in a vector up and down in the array of the present
- * @param[in]  childvec  Vector of children of parent
- * @param[in]  childlen  Length of child vector
+/*! Compare object in a sorted vector with search object
+ * @param[in]  xc        Object in vector
  * @param[in]  x1        XML node to match
  * @param[in]  yangi     Yang order number (according to spec)
- * @param[in]  mid       Where to start from (may be in middle of interval)
- * @param[out] xvec      Vector of matching XML return objects (can be empty)
- * @retval     0         OK, see xvec (may be empty)
- * @retval    -1         Error
+ * @param[in]  skip1     Key matching skipped for keys not in x1
+ * @param[in]  indexvar  Compare explicit index variable instead of list keys, or NULL
+ * @retval     <0        xc is before objects equal to x1
+ * @retval     0         xc is equal to x1
+ * @retval     >0        xc is after objects equal to x1
  */
 static int
-search_multi_equals(cxobj  **childvec,
-		    size_t   childlen,
-		    cxobj   *x1,
-		    int      yangi,
-		    int      mid,
-		    int      skip1,
-		    clixon_xvec *xvec)
+search_equal_cmp(cxobj *xc,
+		 cxobj *x1,
+		 int    yangi,
+		 int    skip1,
+		 char  *indexvar)
 {
-    int        retval = -1;
-    int        i;
-    cxobj     *xc;
     yang_stmt *yc;
-    
-    for (i=mid-1; i>=0; i--){ /* First decrement */
-	xc = childvec[i];
-	yc = xml_spec(xc);
-	if (yangi != yang_order(yc)) /* wrong yang */
-	    break;
-	if (xml_cmp(x1, xc, 0, skip1, NULL) != 0)
+    int        cmp;
+
+    if ((yc = xml_spec(xc)) == NULL) /* eg attributes, sorted first */
+	return -1;
+    if (yang_order(yc) != yangi) /* wrong yang */
+	return yang_order(yc) - yangi;
+    cmp = xml_cmp(x1, xc, 0, skip1, indexvar);
+    return cmp>0 ? -1 : (cmp<0 ? 1 : 0);
+}
+
+/*! Find bound of the objects equal to x1 around a known equal object in a sorted vector
+ *
+ * Step away from mid 1, 2, 4,.. positions until an object that is not equal is found, then
+ * make a binary search between the last equal and the first not equal object.
+ * This is O(log m) where m is the number of equal objects.
+ * @param[in]  vec       Sorted vector
+ * @param[in]  len       Length of vector
+ * @param[in]  x1        XML node to match
+ * @param[in]  yangi     Yang order number (according to spec)
+ * @param[in]  mid       Position of an object equal to x1
+ * @param[in]  skip1     Key matching skipped for keys not in x1
+ * @param[in]  indexvar  Compare explicit index variable instead of list keys, or NULL
+ * @param[in]  up        0: Find first equal object, 1: find position after last equal object
+ * @retval     i         Position
+ */
+static int
+search_equal_bound(cxobj **vec,
+		   int     len,
+		   cxobj  *x1,
+		   int     yangi,
+		   int     mid,
+		   int     skip1,
+		   char   *indexvar,
+		   int     up)
+{
+    int eq = mid; /* Known equal */
+    int ne;       /* Known not equal, or outside of vector */
+    int step = 1;
+    int m;
+
+    while (1){
+	ne = up ? eq + step : eq - step;
+	if (ne >= len){
+	    ne = len;
 	    break;
-	if (clixon_xvec_prepend(xvec, xc) < 0)
-	    goto done;
-    }
-    for (i=mid+1; i<childlen; i++){ /* Then increment */
-	xc = childvec[i];
-	yc = xml_spec(xc);
-	if (yangi != yang_order(yc)) /* wrong yang */
+	}
+	if (ne < 0){
+	    ne = -1;
 	    break;
-	if (xml_cmp(x1, xc, 0, skip1, NULL) != 0)
+	}
+	if (search_equal_cmp(vec[ne], x1, yangi, skip1, indexvar) != 0)
 	    break;
-	if (clixon_xvec_append(xvec, xc) < 0)
-	    goto done;
+	eq = ne;
+	step *= 2;
     }
-
-    retval = 0;
- done:
-    return retval;
+    while (abs(ne - eq) > 1){
+	m = (eq + ne) / 2;
+	if (search_equal_cmp(vec[m], x1, yangi, skip1, indexvar) == 0)
+	    eq = m;
+	else
+	    ne = m;
+    }
+    return up ? ne : eq;
 }
 
-#ifdef XML_EXPLICIT_INDEX
-/* XXX unify with search_multi_equals */
+/*! Find more equal objects in a vector up and down in the array of the present
+ * @param[in]  vec       Sorted vector, eg children of parent or an explicit index vector
+ * @param[in]  len       Length of vector
+ * @param[in]  x1        XML node to match
+ * @param[in]  yangi     Yang order number (according to spec)
+ * @param[in]  mid       Where to start from (may be in middle of interval)
+ * @param[in]  skip1     Key matching skipped for keys not in x1
+ * @param[in]  indexvar  Compare explicit index variable instead of list keys, or NULL
+ * @param[out] xvec      Vector of matching XML return objects (can be empty)
+ * @retval     0         OK, see xvec (may be empty)
+ * @retval    -1         Error
+ */
 static int
-search_multi_equals_xvec(clixon_xvec  *childvec,
-			 cxobj        *x1,
-			 int           yangi,
-			 int           mid,
-			 int           skip1,
-			 clixon_xvec  *xvec)
+search_multi_equals(cxobj      **vec,
+		    int          len,
+		    cxobj       *x1,
+		    int          yangi,
+		    int          mid,
+		    int          skip1,
+		    char        *indexvar,
+		    clixon_xvec *xvec)
 {
     int        retval = -1;
     int        i;
-    cxobj     *xc;
-    yang_stmt *yc;
-    
-    for (i=mid-1; i>=0; i--){ /* First decrement */
-	xc = clixon_xvec_i(childvec, i);
-	yc = xml_spec(xc);
-	if (yangi != yang_order(yc)) /* wrong yang */
-	    break;
-	if (xml_cmp(x1, xc, 0, skip1, NULL) != 0)
-	    break;
-	if (clixon_xvec_prepend(xvec, xc) < 0)
+    int        first;
+    int        last;
+
+    first = search_equal_bound(vec, len, x1, yangi, mid, skip1, indexvar, 0);
+    last = search_equal_bound(vec, len, x1, yangi, mid, skip1, indexvar, 1);
+    for (i=mid-1; i>=first; i--)
+	if (clixon_xvec_prepend(xvec, vec[i]) < 0)
 	    goto done;
-    }
-    for (i=mid+1; i<clixon_xvec_len(childvec); i++){ /* Then increment */
-	xc = clixon_xvec_i(childvec, i);
-	yc = xml_spec(xc);
-	if (yangi != yang_order(yc)) /* wrong yang */
-	    break;
-	if (xml_cmp(x1, xc, 0, skip1, NULL) != 0)
-	    break;
-	if (clixon_xvec_append(xvec, xc) < 0)
+    for (i=mid+1; i<last; i++)
+	if (clixon_xvec_append(xvec, vec[i]) < 0)
 	    goto done;
-    }
     retval = 0;
  done:
     return retval;
 }
 
+#ifdef XML_EXPLICIT_INDEX
 /*! Insert xi in vector sorted according to index variable xi
  * @param[in]  x1    XML parent object (the list element)
  * @param[in]  ivec  Sorted index vector
@@ -694,8 +1012,8 @@ xml_search_indexvar(cxobj   *xp,
 	    if (clixon_xvec_append(xvec, xc) < 0)
 		goto done;
 	    /* there may be more? */
-	    if (search_multi_equals_xvec(ivec, x1, yangi, pos,
-					 0, xvec) < 0)
+	    if (search_multi_equals(clixon_xvec_vec(ivec), ilen, x1, yangi, pos,
+				    0, indexvar, xvec) < 0)
 		goto done;
 	}
     }
@@ -703,6 +1021,77 @@ xml_search_indexvar(cxobj   *xp,
  done:
     return retval;
 }
+
+/*! Compare list elements on keys only, for qsort
+ */
+static int
+xml_cmp_keys_qsort(const void* arg1, 
+		   const void* arg2)
+{
+    return xml_cmp(*(struct xml**)arg1, *(struct xml**)arg2, 0, 0, NULL);
+}
+
+/*! Find XML child of ordered-by user list under xp matching x1 using a key index
+ *
+ * The key index of the list is built on first search, if the list is large enough, and is
+ * thereafter maintained as elements are added and removed.
+ * @param[in]  xp    Parent xml node. 
+ * @param[in]  x1    Find this object among xp:s children, with all keys
+ * @param[in]  yc    Yang spec of x1, ordered-by user list
+ * @param[out] xvec  Vector of matching XML return objects (can be empty)
+ * @retval     1     OK, see xvec (may be empty)
+ * @retval     0     No key index, search linearly
+ * @retval    -1     Error
+ * @see xml_search_keyvec_add
+ */
+static int
+xml_search_userorder(cxobj       *xp,
+		     cxobj       *x1,
+		     yang_stmt   *yc,
+		     clixon_xvec *xvec)
+{
+    int          retval = -1;
+    clixon_xvec *ivec = NULL;
+    cxobj      **vec = NULL;
+    int          first;
+    int          len;
+    int          pos;
+    int          eq = 0;
+    int          i;
+
+    if (xml_search_keyvec_get(xp, yc, &ivec) < 0)
+	goto done;
+    if (ivec == NULL){
+	if (xml_child_range_yang(xp, yc, &first, &len) == 0 ||
+	    len < XML_USERORDER_INDEX_MIN)
+	    goto nokey;
+	if ((vec = malloc(len*sizeof(cxobj*))) == NULL){
+	    clicon_err(OE_UNIX, errno, "malloc");
+	    goto done;
+	}
+	memcpy(vec, xml_childvec_get(xp)+first, len*sizeof(cxobj*));
+	qsort(vec, len, sizeof(cxobj *), xml_cmp_keys_qsort);
+	if (xml_search_keyvec_add(xp, yc, &ivec) < 0)
+	    goto done;
+	for (i=0; i<len; i++)
+	    if (clixon_xvec_append(ivec, vec[i]) < 0)
+		goto done;
+    }
+    len = clixon_xvec_len(ivec);
+    if ((pos = xml_search_indexvar_binary_pos(x1, NULL, ivec, 0, len, len, &eq)) < 0)
+	goto done;
+    if (eq &&
+	clixon_xvec_append(xvec, clixon_xvec_i(ivec, pos)) < 0)
+	goto done;
+    retval = 1;
+ done:
+    if (vec)
+	free(vec);
+    return retval;
+ nokey:
+    retval = 0;
+    goto done;
+}
 #endif /* XML_EXPLICIT_INDEX */
 
 /*! Find XML child under xp matching x1 using binary search
@@ -765,7 +1154,7 @@ xml_search_binary(cxobj   *xp,
 	    goto done;
 	/* there may be more? */
 	if (search_multi_equals(xml_childvec_get(xp), xml_child_nr(xp),
-				x1, yangi, mid,	skip1, xvec) < 0)
+				x1, yangi, mid,	skip1, NULL, xvec) < 0)
 	    goto done;
     }
     else if (cmp < 0)
@@ -808,6 +1197,9 @@ xml_search_yang(cxobj       *xp,
     int    upper = xml_child_nr(xp);
     int    sorted = 1;
     int    yangi;
+#ifdef XML_EXPLICIT_INDEX
+    int    ret;
+#endif
     
     if (xp == NULL){
 	clicon_err(OE_XML, EINVAL, "xp is NULL");
@@ -827,10 +1219,25 @@ xml_search_yang(cxobj       *xp,
 #endif
 	if (yang_keyword_get(yc) == Y_LIST || yang_keyword_get(yc) == Y_LEAF_LIST)
 	    sorted = (yang_find(yc, Y_ORDERED_BY, "user") == NULL);
+#ifdef XML_EXPLICIT_INDEX
+    /* Ordered-by user list searched on all keys */
+    if (!sorted && !skip1 && indexvar == NULL &&
+	yang_keyword_get(yc) == Y_LIST &&
+	yang_find(yc, Y_ORDERED_BY, "user") != NULL &&
+	yang_find(yc, Y_KEY, NULL) != NULL){
+	if ((ret = xml_search_userorder(xp, x1, yc, xvec)) < 0)
+	    goto done;
+	if (ret == 1)
+	    goto ok;
+    }
+#endif
     yangi = yang_order(yc);
     
     if (xml_search_binary(xp, x1, sorted, yangi, low, upper, skip1, indexvar, xvec) < 0)
 	goto done;
+#ifdef XML_EXPLICIT_INDEX
+ ok:
+#endif
     retval = 0;
  done:
     return retval;
@@ -1081,9 +1488,136 @@ xml_insert(cxobj           *xp,
     xml_parent_set(xi, xp);
     /* clear namespace context cache of child */
     nscache_clear(xi);
+#ifdef XML_EXPLICIT_INDEX
+    if (xml_search_index_update(xi, 1) < 0)
+	goto done;
+#endif
+    retval = 0;
+ done:
+    return retval;
+}
 
+/*! Insert a set of new child nodes in xp:s sorted child list
+ *
+ * Same result as xml_insert with INS_LAST on each child, but the new children are sorted
+ * once and merged with the existing children in a single pass, instead of shifting the
+ * child vector on each insert, which is quadratic when many children are added.
+ * Children that are not sorted by system, ie of ordered-by user lists or state data, are
+ * inserted one by one with xml_insert after the others, in the order given.
+ * @param[in] xp   Parent xml node
+ * @param[in] xv   New child nodes with yang spec and without parent
+ * @retval    0    OK
+ * @retval   -1    Error
+ * @note On error, some of the nodes may already have been inserted in xp
+ * @see xml_insert
+ */
+int
+xml_insert_vec(cxobj       *xp,
+	       clixon_xvec *xv)
+{
+    int        retval = -1;
+    int        len;
+    int        n;
+    int        m = 0;
+    int        i;
+    int        j;
+    int        k;
+    cxobj     *x;
+    cxobj    **vec = NULL;
+    cxobj    **xold = NULL;
+    yang_stmt *y;
+    yang_stmt *yprev = NULL;
+    int        userorder = 0;
+    clixon_xvec *xuser = NULL;
+
+    if ((len = clixon_xvec_len(xv)) == 0)
+	goto ok;
+    if ((vec = malloc(len*sizeof(cxobj*))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto done;
+    }
+    /* Split in nodes sorted by system and others */
+    for (i=0; i<len; i++){
+	x = clixon_xvec_i(xv, i);
+	if (xml_parent(x) != NULL){
+	    clicon_err(OE_XML, 0, "XML node %s should not have parent", xml_name(x));
+	    goto done;
+	}
+	if ((y = xml_spec(x)) == NULL){
+	    clicon_err(OE_XML, 0, "No spec found %s", xml_name(x));
+	    goto done;
+	}
+	if (y != yprev){ /* Same as in xml_insert */
+	    yprev = y;
+#ifndef STATE_ORDERED_BY_SYSTEM
+	    if (yang_config_ancestor(y)==0)
+		userorder = 1;
+	    else
+#endif
+		if (yang_keyword_get(y) == Y_LIST || yang_keyword_get(y) == Y_LEAF_LIST)
+		    userorder = (yang_find(y, Y_ORDERED_BY, "user") != NULL);
+		else
+		    userorder = 0;
+	}
+	if (userorder){
+	    if (xuser == NULL && (xuser = clixon_xvec_new()) == NULL)
+		goto done;
+	    if (clixon_xvec_append(xuser, x) < 0)
+		goto done;
+	}
+	else
+	    vec[m++] = x;
+    }
+    /* New nodes are usually already sorted, eg if they come from a sorted tree */
+    for (i=1; i<m; i++)
+	if (xml_cmp(vec[i-1], vec[i], 0, 0, NULL) > 0)
+	    break;
+    if (i < m)
+	qsort(vec, m, sizeof(cxobj *), xml_cmp_qsort);
+    /* Merge existing and new children into a new child vector */
+    if (m){
+	n = xml_child_nr(xp);
+	if (n && (xold = malloc(n*sizeof(cxobj*))) == NULL){
+	    clicon_err(OE_UNIX, errno, "malloc");
+	    goto done;
+	}
+	if (n)
+	    memcpy(xold, xml_childvec_get(xp), n*sizeof(cxobj*));
+	if (xml_childvec_set(xp, n+m) < 0)
+	    goto done;
+	i = j = k = 0;
+	while (i < n || j < m){
+	    if (j == m ||
+		(i < n && xml_cmp(vec[j], xold[i], 0, 0, NULL) >= 0))
+		xml_child_i_set(xp, k++, xold[i++]);
+	    else
+		xml_child_i_set(xp, k++, vec[j++]);
+	}
+#ifdef XML_KEY_BLOB
+	xml_key_set(xp, XK_NONE, NULL, 0);
+#endif
+	for (j=0; j<m; j++){
+	    xml_parent_set(vec[j], xp);
+	    /* clear namespace context cache of child */
+	    nscache_clear(vec[j]);
+#ifdef XML_EXPLICIT_INDEX
+	    if (xml_search_index_update(vec[j], 1) < 0)
+		goto done;
+#endif
+	}
+    }
+    for (i=0; xuser && i<clixon_xvec_len(xuser); i++)
+	if (xml_insert(xp, clixon_xvec_i(xuser, i), INS_LAST, NULL, NULL) < 0)
+	    goto done;
+ ok:
     retval = 0;
  done:
+    if (vec)
+	free(vec);
+    if (xold)
+	free(xold);
+    if (xuser)
+	clixon_xvec_free(xuser);
     return retval;
 }
 
@@ -1126,6 +1660,68 @@ xml_sort_verify(cxobj *x0,
     return retval;
 }
 
+/*! Verify that an XML node is in order with its preceding element sibling
+ *
+ * Used when building a tree from input trusted to be sorted, eg a datastore file written
+ * by clixon, as a cheap linear check of each node as it is completed, instead of trusting
+ * the input. Value caches created by the comparison are cleared.
+ * @param[in] x     XML node, typically the last child of its parent
+ * @retval    1     OK, x is in order (or its parent is not sortable)
+ * @retval    0     x is out of order, its parent needs to be sorted
+ * @retval   -1     Error
+ * @see xml_sort_verify  Verify all children of a node
+ */
+int
+xml_sort_verify_prev(cxobj *x)
+{
+    int        retval = -1;
+    cxobj     *xp;
+    cxobj     *xprev = NULL;
+    cxobj     *xc;
+    yang_stmt *y;
+    int        i;
+    int        ret;
+
+    if ((xp = xml_parent(x)) == NULL)
+	goto ok;
+#ifndef STATE_ORDERED_BY_SYSTEM
+    /* Not sortable if non-config (=state) data */
+    if ((y = xml_spec(xp)) != NULL && yang_config_ancestor(y)==0)
+	goto ok;
+#endif
+    for (i=xml_child_nr(xp)-1; i>=0; i--)
+	if (xml_child_i(xp, i) == x)
+	    break;
+    while (--i >= 0)
+	if (xml_type(xc = xml_child_i(xp, i)) == CX_ELMNT){
+	    xprev = xc;
+	    break;
+	}
+    if (xprev == NULL)
+	goto ok;
+    /* Ordered by user: existing order is correct */
+    if ((y = xml_spec(x)) != NULL && y == xml_spec(xprev) &&
+	yang_find(y, Y_ORDERED_BY, "user") != NULL)
+	goto ok;
+    ret = xml_cmp(xprev, x, 0, 0, NULL) <= 0;
+    /* Clear value caches of leaf-lists, or of list keys */
+    for (i=0; i<2; i++){
+	xc = i ? x : xprev;
+	if ((y = xml_spec(xc)) != NULL && yang_keyword_get(y) == Y_LIST){
+	    if (xml_cv_cache_clear(xc) < 0)
+		goto done;
+	}
+	else if (xml_cv_set(xc, NULL) < 0)
+	    goto done;
+    }
+    retval = ret;
+    goto done;
+ ok:
+    retval = 1;
+ done:
+    return retval;
+}
+
 /*! Given child tree x1c, find (first) matching child in base tree x0 and return as x0cp
  * @param[in]  x0      Base tree node
  * @param[in]  x1c     Modification tree child
@@ -1207,6 +1803,98 @@ match_base_child(cxobj      *x0,
     return retval;
 }
 
+/*! Given child tree x1c, find matching child in base tree x0 by walking x0:s children in order
+ *
+ * Merge-join variant of match_base_child when several children of a modification tree are
+ * matched against the same base tree. Both children vectors are sorted with xml_cmp, so
+ * instead of a search per x1c, a cursor in x0:s children is advanced in lockstep with x1c
+ * giving a linear match of all x1 children.
+ * Reverts to match_base_child for choice, ordered-by user and state data, and for all 
+ * following children if x1c is not in sorted order.
+ * @param[in]     x0      Base tree node
+ * @param[in]     x1c     Modification tree child
+ * @param[in]     yc      Yang spec of tree child. If null revert to linear search.
+ * @param[in,out] cursor  Position in x0:s children. Init to 0, -1 reverts to match_base_child
+ * @param[in,out] x1prev  Previous x1 child matched using the cursor. Init to NULL
+ * @param[out]    x0cp    Matching base tree child (if any)
+ * @retval        0       OK
+ * @retval       -1       Error
+ * @code
+ *   int    cursor = 0;
+ *   cxobj *x1prev = NULL;
+ *   while ((x1c = xml_child_each(x1, x1c, CX_ELMNT)) != NULL) {
+ *      if (match_base_child_sorted(x0, x1c, yc, &cursor, &x1prev, &x0c) < 0)
+ *         err;
+ *   }
+ * @endcode
+ * @note x0 children may not be added or removed between calls with the same cursor
+ * @see match_base_child
+ */
+int
+match_base_child_sorted(cxobj      *x0, 
+			cxobj      *x1c,
+			yang_stmt  *yc,
+			int        *cursor,
+			cxobj     **x1prev,
+			cxobj     **x0cp)
+{
+    int        retval = -1;
+    cvec      *cvk;
+    cg_var    *cvi;
+    cxobj     *x0c = NULL;
+    int        cmp = 1;
+
+    *x0cp = NULL; /* init return value */
+    if (*cursor < 0 || yc == NULL || yang_choice(yc) != NULL)
+	goto fallback;
+#ifndef STATE_ORDERED_BY_SYSTEM
+    if (yang_config_ancestor(yc) == 0)
+	goto fallback;
+#endif
+    switch (yang_keyword_get(yc)){
+    case Y_LEAF_LIST:
+	if (yang_find(yc, Y_ORDERED_BY, "user") != NULL ||
+	    xml_body(x1c) == NULL)
+	    goto fallback;
+	break;
+    case Y_LIST:
+	if (yang_find(yc, Y_ORDERED_BY, "user") != NULL)
+	    goto fallback;
+	cvk = yang_cvec_get(yc); /* Use Y_LIST cache, see ys_populate_list() */
+	cvi = NULL; 
+	while ((cvi = cvec_each(cvk, cvi)) != NULL)
+	    if (xml_find(x1c, cv_string_get(cvi)) == NULL)
+		goto fallback;
+	break;
+    default:
+	break;
+    }
+    /* x1 children not sorted, cursor cannot be used for the rest */
+    if (*x1prev && xml_cmp(*x1prev, x1c, 0, 0, NULL) > 0){
+	*cursor = -1;
+	goto fallback;
+    }
+    *x1prev = x1c;
+    /* Advance cursor past all x0 children smaller than x1c */
+    while (*cursor < xml_child_nr(x0)){
+	x0c = xml_child_i(x0, *cursor);
+	if (xml_type(x0c) == CX_ELMNT &&
+	    (cmp = xml_cmp(x1c, x0c, 0, 0, NULL)) <= 0)
+	    break;
+	(*cursor)++;
+    }
+    if (cmp == 0)
+	*x0cp = x0c;
+    retval = 0;
+ done:
+    return retval;
+ fallback:
+    if (match_base_child(x0, x1c, yc, x0cp) < 0)
+	goto done;
+    retval = 0;
+    goto done;
+}
+
 /*! API for search in XML child list with non-indexed variables
  */
 static int
@@ -1308,15 +1996,50 @@ xml_find_noyang_name(cxobj       *xp,
     return retval;
 }
 
+/*! Check if a list element matches index variables not used in the search
+ * @param[in]  xc    XML list element
+ * @param[in]  cvk   List of keys and values as CLIgen vector on the form k1=foo, k2=bar
+ * @param[in]  used  Do not match entry i of cvk if used[i] is set
+ * @retval     1     All leafs k1, k2,.. of xc have values foo, bar,..
+ * @retval     0     No match
+ * @see xml_find_noyang_cvk  same string comparison
+ */
+static int
+xml_find_index_match(cxobj  *xc,
+		     cvec   *cvk,
+		     char   *used)
+{
+    cg_var *cvi;
+    char   *body;
+    char   *keyval;
+    int     i;
+
+    for (i=0; i<cvec_len(cvk); i++){
+	if (used[i])
+	    continue;
+	cvi = cvec_i(cvk, i);
+	keyval = cv_string_get(cvi);
+	body = xml_find_body(xc, cv_name_get(cvi));
+	if (body == NULL && (keyval == NULL || strlen(keyval) == 0))
+	    continue;
+	if (body == NULL || keyval == NULL || strcmp(body, keyval) != 0)
+	    return 0;
+    }
+    return 1;
+}
+
 /*! Try to find an XML child from parent with yang available using list keys and leaf-lists
  *
- * Must be populated with Yang specs, parent must be list or leaf-list, and (for list) search
- * index MUST be keys in the order they are declared.
+ * Must be populated with Yang specs, parent must be list or leaf-list.
  * First identify that this search qualifies for yang-based list/leaf-list optimized search,
  * - if no, revert (return 0) so that the overlying algorithm can try next or fallback to
  *   linear seacrh
  * - if yes, then construct a dummy search object and find it in the list of xp:s children
  *   using binary search
+ * For lists, the search object is made of the list keys in declared order, as long as they
+ * are in cvk, in any order, so that the binary search is made on as many keys as possible.
+ * If cvk has not the first key, the search object is made of the first explicit index
+ * variable in cvk. Any other entries of cvk are then matched against the found elements.
  * @param[in]  xp    Parent xml node. 
  * @param[in]  yc    Yang spec of list child (preferred) See rule (2) above
  * @param[in]  cvk   List of keys and values as CLIgen vector on the form k1=foo, k2=bar
@@ -1340,10 +2063,15 @@ xml_find_index_yang(cxobj       *xp,
     char      *kname;
     cvec      *ycvk;
     cg_var    *ycv = NULL;
-    int        i;
+    int        i = 0;
+    int        j;
     char      *name;
     int        revert = 0;
+    int        filter = 0;
+    int        skip1 = 1;     /* Search object lacks some keys */
+    char      *used = NULL;   /* Entries of cvk in search object */
     char      *indexvar = NULL;
+    clixon_xvec *xv = NULL;
 
     if (xp == NULL){
 	clicon_err(OE_XML, EINVAL, "xp is NULL");
@@ -1363,24 +2091,38 @@ xml_find_index_yang(cxobj       *xp,
 	    revert++;
 	    break;
 	}
-	i = 0;
-	while ((cvi = cvec_each(cvk, cvi)) != NULL) {
-	    if ((kname = cv_name_get(cvi)) == NULL){
+	while ((cvi = cvec_each(cvk, cvi)) != NULL) 
+	    if (cv_name_get(cvi) == NULL){
 		clicon_err(OE_YANG, ENOENT, "missing yang key name in cvk");
 		goto done;
 	    }
-	    /* Parameter in cvk is not key or not in right key order, then we cannot call
-	     * xml_find_keys and we need to revert to noyang
-	     */
-	    if ((ycv = cvec_i(ycvk, i)) == NULL || strcmp(kname, cv_string_get(ycv))){
-		revert++;
+	if ((used = calloc(cvec_len(cvk), sizeof(char))) == NULL){
+	    clicon_err(OE_UNIX, errno, "calloc");
+	    goto done;
+	}
+	/* Keys in declared order, regardless of order in cvk, until a key is not in cvk.
+	 * Then search with the keys before it and filter the result on the rest of cvk
+	 */
+	i = 0;
+	ycv = NULL;
+	while (ycvk && (ycv = cvec_each(ycvk, ycv)) != NULL) {
+	    kname = cv_string_get(ycv);
+	    for (j=0; j<cvec_len(cvk); j++)
+		if (!used[j] && strcmp(kname, cv_name_get(cvec_i(cvk, j))) == 0)
+		    break;
+	    if (j == cvec_len(cvk))
 		break;
-	    }
+	    used[j]++;
+	    cvi = cvec_i(cvk, j);
 	    cprintf(cb, "<%s>%s</%s>", kname, cv_string_get(cvi), kname);
 	    i++;
 	}
-	if (revert)
+	if (i == 0){ /* No keys, try index variables or revert to noyang */
+	    revert++;
 	    break;
+	}
+	skip1 = (i < cvec_len(ycvk));
+	filter = (i < cvec_len(cvk));
 	cprintf(cb, "</%s>", name);
 	break;
     case Y_LEAF_LIST:
@@ -1396,23 +2138,31 @@ xml_find_index_yang(cxobj       *xp,
 	break;
     }
 #ifdef XML_EXPLICIT_INDEX
-    if (revert){
-	char      *iname;
+    if (revert && cvk != NULL){
+	char      *iname = NULL;
 	yang_stmt *yi;
-	if (cvec_len(cvk) != 1 ||
-	    (cvi = cvec_i(cvk, 0)) == NULL ||
-	    (iname = cv_name_get(cvi)) == NULL ||
-	    (yi = yang_find_datanode(yc, iname)) == NULL ||
-	    yang_flag_get(yi, YANG_FLAG_INDEX) == 0)
+
+	/* First explicit index variable in cvk */
+	for (j=0; j<cvec_len(cvk); j++){
+	    cvi = cvec_i(cvk, j);
+	    if ((iname = cv_name_get(cvi)) != NULL &&
+		(yi = yang_find_datanode(yc, iname)) != NULL &&
+		yang_flag_get(yi, YANG_FLAG_INDEX) != 0)
+		break;
+	}
+	if (j == cvec_len(cvk) || used == NULL)
 	    goto revert;
 	cbuf_reset(cb);
 	cprintf(cb, "<%s><%s>%s</%s></%s>", name, iname, cv_string_get(cvi), iname, name);	
 	indexvar = iname;
+	revert = 0;
+	used[j]++;
+	if (cvec_len(cvk) > 1)
+	    filter++;
     }
-#else
+#endif
     if (revert)
 	goto revert;
-#endif
     if (clixon_xml_parse_string(cbuf_get(cb), YB_NONE, NULL, &xc, NULL) < 0)
 	goto done;
     if (xml_rootchild(xc, 0, &xc) < 0)
@@ -1429,7 +2179,17 @@ xml_find_index_yang(cxobj       *xp,
 	if (xml_spec_set(xk, yk) < 0) 
 	    goto done;
     }
-    if (xml_search_yang(xp, xc, yc, 1, indexvar, xvec) < 0)
+    if (filter){ /* cvk entries not used are not in search object */
+	if ((xv = clixon_xvec_new()) == NULL)
+	    goto done;
+	if (xml_search_yang(xp, xc, yc, skip1, indexvar, xv) < 0)
+	    goto done;
+	for (j=0; j<clixon_xvec_len(xv); j++)
+	    if (xml_find_index_match(clixon_xvec_i(xv, j), cvk, used) &&
+		clixon_xvec_append(xvec, clixon_xvec_i(xv, j)) < 0)
+		goto done;
+    }
+    else if (xml_search_yang(xp, xc, yc, skip1, indexvar, xvec) < 0)
 	goto done;
     retval = 1; /* OK */
  done:
@@ -1437,6 +2197,10 @@ xml_find_index_yang(cxobj       *xp,
 	cbuf_free(cb);
     if (xc)
 	xml_free(xc);
+    if (xv)
+	clixon_xvec_free(xv);
+    if (used)
+	free(used);
     return retval;
  revert: /* means give up yang/key search, try next (eg explicit/noyang) */
     retval = 0;
@@ -1465,6 +2229,8 @@ xml_find_index_yang(cxobj       *xp,
  * - if xp is leaf-list and "id" is "."
  * - if xp is a yang list and "id" is a registered index key
  * - if xp is a yang list and first "id" is first leaf key, second "id" is second leaf key, etc.
+ * - if xp is a yang list and any "id" is a registered index variable
+ * - In the last two cases, other "id":s are matched against the elements found
  * - Otherwise search is made using linear search
  * 
  * @param[in]  xp     Parent xml node. 
@@ -1582,3 +2348,60 @@ clixon_xml_find_pos(cxobj        *xp,
  done:
     return retval;
 }
+
+/*! Find the children of an xml node that have a given yang spec using binary search
+ *
+ * Children of an xml node bound to yang and sorted are in yang order, so all children
+ * of the same yang node are adjacent, eg all entries of a list.
+ * @param[in]  xp     Parent xml node, bound to yang and sorted
+ * @param[in]  yc     Yang spec of children, data node child of the spec of xp
+ * @param[out] first  Position of first child with spec yc
+ * @param[out] len    Number of children with spec yc, may be 0
+ * @retval     1      OK
+ * @retval     0      A child without yang spec was found, use linear search
+ * @see xml_search_yang  which makes the same assumption
+ */
+int
+xml_child_range_yang(cxobj     *xp,
+		     yang_stmt *yc,
+		     int       *first,
+		     int       *len)
+{
+    cxobj     *xc;
+    yang_stmt *y;
+    int        yangi;
+    int        low;
+    int        upper;
+    int        mid;
+    int        i;
+    int        n;
+
+    n = xml_child_nr(xp);
+    /* Assume if there are any attributes, they are first in the list */
+    for (low=0; low<n; low++)
+	if ((xc = xml_child_i(xp, low)) == NULL || xml_type(xc) != CX_ATTR)
+	    break;
+    yangi = yang_order(yc);
+    upper = n;
+    /* Find first child with yang order not less than that of yc */
+    while (low < upper){
+	mid = (low + upper) / 2;
+	xc = xml_child_i(xp, mid);
+	if (xml_type(xc) != CX_ELMNT || (y = xml_spec(xc)) == NULL)
+	    return 0;
+	if (yang_order(y) < yangi)
+	    low = mid + 1;
+	else
+	    upper = mid;
+    }
+    for (i=low; i<n; i++){
+	xc = xml_child_i(xp, i);
+	if (xml_type(xc) != CX_ELMNT || (y = xml_spec(xc)) == NULL)
+	    return 0;
+	if (y != yc)
+	    break;
+    }
+    *first = low;
+    *len = i - low;
+    return 1;
+}
@@ -198,6 +198,17 @@ clixon_xvec_i(clixon_xvec *xv,
 	return NULL;
 }
 
+/*! Return XML object vector, not a copy
+ * @param[in]  xv    XML tree vector
+ * @retval     vec   Vector of XML objects, valid until xv is changed
+ * @see clixon_xvec_extract  which moves the vector
+ */
+cxobj**
+clixon_xvec_vec(clixon_xvec *xv)
+{
+    return xv->xv_vec;
+}
+
 /*! Return whole XML object vector and null it in original xvec, essentially moving it
  *
  * Used in glue code between clixon_xvec code and cxobj **, size_t code, may go AWAY?
@@ -447,6 +447,81 @@ xpath_tree_traverse(xpath_tree *xt,
     return xs;
 }
 
+/*! Skip xpath tree nodes that only wrap a single child, eg expr -> andexpr -> relexpr
+ * @param[in]  xs  XPath tree
+ * @retval     xs  First node that is not a single-child wrapper
+ */
+xpath_tree *
+xpath_tree_unwrap(xpath_tree *xs)
+{
+    while (xs != NULL){
+	switch (xs->xs_type){
+	case XP_EXP:
+	case XP_AND:
+	case XP_RELEX:
+	case XP_ADD:
+	case XP_UNION:
+	    if (xs->xs_c1 != NULL)
+		return xs;
+	    break;
+	case XP_PATHEXPR:
+	case XP_PRI0:
+	    break;
+	default:
+	    return xs;
+	}
+	xs = xs->xs_c0;
+    }
+    return xs;
+}
+
+/*! Check if a predicate expression calls position() or last()
+ * @param[in]  xs  XPath tree
+ */
+static int
+xpath_tree_posfn(xpath_tree *xs)
+{
+    if (xs == NULL)
+	return 0;
+    if (xs->xs_type == XP_PRIME_FN && xs->xs_s0 &&
+	(strcmp(xs->xs_s0, "position") == 0 || strcmp(xs->xs_s0, "last") == 0))
+	return 1;
+    return xpath_tree_posfn(xs->xs_c0) || xpath_tree_posfn(xs->xs_c1);
+}
+
+/*! Check if a predicate expression may depend on the position of the context node
+ *
+ * A predicate filters nodes independently of their position if it evaluates to a 
+ * boolean (or a node-set) and does not call position() or last(). Otherwise, eg [3],
+ * the result may be a number compared with the context position.
+ * @param[in]  xs  XPath predicate expression tree
+ * @retval     1   Positional, or may be
+ * @retval     0   Not positional
+ */
+int
+xpath_tree_positional(xpath_tree *xs)
+{
+    xpath_tree *xe;
+
+    if (xpath_tree_posfn(xs))
+	return 1;
+    if ((xe = xpath_tree_unwrap(xs)) == NULL)
+	return 1;
+    switch (xe->xs_type){
+    case XP_EXP:   /* or */
+    case XP_AND:   /* and, or */
+    case XP_LOCPATH:
+	break;
+    case XP_RELEX: /* =, !=, <, etc */
+	if (xe->xs_int < XO_EQ || xe->xs_int > XO_GT)
+	    return 1;
+	break;
+    default:       /* Number or other value: may be a position */
+	return 1;
+    }
+    return 0;
+}
+
 /*! Free a xpath_tree
  * @param[in]  xs  XPATH tree
  * @see xpath_parse  creates a xpath_tree
@@ -572,6 +647,61 @@ xpath_vec_ctx(cxobj      *xcur,
     return retval;
 }
 
+/*! Evaluate an xpath and get the first node of the result
+ *
+ * Location paths are streamed and evaluation stops at the first selected node, other
+ * expressions are evaluated in full.
+ * @param[in]  xcur   XML tree where to search
+ * @param[in]  nsc    External XML namespace context, or NULL
+ * @param[in]  xpath  String with XPATH 1.0 syntax
+ * @param[in]  localonly Skip prefix and namespace tests (non-standard)
+ * @param[out] xfirst First node of node-set result, or NULL
+ * @param[out] xrp    Result context if evaluated in full, or NULL. Free with ctx_free
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see xp_eval_first
+ */
+static int
+xpath_first_ctx(cxobj      *xcur, 
+		cvec       *nsc,
+		const char *xpath,
+		int         localonly,
+		cxobj     **xfirst,
+		xp_ctx    **xrp)
+{
+    int         retval = -1;
+    xpath_tree *xptree = NULL;
+    xp_ctx      xc = {0,};
+    xp_ctx     *xr = NULL;
+    int         ret;
+    
+    *xfirst = NULL;
+    *xrp = NULL;
+    if (xpath_parse(xpath, &xptree) < 0)
+	goto done;
+    xc.xc_type = XT_NODESET;
+    xc.xc_node = xcur;
+    xc.xc_initial = xcur;
+    if (cxvec_append(xcur, &xc.xc_nodeset, &xc.xc_size) < 0)
+	goto done;
+    if ((ret = xp_eval_first(&xc, xptree, nsc, localonly, xfirst)) < 0)
+	goto done;
+    if (ret == 0){
+	if (xp_eval(&xc, xptree, nsc, localonly, &xr) < 0)
+	    goto done;
+	if (xr->xc_type == XT_NODESET && xr->xc_size)
+	    *xfirst = xr->xc_nodeset[0];
+	*xrp = xr;
+    }
+    retval = 0;
+ done:
+    if (xc.xc_nodeset)
+	free(xc.xc_nodeset);
+    if (xptree)
+	xpath_tree_free(xptree);
+    return retval;
+}
+
 /*! XPath nodeset function where only the first matching entry is returned
  *
  * @param[in]  xcur      XML tree where to search
@@ -619,10 +749,8 @@ xpath_first(cxobj      *xcur,
 	goto done;
     }
     va_end(ap);
-    if (xpath_vec_ctx(xcur, nsc, xpath, 0, &xr) < 0)
+    if (xpath_first_ctx(xcur, nsc, xpath, 0, &cx, &xr) < 0)
 	goto done;
-    if (xr && xr->xc_type == XT_NODESET && xr->xc_size)
-	cx = xr->xc_nodeset[0];
  done:
     if (xr)
 	ctx_free(xr);
@@ -678,10 +806,8 @@ xpath_first_localonly(cxobj      *xcur,
 	goto done;
     }
     va_end(ap);
-    if (xpath_vec_ctx(xcur, NULL, xpath, 1, &xr) < 0)
+    if (xpath_first_ctx(xcur, NULL, xpath, 1, &cx, &xr) < 0)
 	goto done;
-    if (xr && xr->xc_type == XT_NODESET && xr->xc_size)
-	cx = xr->xc_nodeset[0];
  done:
     if (xr)
 	ctx_free(xr);
@@ -858,6 +984,7 @@ xpath_vec_bool(cxobj      *xcur,
     size_t     len;
     char      *xpath = NULL;
     xp_ctx    *xr = NULL;
+    cxobj     *x;
     
     va_start(ap, xpformat);    
     len = vsnprintf(NULL, 0, xpformat, ap);
@@ -875,10 +1002,13 @@ xpath_vec_bool(cxobj      *xcur,
 	goto done;
     }
     va_end(ap);
-    if (xpath_vec_ctx(xcur, nsc, xpath, 0, &xr) < 0)
+    /* A location path is true if it selects a node */
+    if (xpath_first_ctx(xcur, nsc, xpath, 0, &x, &xr) < 0)
 	goto done;
     if (xr)
 	retval = ctx2boolean(xr);
+    else
+	retval = (x != NULL);
  done:
     if (xr)
 	ctx_free(xr);
@@ -129,9 +129,6 @@ nodetest_eval_node(cxobj      *x,
     /* Namespaces is s0, name is s1 */
     if (strcmp(xs->xs_s1, "*")==0)
 	return 1;
-    /* get namespace of xml tree */
-    if (xml2ns(x, prefix1, &nsxml) < 0)
-	goto done;
     prefix2 = xs->xs_s0;
     name2 = xs->xs_s1;
     /* Before going into namespaces, check name equality and filter out noteq  */
@@ -139,6 +136,9 @@ nodetest_eval_node(cxobj      *x,
 	retval = 0; /* no match */
 	goto done;
     }
+    /* get namespace of xml tree */
+    if (xml2ns(x, prefix1, &nsxml) < 0)
+	goto done;
     /* here names are equal 
      * Now look for namespaces
      * 1) prefix1 and prefix2 point to same namespace <<-- try this first
@@ -235,7 +235,22 @@ nodetest_eval(cxobj      *x,
     return retval;
 }
 
+/*! Get the name of a nodetest that only matches elements with that name
+ * @param[in]  nodetest  XPATH stack of type XP_NODE or XP_NODE_FN
+ * @retval     name      Name, without prefix
+ * @retval     NULL      Also matches other names, eg * or node()
+ */
+static char *
+nodetest_name(xpath_tree *nodetest)
+{
+    if (nodetest == NULL || nodetest->xs_type != XP_NODE ||
+	nodetest->xs_s1 == NULL || strcmp(nodetest->xs_s1, "*") == 0)
+	return NULL;
+    return nodetest->xs_s1;
+}
+
 /*!
+ * Subtrees that have no descendant with the name of the nodetest are skipped
  * @param[in]  xn
  * @param[in]  nodetest  XPATH stack
  * @param[in]  node_type
@@ -259,6 +274,7 @@ nodetest_recursive(cxobj      *xn,
     cxobj  *xsub; 
     cxobj **vec = *vec0;
     int     veclen = *vec0len;
+    char   *name = nodetest_name(nodetest);
 
     xsub = NULL;
     while ((xsub = xml_child_each(xn, xsub, node_type)) != NULL) {
@@ -269,6 +285,8 @@ nodetest_recursive(cxobj      *xn,
 		    goto done;
 	    //	    continue; /* Dont go deeper */
 	}
+	if (name && !xml_descendant_maybe(xsub, name))
+	    continue;
 	if (nodetest_recursive(xsub, nodetest, node_type, flags, nsc, localonly, &vec, &veclen) < 0)
 	    goto done;
     }
@@ -279,6 +297,79 @@ nodetest_recursive(cxobj      *xn,
     return retval;
 }
 
+/*! Resolve the yang spec of the children selected by a child step
+ *
+ * The name and namespace of the nodetest are looked up among the data node children
+ * of the yang spec of the context node. The result is cached in the step, since
+ * consecutive context nodes usually have the same spec, eg entries of a list.
+ * @param[in]  xs    XPath tree of type STEP
+ * @param[in]  yp    Yang spec of context node
+ * @param[in]  nsc   XML Namespace context
+ * @retval     yc    Yang spec of the children the step selects
+ * @retval     NULL  Not resolved, eg no namespace context or not in schema
+ */
+static yang_stmt *
+xp_step_yang(xpath_tree *xs,
+	     yang_stmt  *yp,
+	     cvec       *nsc)
+{
+    yang_stmt *yc = NULL;
+    char      *name;
+    char      *ns;
+    char      *ns1;
+
+    if (xs->xs_yparent == yp)
+	return xs->xs_ychild;
+    if ((yang_keyword_get(yp) == Y_CONTAINER || yang_keyword_get(yp) == Y_LIST) &&
+	(name = nodetest_name(xs->xs_c0)) != NULL &&
+	nsc != NULL &&
+	(ns = xml_nsctx_get(nsc, xs->xs_c0->xs_s0)) != NULL &&
+	(yc = yang_find_datanode(yp, name)) != NULL){
+	/* Names are unique within a namespace, a node from another module with the
+	 * same name may be found instead */
+	if ((ns1 = yang_find_mynamespace(yc)) == NULL || strcmp(ns, ns1) != 0)
+	    yc = NULL;
+    }
+    xs->xs_yparent = yp;
+    xs->xs_ychild = yc;
+    return yc;
+}
+
+/*! Get the children of a node that a child step may select, using the schema
+ *
+ * If the node is bound to yang and the step resolves to a yang child, only the
+ * adjacent children with that spec are candidates, found with binary search, and
+ * all other children and their subtrees are skipped.
+ * Only made if the node has more children than its yang spec has statements, ie
+ * there are list entries, otherwise a linear scan is as fast.
+ * @param[in]  xs     XPath tree of type STEP, child axis
+ * @param[in]  xv     Context node
+ * @param[in]  nsc    XML Namespace context
+ * @param[in]  localonly Skip prefix and namespace tests (non-standard)
+ * @param[out] first  Position of first candidate child
+ * @param[out] len    Number of candidate children
+ * @retval     1      OK, children first..first+len-1 all match the nodetest
+ * @retval     0      Not resolved, test all children
+ */
+static int
+xp_step_children(xpath_tree *xs,
+		 cxobj      *xv,
+		 cvec       *nsc,
+		 int         localonly,
+		 int        *first,
+		 int        *len)
+{
+    yang_stmt *yp;
+    yang_stmt *yc;
+
+    if (localonly ||
+	(yp = xml_spec(xv)) == NULL ||
+	xml_child_nr(xv) <= yang_len_get(yp) ||
+	(yc = xp_step_yang(xs, yp, nsc)) == NULL)
+	return 0;
+    return xml_child_range_yang(xv, yc, first, len);
+}
+
 /*! Evaluate xpath step rule of an XML tree
  *
  * @param[in]  xc0  Incoming context
@@ -308,11 +399,25 @@ xp_eval_step(xp_ctx     *xc0,
     cxobj     **vec = NULL;
     int         veclen = 0;
     xpath_tree *nodetest = xs->xs_c0;
+    xpath_tree *xpred;
     xp_ctx     *xc = NULL;
+    int         j;
+    int         n;
     int         ret;
     
-    /* Create new xc */
-    if ((xc = ctx_dup(xc0)) == NULL)
+    /* Create new xc, the child and descendant axes replace its nodeset so it is
+     * not copied */
+    if (xs->xs_int == A_CHILD || xs->xs_int == A_DESCENDANT){
+	if ((xc = malloc(sizeof(*xc))) == NULL){
+	    clicon_err(OE_UNIX, errno, "malloc");
+	    goto done;
+	}
+	memset(xc, 0, sizeof(*xc));
+	xc->xc_type = xc0->xc_type;
+	xc->xc_node = xc0->xc_node;
+	xc->xc_initial = xc0->xc_initial;
+    }
+    else if ((xc = ctx_dup(xc0)) == NULL)
 	goto done;
     switch (xs->xs_int){
     case A_ANCESTOR:
@@ -322,13 +427,12 @@ xp_eval_step(xp_ctx     *xc0,
     case A_ATTRIBUTE: /* principal node type is attribute */
 	break;
     case A_CHILD:
-	if (xc->xc_descendant){
-	    for (i=0; i<xc->xc_size; i++){
-		xv = xc->xc_nodeset[i];
+	if (xc0->xc_descendant){
+	    for (i=0; i<xc0->xc_size; i++){
+		xv = xc0->xc_nodeset[i];
 		if (nodetest_recursive(xv, nodetest, CX_ELMNT, 0x0, nsc, localonly, &vec, &veclen) < 0)
 		    goto done;
 	    }
-	    xc->xc_descendant = 0;
 	}
 	else{
 	    if (nodetest->xs_type==XP_NODE_FN &&
@@ -337,12 +441,18 @@ xp_eval_step(xp_ctx     *xc0,
 		if (cxvec_append(xc->xc_initial, &vec, &veclen) < 0)
 		    goto done;
 	    }
-	    else for (i=0; i<xc->xc_size; i++){ 
-		    xv = xc->xc_nodeset[i];
+	    else for (i=0; i<xc0->xc_size; i++){ 
+		    xv = xc0->xc_nodeset[i];
 		    x = NULL; 
 		    if ((ret = xpath_optimize_check(xs, xv, &vec, &veclen)) < 0)
 			goto done;
-		    if (ret == 0){/* regular code, no optimization made */
+		    if (ret == 0 &&
+			xp_step_children(xs, xv, nsc, localonly, &j, &n) == 1){
+			for (; n>0; j++, n--)
+			    if (cxvec_append(xml_child_i(xv, j), &vec, &veclen) < 0)
+				goto done;
+		    }
+		    else if (ret == 0){/* regular code, no optimization made */
 			while ((x = xml_child_each(xv, x, CX_ELMNT)) != NULL) {
 			    /* xs->xs_c0 is nodetest */
 			    if (nodetest == NULL || nodetest_eval(x, nodetest, nsc, localonly) == 1){
@@ -372,8 +482,8 @@ xp_eval_step(xp_ctx     *xc0,
 	}
 	break;
     case A_DESCENDANT:
-	for (i=0; i<xc->xc_size; i++){
-	    xv = xc->xc_nodeset[i];
+	for (i=0; i<xc0->xc_size; i++){
+	    xv = xc0->xc_nodeset[i];
 	    if (nodetest_recursive(xv, xs->xs_c0, CX_ELMNT, 0x0, nsc, localonly, &vec, &veclen) < 0)
 		goto done;
 	}
@@ -412,8 +522,9 @@ xp_eval_step(xp_ctx     *xc0,
 	goto done;
 	break;
     }
-    if (xs->xs_c1){
-	if (xp_eval(xc, xs->xs_c1, nsc, localonly, xrp) < 0)
+    /* Predicates, an empty predicate node is the base of the predicate list */
+    if ((xpred = xs->xs_c1) != NULL && (xpred->xs_c0 != NULL || xpred->xs_c1 != NULL)){
+	if (xp_eval(xc, xpred, nsc, localonly, xrp) < 0)
 	    goto done;
     }
     else{
@@ -465,19 +576,21 @@ xp_eval_predicate(xp_ctx     *xc,
     xp_ctx  *xrc = NULL;
     int      i;
     cxobj   *x;
-    xp_ctx  *xcc;
+    xp_ctx  *xin;        /* Node-set to filter */
+    xp_ctx  *xcc = NULL; /* Context of each node */
     
-    if (xs->xs_c0 == NULL){ /* empty */
-	if ((xr0 = ctx_dup(xc)) == NULL)
-	    goto done;
-    }
-    else{ /* eval previous predicates */
+    if (xs->xs_c0 != NULL){ /* eval previous predicates */
 	if (xp_eval(xc, xs->xs_c0, nsc, localonly, &xr0) < 0) 	
 	    goto done;	
+	xin = xr0;
     }
+    else if (xs->xs_c1 != NULL) /* first predicate filters incoming node-set */
+	xin = xc;
+    else if ((xr0 = ctx_dup(xc)) == NULL) /* empty */
+	goto done;
     if (xs->xs_c1){
 	/* Loop over each node in the nodeset */
-	assert (xr0->xc_type == XT_NODESET);
+	assert (xin->xc_type == XT_NODESET);
 	if ((xr1 = malloc(sizeof(*xr1))) == NULL){
 	    clicon_err(OE_UNIX, errno, "malloc");
 	    goto done;
@@ -486,25 +599,30 @@ xp_eval_predicate(xp_ctx     *xc,
 	xr1->xc_type = XT_NODESET;
 	xr1->xc_node = xc->xc_node;
 	xr1->xc_initial = xc->xc_initial;
-	for (i=0; i<xr0->xc_size; i++){
-	    x = xr0->xc_nodeset[i];
-	    /* Create new context */
-	    if ((xcc = malloc(sizeof(*xcc))) == NULL){
-		clicon_err(OE_XML, errno, "malloc");
-		goto done;
-	    }
-	    memset(xcc, 0, sizeof(*xcc));
-	    xcc->xc_type = XT_NODESET;
-	    xcc->xc_initial = xc->xc_initial;
-	    xcc->xc_node = x;
+	/* Create new context, reused for each node */
+	if ((xcc = malloc(sizeof(*xcc))) == NULL){
+	    clicon_err(OE_XML, errno, "malloc");
+	    goto done;
+	}
+	memset(xcc, 0, sizeof(*xcc));
+	xcc->xc_type = XT_NODESET;
+	xcc->xc_initial = xc->xc_initial;
+	for (i=0; i<xin->xc_size; i++){
+	    x = xin->xc_nodeset[i];
 	    /* For each node in the node-set to be filtered, the PredicateExpr is
 	     * evaluated with that node as the context node */
-	    if (cxvec_append(x, &xcc->xc_nodeset, &xcc->xc_size) < 0)
-		goto done;
+	    xcc->xc_node = x;
+	    xcc->xc_descendant = 0;
+	    if (xcc->xc_size == 0){
+		if (cxvec_append(x, &xcc->xc_nodeset, &xcc->xc_size) < 0)
+		    goto done;
+	    }
+	    else{
+		xcc->xc_nodeset[0] = x;
+		xcc->xc_size = 1;
+	    }
 	    if (xp_eval(xcc, xs->xs_c1, nsc, localonly, &xrc) < 0)
 		goto done;
-	    if (xcc)
-		ctx_free(xcc);
 	    if (xrc->xc_type == XT_NUMBER){
 		/* If the result is a number, the result will be converted to true
 		   if the number is equal to the context position */
@@ -536,6 +654,8 @@ xp_eval_predicate(xp_ctx     *xc,
 	}
     retval = 0;
  done:
+    if (xcc)
+	ctx_free(xcc);
     if (xr0)
 	ctx_free(xr0);
     if (xr1)
@@ -654,6 +774,81 @@ xp_numop(xp_ctx    *xc1,
     return retval;
 }
 
+/*! Compare the string-value of a node with a string or a number
+ * @param[in]  x        XML node
+ * @param[in]  xc2      Context of other operand, of type string or number
+ * @param[in]  op       Relational operator
+ * @param[in]  reverse  The node is the second operand
+ * @retval     1        Comparison is true
+ * @retval     0        Comparison is false
+ * @retval    -1        Error
+ */
+static int
+xp_relop_node(cxobj     *x,
+	      xp_ctx    *xc2,
+	      enum xp_op op,
+	      int        reverse)
+{
+    int     retval = -1;
+    char   *s1;
+    char   *s2;
+    double  n1, n2;
+
+    s1 = xml_body(x);
+    if (xc2->xc_type == XT_STRING){
+	s2 = xc2->xc_string;
+	switch(op){
+	case XO_EQ:
+	    if (s1 == NULL || s2 == NULL)
+		retval = (s1==NULL && s2 == NULL);
+	    else
+		retval = (strcmp(s1, s2)==0);
+	    break;
+	case XO_NE:
+	    if (s1 == NULL || s2 == NULL)
+		retval = !(s1==NULL && s2 == NULL);
+	    else
+		retval = (strcmp(s1, s2)!=0);
+	    break;
+	default:
+	    clicon_err(OE_XML, 0, "Operator %s not supported for nodeset and string", clicon_int2str(xpopmap,op));
+	    goto done;
+	    break;
+	}
+    }
+    else{
+	if (s1 == NULL || sscanf(s1, "%lf", &n1) != 1)
+	    n1 = NAN;
+	n2 = xc2->xc_number;
+	switch(op){
+	case XO_EQ:
+	    retval = (n1 == n2);
+	    break;
+	case XO_NE:
+	    retval = (n1 != n2);
+	    break;
+	case XO_GE:
+	    retval = reverse?(n2 >= n1):(n1 >= n2);
+	    break;
+	case XO_LE:
+	    retval = reverse?(n2 <= n1):(n1 <= n2);
+	    break;
+	case XO_LT:
+	    retval = reverse?(n2 < n1):(n1 < n2);
+	    break;
+	case XO_GT:
+	    retval = reverse?(n2 > n1):(n1 > n2);
+	    break;
+	default:
+	    clicon_err(OE_XML, 0, "Operator %s not supported for nodeset and number", clicon_int2str(xpopmap,op));
+	    goto done;
+	    break;
+	}
+    }
+ done:
+    return retval;
+}
+
 /*! Given two XPATH contexts, eval relational operations: <>=
  * A RelationalExpr is evaluated by comparing the objects that result from 
  * evaluating the two operands.
@@ -691,7 +886,6 @@ xp_relop(xp_ctx    *xc1,
     char   *s1;
     char   *s2;
     int     reverse = 0;
-    double  n1, n2;
     
     if ((xr = malloc(sizeof(*xr))) == NULL){
 	clicon_err(OE_UNIX, errno, "malloc");
@@ -790,67 +984,17 @@ xp_relop(xp_ctx    *xc1,
 	    } /* switch op */
 	    break;
 	case XT_STRING:
+	case XT_NUMBER:
 	    /* If one object to be compared is a node-set and the
-	       other is a string, then the comparison will be true if and only
-	       if there is a node in the node-set such that the result of
+	       other is a string or number, then the comparison will be true if and
+	       only if there is a node in the node-set such that the result of
 	       performing the comparison on the string-value of the node and 
-	       the other string is true.*/
-	    s2 = xc2->xc_string;
+	       the other object is true.*/
 	    for (i=0; i<xc1->xc_size; i++){
 		x = xc1->xc_nodeset[i]; /* node in nodeset */
-		s1 = xml_body(x);
-		switch(op){
-		case XO_EQ:
-		    if (s1 == NULL || s2 == NULL)
-			xr->xc_bool = (s1==NULL && s2 == NULL);
-		    else
-			xr->xc_bool = (strcmp(s1, s2)==0);
-		    break;
-		case XO_NE:
-		    if (s1 == NULL || s2 == NULL)
-			xr->xc_bool = !(s1==NULL && s2 == NULL);
-		    else
-			xr->xc_bool = (strcmp(s1, s2));
-		    break;
-		default:
-		    clicon_err(OE_XML, 0, "Operator %s not supported for nodeset and string", clicon_int2str(xpopmap,op));
-		goto done;
-		    break;
-		}
-		if (xr->xc_bool) /* enough to find a single node */
-		    break;
-	    }
-	    break;
-	case XT_NUMBER:
-	    for (i=0; i<xc1->xc_size; i++){
-		x = xc1->xc_nodeset[i]; /* node in nodeset */
-		if (sscanf(xml_body(x), "%lf", &n1) != 1)
-		    n1 = NAN;
-		n2 = xc2->xc_number;
-		switch(op){
-		case XO_EQ:
-		    xr->xc_bool = (n1 == n2);
-		    break;
-		case XO_NE:
-		    xr->xc_bool = (n1 != n2);
-		    break;
-		case XO_GE:
-		    xr->xc_bool = reverse?(n2 >= n1):(n1 >= n2);
-		    break;
-		case XO_LE:
-		    xr->xc_bool = reverse?(n2 <= n1):(n1 <= n2);
-		    break;
-		case XO_LT:
-		    xr->xc_bool = reverse?(n2 < n1):(n1 < n2);
-		    break;
-		case XO_GT:
-		    xr->xc_bool = reverse?(n2 > n1):(n1 > n2);
-		    break;
-		default:
-		    clicon_err(OE_XML, 0, "Operator %s not supported for nodeset and number", clicon_int2str(xpopmap,op));
-		goto done;
-		    break;
-		}
+		if ((b = xp_relop_node(x, xc2, op, reverse)) < 0)
+		    goto done;
+		xr->xc_bool = b;
 		if (xr->xc_bool) /* enough to find a single node */
 		    break;
 	    }
@@ -914,6 +1058,450 @@ xp_union(xp_ctx    *xc1,
     return retval;
 }
 
+/*
+ * Pull-based evaluation of location paths
+ * A location path is evaluated depth-first, one candidate node at a time through its
+ * steps and predicates, and each selected node is handed to a callback which may
+ * stop the evaluation. The nodes are selected in the same order as in the node-set
+ * made by xp_eval, but no node-sets are built. This is used when only the first node
+ * or existence is needed.
+ */
+
+/*! Callback for each node selected by a streamed location path
+ * @param[in]  x    Selected XML node
+ * @param[in]  arg  Callback argument
+ * @retval     1    Stop evaluation
+ * @retval     0    Continue
+ * @retval    -1    Error
+ */
+typedef int (xp_stream_fn)(cxobj *x, void *arg);
+
+/* Streamed location path evaluation state */
+typedef struct {
+    xpath_tree  **xst_steps;      /* Vector of location steps */
+    int           xst_len;        /* Length of step vector */
+    int           xst_descendant; /* First step selects descendants, ie leading // */
+    xp_ctx       *xst_xc;         /* Incoming context */
+    xp_ctx       *xst_xcc;        /* Single node context of predicates */
+    cvec         *xst_nsc;        /* XML Namespace context */
+    int           xst_localonly;  /* Skip prefix and namespace tests */
+    xp_stream_fn *xst_fn;         /* Callback of selected nodes */
+    void         *xst_arg;        /* Callback argument */
+} xp_stream;
+
+/* Argument of xp_relop_stream_fn */
+typedef struct {
+    xp_ctx     *xra_xc2;     /* Other operand, string or number */
+    enum xp_op  xra_op;      /* Relational operator */
+    int         xra_reverse; /* Node is second operand */
+    int         xra_bool;    /* Result */
+} xp_relop_arg;
+
+static int xp_stream_step(xp_stream *xst, cxobj *x, int i);
+
+/*! Collect the steps of a relative location path that can be streamed
+ * Supported are child steps, '.' and '..', where the predicates do not depend on the
+ * position of nodes.
+ * @param[in]  xs     XPath tree of type RELLOCPATH
+ * @param[out] steps  Vector of steps, or NULL to only count them
+ * @param[out] len    Number of steps
+ * @retval     1      OK
+ * @retval     0      Path cannot be streamed
+ */
+static int
+xp_stream_steps(xpath_tree  *xs,
+		xpath_tree **steps,
+		int         *len)
+{
+    xpath_tree *xstep;
+    xpath_tree *xp;
+
+    if (xs == NULL || xs->xs_type != XP_RELLOCPATH || xs->xs_int != A_NAN)
+	return 0;
+    if (xs->xs_c1 == NULL)
+	xstep = xs->xs_c0;
+    else{
+	if (xp_stream_steps(xs->xs_c0, steps, len) == 0)
+	    return 0;
+	xstep = xs->xs_c1;
+    }
+    if (xstep == NULL || xstep->xs_type != XP_STEP)
+	return 0;
+    switch (xstep->xs_int){
+    case A_CHILD:
+	if (xstep->xs_c0 == NULL)
+	    return 0;
+	break;
+    case A_SELF:
+    case A_PARENT:
+	break;
+    default:
+	return 0;
+    }
+    for (xp = xstep->xs_c1; xp != NULL; xp = xp->xs_c0)
+	if (xp->xs_type != XP_PRED ||
+	    (xp->xs_c1 != NULL && xpath_tree_positional(xp->xs_c1)))
+	    return 0;
+    if (steps)
+	steps[*len] = xstep;
+    (*len)++;
+    return 1;
+}
+
+/*! Evaluate the predicates of a step on a single node
+ * @param[in]  xst  Stream state
+ * @param[in]  xp   XPath tree of type PRED
+ * @param[in]  x    XML node
+ * @retval     1    All predicates are true
+ * @retval     0    A predicate is false
+ * @retval    -1    Error
+ */
+static int
+xp_stream_preds(xp_stream  *xst,
+		xpath_tree *xp,
+		cxobj      *x)
+{
+    int     retval = -1;
+    xp_ctx *xcc = xst->xst_xcc;
+    xp_ctx *xrc = NULL;
+
+    if (xp == NULL)
+	return 1;
+    if (xp->xs_c0 && (retval = xp_stream_preds(xst, xp->xs_c0, x)) != 1)
+	goto done;
+    if (xp->xs_c1 == NULL){
+	retval = 1;
+	goto done;
+    }
+    xcc->xc_node = x;
+    xcc->xc_nodeset[0] = x;
+    xcc->xc_size = 1;
+    xcc->xc_descendant = 0;
+    if (xp_eval(xcc, xp->xs_c1, xst->xst_nsc, xst->xst_localonly, &xrc) < 0){
+	retval = -1;
+	goto done;
+    }
+    retval = ctx2boolean(xrc);
+ done:
+    if (xrc)
+	ctx_free(xrc);
+    return retval;
+}
+
+/*! A candidate node of step i, check predicates and continue with next step
+ * @param[in]  xst  Stream state
+ * @param[in]  x    XML node
+ * @param[in]  i    Step index
+ * @retval     1    Stopped by callback
+ * @retval     0    Continue
+ * @retval    -1    Error
+ */
+static int
+xp_stream_node(xp_stream *xst,
+	       cxobj     *x,
+	       int        i)
+{
+    int ret;
+
+    if ((ret = xp_stream_preds(xst, xst->xst_steps[i]->xs_c1, x)) != 1)
+	return ret;
+    return xp_stream_step(xst, x, i+1);
+}
+
+/*! Descendants of a node as candidates of step i, in document order
+ * @see nodetest_recursive
+ */
+static int
+xp_stream_descendants(xp_stream *xst,
+		      cxobj     *xn,
+		      int        i)
+{
+    int         ret;
+    cxobj      *xsub;
+    xpath_tree *nodetest = xst->xst_steps[i]->xs_c0;
+    char       *name = nodetest_name(nodetest);
+
+    xsub = NULL;
+    while ((xsub = xml_child_each(xn, xsub, CX_ELMNT)) != NULL) {
+	if (nodetest_eval(xsub, nodetest, xst->xst_nsc, xst->xst_localonly) == 1 &&
+	    (ret = xp_stream_node(xst, xsub, i)) != 0)
+	    return ret;
+	if (name && !xml_descendant_maybe(xsub, name))
+	    continue;
+	if ((ret = xp_stream_descendants(xst, xsub, i)) != 0)
+	    return ret;
+    }
+    return 0;
+}
+
+/*! Evaluate step i of a streamed location path from a context node
+ * @param[in]  xst  Stream state
+ * @param[in]  x    Context XML node
+ * @param[in]  i    Step index, if past last step, x is selected
+ * @retval     1    Stopped by callback
+ * @retval     0    Continue
+ * @retval    -1    Error
+ * @see xp_eval_step
+ */
+static int
+xp_stream_step(xp_stream *xst,
+	       cxobj     *x,
+	       int        i)
+{
+    int         retval = -1;
+    xpath_tree *xs;
+    xpath_tree *nodetest;
+    cxobj      *xc;
+    cxobj     **vec = NULL;
+    int         veclen = 0;
+    int         j;
+    int         n;
+    int         ret;
+
+    if (i == xst->xst_len)
+	return xst->xst_fn(x, xst->xst_arg);
+    xs = xst->xst_steps[i];
+    nodetest = xs->xs_c0;
+    switch (xs->xs_int){
+    case A_SELF:
+	retval = xp_stream_node(xst, x, i);
+	goto done;
+	break;
+    case A_PARENT:
+	if ((xc = xml_parent(x)) == NULL)
+	    retval = 0;
+	else
+	    retval = xp_stream_node(xst, xc, i);
+	goto done;
+	break;
+    default: /* A_CHILD */
+	break;
+    }
+    if (i == 0 && xst->xst_descendant){
+	retval = xp_stream_descendants(xst, x, i);
+	goto done;
+    }
+    if (nodetest->xs_type==XP_NODE_FN &&
+	nodetest->xs_s0 &&
+	strcmp(nodetest->xs_s0, "current")==0){
+	retval = xp_stream_node(xst, xst->xst_xc->xc_initial, i);
+	goto done;
+    }
+    if ((ret = xpath_optimize_check(xs, x, &vec, &veclen)) < 0)
+	goto done;
+    if (ret == 1){ /* optimized lookup */
+	ret = 0;
+	for (j=0; j<veclen; j++)
+	    if ((ret = xp_stream_node(xst, vec[j], i)) != 0)
+		break;
+    }
+    else if (xp_step_children(xs, x, xst->xst_nsc, xst->xst_localonly, &j, &n) == 1){
+	ret = 0;
+	for (; n>0; j++, n--)
+	    if ((ret = xp_stream_node(xst, xml_child_i(x, j), i)) != 0)
+		break;
+    }
+    else{
+	xc = NULL;
+	while ((xc = xml_child_each(x, xc, CX_ELMNT)) != NULL) {
+	    if (nodetest_eval(xc, nodetest, xst->xst_nsc, xst->xst_localonly) == 1 &&
+		(ret = xp_stream_node(xst, xc, i)) != 0)
+		break;
+	}
+    }
+    retval = ret;
+ done:
+    if (vec)
+	free(vec);
+    return retval;
+}
+
+/*! Evaluate a location path and call a function for each selected node
+ *
+ * Only location paths of child steps, '.' and '..' with an optional leading '/' or 
+ * '//', and predicates that do not depend on node position, are streamed.
+ * @param[in]  xc    Incoming context
+ * @param[in]  xs    XPATH node tree, unwrapped
+ * @param[in]  nsc   XML Namespace context
+ * @param[in]  localonly Skip prefix and namespace tests (non-standard)
+ * @param[in]  fn    Called for each selected node until it returns 1
+ * @param[in]  arg   Argument of fn
+ * @retval     1    OK
+ * @retval     0    Not a location path that can be streamed
+ * @retval    -1    Error
+ */
+static int
+xp_stream_path(xp_ctx       *xc,
+	       xpath_tree   *xs,
+	       cvec         *nsc,
+	       int           localonly,
+	       xp_stream_fn *fn,
+	       void         *arg)
+{
+    int         retval = -1;
+    xp_stream   xst = {0,};
+    xpath_tree *xr;
+    cxobj      *x;
+    int         len = 0;
+    int         i;
+    int         ret = 0;
+
+    if (xs == NULL || xs->xs_type != XP_LOCPATH ||
+	(xr = xs->xs_c0) == NULL || xc->xc_descendant)
+	goto notapplicable;
+    if (xr->xs_type == XP_ABSPATH){
+	xst.xst_descendant = (xr->xs_int == A_DESCENDANT_OR_SELF);
+	xr = xr->xs_c0;
+    }
+    if (xp_stream_steps(xr, NULL, &len) == 0)
+	goto notapplicable;
+    if ((xst.xst_steps = malloc(len*sizeof(xpath_tree *))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto done;
+    }
+    xp_stream_steps(xr, xst.xst_steps, &xst.xst_len);
+    /* Descendant flag of // is only consumed by a child step */
+    if (xst.xst_descendant && xst.xst_steps[0]->xs_int != A_CHILD)
+	goto notapplicable;
+    if ((xst.xst_xcc = malloc(sizeof(*xst.xst_xcc))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto done;
+    }
+    memset(xst.xst_xcc, 0, sizeof(*xst.xst_xcc));
+    xst.xst_xcc->xc_type = XT_NODESET;
+    xst.xst_xcc->xc_initial = xc->xc_initial;
+    if (cxvec_append(xc->xc_node, &xst.xst_xcc->xc_nodeset, &xst.xst_xcc->xc_size) < 0)
+	goto done;
+    xst.xst_xc = xc;
+    xst.xst_nsc = nsc;
+    xst.xst_localonly = localonly;
+    xst.xst_fn = fn;
+    xst.xst_arg = arg;
+    if (xs->xs_c0->xs_type == XP_ABSPATH){
+	/* Context node is top node */
+	x = xc->xc_node;
+	while (xml_parent(x) != NULL)
+	    x = xml_parent(x);
+	ret = xp_stream_step(&xst, x, 0);
+    }
+    else
+	for (i=0; i<xc->xc_size; i++)
+	    if ((ret = xp_stream_step(&xst, xc->xc_nodeset[i], 0)) != 0)
+		break;
+    if (ret < 0)
+	goto done;
+    retval = 1;
+ done:
+    if (xst.xst_xcc)
+	ctx_free(xst.xst_xcc);
+    if (xst.xst_steps)
+	free(xst.xst_steps);
+    return retval;
+ notapplicable:
+    retval = 0;
+    goto done;
+}
+
+/*! Stream callback of xp_eval_first: keep first node and stop
+ */
+static int
+xp_first_stream_fn(cxobj *x,
+		   void  *arg)
+{
+    *(cxobj **)arg = x;
+    return 1;
+}
+
+/*! Stream callback of xp_relop_stream: compare node and stop at first true comparison
+ */
+static int
+xp_relop_stream_fn(cxobj *x,
+		   void  *arg)
+{
+    xp_relop_arg *xra = (xp_relop_arg *)arg;
+    int           ret;
+
+    if ((ret = xp_relop_node(x, xra->xra_xc2, xra->xra_op, xra->xra_reverse)) < 0)
+	return -1;
+    xra->xra_bool = ret;
+    return ret;
+}
+
+/*! Evaluate relational operation between a location path and a literal
+ *
+ * Eg x/y = 'foo' is true if any node selected by x/y has string-value 'foo', so the
+ * location path is streamed and evaluation stops at the first such node.
+ * @param[in]  xc   Incoming context
+ * @param[in]  xs   XPATH node tree of type RELEX with two operands
+ * @param[in]  nsc  XML Namespace context
+ * @param[in]  localonly Skip prefix and namespace tests (non-standard)
+ * @param[out] xrp  Resulting context, of type boolean
+ * @retval     1    OK
+ * @retval     0    Not applicable, use xp_relop
+ * @retval    -1    Error
+ * @see xp_relop
+ */
+static int
+xp_relop_stream(xp_ctx     *xc,
+		xpath_tree *xs,
+		cvec       *nsc,
+		int         localonly,
+		xp_ctx    **xrp)
+{
+    int           retval = -1;
+    xpath_tree   *xpath;
+    xpath_tree   *xlit;
+    xp_ctx        xc2 = {0,};
+    xp_ctx       *xr = NULL;
+    xp_relop_arg  xra = {0,};
+    int           ret;
+
+    xpath = xpath_tree_unwrap(xs->xs_c0);
+    xlit = xpath_tree_unwrap(xs->xs_c1);
+    if (xlit == NULL ||
+	(xlit->xs_type != XP_PRIME_STR && xlit->xs_type != XP_PRIME_NR)){
+	xlit = xpath;
+	xpath = xpath_tree_unwrap(xs->xs_c1);
+	xra.xra_reverse = 1;
+    }
+    if (xlit == NULL)
+	goto notapplicable;
+    if (xlit->xs_type == XP_PRIME_STR){
+	/* Other operators are errors reported by xp_relop */
+	if (xs->xs_int != XO_EQ && xs->xs_int != XO_NE)
+	    goto notapplicable;
+	xc2.xc_type = XT_STRING;
+	xc2.xc_string = xlit->xs_s0;
+    }
+    else if (xlit->xs_type == XP_PRIME_NR){
+	xc2.xc_type = XT_NUMBER;
+	xc2.xc_number = xlit->xs_double;
+    }
+    else
+	goto notapplicable;
+    xra.xra_xc2 = &xc2;
+    xra.xra_op = xs->xs_int;
+    if ((ret = xp_stream_path(xc, xpath, nsc, localonly, xp_relop_stream_fn, &xra)) < 0)
+	goto done;
+    if (ret == 0)
+	goto notapplicable;
+    if ((xr = malloc(sizeof(*xr))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto done;
+    }
+    memset(xr, 0, sizeof(*xr));
+    xr->xc_initial = xc->xc_initial;
+    xr->xc_type = XT_BOOL;
+    xr->xc_bool = xra.xra_bool;
+    *xrp = xr;
+    retval = 1;
+ done:
+    return retval;
+ notapplicable:
+    retval = 0;
+    goto done;
+}
+
 /*! Evaluate an XPATH on an XML tree
 
  * The initial sequence of steps selects a set of nodes relative to a context node. 
@@ -939,6 +1527,8 @@ xp_eval(xp_ctx     *xc,
     xp_ctx    *xr1 = NULL;
     xp_ctx    *xr2 = NULL;
     int        use_xr0 = 0; /* In 2nd child use transitively result of 1st child */
+    int        b;
+    int        ret;
     
     if (clicon_debug_get() > 1)
 	ctx_print(stderr, xc, xpath_tree_int2str(xs->xs_type));
@@ -972,6 +1562,14 @@ xp_eval(xp_ctx     *xc,
 	    goto done;
 	goto ok;
 	break;
+    case XP_RELEX: /* Location path and literal, stop at first true comparison */
+	if (xs->xs_c1){
+	    if ((ret = xp_relop_stream(xc, xs, nsc, localonly, xrp)) < 0)
+		goto done;
+	    if (ret == 1)
+		goto ok;
+	}
+	break;
     default:
 	break;
     }
@@ -987,6 +1585,21 @@ xp_eval(xp_ctx     *xc,
     case XP_EXP:
 	break;
     case XP_AND:
+	/* Skip second operand if the first decides the result */
+	if (xs->xs_c1 && (xs->xs_int == XO_AND || xs->xs_int == XO_OR)){
+	    if ((b = ctx2boolean(xr0)) < 0)
+		goto done;
+	    if (b == (xs->xs_int == XO_OR)){
+		if ((xr2 = malloc(sizeof(*xr2))) == NULL){
+		    clicon_err(OE_UNIX, errno, "malloc");
+		    goto done;
+		}
+		memset(xr2, 0, sizeof(*xr2));
+		xr2->xc_initial = xc->xc_initial;
+		xr2->xc_type = XT_BOOL;
+		xr2->xc_bool = b;
+	    }
+	}
 	break;
     case XP_RELEX: /* relexpr --> addexpr | relexpr relop addexpr */
 	break;
@@ -1055,12 +1668,12 @@ xp_eval(xp_ctx     *xc,
     /* Eval second child c0
      * Note, some operators like locationpath, need transitive context (use_xr0)
      */
-    if (xs->xs_c1)
+    if (xs->xs_c1 && xr2 == NULL)
 	if (xp_eval(use_xr0?xr0:xc, xs->xs_c1, nsc, localonly, &xr1) < 0) 
 	    goto done;
     /* Actions after second child
      */
-    if (xs->xs_c1)
+    if (xs->xs_c1 && xr2 == NULL)
 	switch (xs->xs_type){
 	case XP_AND: /* combine and and or ops */
 	    if (xp_logop(xr0, xr1, xs->xs_int, &xr2) < 0)
@@ -1109,4 +1722,28 @@ xp_eval(xp_ctx     *xc,
     return retval;
 } /* xp_eval */
 
-
+/*! Evaluate an XPATH on an XML tree and get the first node of the result
+ *
+ * Location paths are evaluated depth-first, node by node, and evaluation stops at the
+ * first selected node, instead of building the node-sets of every step.
+ * @param[in]  xc     Incoming context
+ * @param[in]  xs     XPATH node tree
+ * @param[in]  nsc    XML Namespace context
+ * @param[in]  localonly Skip prefix and namespace tests (non-standard)
+ * @param[out] xfirst First node of resulting node-set, or NULL if empty
+ * @retval     1      OK
+ * @retval     0      Not a location path that can be streamed, use xp_eval
+ * @retval    -1      Error
+ * @see xp_eval
+ */
+int
+xp_eval_first(xp_ctx     *xc,
+	      xpath_tree *xs,
+	      cvec       *nsc,
+	      int         localonly,
+	      cxobj     **xfirst)
+{
+    *xfirst = NULL;
+    return xp_stream_path(xc, xpath_tree_unwrap(xs), nsc, localonly,
+			  xp_first_stream_fn, xfirst);
+}
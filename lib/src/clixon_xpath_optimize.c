@@ -63,6 +63,7 @@
 #include "clixon_hash.h"
 #include "clixon_handle.h"
 #include "clixon_yang.h"
+#include "clixon_yang_type.h"
 #include "clixon_xml.h"
 #include "clixon_xml_vec.h"
 #include "clixon_xml_sort.h"
@@ -71,20 +72,32 @@
 #include "clixon_xpath_optimize.h"
 
 #ifdef XPATH_LIST_OPTIMIZE
-static xpath_tree *_xmtop = NULL; /* pattern match tree top */
-static xpath_tree *_xm = NULL;
-static xpath_tree *_xe = NULL;
 static int _optimize_enable = 1;
-static int _optimize_hits = 0;
+static int _optimize_hits = 0;       /* Lookups made on list keys */
+static int _optimize_index_hits = 0; /* Lookups made on explicit indexes */
+static int _optimize_misses = 0;     /* List steps with predicates and no lookup */
 #endif /* XPATH_LIST_OPTIMIZE */
 
-/* XXX development in clixon_xpath_eval */
+/*! Get and reset xpath list optimization statistics
+ * @param[out] hits       Number of list steps looked up using list keys, or NULL
+ * @param[out] indexhits  Number of list steps looked up using explicit indexes, or NULL
+ * @param[out] misses     Number of list steps with predicates not looked up, or NULL
+ */
 int
-xpath_list_optimize_stats(int *hits)
+xpath_list_optimize_stats(int *hits,
+			  int *indexhits,
+			  int *misses)
 {
 #ifdef XPATH_LIST_OPTIMIZE
-    *hits = _optimize_hits;
+    if (hits)
+	*hits = _optimize_hits;
+    if (indexhits)
+	*indexhits = _optimize_index_hits;
+    if (misses)
+	*misses = _optimize_misses;
     _optimize_hits = 0;
+    _optimize_index_hits = 0;
+    _optimize_misses = 0;
 #endif
     return 0;
 }
@@ -104,127 +117,237 @@ xpath_list_optimize_set(int enable)
 void
 xpath_optimize_exit(void)
 {
-#ifdef XPATH_LIST_OPTIMIZE
-    if (_xmtop)
-	xpath_tree_free(_xmtop);
-#endif
+    xpath_list_optimize_stats(NULL, NULL, NULL);
 }
 
 #ifdef XPATH_LIST_OPTIMIZE
-/*! Initialize xpath module
- * XXX move to clixon_xpath.c 
- * @see loop_preds
+/*! Get name of a relative path consisting of a single child step, eg "k" or "ex:k"
+ * @param[in]  xs    XPath tree, unwrapped
+ * @retval     name  Name (without prefix) of child
+ * @retval     NULL  Not a single child step
  */
-int
-xpath_optimize_init(xpath_tree **xm,
-		    xpath_tree **xe)
+static char *
+xp_child_name(xpath_tree *xs)
 {
-    int         retval = -1;
-    xpath_tree *xs;
-    
-    if (_xm == NULL){
-	/* Initialize xpath-tree */
-	if (xpath_parse("_x[_y='_z']", &_xmtop) < 0) 
-	    goto done;
-	/* Go down two steps */
-	if ((_xm = xpath_tree_traverse(_xmtop, 0, 0, -1)) == NULL)
-	    goto done;
-	/* get nodetest tree (_x) */
-	if ((xs = xpath_tree_traverse(_xm, 0, -1)) == NULL)
-	    goto done;
-	xs->xs_match++;
-	/* get predicates [_y=_z][z=2] */
-	if ((xs = xpath_tree_traverse(_xm, 1, -1)) == NULL)
-	    goto done;
-	xs->xs_match++;
-	/* get expression [_y=_z] */
-	if ((_xe = xpath_tree_traverse(xs, 1, -1)) == NULL)
-	    goto done;
-	/* get keyname (_y) */
-	if ((xs = xpath_tree_traverse(_xe, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, -1)) == NULL)
-	    goto done;
-	xs->xs_match++; /* in loop_preds get name in xs_s1 XXX: leaf-list is different */
-	/* get keyval (_z) */
-	if ((xs = xpath_tree_traverse(_xe, 0, 0, 1, 0, 0, 0, -1)) == NULL)
-	    goto done;
-	xs->xs_match++; /* in loop_preds get value in xs_s0 or xs_strnr */
-    }
-    *xm = _xm;
-    *xe = _xe;
-    retval = 0;
- done:
-    return retval;
+    xpath_tree *xr;
+    xpath_tree *xp;
+
+    if (xs == NULL || xs->xs_type != XP_LOCPATH ||
+	(xr = xs->xs_c0) == NULL || xr->xs_type != XP_RELLOCPATH ||
+	xr->xs_c1 != NULL || xr->xs_int != A_NAN ||
+	(xs = xr->xs_c0) == NULL || xs->xs_type != XP_STEP || xs->xs_int != A_CHILD)
+	return NULL;
+    /* No predicates */
+    if ((xp = xs->xs_c1) != NULL && (xp->xs_c0 != NULL || xp->xs_c1 != NULL))
+	return NULL;
+    if ((xs = xs->xs_c0) == NULL || xs->xs_type != XP_NODE)
+	return NULL;
+    return xs->xs_s1;
 }
 
+/*! Get string value of a string or number literal
+ * @param[in]  xs    XPath tree, unwrapped
+ * @retval     str   Literal value as given in the xpath
+ * @retval     NULL  Not a literal, or a literal that cannot be used in a search object
+ */
+static char *
+xp_literal(xpath_tree *xs)
+{
+    char *str;
+
+    if (xs == NULL)
+	return NULL;
+    if (xs->xs_type == XP_PRIME_STR)
+	str = xs->xs_s0 ? xs->xs_s0 : "";
+    else if (xs->xs_type == XP_PRIME_NR)
+	str = xs->xs_strnr;
+    else
+	return NULL;
+    /* Search objects are created by parsing XML */
+    if (str == NULL || strchr(str, '<') != NULL || strchr(str, '&') != NULL)
+	return NULL;
+    return str;
+}
 
-/*! Recursive function to loop over all EXPR and pattern match them
+/*! Check if an equality between a leaf of a list and a literal can be used in a lookup
  *
- * @param[in]  xt    XPath tree of type PRED
- * @param[in]  xepat Pattern matching XPath tree of type EXPR
- * @param[out] cvk   Vector of <keyname>:<keyval> pairs
+ * A number literal is compared with the number value of the leaf, eg [k=1] is true if k
+ * is "01" or "1.0", so it is used only if the leaf is of a numeric type. The literal
+ * must also be a valid value of a numeric leaf, since it is parsed as the leaf value in
+ * the search object.
+ * @param[in]  yc    Yang list
+ * @param[in]  name  Name of leaf in list
+ * @param[in]  xs    XPath literal, unwrapped
+ * @param[in]  val   Value of literal, see xp_literal
+ * @retval     1     Yes, use in lookup
+ * @retval     0     No, evaluate equality without lookup
  * @retval    -1     Error
- * @retval     0     No match
- * @retval     1     Match
- * @see xpath_optimize_init
  */
 static int
-loop_preds(xpath_tree *xt,
-	   xpath_tree *xepat,
-	   cvec       *cvk)
+xp_literal_check(yang_stmt  *yc,
+		 char       *name,
+		 xpath_tree *xs,
+		 char       *val)
 {
     int          retval = -1;
+    yang_stmt   *yl;
+    yang_stmt   *yrestype;
+    enum cv_type cvtype = CGV_ERR;
+    uint8_t      fraction = 0;
+    cg_var      *cv = NULL;
+    char        *reason = NULL;
     int          ret;
-    xpath_tree  *xe;
-    xpath_tree **vec = NULL;
-    size_t       veclen = 0;
-    cg_var      *cvi;
-	
-    if (xt->xs_type == XP_PRED && xt->xs_c0){
-	if ((ret = loop_preds(xt->xs_c0, xepat, cvk)) < 0)
-	    goto done;
-	if (ret == 0)
-	    goto ok;
+
+    if ((yl = yang_find_datanode(yc, name)) == NULL ||
+	yang_keyword_get(yl) != Y_LEAF)
+	goto fail;
+    if (yang_type_get(yl, NULL, &yrestype, NULL, NULL, NULL, NULL, &fraction) < 0)
+	goto done;
+    if (yrestype == NULL || yang2cv_type(yang_argument_get(yrestype), &cvtype) < 0)
+	goto fail;
+    if (!cv_isint(cvtype) && cvtype != CGV_DEC64){
+	if (xs->xs_type == XP_PRIME_NR)
+	    goto fail;
+	goto ok;
     }
-    if ((xe = xt->xs_c1) && (xe->xs_type == XP_EXP)){
-	if ((ret = xpath_tree_eq(xepat, xe, &vec, &veclen)) < 0)
+    if ((cv = cv_new(cvtype)) == NULL){
+	clicon_err(OE_XML, errno, "cv_new");
+	goto done;
+    }
+    if (cvtype == CGV_DEC64)
+	cv_dec64_n_set(cv, fraction);
+    if ((ret = cv_parse1(val, cv, &reason)) < 0){
+	clicon_err(OE_XML, errno, "cv_parse1");
+	goto done;
+    }
+    if (ret == 0)
+	goto fail;
+ ok:
+    retval = 1;
+ done:
+    if (reason)
+	free(reason);
+    if (cv)
+	cv_free(cv);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Collect equalities between child leafs and literals of a predicate expression
+ *
+ * Only equalities that are conjuncts of the whole expression are collected, ie in
+ * [a='1' and (b=2 and c>3)] a=1 and b=2 are collected, in [a='1' or b=2] none.
+ * @param[in]  xs   XPath predicate expression tree
+ * @param[in]  yc   Yang list
+ * @param[out] cvk  Name:value pairs, first equality of each name
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+xp_pred_equalities(xpath_tree *xs,
+		   yang_stmt  *yc,
+		   cvec       *cvk)
+{
+    int         retval = -1;
+    xpath_tree *xl;
+    xpath_tree *xr;
+    xpath_tree *xv;
+    char       *name;
+    char       *val;
+    cg_var     *cvi;
+    int         ret;
+
+    if ((xs = xpath_tree_unwrap(xs)) == NULL)
+	goto ok;
+    switch (xs->xs_type){
+    case XP_AND: /* andexpr LOGOP relexpr */
+	if (xs->xs_int != XO_AND)
+	    break;
+	if (xp_pred_equalities(xs->xs_c0, yc, cvk) < 0)
+	    goto done;
+	if (xp_pred_equalities(xs->xs_c1, yc, cvk) < 0)
+	    goto done;
+	break;
+    case XP_RELEX: /* relexpr RELOP addexpr */
+	if (xs->xs_int != XO_EQ)
+	    break;
+	xl = xpath_tree_unwrap(xs->xs_c0);
+	xr = xpath_tree_unwrap(xs->xs_c1);
+	if ((name = xp_child_name(xl)) != NULL)
+	    xv = xr;
+	else if ((name = xp_child_name(xr)) != NULL)
+	    xv = xl;
+	else
+	    break;
+	if ((val = xp_literal(xv)) == NULL || cvec_find(cvk, name) != NULL)
+	    break;
+	if ((ret = xp_literal_check(yc, name, xv, val)) < 0)
 	    goto done;
 	if (ret == 0)
-	    goto ok;
-	if (veclen != 2)
-	    goto ok;
+	    break;
 	if ((cvi = cvec_add(cvk, CGV_STRING)) == NULL){
 	    clicon_err(OE_XML, errno, "cvec_add");	
 	    goto done;
 	}
-	cv_name_set(cvi, vec[0]->xs_s1);
-	if (vec[1]->xs_type == XP_PRIME_NR)
-	    cv_string_set(cvi, vec[1]->xs_strnr);
-	else
-	    cv_string_set(cvi, vec[1]->xs_s0);
+	cv_name_set(cvi, name);
+	cv_string_set(cvi, val);
+	break;
+    default:
+	break;
     }
-    retval = 1;
+ ok:
+    retval = 0;
  done:
-    if (vec)
-	free(vec);
     return retval;
- ok: /* no match, not special case */
-    retval = 0;
-    goto done;
 }
 
-/*! Pattern matching to find fastpath
+/*! Collect equalities of leading predicates that filter independently of node position
+ *
+ * Predicates are evaluated in order, each on the result of the previous. A predicate may
+ * be pushed down to the lookup only if it and all predicates before it do not depend on
+ * the position of nodes: ie they evaluate to a boolean and do not call position() or last().
+ * @param[in]  xp   XPath tree of type PRED
+ * @param[in]  yc   Yang list
+ * @param[out] cvk  Name:value pairs
+ * @retval     1    OK, continue with next predicate
+ * @retval     0    OK, stop
+ * @retval    -1    Error
+ */
+static int
+xp_preds_equalities(xpath_tree *xp,
+		    yang_stmt  *yc,
+		    cvec       *cvk)
+{
+    int         ret;
+    xpath_tree *xe;
+
+    if (xp->xs_c0 && (ret = xp_preds_equalities(xp->xs_c0, yc, cvk)) <= 0)
+	return ret;
+    if ((xe = xp->xs_c1) == NULL)
+	return 1;
+    if (xpath_tree_positional(xe))
+	return 0;
+    if (xp_pred_equalities(xe, yc, cvk) < 0)
+	return -1;
+    return 1;
+}
+
+/*! Push down key and index equalities of a list step predicates to a lookup
  *
- * @param[in]  xt     XPath tree
+ * From the predicates of a step selecting list entries, eg y[k1='a' and x>2][k2=3],
+ * equalities between a list key or explicit index and a literal are collected. 
+ * If they cover the first key(s) in yang order, a binary search on keys is made,
+ * otherwise if one is an explicit index, a search on the index is made.
+ * The predicates are evaluated on the result, so the lookup only needs to return
+ * a superset of the matching nodes.
+ * @param[in]  xt     XPath tree of type STEP
  * @param[in]  xv     XML base node
  * @param[out] xvec   Array of found nodes
- * @param[out] xlen   Len of xvec
- * @param[out] key
- * @param[out] keyval
  * @retval    -1      Error
  * @retval     0      No match - use non-optimized lookup
  * @retval     1      Match
- *  XPath:
- *  y[k=3] # corresponds to: <name>[<keyname>=<keyval>]
  */
 static int
 xpath_list_optimize_fn(xpath_tree  *xt,
@@ -232,19 +355,19 @@ xpath_list_optimize_fn(xpath_tree  *xt,
 		       clixon_xvec *xvec)
 {
     int          retval = -1;
-    xpath_tree  *xm = NULL;
-    xpath_tree  *xem = NULL;
+    xpath_tree  *xp;
     char        *name;
     yang_stmt   *yp;
     yang_stmt   *yc;
-    cvec        *cvv = NULL;
-    xpath_tree **vec = NULL;
-    size_t       veclen = 0;
-    xpath_tree  *xtp;
-    int          ret;
-    cvec        *cvk = NULL; /* vector of index keys */
+    cvec        *cvv;
+    cvec        *cvk = NULL; /* vector of equalities in predicates */
+    cvec        *cvl = NULL; /* vector of lookup keys */
     cg_var      *cvi;
-    int          i;
+    cg_var      *cv;
+    int          ret;
+#ifdef XML_EXPLICIT_INDEX
+    yang_stmt   *yi;
+#endif
     
     /* revert to non-optimized if no yang */
     if ((yp = xml_spec(xv)) == NULL)
@@ -252,57 +375,65 @@ xpath_list_optimize_fn(xpath_tree  *xt,
     /* or if not config data (state data should not be ordered) */
     if (yang_config_ancestor(yp) == 0)
 	goto ok;
-    /* Check yang and that only a list with key as index is a special case can do bin search 
-     * That is, ONLY check optimize cases of this type:_x[_y='_z']
-     * Should we extend this simple example and have more cases (all cases?)
-     */
-    xpath_optimize_init(&xm, &xem);
-    /* Here is where pattern is checked for equality and where variable binding is made (if
-     * equal) */
-    if ((ret = xpath_tree_eq(xm, xt, &vec, &veclen)) < 0)
-	goto done;
-    if (ret == 0)
-	goto ok; /* no match */
-    if (veclen != 2)
+    /* Child step with name and predicates */
+    if (xt->xs_type != XP_STEP || xt->xs_int != A_CHILD ||
+	xt->xs_c0 == NULL || xt->xs_c0->xs_type != XP_NODE ||
+	(name = xt->xs_c0->xs_s1) == NULL ||
+	(xp = xt->xs_c1) == NULL || xp->xs_c1 == NULL)
 	goto ok;
-    name = vec[0]->xs_s1;
-    /* Extract variables */
-    if ((yc = yang_find(yp, Y_LIST, name)) == NULL)
-#ifdef NOTYET /* leaf-list is not detected by xpath optimize detection */
-	if ((yc = yang_find(yp, Y_LEAF_LIST, name)) == NULL) /* XXX */
-#endif
-	    goto ok; 
-    /* Validate keys */
+    if ((yc = yang_find_datanode(yp, name)) == NULL ||
+	yang_keyword_get(yc) != Y_LIST)
+	goto ok; 
     if ((cvv = yang_cvec_get(yc)) == NULL)
 	goto ok;
-    xtp = vec[1];
-    if ((cvk = cvec_new(0)) == NULL){
+    if ((cvk = cvec_new(0)) == NULL ||
+	(cvl = cvec_new(0)) == NULL){
 	clicon_err(OE_YANG, errno, "cvec_new");	
 	goto done;
     }
-    if ((ret = loop_preds(xtp, xem, cvk)) < 0)
+    if ((ret = xp_preds_equalities(xp, yc, cvk)) < 0)
 	goto done;
-    if (ret == 0)
-	goto ok;
-
-    if (cvec_len(cvv) != cvec_len(cvk))
-	goto ok;
-    i = 0;
+    /* Keys in yang order, as long as there are equalities */
     cvi = NULL;
-    while ((cvi = cvec_each(cvk, cvi)) != NULL) {
-	if (strcmp(cv_name_get(cvi), cv_string_get(cvec_i(cvv,i))))
-	    goto ok;
-	i++;
+    while ((cvi = cvec_each(cvv, cvi)) != NULL) {
+	if ((cv = cvec_find(cvk, cv_string_get(cvi))) == NULL)
+	    break;
+	if (cvec_append_var(cvl, cv) == NULL){
+	    clicon_err(OE_YANG, errno, "cvec_append_var");	
+	    goto done;
+	}
+    }
+    if (cvec_len(cvl))
+	_optimize_hits++;
+#ifdef XML_EXPLICIT_INDEX
+    else{
+	cvi = NULL;
+	while ((cvi = cvec_each(cvk, cvi)) != NULL) {
+	    if ((yi = yang_find_datanode(yc, cv_name_get(cvi))) != NULL &&
+		yang_flag_get(yi, YANG_FLAG_INDEX) != 0)
+		break;
+	}
+	if (cvi != NULL){
+	    if (cvec_append_var(cvl, cvi) == NULL){
+		clicon_err(OE_YANG, errno, "cvec_append_var");	
+		goto done;
+	    }
+	    _optimize_index_hits++;
+	}
     }
-    /* Use 2a form since yc allready given to compute cvk */
-    if (clixon_xml_find_index(xv, yp, NULL, name, cvk, xvec) < 0)
+#endif
+    if (cvec_len(cvl) == 0){
+	_optimize_misses++;
+	goto ok;
+    }
+    if (clixon_xml_find_index(xv, yp, NULL, name, cvl, xvec) < 0)
 	goto done;
     retval = 1; /* match */
  done:
-    if (vec)
-	free(vec);
     if (cvk)
 	cvec_free(cvk);
+    if (cvl)
+	cvec_free(cvl);
     return retval;
  ok: /* no match, not special case */
     retval = 0;
@@ -338,7 +469,6 @@ xpath_optimize_check(xpath_tree *xs,
 	if (clixon_xvec_extract(xvec, xvec0, xlen0) < 0)
 	    return -1;
 	clixon_xvec_free(xvec);
-	_optimize_hits++;
 	return 1; /* Optimized */
     }
     else{
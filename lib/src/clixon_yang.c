@@ -264,6 +264,32 @@ yang_cvec_get(yang_stmt *ys)
     return ys->ys_cvec;
 }
 
+/*! Get cached JSON encoding metadata of yang data node
+ * @param[in] ys   Yang statement node
+ * @retval    yj   JSON encoding metadata, or NULL if not cached
+ * @see yang_json_cache_set
+ */
+yang_json_cache *
+yang_json_cache_get(yang_stmt *ys)
+{
+    return ys->ys_jsoncache;
+}
+
+/*! Cache JSON encoding metadata on yang data node
+ * @param[in] ys   Yang statement node
+ * @param[in] yj   JSON encoding metadata, allocated with malloc and freed with the node
+ * @retval    0    OK
+ */
+int
+yang_json_cache_set(yang_stmt       *ys,
+		    yang_json_cache *yj)
+{
+    if (ys->ys_jsoncache)
+	free(ys->ys_jsoncache);
+    ys->ys_jsoncache = yj;
+    return 0;
+}
+
 /*! Set yang statement CLIgen variable vector
  * @param[in] ys   Yang statement node
  * @param[in] cvec CLIgen vector
@@ -374,6 +400,8 @@ ys_free1(yang_stmt *ys)
 	cvec_free(ys->ys_cvec);
     if (ys->ys_typecache)
 	yang_type_cache_free(ys->ys_typecache);
+    if (ys->ys_jsoncache)
+	free(ys->ys_jsoncache);
     free(ys);
     return 0;
 }
@@ -503,6 +531,7 @@ ys_cp(yang_stmt *ynew,
 	if (yang_type_cache_cp(ynew, yold) < 0)
 	    goto done;
     }
+    ynew->ys_jsoncache = NULL; /* Recomputed on demand */
     for (i=0; i<ynew->ys_len; i++){
 	yco = yold->ys_stmt[i];
 	if ((ycn = ys_dup(yco)) == NULL)
@@ -3027,6 +3056,7 @@ yang_list_index_add(yang_stmt *ys)
 	goto ok;
     }
     yang_flag_set(ys, YANG_FLAG_INDEX);
+    yang_flag_set(yp, YANG_FLAG_INDEX_LIST);
  ok:
     retval = 0;
    // done:
@@ -87,6 +87,7 @@ struct yang_stmt{
 					   types as <module>:<id> list
 				     */
     yang_type_cache   *ys_typecache; /* If ys_keyword==Y_TYPE, cache all typedef data except unions */
+    yang_json_cache   *ys_jsoncache; /* If data node, cache JSON encoding, see clixon_json.c */
     int               _ys_vector_i;   /* internal use: yn_each */
 };
 
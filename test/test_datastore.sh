@@ -44,6 +44,11 @@ module ietf-ip{
       }
     }
   }
+  container z {
+    leaf w {
+      type string;
+    }
+  }
 }
 EOF
 
@@ -156,6 +161,195 @@ expectfn "$clixon_util_datastore $conf copy kalle" 0 ""
 
 diff $mydir/kalle_db $mydir/candidate_db
 
+new "datastore file not stamped as sorted by default"
+ret=$(head -1 $mydir/candidate_db)
+if [ "$(echo "$ret" | grep -c '^<!-- clixon sorted')" -ne 0 ]; then
+    err "<config>" "$ret"
+fi
+
+new "datastore put all replace stamped as sorted"
+ret=$($clixon_util_datastore -s $conf put replace "$xml")
+expectmatch "$ret" $? "0" ""
+
+new "datastore file stamped as sorted"
+ret=$(head -1 $mydir/candidate_db)
+if [ "$(echo "$ret" | grep -c '^<!-- clixon sorted [0-9a-f]* -->$')" -ne 1 ]; then
+    err "<!-- clixon sorted <checksum> -->" "$ret"
+fi
+
+# Stamped file edited by hand with lists, leaf-lists and leafs out of order
+new "datastore stamped file out of order is sorted when read"
+stamp=$(head -1 $mydir/candidate_db)
+cat <<EOF > $mydir/candidate_db
+$stamp
+<config><x xmlns="urn:example:clixon"><g>astring</g><f><e>c</e><e>a</e><e>b</e></f><d/><y><a>2</a><b>3</b><c>third-entry</c></y><y><a>1</a><b>3</b><c>second-entry</c></y><y><a>1</a><b>2</b><c>first-entry</c></y></x></config>
+EOF
+expectfn "$clixon_util_datastore $conf get /" 0 "^$xml$"
+
+new "datastore binary init"
+binconf="-d bin -b $mydir -f binary -y $dir/ietf-ip.yang"
+expectfn "$clixon_util_datastore $binconf init" 0 ""
+
+new "datastore binary put all replace"
+ret=$($clixon_util_datastore $binconf put replace "$xml")
+expectmatch "$ret" $? "0" ""
+
+new "datastore binary get"
+expectfn "$clixon_util_datastore $binconf get /" 0 "^$xml$"
+
+new "datastore binary convert to xml"
+expectfn "$clixon_util_datastore $binconf convert xml $mydir/conv_db" 0 ""
+
+new "datastore converted xml get"
+expectfn "$clixon_util_datastore -d conv -b $mydir -y $dir/ietf-ip.yang get /" 0 "^$xml$"
+
+# One file per top-level module
+mconf="-d multi -b $mydir -m -y $dir/ietf-ip.yang"
+new "datastore multi init"
+expectfn "$clixon_util_datastore $mconf init" 0 ""
+
+new "datastore multi put all replace"
+ret=$($clixon_util_datastore $mconf put replace "$xml")
+expectmatch "$ret" $? "0" ""
+
+new "datastore multi module file"
+if [ ! -f $mydir/multi.d/ietf-ip.xml ]; then
+    err "$mydir/multi.d/ietf-ip.xml" "no such file"
+fi
+if grep -q first-entry $mydir/multi_db; then
+    err "no module data in $mydir/multi_db" "$(cat $mydir/multi_db)"
+fi
+
+new "datastore multi get"
+expectfn "$clixon_util_datastore $mconf get /" 0 "^$xml$"
+
+new "datastore multi merge leaf"
+expectfn "$clixon_util_datastore $mconf put merge <config><x xmlns=\"urn:example:clixon\"><g>nalle</g></x></config>" 0 ""
+
+new "datastore multi get merged"
+expectfn "$clixon_util_datastore $mconf get /" 0 "^${xml/astring/nalle}$"
+
+new "datastore multi copy"
+expectfn "$clixon_util_datastore $mconf copy mcopy" 0 ""
+
+diff $mydir/multi.d/ietf-ip.xml $mydir/mcopy.d/ietf-ip.xml
+
+new "datastore multi put all remove"
+expectfn "$clixon_util_datastore $mconf put remove <config/>" 0 ""
+
+new "datastore multi module file removed"
+if [ -f $mydir/multi.d/ietf-ip.xml ]; then
+    err "no $mydir/multi.d/ietf-ip.xml" "$(cat $mydir/multi.d/ietf-ip.xml)"
+fi
+
+new "datastore multi get empty"
+expectfn "$clixon_util_datastore $mconf get /" 0 "^<config/>$"
+
+# Datastore written as one file, then edited with one file per module: the module
+# data in the main file is moved to its module file although the directory exists
+new "datastore single put all replace"
+ret=$($clixon_util_datastore -d msingle -b $mydir -y $dir/ietf-ip.yang put replace "$xml")
+expectmatch "$ret" $? "0" ""
+mkdir -p $mydir/msingle.d
+
+new "datastore single to multi merge leaf"
+expectfn "$clixon_util_datastore -d msingle -b $mydir -m -y $dir/ietf-ip.yang put merge <config><x xmlns=\"urn:example:clixon\"><g>nalle</g></x></config>" 0 ""
+
+new "datastore single to multi module file"
+if [ ! -f $mydir/msingle.d/ietf-ip.xml ]; then
+    err "$mydir/msingle.d/ietf-ip.xml" "no such file"
+fi
+if grep -q first-entry $mydir/msingle_db; then
+    err "no module data in $mydir/msingle_db" "$(cat $mydir/msingle_db)"
+fi
+
+new "datastore single to multi get"
+expectfn "$clixon_util_datastore -d msingle -b $mydir -m -y $dir/ietf-ip.yang get /" 0 "^${xml/astring/nalle}$"
+
+# A datastore file keeps its mode when it is replaced by a written file
+chmod 640 $mydir/msingle_db
+
+new "datastore file mode kept on write"
+expectfn "$clixon_util_datastore -d msingle -b $mydir -y $dir/ietf-ip.yang put merge <config><x xmlns=\"urn:example:clixon\"><g>nisse</g></x></config>" 0 ""
+mode=$(ls -l $mydir/msingle_db | cut -c1-10)
+if [ "$mode" != "-rw-r-----" ]; then
+    err "-rw-r-----" "$mode"
+fi
+
+# Compressed datastores, if configured --with-zlib
+if [ "${WITH_ZLIB}" = yes ]; then
+    for format in xml json binary; do
+	zconf="-d z$format -b $mydir -f $format -z zlib -y $dir/ietf-ip.yang"
+	new "datastore $format zlib init"
+	expectfn "$clixon_util_datastore $zconf init" 0 ""
+
+	new "datastore $format zlib put all replace"
+	ret=$($clixon_util_datastore $zconf put replace "$xml")
+	expectmatch "$ret" $? "0" ""
+
+	new "datastore $format zlib file is compressed"
+	if [ "$(od -An -tx1 -N2 $mydir/z${format}_db | tr -d ' ')" != "1f8b" ]; then
+	    err "gzip magic 1f8b" "$(od -An -tx1 -N2 $mydir/z${format}_db)"
+	fi
+
+	new "datastore $format zlib get"
+	expectfn "$clixon_util_datastore $zconf get /" 0 "^$xml$"
+
+	new "datastore $format zlib file mode kept on write"
+	chmod 600 $mydir/z${format}_db
+	ret=$($clixon_util_datastore $zconf put replace "$xml")
+	expectmatch "$ret" $? "0" ""
+	mode=$(ls -l $mydir/z${format}_db | cut -c1-10)
+	if [ "$mode" != "-rw-------" ]; then
+	    err "-rw-------" "$mode"
+	fi
+    done
+fi
+
+# Snapshots keep the datastore as it was when taken, while the datastore is modified
+sconf="-d snap -b $mydir -y $dir/ietf-ip.yang"
+xmlz="${xml%</config>}<z xmlns=\"urn:example:clixon\"><w>new</w></z></config>"
+
+new "datastore snapshot put all replace"
+ret=$($clixon_util_datastore $sconf put replace "$xml")
+expectmatch "$ret" $? "0" ""
+
+new "datastore snapshot merge other top-level node"
+ret=$($clixon_util_datastore $sconf snapshot merge "<config><z xmlns=\"urn:example:clixon\"><w>new</w></z></config>")
+if [ "$(echo "$ret" | sed -n 1p)" != "$xml" ]; then
+    err "$xml" "$ret"
+fi
+if [ "$(echo "$ret" | sed -n 2p)" != "$xmlz" ]; then
+    err "$xmlz" "$ret"
+fi
+
+new "datastore snapshot merge shared top-level node"
+ret=$($clixon_util_datastore $sconf snapshot merge "<config><x xmlns=\"urn:example:clixon\"><g>nalle</g></x></config>")
+if [ "$(echo "$ret" | sed -n 1p)" != "$xmlz" ]; then
+    err "$xmlz" "$ret"
+fi
+if [ "$(echo "$ret" | sed -n 2p)" != "${xmlz/astring/nalle}" ]; then
+    err "${xmlz/astring/nalle}" "$ret"
+fi
+
+new "datastore snapshot delete top-level node"
+ret=$($clixon_util_datastore $sconf snapshot delete "<config><z xmlns=\"urn:example:clixon\"/></config>")
+if [ "$(echo "$ret" | sed -n 1p)" != "${xmlz/astring/nalle}" ]; then
+    err "${xmlz/astring/nalle}" "$ret"
+fi
+if [ "$(echo "$ret" | sed -n 2p)" != "${xml/astring/nalle}" ]; then
+    err "${xml/astring/nalle}" "$ret"
+fi
+
+new "datastore snapshot replace all"
+ret=$($clixon_util_datastore $sconf snapshot replace "<config/>")
+if [ "$(echo "$ret" | sed -n 1p)" != "${xml/astring/nalle}" ]; then
+    err "${xml/astring/nalle}" "$ret"
+fi
+if [ "$(echo "$ret" | sed -n 2p)" != "<config/>" ]; then
+    err "<config/>" "$ret"
+fi
+
 new "datastore lock"
 expectfn "$clixon_util_datastore $conf lock 756" 0 ""
 
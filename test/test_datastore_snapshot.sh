@@ -0,0 +1,130 @@
+#!/usr/bin/env bash
+# get-config from datastore snapshots while the datastore is edited by other sessions
+# Each get-config reply should be a consistent view of running, ie from before or after
+# a commit, never a mix of them
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Number of list entries in datastore
+: ${perfnr:=1000}
+
+# Number of parallel get-config sessions and of commits
+: ${getnr:=5}
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/snapshot.yang
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_FEATURE>ietf-netconf:startup</CLICON_FEATURE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_CLISPEC_DIR>/usr/local/lib/$APPNAME/clispec</CLICON_CLISPEC_DIR>
+  <CLICON_CLI_DIR>/usr/local/lib/$APPNAME/cli</CLICON_CLI_DIR>
+  <CLICON_CLI_MODE>$APPNAME</CLICON_CLI_MODE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module snapshot{
+  yang-version 1.1;
+  namespace "urn:example:snapshot";
+  prefix sn;
+  container x{
+     list y {
+        key a;
+        leaf a{
+          type int32;
+        }
+        leaf b{
+          type int32;
+        }
+     }
+  }
+  container z{
+     leaf w{
+        type int32;
+     }
+  }
+}
+EOF
+
+new "generate startup config with $perfnr list entries"
+echo -n "<config><x xmlns=\"urn:example:snapshot\">" > $dir/startup_db
+for (( i=0; i<$perfnr; i++ )); do
+    echo -n "<y><a>$i</a><b>0</b></y>" >> $dir/startup_db
+done
+echo "</x><z xmlns=\"urn:example:snapshot\"><w>0</w></z></config>" >> $dir/startup_db
+
+new "test params: -f $cfg"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+	err
+    fi
+    new "start backend -s startup -f $cfg"
+    start_backend -s startup -f $cfg
+fi
+
+new "waiting"
+wait_backend
+
+new "get-config in $getnr sessions while editing and committing"
+pids=""
+for (( k=1; k<=$getnr; k++ )); do
+    echo "<rpc><get-config><source><running/></source></get-config></rpc>]]>]]>" | $clixon_netconf -qf $cfg > $dir/get$k &
+    pids="$pids $!"
+    # The first entry and the other top-level node are changed in the same commit
+    expecteof "$clixon_netconf -qf $cfg" 0 "<rpc><edit-config><target><candidate/></target><config><x xmlns=\"urn:example:snapshot\"><y><a>0</a><b>$k</b></y></x><z xmlns=\"urn:example:snapshot\"><w>$k</w></z></config></edit-config></rpc>]]>]]>" "^<rpc-reply><ok/></rpc-reply>]]>]]>$"
+    expecteof "$clixon_netconf -qf $cfg" 0 "<rpc><commit/></rpc>]]>]]>" "^<rpc-reply><ok/></rpc-reply>]]>]]>$"
+done
+wait $pids
+
+for (( k=1; k<=$getnr; k++ )); do
+    new "get-config reply $k is complete and consistent"
+    ret=$(cat $dir/get$k)
+    match=$(echo "$ret" | grep -c '</data></rpc-reply>]]>]]>$')
+    if [ $match -ne 1 ]; then
+	err "</data></rpc-reply>]]>]]>" "$ret"
+    fi
+    nr=$(echo "$ret" | grep -o "<y>" | wc -l)
+    if [ $nr -ne $perfnr ]; then
+	err "$perfnr entries" "$nr entries"
+    fi
+    b=$(echo "$ret" | grep -o "<y><a>0</a><b>[0-9]*</b>" | sed -e 's/.*<b>\([0-9]*\)<\/b>/\1/')
+    w=$(echo "$ret" | grep -o "<w>[0-9]*</w>" | sed -e 's/<w>\([0-9]*\)<\/w>/\1/')
+    if [ -z "$b" -o "$b" != "$w" ]; then
+	err "b = w" "b: $b w: $w"
+    fi
+done
+
+new "get-config after last commit"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc><get-config><source><running/></source><filter type=\"xpath\" select=\"/sn:z\" xmlns:sn=\"urn:example:snapshot\"/></get-config></rpc>]]>]]>" "^<rpc-reply><data><z xmlns=\"urn:example:snapshot\"><w>$getnr</w></z></data></rpc-reply>]]>]]>$"
+
+if [ $BE -eq 0 ]; then
+    exit # BE
+fi
+
+new "Kill backend"
+# Check if premature kill
+pid=$(pgrep -u root -f clixon_backend)
+if [ -z "$pid" ]; then
+    err "backend already dead"
+fi
+# kill backend
+stop_backend -f $cfg
+
+rm -rf $dir
+
+# unset conditional parameters
+unset perfnr
+unset getnr
@@ -0,0 +1,151 @@
+#!/usr/bin/env bash
+# Edit-config with many new list entries in one request (batch)
+# New entries are collected and inserted together after the request has been
+# checked. Check the resulting order, and that a NACM deny of an entry in the
+# middle of a batch leaves none of the entries of that batch in the datastore.
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+# Common NACM scripts
+. ./nacm.sh
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/example-batch.yang
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>$IETFRFC</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_CLISPEC_DIR>/usr/local/lib/$APPNAME/clispec</CLICON_CLISPEC_DIR>
+  <CLICON_CLI_DIR>/usr/local/lib/$APPNAME/cli</CLICON_CLI_DIR>
+  <CLICON_CLI_MODE>$APPNAME</CLICON_CLI_MODE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_NACM_MODE>internal</CLICON_NACM_MODE>
+  <CLICON_NACM_CREDENTIALS>none</CLICON_NACM_CREDENTIALS>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module example-batch {
+  namespace "urn:example:batch";
+  prefix "ex";
+  import ietf-netconf-acm {
+    prefix nacm;
+  }
+  container c{
+    list y {
+      key a;
+      leaf a{
+        type int32;
+      }
+      leaf z{
+        type string;
+      }
+    }
+  }
+}
+EOF
+
+# The limited group (wilma) may create list entries, but not leaf z
+RULES=$(cat <<EOF
+   <nacm xmlns="urn:ietf:params:xml:ns:yang:ietf-netconf-acm">
+     <enable-nacm>true</enable-nacm>
+     <read-default>permit</read-default>
+     <write-default>deny</write-default>
+     <exec-default>permit</exec-default>
+
+     $NGROUPS
+
+     <rule-list>
+       <name>limited-acl</name>
+       <group>limited</group>
+       <rule>
+         <name>deny-z</name>
+         <module-name>example-batch</module-name>
+         <access-operations>create</access-operations>
+         <path xmlns:ex="urn:example:batch">/ex:c/ex:y/ex:z</path>
+         <action>deny</action>
+       </rule>
+       <rule>
+         <name>permit-y</name>
+         <module-name>example-batch</module-name>
+         <access-operations>create</access-operations>
+         <path xmlns:ex="urn:example:batch">/ex:c/ex:y</path>
+         <action>permit</action>
+       </rule>
+     </rule-list>
+
+     $NADMIN
+
+   </nacm>
+EOF
+)
+
+FILTER='<filter type="xpath" select="/ex:c" xmlns:ex="urn:example:batch"/>'
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+	err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "waiting"
+wait_backend
+
+new "Set NACM rules and a batch of entries in reverse order"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc><edit-config><target><candidate/></target><config>$RULES<c xmlns=\"urn:example:batch\"><y><a>5</a></y><y><a>3</a></y><y><a>1</a></y></c></config></edit-config></rpc>]]>]]>" "^<rpc-reply><ok/></rpc-reply>]]>]]>$"
+
+new "Commit"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc><commit/></rpc>]]>]]>" "^<rpc-reply><ok/></rpc-reply>]]>]]>$"
+
+new "get-config batch is sorted"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc><get-config><source><candidate/></source>$FILTER</get-config></rpc>]]>]]>" "^<rpc-reply><data><c xmlns=\"urn:example:batch\"><y><a>1</a></y><y><a>3</a></y><y><a>5</a></y></c></data></rpc-reply>]]>]]>$"
+
+new "limited batch with denied entry in the middle"
+expecteof "$clixon_netconf -U wilma -qf $cfg" 0 "<rpc><edit-config><target><candidate/></target><config><c xmlns=\"urn:example:batch\"><y><a>4</a></y><y><a>2</a><z>denied</z></y><y><a>6</a></y></c></config></edit-config></rpc>]]>]]>" "^<rpc-reply><rpc-error><error-type>application</error-type><error-tag>access-denied</error-tag><error-severity>error</error-severity><error-message>access denied</error-message></rpc-error></rpc-reply>]]>]]>$"
+
+new "get-config no entry of denied batch"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc><get-config><source><candidate/></source>$FILTER</get-config></rpc>]]>]]>" "^<rpc-reply><data><c xmlns=\"urn:example:batch\"><y><a>1</a></y><y><a>3</a></y><y><a>5</a></y></c></data></rpc-reply>]]>]]>$"
+
+new "limited batch without denied leaf"
+expecteof "$clixon_netconf -U wilma -qf $cfg" 0 "<rpc><edit-config><target><candidate/></target><config><c xmlns=\"urn:example:batch\"><y><a>6</a></y><y><a>4</a></y><y><a>2</a></y></c></config></edit-config></rpc>]]>]]>" "^<rpc-reply><ok/></rpc-reply>]]>]]>$"
+
+new "get-config batch merged in order"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc><get-config><source><candidate/></source>$FILTER</get-config></rpc>]]>]]>" "^<rpc-reply><data><c xmlns=\"urn:example:batch\"><y><a>1</a></y><y><a>2</a></y><y><a>3</a></y><y><a>4</a></y><y><a>5</a></y><y><a>6</a></y></c></data></rpc-reply>]]>]]>$"
+
+new "batch of new and existing entries"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc><edit-config><target><candidate/></target><config><c xmlns=\"urn:example:batch\"><y><a>7</a></y><y><a>3</a><z>three</z></y><y><a>0</a></y></c></config></edit-config></rpc>]]>]]>" "^<rpc-reply><ok/></rpc-reply>]]>]]>$"
+
+new "get-config new and existing entries in order"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc><get-config><source><candidate/></source>$FILTER</get-config></rpc>]]>]]>" "^<rpc-reply><data><c xmlns=\"urn:example:batch\"><y><a>0</a></y><y><a>1</a></y><y><a>2</a></y><y><a>3</a><z>three</z></y><y><a>4</a></y><y><a>5</a></y><y><a>6</a></y><y><a>7</a></y></c></data></rpc-reply>]]>]]>$"
+
+new "Commit"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc><commit/></rpc>]]>]]>" "^<rpc-reply><ok/></rpc-reply>]]>]]>$"
+
+if [ $BE -eq 0 ]; then
+    exit # BE
+fi
+
+new "Kill backend"
+# Check if premature kill
+pid=$(pgrep -u root -f clixon_backend)
+if [ -z "$pid" ]; then
+    err "backend already dead"
+fi
+# kill backend
+stop_backend -f $cfg
+
+rm -rf $dir
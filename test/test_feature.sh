@@ -242,6 +242,13 @@ if [ -z "$match" ]; then
       err "$expect" "$ret"
 fi
 
+new "netconf module ietf-netconf-with-defaults"
+expect="<module><name>ietf-netconf-with-defaults</name><revision>2011-06-01</revision><namespace>urn:ietf:params:xml:ns:yang:ietf-netconf-with-defaults</namespace><conformance-type>implement</conformance-type></module>"
+match=`echo "$ret" | grep --null -Go "$expect"`
+if [ -z "$match" ]; then
+      err "$expect" "$ret"
+fi
+
 new "netconf module ietf-routing"
 expect="<module><name>ietf-routing</name><revision>2018-03-13</revision><namespace>urn:ietf:params:xml:ns:yang:ietf-routing</namespace><feature>router-id</feature><conformance-type>implement</conformance-type></module>"
 match=`echo "$ret" | grep --null -Go "$expect"`
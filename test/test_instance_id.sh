@@ -235,6 +235,9 @@ for (( ii=0; ii<$rep; ii++ )); do
     new "instance-id double string key k1=a$rnd k2=b$rnd"
     expectpart "$($clixon_util_path -f $xml3 -y $ydir -p /a:x3/a:y[k1=\"a$rnd\"][k2=\"b$rnd\"])" 0 "0: <y><k1>a$rnd</k1><k2>b$rnd</k2><z>foob$rnd</z></y>"
 
+    new "instance-id double string key reversed order k2=b$rnd k1=a$rnd"
+    expectpart "$($clixon_util_path -f $xml3 -y $ydir -p /a:x3/a:y[k2=\"b$rnd\"][k1=\"a$rnd\"])" 0 "0: <y><k1>a$rnd</k1><k2>b$rnd</k2><z>foob$rnd</z></y>"
+
     new "instance-id double string key k1=a$rnd, - empty k2 string"
     expectpart "$($clixon_util_path -f $xml3 -y $ydir -p /a:x3/a:y[k1=\"a1\"][k2=\"\"])" 0 "0: <y><k1>a1</k1><k2/><z>foo1</z></y>"
 
@@ -31,6 +31,9 @@ module json{
    leaf a{
      type int32;
    }
+   leaf-list l{
+     type int32;
+   }
    container c{
      leaf a{
        type int32;
@@ -121,6 +124,40 @@ expecteofx "$clixon_util_json -jy $fyang" 0 "$JSON" '{"json:g2":"blues"}'
 new "xml indirect identity with explicit ns to json"
 expecteofx "$clixon_util_xml -ojvy $fyang" 0 '<g2 xmlns="urn:example:clixon" xmlns:ex="urn:example:clixon">ex:blues</g2>' '{"json:g2":"blues"}'
 
+new "json parse fast and flex/bison output equal"
+JSON='{"json:c":{"a":42,"s":"str \"q\" \\ x\ny \u00e5"},"json:g2":"json:blues","json:a":-1,"json:l":[1,2]}'
+ret1=$(echo "$JSON" | $clixon_util_json -F -y $fyang)
+ret2=$(echo "$JSON" | $clixon_util_json -y $fyang)
+if [ "$ret1" != "$ret2" ]; then
+    err "$ret2" "$ret1"
+fi
+
+# Both the flex/bison parser (default) and the fast scanner (-F)
+for opt in "" "-F"; do
+    JSON='{"json:c":{"s":"line1\nline2 \u00e5 \u20ac \ud83d\ude00"}}'
+    new "json $opt string escapes back to json"
+    expecteofx "$clixon_util_json $opt -jy $fyang" 0 "$JSON" '{"json:c":{"s":"line1\nline2 å € 😀"}}'
+
+    new "json $opt tab escape"
+    expecteofx "$clixon_util_json $opt -jy $fyang" 0 '{"json:c":{"s":"a\tb"}}' $'{"json:c":{"s":"a\tb"}}'
+
+    new "json $opt escaped quote, backslash and slash"
+    expecteofx "$clixon_util_json $opt -y $fyang" 0 '{"json:c":{"s":"\"\\\/"}}' '<c xmlns="urn:example:clixon"><s>"\/</s></c>'
+
+    new "json $opt invalid unicode escape"
+    expecteofx "$clixon_util_json $opt -y $fyang" 255 '{"json:c":{"s":"\u00g0"}}' "" 2> /dev/null
+
+    # Each element of a top-level array keeps the module name of the array
+    new "json $opt top-level array"
+    expecteofx "$clixon_util_json $opt -y $fyang" 0 '{"json:l":[1,2]}' '<l xmlns="urn:example:clixon">1</l><l xmlns="urn:example:clixon">2</l>'
+done
+
+new "json top-level not qualified"
+expecteofx "$clixon_util_json -y $fyang" 255 '{"c":{"a":42}}' "" 2> /dev/null
+
+new "json syntax error"
+expecteofx "$clixon_util_json" 255 '{"a":1,}' "" 2> /dev/null
+
 # XXX CDATA translation, should work bit does not
 if false; then
 JSON='{"json:c": {"s": "<![CDATA[  z > x  & x < y ]]>"}}'
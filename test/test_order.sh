@@ -122,6 +122,16 @@ module order-example{
           }
         }
       }
+      list listunions{
+        ordered-by system;
+        key a;
+        leaf a {
+          type union{
+            type int32;
+            type string;
+          }
+        }
+      }
     }
 }
 EOF
@@ -273,6 +283,17 @@ expecteof "$clixon_netconf -qf $cfg" 0 '<rpc><edit-config><target><candidate/></
 new "check list int order (1,2,10)"
 expecteof "$clixon_netconf -qf $cfg" 0 '<rpc><get-config><source><candidate/></source><filter type="xpath" select="/exo:types/exo:listints" xmlns:exo="urn:example:order"/></get-config></rpc>]]>]]>' '^<rpc-reply><data><types xmlns="urn:example:order"><listints><a>1</a></listints><listints><a>2</a></listints><listints><a>10</a></listints></types></data></rpc-reply>]]>]]>$'
 
+new "put list int (-3,-20)"
+expecteof "$clixon_netconf -qf $cfg" 0 '<rpc><edit-config><target><candidate/></target><config><types xmlns="urn:example:order">
+<listints><a>-3</a></listints><listints><a>-20</a></listints>
+</types></config></edit-config></rpc>]]>]]>' "^<rpc-reply><ok/></rpc-reply>]]>]]>$"
+
+new "check list int order (-20,-3,1,2,10)"
+expecteof "$clixon_netconf -qf $cfg" 0 '<rpc><get-config><source><candidate/></source><filter type="xpath" select="/exo:types/exo:listints" xmlns:exo="urn:example:order"/></get-config></rpc>]]>]]>' '^<rpc-reply><data><types xmlns="urn:example:order"><listints><a>-20</a></listints><listints><a>-3</a></listints><listints><a>1</a></listints><listints><a>2</a></listints><listints><a>10</a></listints></types></data></rpc-reply>]]>]]>$'
+
+new "get list int entry -3"
+expecteof "$clixon_netconf -qf $cfg" 0 '<rpc><get-config><source><candidate/></source><filter type="xpath" select="/exo:types/exo:listints[exo:a=-3]" xmlns:exo="urn:example:order"/></get-config></rpc>]]>]]>' '^<rpc-reply><data><types xmlns="urn:example:order"><listints><a>-3</a></listints></types></data></rpc-reply>]]>]]>$'
+
 new "put leaf-list decimal64 (10,2,1)"
 expecteof "$clixon_netconf -qf $cfg" 0 '<rpc><edit-config><target><candidate/></target><config><types xmlns="urn:example:order">
 <decs>10.0</decs><decs>2.0</decs><decs>1.0</decs>
@@ -289,6 +310,29 @@ expecteof "$clixon_netconf -qf $cfg" 0 '<rpc><edit-config><target><candidate/></
 new "check list decimal64 order (1,2,10)"
 expecteof "$clixon_netconf -qf $cfg" 0 '<rpc><get-config><source><candidate/></source><filter type="xpath" select="/exo:types/exo:listdecs" xmlns:exo="urn:example:order"/></get-config></rpc>]]>]]>' '^<rpc-reply><data><types xmlns="urn:example:order"><listdecs><a>1.0</a></listdecs><listdecs><a>2.0</a></listdecs><listdecs><a>10.0</a></listdecs></types></data></rpc-reply>]]>]]>$'
 
+new "put list decimal64 (-2.5,-10)"
+expecteof "$clixon_netconf -qf $cfg" 0 '<rpc><edit-config><target><candidate/></target><config><types xmlns="urn:example:order">
+<listdecs><a>-2.5</a></listdecs><listdecs><a>-10.0</a></listdecs>
+</types></config></edit-config></rpc>]]>]]>' "^<rpc-reply><ok/></rpc-reply>]]>]]>$"
+
+new "check list decimal64 order (-10,-2.5,1,2,10)"
+expecteof "$clixon_netconf -qf $cfg" 0 '<rpc><get-config><source><candidate/></source><filter type="xpath" select="/exo:types/exo:listdecs" xmlns:exo="urn:example:order"/></get-config></rpc>]]>]]>' '^<rpc-reply><data><types xmlns="urn:example:order"><listdecs><a>-10.0</a></listdecs><listdecs><a>-2.5</a></listdecs><listdecs><a>1.0</a></listdecs><listdecs><a>2.0</a></listdecs><listdecs><a>10.0</a></listdecs></types></data></rpc-reply>]]>]]>$'
+
+new "get list decimal64 entry -2.5"
+expecteof "$clixon_netconf -qf $cfg" 0 '<rpc><get-config><source><candidate/></source><filter type="xpath" select="/exo:types/exo:listdecs[exo:a=-2.5]" xmlns:exo="urn:example:order"/></get-config></rpc>]]>]]>' '^<rpc-reply><data><types xmlns="urn:example:order"><listdecs><a>-2.5</a></listdecs></types></data></rpc-reply>]]>]]>$'
+
+new "put list union (b,10,2,a)"
+expecteof "$clixon_netconf -qf $cfg" 0 '<rpc><edit-config><target><candidate/></target><config><types xmlns="urn:example:order">
+<listunions><a>b</a></listunions><listunions><a>10</a></listunions><listunions><a>2</a></listunions><listunions><a>a</a></listunions>
+</types></config></edit-config></rpc>]]>]]>' "^<rpc-reply><ok/></rpc-reply>]]>]]>$"
+
+# Union keys are compared as strings, not as binary keys (XML_KEY_BLOB)
+new "check list union order (10,2,a,b)"
+expecteof "$clixon_netconf -qf $cfg" 0 '<rpc><get-config><source><candidate/></source><filter type="xpath" select="/exo:types/exo:listunions" xmlns:exo="urn:example:order"/></get-config></rpc>]]>]]>' '^<rpc-reply><data><types xmlns="urn:example:order"><listunions><a>10</a></listunions><listunions><a>2</a></listunions><listunions><a>a</a></listunions><listunions><a>b</a></listunions></types></data></rpc-reply>]]>]]>$'
+
+new "get list union entry 2"
+expecteof "$clixon_netconf -qf $cfg" 0 '<rpc><get-config><source><candidate/></source><filter type="xpath" select="/exo:types/exo:listunions[exo:a=2]" xmlns:exo="urn:example:order"/></get-config></rpc>]]>]]>' '^<rpc-reply><data><types xmlns="urn:example:order"><listunions><a>2</a></listunions></types></data></rpc-reply>]]>]]>$'
+
 new "delete candidate"
 expecteof "$clixon_netconf -qf $cfg" 0 '<rpc><edit-config><target><candidate/></target><default-operation>none</default-operation><config operation="delete"/></edit-config></rpc>]]>]]>' "^<rpc-reply><ok/></rpc-reply>]]>]]>$"
 
@@ -391,6 +435,73 @@ expecteof "$clixon_netconf -qf $cfg" 0 "<rpc><edit-config><target><candidate/></
 new "check ordered-by-user: e,a,71,b,42,c,d"
 expecteof "$clixon_netconf -qf $cfg" 0 '<rpc><get-config><source><candidate/></source></get-config></rpc>]]>]]>' '^<rpc-reply><data><y2 xmlns="urn:example:order"><k>e</k><a>bar</a></y2><y2 xmlns="urn:example:order"><k>a</k><a>foo</a></y2><y2 xmlns="urn:example:order"><k>71</k><a>fie</a></y2><y2 xmlns="urn:example:order"><k>b</k><a>bar</a></y2><y2 xmlns="urn:example:order"><k>42</k><a>fum</a></y2><y2 xmlns="urn:example:order"><k>c</k><a>foo</a></y2><y2 xmlns="urn:example:order"><k>d</k><a>fie</a></y2></data></rpc-reply>]]>]]>$'
 
+# Large ordered-by user list, searched using a key index
+XML=""
+for i in $(seq 1 40); do
+    XML="$XML<y2 xmlns=\"urn:example:order\"><k>x$i</k><a>$i</a></y2>"
+done
+new "add 40 entries to list user order"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc><edit-config><target><candidate/></target><config>$XML</config></edit-config></rpc>]]>]]>" "^<rpc-reply><ok/></rpc-reply>]]>]]>$"
+
+new "add one entry n before key x20"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc><edit-config><target><candidate/></target><config><y2 xmlns=\"urn:example:order\" xmlns:yang=\"urn:ietf:params:xml:ns:yang:1\" yang:insert=\"before\" yang:key=\"[k='x20']\"><k>n</k><a>n</a></y2></config></edit-config></rpc>]]>]]>" "^<rpc-reply><ok/></rpc-reply>]]>]]>$"
+
+new "move entry x10 to list first"
+expecteof "$clixon_netconf -qf $cfg" 0 '<rpc><edit-config><target><candidate/></target><config><y2 xmlns="urn:example:order" xmlns:yang="urn:ietf:params:xml:ns:yang:1" yang:insert="first"><k>x10</k><a>10</a></y2></config></edit-config></rpc>]]>]]>' "^<rpc-reply><ok/></rpc-reply>]]>]]>$"
+
+new "get entry x30 of large list"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc><get-config><source><candidate/></source><filter type=\"xpath\" select=\"/exo:y2[exo:k='x30']\" xmlns:exo=\"urn:example:order\"/></get-config></rpc>]]>]]>" '^<rpc-reply><data><y2 xmlns="urn:example:order"><k>x30</k><a>30</a></y2></data></rpc-reply>]]>]]>$'
+
+new "get moved entry x10 of large list"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc><get-config><source><candidate/></source><filter type=\"xpath\" select=\"/exo:y2[exo:k='x10']\" xmlns:exo=\"urn:example:order\"/></get-config></rpc>]]>]]>" '^<rpc-reply><data><y2 xmlns="urn:example:order"><k>x10</k><a>10</a></y2></data></rpc-reply>]]>]]>$'
+
+RES='<y2 xmlns="urn:example:order"><k>x10</k><a>10</a></y2><y2 xmlns="urn:example:order"><k>e</k><a>bar</a></y2><y2 xmlns="urn:example:order"><k>a</k><a>foo</a></y2><y2 xmlns="urn:example:order"><k>71</k><a>fie</a></y2><y2 xmlns="urn:example:order"><k>b</k><a>bar</a></y2><y2 xmlns="urn:example:order"><k>42</k><a>fum</a></y2><y2 xmlns="urn:example:order"><k>c</k><a>foo</a></y2><y2 xmlns="urn:example:order"><k>d</k><a>fie</a></y2>'
+for i in $(seq 1 40); do
+    if [ $i -eq 20 ]; then
+	RES="$RES<y2 xmlns=\"urn:example:order\"><k>n</k><a>n</a></y2>"
+    fi
+    if [ $i -ne 10 ]; then
+	RES="$RES<y2 xmlns=\"urn:example:order\"><k>x$i</k><a>$i</a></y2>"
+    fi
+done
+new "check large ordered-by-user list: x10,e,a,71,b,42,c,d,x1..x19,n,x20..x40"
+expecteof "$clixon_netconf -qf $cfg" 0 '<rpc><get-config><source><candidate/></source><filter type="xpath" select="/exo:y2" xmlns:exo="urn:example:order"/></get-config></rpc>]]>]]>' "^<rpc-reply><data>$RES</data></rpc-reply>]]>]]>$"
+
+# Merge and replace of ordered-by user and system lists and leaf-lists, mixed with
+# other children and not in sorted order
+NS='xmlns="urn:example:order"'
+new "delete candidate"
+expecteof "$clixon_netconf -qf $cfg" 0 '<rpc><edit-config><target><candidate/></target><default-operation>none</default-operation><config operation="delete"/></edit-config></rpc>]]>]]>' "^<rpc-reply><ok/></rpc-reply>]]>]]>$"
+
+new "add mixed entries"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc><edit-config><target><candidate/></target><config><y3 $NS><k>b</k><a>1</a></y3><y0 $NS>b</y0><y2 $NS><k>b</k><a>1</a></y2><c $NS><d>hej</d></c><y1 $NS>b</y1><y0 $NS>a</y0><y2 $NS><k>a</k><a>2</a></y2><l $NS>hopp</l><y1 $NS>a</y1><y3 $NS><k>a</k><a>2</a></y3></config></edit-config></rpc>]]>]]>" "^<rpc-reply><ok/></rpc-reply>]]>]]>$"
+
+new "merge mixed entries, existing user ordered keep their place"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc><edit-config><target><candidate/></target><config><y3 $NS><k>c</k><a>3</a></y3><y0 $NS>c</y0><y2 $NS><k>a</k><a>new</a></y2><y1 $NS>c</y1><l $NS>new</l><y2 $NS><k>c</k><a>3</a></y2><y0 $NS>a</y0><y3 $NS><k>a</k><a>new</a></y3></config></edit-config></rpc>]]>]]>" "^<rpc-reply><ok/></rpc-reply>]]>]]>$"
+
+RES="<c $NS><d>hej</d></c><l $NS>new</l><y0 $NS>b</y0><y0 $NS>a</y0><y0 $NS>c</y0><y1 $NS>a</y1><y1 $NS>b</y1><y1 $NS>c</y1><y2 $NS><k>b</k><a>1</a></y2><y2 $NS><k>a</k><a>new</a></y2><y2 $NS><k>c</k><a>3</a></y2><y3 $NS><k>a</k><a>new</a></y3><y3 $NS><k>b</k><a>1</a></y3><y3 $NS><k>c</k><a>3</a></y3>"
+new "check merge: y0 b,a,c y1 a,b,c y2 b,a,c y3 a,b,c"
+expecteof "$clixon_netconf -qf $cfg" 0 '<rpc><get-config><source><candidate/></source></get-config></rpc>]]>]]>' "^<rpc-reply><data>$RES</data></rpc-reply>]]>]]>$"
+
+new "replace with mixed entries"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc><edit-config><target><candidate/></target><default-operation>replace</default-operation><config><y2 $NS><k>z</k></y2><y0 $NS>z</y0><y3 $NS><k>z</k></y3><y2 $NS><k>b</k><a>r</a></y2><y0 $NS>b</y0><y1 $NS>z</y1><y3 $NS><k>b</k><a>r</a></y3><y1 $NS>b</y1><l $NS>r</l></config></edit-config></rpc>]]>]]>" "^<rpc-reply><ok/></rpc-reply>]]>]]>$"
+
+RES="<l $NS>r</l><y0 $NS>z</y0><y0 $NS>b</y0><y1 $NS>b</y1><y1 $NS>z</y1><y2 $NS><k>z</k></y2><y2 $NS><k>b</k><a>r</a></y2><y3 $NS><k>b</k><a>r</a></y3><y3 $NS><k>z</k></y3>"
+new "check replace: y0 z,b y1 b,z y2 z,b y3 b,z"
+expecteof "$clixon_netconf -qf $cfg" 0 '<rpc><get-config><source><candidate/></source></get-config></rpc>]]>]]>' "^<rpc-reply><data>$RES</data></rpc-reply>]]>]]>$"
+
+# Delete and remove of a middle entry, the entry after it must still be matched
+NC='xmlns:nc="urn:ietf:params:xml:ns:netconf:base:1.0"'
+new "add ordered-by system entries a and c"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc><edit-config><target><candidate/></target><config><y1 $NS>c</y1><y1 $NS>a</y1><y3 $NS><k>c</k></y3><y3 $NS><k>a</k></y3></config></edit-config></rpc>]]>]]>" "^<rpc-reply><ok/></rpc-reply>]]>]]>$"
+
+new "delete and remove middle entries b, merge entries after them"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc><edit-config><target><candidate/></target><config><y1 $NS $NC nc:operation=\"remove\">b</y1><y1 $NS>c</y1><y1 $NS $NC nc:operation=\"remove\">x</y1><y1 $NS>z</y1><y3 $NS $NC nc:operation=\"delete\"><k>b</k></y3><y3 $NS><k>c</k><a>new</a></y3><y3 $NS $NC nc:operation=\"remove\"><k>x</k></y3><y3 $NS><k>z</k><a>new</a></y3></config></edit-config></rpc>]]>]]>" "^<rpc-reply><ok/></rpc-reply>]]>]]>$"
+
+RES="<l $NS>r</l><y0 $NS>z</y0><y0 $NS>b</y0><y1 $NS>a</y1><y1 $NS>c</y1><y1 $NS>z</y1><y2 $NS><k>z</k></y2><y2 $NS><k>b</k><a>r</a></y2><y3 $NS><k>a</k></y3><y3 $NS><k>c</k><a>new</a></y3><y3 $NS><k>z</k><a>new</a></y3>"
+new "check delete: y1 a,c,z y3 a,c,z"
+expecteof "$clixon_netconf -qf $cfg" 0 '<rpc><get-config><source><candidate/></source></get-config></rpc>]]>]]>' "^<rpc-reply><data>$RES</data></rpc-reply>]]>]]>$"
+
 if [ $BE -eq 0 ]; then
     exit # BE
 fi
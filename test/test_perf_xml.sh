@@ -5,6 +5,7 @@
 s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
 
 : ${clixon_util_xml:="clixon_util_xml"}
+: ${clixon_util_xml_bench:="clixon_util_xml_bench"}
 
 # Number of list/leaf-list entries in file
 : ${perfnr:=30000}
@@ -24,9 +25,27 @@ echo "]]></stdout></rpc-reply>" >> $fxml
 new "xml parse long CDATA"
 expecteof_file "time -p $clixon_util_xml" 0 "$fxml" 2>&1 | awk '/real/ {print $2}'
 
+new "generate large config file $fxml"
+echo -n "<config><interfaces xmlns=\"urn:ietf:params:xml:ns:yang:ietf-interfaces\">" > $fxml
+for (( i=0; i<$perfnr; i++ )); do  
+    echo "<interface><name>e$i</name><description>Interface &amp; $i</description><enabled>true</enabled></interface>" >> $fxml
+done
+echo "</interfaces></config>" >> $fxml
+
+new "xml parse fast and flex/bison output equal"
+ret1=$($clixon_util_xml -o -F -f $fxml)
+ret2=$($clixon_util_xml -o -x -f $fxml)
+if [ "$ret1" != "$ret2" ]; then
+    err "$ret1" "$ret2"
+fi
+
+new "xml parse benchmark"
+expectpart "$($clixon_util_xml_bench -f $fxml -n 3)" 0 "flex/bison" "fast" "xml print" "json print" "encode"
+
 rm -rf $dir
 
 # unset conditional parameters 
 unset clixon_util_xml
+unset clixon_util_xml_bench
 unset perfnr
 
@@ -4,6 +4,7 @@
 # Test explicit indexes in lists these cases:
 #   - not a key string
 #   - not a key int
+#   - index or key together with non-index variables
 #   - key in an ordered-by user
 #   - key in state data
 # Use instance-id for tests, since api-path can only handle keys, and xpath is too complex.
@@ -81,6 +82,16 @@ for (( ii=0; ii<10; ii++ )); do
     expectpart "$($clixon_util_path -f $xml1 -y $ydir -p /a:x1/a:y[a:i=\"$rndi\"])" 0 "^0: <y><k1>a$rnd</k1><z>foo$rnd</z><i>$rndi</i><j>$rndi</j></y>$"
 done
 
+# Several predicates: search with index or key, match the rest
+new "instance-id index and non-index i=$rndi z=foo$rnd"
+expectpart "$($clixon_util_path -f $xml1 -y $ydir -p /a:x1/a:y[a:i=\"$rndi\"][a:z=\"foo$rnd\"])" 0 "^0: <y><k1>a$rnd</k1><z>foo$rnd</z><i>$rndi</i><j>$rndi</j></y>$"
+
+new "instance-id index and non-index no match i=$rndi z=bar"
+expectpart "$($clixon_util_path -f $xml1 -y $ydir -p /a:x1/a:y[a:i=\"$rndi\"][a:z=\"bar\"])" 0 --not-- "<y>"
+
+new "instance-id key and non-index k1=a$rnd j=$rndi"
+expectpart "$($clixon_util_path -f $xml1 -y $ydir -p /a:x1/a:y[a:k1=\"a$rnd\"][a:j=\"$rndi\"])" 0 "^0: <y><k1>a$rnd</k1><z>foo$rnd</z><i>$rndi</i><j>$rndi</j></y>$"
+
 # Then measure time for index and non-index, assume correct
 # For small nr, the time to parse is so much larger than searching (and also parsing involves
 # searching) which makes it hard to make a  test comparing accessing the index variable "i" and the
@@ -6,9 +6,9 @@
 # (o  report-all-tagged)
 # o  trim
 # o  explicit
-# Clixon supports explicit, but the testcases define the other cases as well
-# in case others will be supported
-# XXX I dont think this is correct. Or at least it is not complete.
+# Clixon supports report-all (default), trim and explicit using the with-defaults
+# parameter of get and get-config
+# Also default values of choices: the case in effect (RFC 7950 7.9.3)
 
 # Magic line must be first in script (see README.md)
 s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
@@ -60,6 +60,32 @@ cat <<EOF > $fyang
           }
         }
       }
+      container d{
+        list z {
+          key k;
+          leaf k{
+            type string;
+          }
+          choice ch {
+            default a;
+            case a {
+              leaf a1 {
+                type int32;
+                default 1;
+              }
+            }
+            case b {
+              leaf b1 {
+                type int32;
+                default 2;
+              }
+              leaf b2 {
+                type string;
+              }
+            }
+          }
+        }
+      }
    }
 EOF
 
@@ -93,13 +119,59 @@ TRIM='<c xmlns="urn:example:default"><x><k>default</k></x><x><k>notset</k></x><x
 # explicit:  MUST consider any data node that is not explicitly set data to
 # be default data.
 # (SAME AS Input XML)
-EXPLICIT='<c xmlns="urn:example:default"><x><k>default</k><y>42</y></x><x><k>notset</k><y>42</y></x><x><k>other</k><y>99</y></x></c>'
+EXPLICIT=$XML
 
 new "Set defaults"
 expecteof "$clixon_netconf -qf $cfg" 0 "<rpc><edit-config><target><candidate/></target><config>$XML</config></edit-config></rpc>]]>]]>" "^<rpc-reply><ok/></rpc-reply>]]>]]>$"
 
-new "Check config (Clixon supports explicit)"
-expecteof "$clixon_netconf -qf $cfg" 0 '<rpc><get-config><source><candidate/></source></get-config></rpc>]]>]]>' "^<rpc-reply><data>$EXPLICIT</data></rpc-reply>]]>]]>$"
+new "Check config (default is report-all)"
+expecteof "$clixon_netconf -qf $cfg" 0 '<rpc><get-config><source><candidate/></source></get-config></rpc>]]>]]>' "^<rpc-reply><data>$REPORT_ALL</data></rpc-reply>]]>]]>$"
+
+WD='xmlns="urn:ietf:params:xml:ns:yang:ietf-netconf-with-defaults"'
+
+new "Check config report-all"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc><get-config><source><candidate/></source><with-defaults $WD>report-all</with-defaults></get-config></rpc>]]>]]>" "^<rpc-reply><data>$REPORT_ALL</data></rpc-reply>]]>]]>$"
+
+new "Check config trim"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc><get-config><source><candidate/></source><with-defaults $WD>trim</with-defaults></get-config></rpc>]]>]]>" "^<rpc-reply><data>$TRIM</data></rpc-reply>]]>]]>$"
+
+new "Check config explicit"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc><get-config><source><candidate/></source><with-defaults $WD>explicit</with-defaults></get-config></rpc>]]>]]>" "^<rpc-reply><data>$EXPLICIT</data></rpc-reply>]]>]]>$"
+
+new "Check config report-all-tagged not supported"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc><get-config><source><candidate/></source><with-defaults $WD>report-all-tagged</with-defaults></get-config></rpc>]]>]]>" "^<rpc-reply><rpc-error><error-type>application</error-type><error-tag>invalid-value</error-tag>"
+
+# Choice: the default case if no case exists, otherwise the existing case
+new "Set choice data, one entry without case and one with case b"
+expecteof "$clixon_netconf -qf $cfg" 0 '<rpc><edit-config><target><candidate/></target><config><d xmlns="urn:example:default"><z><k>none</k></z><z><k>b</k><b2>foo</b2></z></d></config></edit-config></rpc>]]>]]>' "^<rpc-reply><ok/></rpc-reply>]]>]]>$"
+
+new "Check choice defaults report-all"
+expecteof "$clixon_netconf -qf $cfg" 0 '<rpc><get-config><source><candidate/></source><filter type="xpath" select="/ex:d" xmlns:ex="urn:example:default"/></get-config></rpc>]]>]]>' '^<rpc-reply><data><d xmlns="urn:example:default"><z><k>b</k><b1>2</b1><b2>foo</b2></z><z><k>none</k><a1>1</a1></z></d></data></rpc-reply>]]>]]>$'
+
+new "Check choice defaults explicit"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc><get-config><source><candidate/></source><filter type=\"xpath\" select=\"/ex:d\" xmlns:ex=\"urn:example:default\"/><with-defaults $WD>explicit</with-defaults></get-config></rpc>]]>]]>" '^<rpc-reply><data><d xmlns="urn:example:default"><z><k>b</k><b2>foo</b2></z><z><k>none</k></z></d></data></rpc-reply>]]>]]>$'
+
+new "Remove choice data"
+expecteof "$clixon_netconf -qf $cfg" 0 '<rpc><edit-config><target><candidate/></target><config><d xmlns="urn:example:default" xmlns:nc="urn:ietf:params:xml:ns:netconf:base:1.0" nc:operation="remove"/></config></edit-config></rpc>]]>]]>' "^<rpc-reply><ok/></rpc-reply>]]>]]>$"
+
+# Default leafs are printed with the prefix of their namespace in the parent
+new "Set choice data with prefix"
+expecteof "$clixon_netconf -qf $cfg" 0 '<rpc><edit-config><target><candidate/></target><config><ex:d xmlns:ex="urn:example:default"><ex:z><ex:k>p</ex:k></ex:z></ex:d></config></edit-config></rpc>]]>]]>' "^<rpc-reply><ok/></rpc-reply>]]>]]>$"
+
+new "Check defaults with prefixed parent"
+expecteof "$clixon_netconf -qf $cfg" 0 '<rpc><get-config><source><candidate/></source><filter type="xpath" select="/ex:d" xmlns:ex="urn:example:default"/></get-config></rpc>]]>]]>' '^<rpc-reply><data><ex:d xmlns:ex="urn:example:default"><ex:z><ex:k>p</ex:k><ex:a1>1</ex:a1></ex:z></ex:d></data></rpc-reply>]]>]]>$'
+
+new "Remove choice data with prefix"
+expecteof "$clixon_netconf -qf $cfg" 0 '<rpc><edit-config><target><candidate/></target><config><d xmlns="urn:example:default" xmlns:nc="urn:ietf:params:xml:ns:netconf:base:1.0" nc:operation="remove"/></config></edit-config></rpc>]]>]]>' "^<rpc-reply><ok/></rpc-reply>]]>]]>$"
+
+new "Commit"
+expecteof "$clixon_netconf -qf $cfg" 0 '<rpc><commit/></rpc>]]>]]>' "^<rpc-reply><ok/></rpc-reply>]]>]]>$"
+
+new "Check get trim"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc><get><filter type=\"xpath\" select=\"/ex:c\" xmlns:ex=\"urn:example:default\"/><with-defaults $WD>trim</with-defaults></get></rpc>]]>]]>" "^<rpc-reply><data>$TRIM</data></rpc-reply>]]>]]>$"
+
+new "Check get with xpath reports defaults of matching nodes only"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc><get><filter type=\"xpath\" select=\"/ex:c/ex:x[ex:k='notset']\" xmlns:ex=\"urn:example:default\"/></get></rpc>]]>]]>" "^<rpc-reply><data><c xmlns=\"urn:example:default\"><x><k>notset</k><y>42</y></x></c></data></rpc-reply>]]>]]>$"
 
 if [ $BE -eq 0 ]; then
     exit # BE
@@ -0,0 +1,176 @@
+#!/usr/bin/env bash
+# Netconf with-defaults (RFC 6243) report-all combined with NACM read access (RFC 8341)
+# A leaf with a default value that is denied by NACM must not be reported, neither its
+# value nor its default value
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+# Common NACM scripts
+. ./nacm.sh
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/example-default.yang
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>$IETFRFC</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_CLISPEC_DIR>/usr/local/lib/$APPNAME/clispec</CLICON_CLISPEC_DIR>
+  <CLICON_CLI_DIR>/usr/local/lib/$APPNAME/cli</CLICON_CLI_DIR>
+  <CLICON_CLI_MODE>$APPNAME</CLICON_CLI_MODE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_NACM_MODE>internal</CLICON_NACM_MODE>
+  <CLICON_NACM_CREDENTIALS>none</CLICON_NACM_CREDENTIALS>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module example-default {
+  namespace "urn:example:default";
+  prefix "ex";
+  import ietf-netconf-acm {
+    prefix nacm;
+  }
+  container c{
+    list x {
+      key k;
+      leaf k{
+        type string;
+      }
+      leaf y {
+        type int32;
+        default 42;
+      }
+    }
+  }
+  container e{
+    leaf z {
+      type int32;
+      default 7;
+    }
+    leaf w {
+      type int32;
+      default 8;
+    }
+  }
+}
+EOF
+
+# The limited group (wilma) may not read leaf y, nor leaf z that is never set
+RULES=$(cat <<EOF
+   <nacm xmlns="urn:ietf:params:xml:ns:yang:ietf-netconf-acm">
+     <enable-nacm>true</enable-nacm>
+     <read-default>permit</read-default>
+     <write-default>deny</write-default>
+     <exec-default>permit</exec-default>
+
+     $NGROUPS
+
+     <rule-list>
+       <name>limited-acl</name>
+       <group>limited</group>
+       <rule>
+         <name>deny-y</name>
+         <module-name>*</module-name>
+         <access-operations>read</access-operations>
+         <path xmlns:ex="urn:example:default">/ex:c/ex:x/ex:y</path>
+         <action>deny</action>
+       </rule>
+       <rule>
+         <name>deny-z</name>
+         <module-name>*</module-name>
+         <access-operations>read</access-operations>
+         <path xmlns:ex="urn:example:default">/ex:e/ex:z</path>
+         <action>deny</action>
+       </rule>
+     </rule-list>
+
+     $NADMIN
+
+   </nacm>
+EOF
+)
+
+XML='<c xmlns="urn:example:default"><x><k>notset</k></x><x><k>other</k><y>99</y></x></c><e xmlns="urn:example:default"><w>9</w></e>'
+
+# Admin sees the default value of y in report-all mode
+REPORT_ALL='<c xmlns="urn:example:default"><x><k>notset</k><y>42</y></x><x><k>other</k><y>99</y></x></c>'
+
+# Limited user sees no y at all, neither set nor default
+DENIED='<c xmlns="urn:example:default"><x><k>notset</k></x><x><k>other</k></x></c>'
+
+WD='xmlns="urn:ietf:params:xml:ns:yang:ietf-netconf-with-defaults"'
+FILTER='<filter type="xpath" select="/ex:c" xmlns:ex="urn:example:default"/>'
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+	err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "waiting"
+wait_backend
+
+new "Set data and NACM rules"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc><edit-config><target><candidate/></target><config>$RULES$XML</config></edit-config></rpc>]]>]]>" "^<rpc-reply><ok/></rpc-reply>]]>]]>$"
+
+new "Commit"
+expecteof "$clixon_netconf -qf $cfg" 0 "<rpc><commit/></rpc>]]>]]>" "^<rpc-reply><ok/></rpc-reply>]]>]]>$"
+
+new "admin get-config report-all"
+expecteof "$clixon_netconf -U andy -qf $cfg" 0 "<rpc><get-config><source><running/></source>$FILTER<with-defaults $WD>report-all</with-defaults></get-config></rpc>]]>]]>" "^<rpc-reply><data>$REPORT_ALL</data></rpc-reply>]]>]]>$"
+
+new "admin get report-all"
+expecteof "$clixon_netconf -U andy -qf $cfg" 0 "<rpc><get>$FILTER<with-defaults $WD>report-all</with-defaults></get></rpc>]]>]]>" "^<rpc-reply><data>$REPORT_ALL</data></rpc-reply>]]>]]>$"
+
+new "limited get-config report-all, denied leaf not reported"
+expecteof "$clixon_netconf -U wilma -qf $cfg" 0 "<rpc><get-config><source><running/></source>$FILTER<with-defaults $WD>report-all</with-defaults></get-config></rpc>]]>]]>" "^<rpc-reply><data>$DENIED</data></rpc-reply>]]>]]>$"
+
+new "limited get report-all, denied leaf not reported"
+expecteof "$clixon_netconf -U wilma -qf $cfg" 0 "<rpc><get>$FILTER<with-defaults $WD>report-all</with-defaults></get></rpc>]]>]]>" "^<rpc-reply><data>$DENIED</data></rpc-reply>]]>]]>$"
+
+new "limited get report-all without filter, denied leaf not reported"
+expecteof "$clixon_netconf -U wilma -qf $cfg" 0 "<rpc><get><with-defaults $WD>report-all</with-defaults></get></rpc>]]>]]>" "$DENIED"
+
+new "limited get-config of keyed entry, denied leaf not reported"
+expecteof "$clixon_netconf -U wilma -qf $cfg" 0 "<rpc><get-config><source><running/></source><filter type=\"xpath\" select=\"/ex:c/ex:x[ex:k='notset']\" xmlns:ex=\"urn:example:default\"/></get-config></rpc>]]>]]>" "^<rpc-reply><data><c xmlns=\"urn:example:default\"><x><k>notset</k></x></c></data></rpc-reply>]]>]]>$"
+
+# Leaf z is not in the datastore, the path of its rule refers to a default value only
+FILTERE='<filter type="xpath" select="/ex:e" xmlns:ex="urn:example:default"/>'
+
+new "admin get-config report-all of default never set"
+expecteof "$clixon_netconf -U andy -qf $cfg" 0 "<rpc><get-config><source><running/></source>$FILTERE<with-defaults $WD>report-all</with-defaults></get-config></rpc>]]>]]>" '^<rpc-reply><data><e xmlns="urn:example:default"><z>7</z><w>9</w></e></data></rpc-reply>]]>]]>$'
+
+new "limited get-config report-all, denied default never set not reported"
+expecteof "$clixon_netconf -U wilma -qf $cfg" 0 "<rpc><get-config><source><running/></source>$FILTERE<with-defaults $WD>report-all</with-defaults></get-config></rpc>]]>]]>" '^<rpc-reply><data><e xmlns="urn:example:default"><w>9</w></e></data></rpc-reply>]]>]]>$'
+
+new "limited get report-all, denied default never set not reported"
+expecteof "$clixon_netconf -U wilma -qf $cfg" 0 "<rpc><get>$FILTERE<with-defaults $WD>report-all</with-defaults></get></rpc>]]>]]>" '^<rpc-reply><data><e xmlns="urn:example:default"><w>9</w></e></data></rpc-reply>]]>]]>$'
+
+if [ $BE -eq 0 ]; then
+    exit # BE
+fi
+
+new "Kill backend"
+# Check if premature kill
+pid=$(pgrep -u root -f clixon_backend)
+if [ -z "$pid" ]; then
+    err "backend already dead"
+fi
+# kill backend
+stop_backend -f $cfg
+
+rm -rf $dir
@@ -70,6 +70,17 @@ EOF
 new "xml complex CDATA to json"
 expecteofx "$clixon_util_xml -oj" 0 "$XML" "$JSON"
 
+new "xml complex CDATA to json pushed one byte at a time"
+expecteofx "$clixon_util_xml -oj -c 1" 0 "$XML" "$JSON"
+
+new "xml complex CDATA to json pushed one byte at a time to fast scanner"
+expecteofx "$clixon_util_xml -oj -F -c 1" 0 "$XML" "$JSON"
+
+# Large CDATA section pushed one byte at a time, each push should not rescan the section
+CDATA=$(for i in $(seq 1 20000); do printf "x]"; done)
+new "xml large CDATA pushed one byte at a time"
+expecteofx "$clixon_util_xml -o -F -c 1" 0 "<a><![CDATA[$CDATA]]></a>" "<a><![CDATA[$CDATA]]></a>"
+
 XML=$(cat <<EOF
 <message>Less than: &lt; , greater than: &gt; ampersand: &amp; </message>
 EOF
@@ -43,6 +43,32 @@ module example {
 	leaf x{
 	    type int32;
 	}
+	leaf y{
+	    type int32;
+	}
+      }
+      list un{
+	key k;
+	leaf k{
+	    type union{
+	       type int32;
+	       type string;
+	    }
+	}
+      }
+      list u{
+        ordered-by user;
+	key k;
+	leaf k{
+	    type string;
+	}
+	leaf v{
+	    type string;
+	}
+      }
+      leaf-list ul{
+        ordered-by user;
+        type string;
       }
     }
 }
@@ -118,9 +144,34 @@ testrun merge "$x0a<a><x>1</x></a><a><x>2</x></a>$x0b" "$x0a<d>42</d>$x0b" . 0 '
 new "merge leaf and list"
 testrun merge "$x0a<d>42</d>$x0b" "$x0a<a><x>1</x></a><a><x>2</x></a>$x0b" . 0 '<c xmlns="urn:example:example"><d>42</d><a><x>1</x></a><a><x>2</x></a></c>'
 
+# Existing ordered-by user entries keep their place, new are added last
+new "merge ordered-by user list"
+testrun merge "$x0a<u><k>b</k></u><u><k>a</k></u>$x0b" "$x0a<u><k>c</k></u><u><k>a</k><v>1</v></u>$x0b" . 0 '<c xmlns="urn:example:example"><u><k>b</k></u><u><k>a</k><v>1</v></u><u><k>c</k></u></c>'
+
+new "merge ordered-by user leaf-list"
+testrun merge "$x0a<ul>z</ul><ul>x</ul>$x0b" "$x0a<ul>y</ul><ul>x</ul>$x0b" . 0 '<c xmlns="urn:example:example"><ul>z</ul><ul>x</ul><ul>y</ul></c>'
+
+new "merge mixed keyed and unkeyed children out of order"
+testrun merge "$x0a<u><k>b</k></u><ul>z</ul><d>1</d><a><x>2</x></a>$x0b" "$x0a<ul>y</ul><u><k>c</k></u><a><x>1</x></a><d>3</d><ul>z</ul><u><k>b</k><v>2</v></u>$x0b" . 0 '<c xmlns="urn:example:example"><d>3</d><a><x>1</x></a><a><x>2</x></a><u><k>b</k><v>2</v></u><u><k>c</k></u><ul>z</ul><ul>y</ul></c>'
+
 new "merge overlap with path fail, merge does not work w subtrees"
 testrun merge "$x0a<a><x>1</x></a><a><x>2</x></a>$x0b" "$x0a<a><x>2</x></a><a><x>3</x></a>$x0b" c 255 ''
 
+# Union keys are compared as strings, not as binary keys (XML_KEY_BLOB)
+new "merge union key list"
+testrun merge "$x0a<un><k>10</k></un><un><k>b</k></un>$x0b" "$x0a<un><k>a</k></un><un><k>2</k></un><un><k>10</k></un>$x0b" . 0 '<c xmlns="urn:example:example"><un><k>10</k></un><un><k>2</k></un><un><k>a</k></un><un><k>b</k></un></c>'
+
+# -------- change list keys of a sorted tree, and sort again
+new "change key body"
+testrun body "$x0a<a><x>1</x></a><a><x>2</x></a><a><x>3</x></a>$x0b" 5 "c/a[x=1]/x" 0 '<c xmlns="urn:example:example"><a><x>2</x></a><a><x>3</x></a><a><x>5</x></a></c>'
+
+new "change non-key body"
+testrun body "$x0a<a><x>1</x><y>9</y></a><a><x>2</x></a>$x0b" 0 "c/a[x=1]/y" 0 '<c xmlns="urn:example:example"><a><x>1</x><y>0</y></a><a><x>2</x></a></c>'
+
+# The entry without key is first, until its leaf is renamed to the key
+new "rename leaf to key"
+testrun rename "$x0a<a><x>1</x></a><a><x>2</x></a><a><y>3</y></a>$x0b" x "c/a[y=3]/y" 0 '<c xmlns="urn:example:example"><a><x>1</x></a><a><x>2</x></a><a><x>3</x></a></c>'
+
 rm -rf $dir
 
 # unset conditional parameters 
@@ -101,6 +101,9 @@ new "xpath //b*"
 new "xpath //b*/ccc"
 #expecteof "$clixon_util_xpath -f $xml" 0 "//b*/ccc" ""
 
+new "xpath //name"
+expecteof "$clixon_util_xpath -f $xml2 -p //name" 0 "" "^nodeset:0:<name>foo</name>1:<name>bar</name>$"
+
 new "xpath //bbb[0]"
 expecteof "$clixon_util_xpath -f $xml -p //bbb[0]" 0 "" "^nodeset:0:<bbb x=\"hello\"><ccc>42</ccc></bbb>$"
 
@@ -201,6 +204,111 @@ expecteof "$clixon_util_xpath -f $xml3 -p bbb[ccc='bar']" 0 "" "^nodeset:0:<bbb
 new "xpath bbb[ccc='fie']"
 expecteof "$clixon_util_xpath -f $xml3 -p bbb[ccc='fie']" 0 "" "^nodeset:$"
 
+# List lookups using keys in predicates
+fyang=$dir/example-opt.yang
+xml4=$dir/xml4.xml
+cat <<EOF > $fyang
+module example-opt{
+   yang-version 1.1;
+   namespace "urn:example:opt";
+   prefix ex;
+   container c{
+      list y{
+         key "a b";
+         leaf a{ type int32; }
+         leaf b{ type string; }
+         leaf v{ type string; }
+      }
+      leaf w{ type string; }
+      list s{
+         key k;
+         leaf k{ type string; }
+      }
+   }
+}
+EOF
+
+cat <<EOF > $xml4
+<c xmlns="urn:example:opt">
+  <y><a>1</a><b>x</b><v>foo</v></y>
+  <y><a>1</a><b>y</b><v>bar</v></y>
+  <y><a>2</a><b>x</b><v>foo</v></y>
+  <w>42</w>
+  <s><k>01</k></s>
+  <s><k>2</k></s>
+</c>
+EOF
+
+optconf="-s -y $fyang -f $xml4 -n null:urn:example:opt"
+
+new "xpath list all keys"
+expectpart "$($clixon_util_xpath $optconf -p "/c/y[a=1][b='y']")" 0 '^nodeset:0:<y><a>1</a><b>y</b><v>bar</v></y>$' "optimize hits:1 index:0 misses:0"
+
+new "xpath list keys in other order"
+expectpart "$($clixon_util_xpath $optconf -p "/c/y[b='x' and a=2]")" 0 '^nodeset:0:<y><a>2</a><b>x</b><v>foo</v></y>$' "optimize hits:1 index:0 misses:0"
+
+new "xpath list first key and non-key"
+expectpart "$($clixon_util_xpath $optconf -p "/c/y[a='1' and v='foo']")" 0 '^nodeset:0:<y><a>1</a><b>x</b><v>foo</v></y>$' "optimize hits:1 index:0 misses:0"
+
+new "xpath list first key"
+expectpart "$($clixon_util_xpath $optconf -p "/c/y[a='1']/v")" 0 '^nodeset:0:<v>foo</v>1:<v>bar</v>$' "optimize hits:1 index:0 misses:0"
+
+new "xpath list second key only"
+expectpart "$($clixon_util_xpath $optconf -p "/c/y[b='x']/a")" 0 '^nodeset:0:<a>1</a>1:<a>2</a>$' "optimize hits:0 index:0 misses:1"
+
+new "xpath list key or"
+expectpart "$($clixon_util_xpath $optconf -p "/c/y[a=2 or v='bar']/b")" 0 '^nodeset:0:<b>y</b>1:<b>x</b>$' "optimize hits:0 index:0 misses:1"
+
+new "xpath list position before key"
+expectpart "$($clixon_util_xpath $optconf -p "/c/y[2][a=1]/b")" 0 "optimize hits:0 index:0 misses:1"
+
+new "xpath list key before position"
+expectpart "$($clixon_util_xpath $optconf -p "/c/y[a=1][2]/b")" 0 "optimize hits:1 index:0 misses:0"
+
+# Number literals compare as numbers, and are not looked up as strings
+new "xpath list string key and number"
+expectpart "$($clixon_util_xpath $optconf -p "/c/s[k=1]")" 0 '^nodeset:0:<s><k>01</k></s>$' "optimize hits:0 index:0 misses:1"
+
+new "xpath list string key and string"
+expectpart "$($clixon_util_xpath $optconf -p "/c/s[k='01']")" 0 '^nodeset:0:<s><k>01</k></s>$' "optimize hits:1 index:0 misses:0"
+
+new "xpath list int key and number not an int"
+expectpart "$($clixon_util_xpath $optconf -p "/c/y[a=2.0]/v")" 0 '^nodeset:0:<v>foo</v>$' "optimize hits:0 index:0 misses:1"
+
+# First node and existence, location paths are evaluated until first match
+new "xpath list entries and sibling using schema"
+expectpart "$($clixon_util_xpath $optconf -p "/c/y/v")" 0 '^nodeset:0:<v>foo</v>1:<v>bar</v>2:<v>foo</v>$'
+
+new "xpath sibling after list using schema"
+expectpart "$($clixon_util_xpath $optconf -p "/c/w")" 0 '^nodeset:0:<w>42</w>$'
+
+new "xpath first sibling after list using schema"
+expectpart "$($clixon_util_xpath -1 $optconf -p "/c/w")" 0 '^first:<w>42</w>$'
+
+new "xpath first //bbb"
+expecteof "$clixon_util_xpath -1 -f $xml -p //bbb" 0 "" "^first:<bbb x=\"hello\"><ccc>42</ccc></bbb>$"
+
+new "xpath first /aaa/bbb[ccc=99]/ccc"
+expecteof "$clixon_util_xpath -1 -f $xml -p /aaa/bbb[ccc=99]/ccc" 0 "" "^first:<ccc>99</ccc>$"
+
+new "xpath first no match"
+expecteof "$clixon_util_xpath -1 -f $xml -p /aaa/ddd[ccc=99]" 0 "" "^first:$"
+
+new "xpath first //bbb[0] position"
+expecteof "$clixon_util_xpath -1 -f $xml -p //bbb[0]" 0 "" "^first:<bbb x=\"hello\"><ccc>42</ccc></bbb>$"
+
+new "xpath first list key"
+expectpart "$($clixon_util_xpath -1 $optconf -p "/c/y[a=1]/v")" 0 '^first:<v>foo</v>$' "optimize hits:1 index:0 misses:0"
+
+new "xpath bool /aaa/bbb/ccc"
+expecteof "$clixon_util_xpath -b -f $xml -p /aaa/bbb/ccc" 0 "" "^bool:true$"
+
+new "xpath bool /aaa/eee"
+expecteof "$clixon_util_xpath -b -f $xml -p /aaa/eee" 0 "" "^bool:false$"
+
+new "xpath bool //ccc = 22"
+expecteof "$clixon_util_xpath -b -f $xml -p //ccc=22" 0 "" "^bool:true$"
+
 # Just syntax - no semantic meaning
 new "xpath derived-from-or-self"
 expecteof "$clixon_util_xpath -f $xml3 -p 'derived-from-or-self(../../change-operation,modify)'" 0 "" "derived-from-or-self"
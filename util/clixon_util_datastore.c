@@ -65,7 +65,7 @@
 #include <clixon/clixon.h>
 
 /* Command line options to be passed to getopt(3) */
-#define DATASTORE_OPTS "hDd:b:f:x:y:"
+#define DATASTORE_OPTS "hDd:b:f:msx:y:z:"
 
 /*! usage
  */
@@ -78,13 +78,17 @@ usage(char *argv0)
 		"\t-D\t\tDebug\n"
 		"\t-d <db>\t\tDatabase name. Default: running. Alt: candidate,startup\n"
 		"\t-b <dir>\tDatabase directory. Mandatory\n"
-	        "\t-f <fmt>\tDatabase format: xml or json\n"
+	        "\t-f <fmt>\tDatabase format: xml, json or binary\n"
+		"\t-m \t\tDatabase split in one file per top-level module\n"
+		"\t-s \t\tStamp XML database file as sorted\n"
 		"\t-x <xml>\tXML file. Alternative to put <xml> argument\n"
 		"\t-y <file>\tYang file. Mandatory\n"
+		"\t-z <compr>\tDatabase file compression: none or zlib\n"
 		"and command is either:\n"
 		"\tget [<xpath>]\n"
  	        "\tmget <nr> [<xpath>]\n"
 		"\tput (merge|replace|create|delete|remove) [<xml>]\n"
+		"\tsnapshot (merge|replace|create|delete|remove) <xml>\n"
 		"\tcopy <todb>\n"
 		"\tlock <pid>\n"
 		"\tunlock\n"
@@ -93,6 +97,7 @@ usage(char *argv0)
 		"\texists\n"
 		"\tdelete\n"
 		"\tinit\n"
+		"\tconvert (xml|json|binary) <file>\n"
 		,
 		argv0
 		);
@@ -153,6 +158,17 @@ main(int argc, char **argv)
 	        usage(argv0);
 	    clicon_option_str_set(h, "CLICON_XMLDB_FORMAT", optarg);
 	    break;
+	case 'm': /* db file per module */
+	    clicon_option_str_set(h, "CLICON_XMLDB_MULTI", "true");
+	    break;
+	case 's': /* stamp xml db file as sorted */
+	    clicon_option_str_set(h, "CLICON_XMLDB_SORTED_STAMP", "true");
+	    break;
+	case 'z': /* db file compression */
+	    if (!optarg)
+	        usage(argv0);
+	    clicon_option_str_set(h, "CLICON_XMLDB_COMPRESS", optarg);
+	    break;
 	case 'x': /* XML file */
 	    if (!optarg)
 	        usage(argv0);
@@ -271,6 +287,37 @@ main(int argc, char **argv)
 	if (xmldb_put(h, db, op, xt, NULL, cbret) < 1)
 	    goto done;
     }
+    else if (strcmp(cmd, "snapshot")==0){ /* Put while holding a snapshot, print both */
+	xmldb_snapshot *xs = NULL;
+
+	if (argc != 3)
+	    usage(argv0);
+	if (xml_operation(argv[1], &op) < 0){
+	    clicon_err(OE_DB, 0, "Unrecognized operation: %s", argv[1]);
+	    usage(argv0);
+	}
+	if (xmldb_snapshot_get(h, db, &xs) < 0)
+	    goto done;
+	if (clixon_xml_parse_string(argv[2], YB_MODULE, yspec, &xt, NULL) < 0)
+	    goto done;
+	if (xml_rootchild(xt, 0, &xt) < 0)
+	    goto done;
+	if ((cbret = cbuf_new()) == NULL){
+	    clicon_err(OE_UNIX, errno, "cbuf_new");
+	    goto done;
+	}
+	if (xmldb_put(h, db, op, xt, NULL, cbret) < 1)
+	    goto done;
+	xml_free(xt);
+	xt = NULL;
+	clicon_xml2file(stdout, xmldb_snapshot_xml(xs), 0, 0);
+	fprintf(stdout, "\n");
+	if (xmldb_get(h, db, NULL, "/", &xt) < 0)
+	    goto done;
+	clicon_xml2file(stdout, xt, 0, 0);
+	fprintf(stdout, "\n");
+	xmldb_snapshot_release(h, xs);
+    }
     else if (strcmp(cmd, "copy")==0){
 	if (argc != 2)
 	    usage(argv0);
@@ -323,6 +370,22 @@ main(int argc, char **argv)
 	if (xmldb_create(h, db) < 0)
 	    goto done;
     }
+    else if (strcmp(cmd, "convert")==0){ /* Read db in format -f, write file in other format, compressed as -z */
+	FILE *f;
+	if (argc != 3)
+	    usage(argv0);
+	if (xmldb_get_nodefaults(h, db, NULL, "/", -1, &xt) < 0)
+	    goto done;
+	if ((f = xmldb_fopen(h, argv[2])) == NULL)
+	    goto done;
+	ret = xmldb_dump(h, f, argv[1], xt);
+	if (xmldb_fclose(f, argv[2], ret == 0) < 0)
+	    goto done;
+	if (xt){
+	    xml_free(xt);
+	    xt = NULL;
+	}
+    }
     else{
 	clicon_err(OE_DB, 0, "Unrecognized command: %s", cmd);
 	usage(argv0);
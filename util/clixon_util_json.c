@@ -75,7 +75,10 @@ usage(char *argv0)
 	    "\t-j \t\tOutput as JSON (default is as XML)\n"
 	    "\t-l <s|e|o> \tLog on (s)yslog, std(e)rr, std(o)ut (stderr is default)\n"
 	    "\t-p \t\tPretty-print output\n"
-	    "\t-y <filename> \tyang filename to parse (must be stand-alone)\n"	    ,
+	    "\t-y <filename> \tyang filename to parse (must be stand-alone)\n"
+	    "\t-x \t\tUse flex/bison JSON parser (default)\n"
+	    "\t-F \t\tUse fast JSON scanner instead of flex/bison parser\n"
+	    ,
 	    argv0);
     exit(0);
 }
@@ -100,7 +103,7 @@ main(int    argc,
     
     optind = 1;
     opterr = 0;
-    while ((c = getopt(argc, argv, "hD:jl:py:")) != -1)
+    while ((c = getopt(argc, argv, "hD:jl:py:xF")) != -1)
 	switch (c) {
 	case 'h':
 	    usage(argv[0]);
@@ -122,6 +125,12 @@ main(int    argc,
 	case 'y':
 	    yang_filename = optarg;
 	    break;
+	case 'x':
+	    clixon_json_parse_fast_set(0);
+	    break;
+	case 'F':
+	    clixon_json_parse_fast_set(1);
+	    break;
 	default:
 	    usage(argv[0]);
 	    break;
@@ -66,7 +66,7 @@
 #include "clixon/clixon.h"
 
 /* Command line options passed to getopt(3) */
-#define UTIL_XML_OPTS "hD:f:Jjl:pvoy:Y:t:T:u"
+#define UTIL_XML_OPTS "hD:f:Jjl:pvoy:Y:t:T:uxFc:"
 
 static int
 validate_tree(clicon_handle h,
@@ -107,6 +107,52 @@ validate_tree(clicon_handle h,
     return retval;
 }
 
+/*! Parse XML from file descriptor using the incremental parser, pushing input in chunks
+ * @param[in]  fd    File descriptor
+ * @param[in]  chunk Number of bytes pushed to the parser at a time
+ * @param[in]  yb    How to bind yang to XML top-level when parsing
+ * @param[in]  yspec Yang specification
+ * @param[out] xt    XML parse tree with top element 'top'
+ * @param[out] xerr  Reason for failure (yang assignment not made)
+ * @retval     1     Parse OK and all yang assignment made
+ * @retval     0     Parse OK but yang assigment not made (or only partial) and xerr set
+ * @retval    -1     Error with clicon_err called
+ */
+static int
+xml_parse_chunks(int              fd,
+		 size_t           chunk,
+		 yang_bind        yb,
+		 yang_stmt       *yspec,
+		 cxobj          **xt,
+		 cxobj          **xerr)
+{
+    int              retval = -1;
+    clixon_xml_push *xp = NULL;
+    char            *buf = NULL;
+    ssize_t          len;
+
+    if ((buf = malloc(chunk)) == NULL){
+	clicon_err(OE_XML, errno, "malloc");
+	goto done;
+    }
+    if ((xp = clixon_xml_push_new(yb, yspec)) == NULL)
+	goto done;
+    while ((len = read(fd, buf, chunk)) > 0)
+	if (clixon_xml_push_data(xp, buf, len) < 0)
+	    goto done;
+    if (len < 0){
+	clicon_err(OE_XML, errno, "read");
+	goto done;
+    }
+    retval = clixon_xml_push_end(xp, xt, xerr);
+ done:
+    if (xp)
+	clixon_xml_push_free(xp);
+    if (buf)
+	free(buf);
+    return retval;
+}
+
 static int
 usage(char *argv0)
 {
@@ -126,6 +172,9 @@ usage(char *argv0)
    	    "\t-t <file>\tXML top input file (where base tree is pasted to)\n"
 	    "\t-T <path>\tXPath to where in top input file base should be pasted\n"
 	    "\t-u \t\tTreat unknown XML as anydata\n"
+	    "\t-x \t\tUse flex/bison XML parser (default)\n"
+	    "\t-F \t\tUse fast XML scanner instead of flex/bison parser\n"
+	    "\t-c <n>\t\tPush XML input to incremental parser in chunks of <n> bytes\n"
 	    ,
 	    argv0);
     exit(0);
@@ -164,6 +213,7 @@ main(int    argc,
     cvec         *nsc = NULL; 
     yang_bind     yb;
     int           dbg = 0;
+    int           chunk = 0;
 
     /* In the startup, logs to stderr & debug flag set later */
     clicon_log_init(__FILE__, LOG_INFO, CLICON_LOG_STDERR); 
@@ -226,6 +276,16 @@ main(int    argc,
 		goto done;
 	    xml_bind_yang_unknown_anydata(1);
 	    break;
+	case 'x':
+	    clixon_xml_parse_fast_set(0);
+	    break;
+	case 'F':
+	    clixon_xml_parse_fast_set(1);
+	    break;
+	case 'c':
+	    if ((chunk = atoi(optarg)) <= 0)
+		usage(argv[0]);
+	    break;
 	default:
 	    usage(argv[0]);
 	    break;
@@ -309,7 +369,11 @@ main(int    argc,
 	    yb = YB_MODULE;
 	else
 	    yb = YB_PARENT;
-	if ((ret = clixon_xml_parse_file(fd, yb, yspec, NULL, &xt, &xerr)) < 0){
+	if (chunk && xt == NULL)
+	    ret = xml_parse_chunks(fd, chunk, yb, yspec, &xt, &xerr);
+	else
+	    ret = clixon_xml_parse_file(fd, yb, yspec, NULL, &xt, &xerr);
+	if (ret < 0){
 	    fprintf(stderr, "xml parse error: %s\n", clicon_err_reason);
 	    goto done;
 	}
@@ -0,0 +1,310 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+
+  Copyright (C) 2009-2016 Olof Hagsand and Benny Holmgren
+  Copyright (C) 2017-2019 Olof Hagsand
+  Copyright (C) 2020 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2,
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * XML micro-benchmarks
+ * Parse an XML file a number of times with the fast XML scanner and the flex/bison XML
+ * parser, print the parsed tree as XML and JSON, and encode the file as XML character
+ * data, and print throughput of each in MB/s, eg:
+ *   clixon_util_xml_bench -f startup_db -n 10
+ * On failure, an error is printed on stderr and exitcode != 0
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <limits.h>
+#include <stdint.h>
+#include <syslog.h>
+#include <fcntl.h>
+#include <sys/time.h>
+#include <sys/stat.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include "clixon/clixon.h"
+
+/* Command line options passed to getopt(3) */
+#define UTIL_XML_BENCH_OPTS "hD:f:n:y:"
+
+static int
+usage(char *argv0)
+{
+    fprintf(stderr, "usage:%s [options]\n"
+	    "where options are\n"
+            "\t-h \t\tHelp\n"
+    	    "\t-D <level> \tDebug\n"
+	    "\t-f <file>\tXML input file (required)\n"
+	    "\t-n <nr>\t\tNumber of iterations (default 10)\n"
+	    "\t-y <filename> \tYang filename, bind XML to yang when parsing\n"
+	    ,
+	    argv0);
+    exit(0);
+}
+
+/*! Parse XML string a number of times and print throughput
+ * @param[in]  str    XML string
+ * @param[in]  yspec  Yang spec or NULL
+ * @param[in]  nr     Number of iterations
+ * @param[in]  fast   1: fast XML scanner, 0: flex/bison parser
+ */
+static int
+xml_bench_parse(char      *str,
+		yang_stmt *yspec,
+		int        nr,
+		int        fast)
+{
+    int            retval = -1;
+    cxobj         *xt;
+    struct timeval t0;
+    struct timeval t1;
+    double         secs;
+    int            i;
+
+    clixon_xml_parse_fast_set(fast);
+    gettimeofday(&t0, NULL);
+    for (i=0; i<nr; i++){
+	xt = NULL;
+	if (clixon_xml_parse_string(str, yspec?YB_MODULE:YB_NONE, yspec, &xt, NULL) < 0)
+	    goto done;
+	xml_free(xt);
+    }
+    gettimeofday(&t1, NULL);
+    timersub(&t1, &t0, &t1);
+    secs = t1.tv_sec + t1.tv_usec/1000000.0;
+    fprintf(stdout, "%-10s %8.3f s %10.1f MB/s\n",
+	    fast?"fast":"flex/bison",
+	    secs,
+	    secs>0?((double)strlen(str)*nr)/secs/1000000.0:0);
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Print XML tree as XML or JSON a number of times and print throughput
+ * @param[in]  xt     XML tree
+ * @param[in]  nr     Number of iterations
+ * @param[in]  json   0: print as XML, 1: print as JSON
+ */
+static int
+xml_bench_print(cxobj *xt,
+		int    nr,
+		int    json)
+{
+    int            retval = -1;
+    cbuf          *cb = NULL;
+    struct timeval t0;
+    struct timeval t1;
+    double         secs;
+    size_t         len = 0;
+    int            i;
+
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    gettimeofday(&t0, NULL);
+    for (i=0; i<nr; i++){
+	cbuf_reset(cb);
+	if (json){
+	    if (xml2json_cbuf(cb, xml_child_i_type(xt, 0, CX_ELMNT), 0) < 0)
+		goto done;
+	}
+	else if (clicon_xml2cbuf(cb, xml_child_i_type(xt, 0, CX_ELMNT), 0, 0, -1) < 0)
+	    goto done;
+	len += cbuf_len(cb);
+    }
+    gettimeofday(&t1, NULL);
+    timersub(&t1, &t0, &t1);
+    secs = t1.tv_sec + t1.tv_usec/1000000.0;
+    fprintf(stdout, "%-10s %8.3f s %10.1f MB/s\n",
+	    json?"json print":"xml print",
+	    secs,
+	    secs>0?(double)len/secs/1000000.0:0);
+    retval = 0;
+ done:
+    if (cb)
+	cbuf_free(cb);
+    return retval;
+}
+
+/*! Encode string as XML character data a number of times and print throughput
+ * @param[in]  str    String
+ * @param[in]  nr     Number of iterations
+ * @see xml_chardata_cbuf_append
+ */
+static int
+xml_bench_encode(char *str,
+		 int   nr)
+{
+    int            retval = -1;
+    cbuf          *cb = NULL;
+    struct timeval t0;
+    struct timeval t1;
+    double         secs;
+    int            i;
+
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    gettimeofday(&t0, NULL);
+    for (i=0; i<nr; i++){
+	cbuf_reset(cb);
+	if (xml_chardata_cbuf_append(cb, str) < 0)
+	    goto done;
+    }
+    gettimeofday(&t1, NULL);
+    timersub(&t1, &t0, &t1);
+    secs = t1.tv_sec + t1.tv_usec/1000000.0;
+    fprintf(stdout, "%-10s %8.3f s %10.1f MB/s\n",
+	    "encode",
+	    secs,
+	    secs>0?((double)strlen(str)*nr)/secs/1000000.0:0);
+    retval = 0;
+ done:
+    if (cb)
+	cbuf_free(cb);
+    return retval;
+}
+
+int
+main(int    argc,
+     char **argv)
+{
+    int           retval = -1;
+    int           c;
+    char         *input_filename = NULL;
+    char         *yang_filename = NULL;
+    yang_stmt    *yspec = NULL;
+    clicon_handle h = NULL;
+    struct stat   st;
+    int           fd = -1;
+    char         *buf = NULL;
+    ssize_t       len;
+    int           nr = 10;
+    int           dbg = 0;
+    cxobj        *xt = NULL;
+
+    clicon_log_init(__FILE__, LOG_INFO, CLICON_LOG_STDERR);
+    if ((h = clicon_handle_init()) == NULL)
+	goto done;
+    optind = 1;
+    opterr = 0;
+    while ((c = getopt(argc, argv, UTIL_XML_BENCH_OPTS)) != -1)
+	switch (c) {
+	case 'h':
+	    usage(argv[0]);
+	    break;
+    	case 'D':
+	    if (sscanf(optarg, "%d", &dbg) != 1)
+		usage(argv[0]);
+	    break;
+	case 'f':
+	    input_filename = optarg;
+	    break;
+	case 'n':
+	    if (sscanf(optarg, "%d", &nr) != 1 || nr <= 0)
+		usage(argv[0]);
+	    break;
+	case 'y':
+	    yang_filename = optarg;
+	    break;
+	default:
+	    usage(argv[0]);
+	    break;
+	}
+    if (input_filename == NULL)
+	usage(argv[0]);
+    clicon_debug_init(dbg, NULL);
+    if (yang_filename){
+	if ((yspec = yspec_new()) == NULL)
+	    goto done;
+	if (yang_spec_parse_file(h, yang_filename, yspec) < 0)
+	    goto done;
+    }
+    if ((fd = open(input_filename, O_RDONLY)) < 0){
+	clicon_err(OE_UNIX, errno, "open(%s)", input_filename);
+	goto done;
+    }
+    if (fstat(fd, &st) < 0){
+	clicon_err(OE_UNIX, errno, "fstat");
+	goto done;
+    }
+    if ((buf = malloc(st.st_size + 1)) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto done;
+    }
+    if ((len = read(fd, buf, st.st_size)) < 0){
+	clicon_err(OE_UNIX, errno, "read");
+	goto done;
+    }
+    buf[len] = '\0';
+    fprintf(stdout, "%s: %zd bytes, %d iterations\n", input_filename, len, nr);
+    if (xml_bench_parse(buf, yspec, nr, 0) < 0)
+	goto done;
+    if (xml_bench_parse(buf, yspec, nr, 1) < 0)
+	goto done;
+    if (clixon_xml_parse_string(buf, yspec?YB_MODULE:YB_NONE, yspec, &xt, NULL) < 0)
+	goto done;
+    if (xml_bench_print(xt, nr, 0) < 0)
+	goto done;
+    if (xml_bench_print(xt, nr, 1) < 0)
+	goto done;
+    if (xml_bench_encode(buf, nr) < 0)
+	goto done;
+    retval = 0;
+ done:
+    if (retval < 0)
+	fprintf(stderr, "%s\n", clicon_err_reason);
+    if (xt)
+	xml_free(xt);
+    if (buf)
+	free(buf);
+    if (fd != -1)
+	close(fd);
+    if (yspec)
+	yspec_free(yspec);
+    if (h)
+	clicon_handle_exit(h);
+    return retval;
+}
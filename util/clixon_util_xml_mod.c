@@ -72,13 +72,17 @@ enum opx{
     OPX_ERROR = -1,
     OPX_INSERT,
     OPX_MERGE,
-    OPX_PARENT
+    OPX_PARENT,
+    OPX_BODY,
+    OPX_RENAME
 };
 
 static const map_str2int opx_map[] = {
     {"insert",  OPX_INSERT},
     {"merge",   OPX_MERGE},
     {"parent",  OPX_PARENT},
+    {"body",    OPX_BODY},
+    {"rename",  OPX_RENAME},
     {NULL,             -1}
 };
 
@@ -95,11 +99,11 @@ usage(char *argv0)
 	    "where options are\n"
             "\t-h \t\tHelp\n"
     	    "\t-D <level>\tDebug\n"
-	    "\t-o <op>   \tOperation: parent, insert or merge\n"
+	    "\t-o <op>   \tOperation: parent, insert, merge, body or rename\n"
 	    "\t-y <file> \tYANG spec file\n"
     	    "\t-Y <dir> \tYang dirs (can be several)\n"
 	    "\t-b <base> \tXML base expression\n"
-	    "\t-x <xml>  \tXML to insert\n"
+	    "\t-x <xml>  \tXML to insert, or new body or name of base element (body, rename)\n"
 	    "\t-p <xpath>\tXpath to where in base and XML\n"
 	    "\t-s        \tSort output after operation\n",
 	    argv0
@@ -124,6 +128,7 @@ main(int argc, char **argv)
     cxobj        *xb = NULL;
     cxobj        *xi = NULL;
     cxobj        *xi1 = NULL;
+    cxobj        *xbody;
     cxobj        *xerr = NULL;
     int           sort = 0;
     int           ret;
@@ -271,6 +276,22 @@ main(int argc, char **argv)
 	if (xml_insert(xb, xi1, INS_LAST, NULL, NULL) < 0) 
 	    goto done;
 	break;
+    case OPX_BODY: /* Set body of base element, then sort and print all of base */
+	if ((xbody = xml_body_get(xb)) == NULL){
+	    clicon_err(OE_XML, 0, "xpath: %s has no body", xpath);
+	    goto done;
+	}
+	if (xml_value_set(xbody, x1str) < 0)
+	    goto done;
+	xb = x0;
+	sort++;
+	break;
+    case OPX_RENAME: /* Rename base element, then sort and print all of base */
+	if (xml_name_set(xb, x1str) < 0)
+	    goto done;
+	xb = x0;
+	sort++;
+	break;
     default:
 	usage(argv0);
     }
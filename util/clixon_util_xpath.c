@@ -50,6 +50,7 @@ See https://www.w3.org/TR/xpath/
 #include <stdint.h>
 #include <syslog.h>
 #include <fcntl.h>
+#include <sys/time.h>
 #include <sys/stat.h>
 
 /* cligen */
@@ -59,7 +60,7 @@ See https://www.w3.org/TR/xpath/
 #include "clixon/clixon.h"
 
 /* Command line options to be passed to getopt(3) */
-#define XPATH_OPTS "hD:f:p:i:n:cy:Y:"
+#define XPATH_OPTS "hD:f:p:i:n:cy:Y:s1bt:"
 
 static int
 usage(char *argv0)
@@ -75,6 +76,10 @@ usage(char *argv0)
 	    "\t-c \t\tMap xpath to canonical form\n"
 	    "\t-y <filename> \tYang filename or dir (load all files)\n"
     	    "\t-Y <dir> \tYang dirs (can be several)\n"
+	    "\t-s \t\tPrint list optimization statistics\n"
+	    "\t-1 \t\tPrint first node only (xpath_first)\n"
+	    "\t-b \t\tPrint boolean result only (xpath_vec_bool)\n"
+	    "\t-t <nr> \tEvaluate xpath nr times and print time\n"
 	    "and the following extra rules:\n"
 	    "\tif -f is not given, XML input is expected on stdin\n"
 	    "\tif -p is not given, <xpath> is expected as the first line on stdin\n"
@@ -137,6 +142,13 @@ main(int    argc,
     struct stat st;
     cvec       *nsc = NULL;
     int         canonical = 0;
+    int         stats = 0;
+    int         first = 0;
+    int         boolean = 0;
+    int         nr = 1;
+    cxobj      *xf = NULL;
+    struct timeval t0;
+    struct timeval t1;
     cxobj      *xcfg = NULL;
     cbuf       *cbret = NULL;
     cxobj      *xerr = NULL; /* malloced must be freed */
@@ -207,6 +219,19 @@ main(int    argc,
 	    if (clicon_option_add(h, "CLICON_YANG_DIR", optarg) < 0)
 		goto done;
 	    break;
+	case 's':
+	    stats++;
+	    break;
+	case '1':
+	    first++;
+	    break;
+	case 'b':
+	    boolean++;
+	    break;
+	case 't':
+	    if (sscanf(optarg, "%d", &nr) != 1 || nr <= 0)
+		usage(argv0);
+	    break;
 	default:
 	    usage(argv[0]);
 	    break;
@@ -337,12 +362,46 @@ main(int    argc,
     }
     else
 	x = x0;
-    if (xpath_vec_ctx(x, nsc, xpath, 0, &xc) < 0)
-	return -1;
+    xpath_list_optimize_stats(NULL, NULL, NULL);
+    gettimeofday(&t0, NULL);
+    for (i=0; i<nr; i++){
+	if (xc){
+	    ctx_free(xc);
+	    xc = NULL;
+	}
+	if (first)
+	    xf = xpath_first(x, nsc, "%s", xpath);
+	else if (boolean){
+	    if ((ret = xpath_vec_bool(x, nsc, "%s", xpath)) < 0)
+		return -1;
+	}
+	else if (xpath_vec_ctx(x, nsc, xpath, 0, &xc) < 0)
+	    return -1;
+    }
+    gettimeofday(&t1, NULL);
     /* Print results */
     cb = cbuf_new();
-    ctx_print2(cb, xc);
+    if (first){
+	cprintf(cb, "first:");
+	if (xf)
+	    clicon_xml2cbuf(cb, xf, 0, 0, -1);
+    }
+    else if (boolean)
+	cprintf(cb, "bool:%s", ret?"true":"false");
+    else
+	ctx_print2(cb, xc);
     fprintf(stdout, "%s\n", cbuf_get(cb));
+    if (nr > 1){
+	timersub(&t1, &t0, &t1);
+	fprintf(stdout, "time: %d iterations %.6f s\n", nr, t1.tv_sec + t1.tv_usec/1000000.0);
+    }
+    if (stats){
+	int hits;
+	int indexhits;
+	int misses;
+	xpath_list_optimize_stats(&hits, &indexhits, &misses);
+	fprintf(stdout, "optimize hits:%d index:%d misses:%d\n", hits, indexhits, misses);
+    }
  ok:
     retval = 0;
  done: